@@ -647,6 +647,120 @@ static void test_new_assembly(int N, int NX, int pK) {
 }
 
 
+/* Comparison of the hash based dof enumeration of mesh_fem with the
+   original kd-tree based one. */
+static void test_dof_enumeration(int N, int NX, int pK) {
+  cout << "\n\n-------------------------------------\n"
+       <<     "Dof enumeration in dimension " << N << " with P" << pK
+       <<   " elements\n-------------------------------------"
+       << endl << endl;
+  char Ns[5]; snprintf(Ns, 5, "%d", N);
+  char Ks[5]; snprintf(Ks, 5, "%d", pK);
+  getfem::mesh m;
+  bgeot::pgeometric_trans pgt =
+    bgeot::geometric_trans_descriptor
+    ((std::string("GT_PK(") + Ns + ",1)").c_str());
+  std::vector<size_type> nsubdiv(N, NX);
+  getfem::regular_unit_mesh(m, nsubdiv, pgt);
+  getfem::pfem pf = getfem::fem_descriptor
+    ((std::string("FEM_PK(") + Ns + "," + Ks + ")").c_str());
+
+  chrono ch;
+  getfem::mesh_fem mf_kdtree(m, dim_type(N)), mf_hash(m, dim_type(N));
+  mf_kdtree.set_finite_element(m.convex_index(), pf);
+  mf_kdtree.set_hash_dof_enumeration(false);
+  mf_hash.set_finite_element(m.convex_index(), pf);
+  ch.init(); ch.tic(); mf_kdtree.enumerate_dof(); ch.toc();
+  cout << "nb elements = " << m.convex_index().card()
+       << " ndof = " << mf_kdtree.nb_dof() << endl;
+  cout << "kd-tree based enumeration : " << ch << endl;
+  ch.init(); ch.tic(); mf_hash.enumerate_dof(); ch.toc();
+  cout << "hash based enumeration    : " << ch << endl;
+
+  GMM_ASSERT1(mf_kdtree.nb_dof() == mf_hash.nb_dof(), "Bad number of dofs");
+  for (dal::bv_visitor cv(m.convex_index()); !cv.finished(); ++cv)
+    GMM_ASSERT1(mf_kdtree.ind_scalar_basic_dof_of_element(cv)
+                == mf_hash.ind_scalar_basic_dof_of_element(cv),
+                "The two dof enumerations differ");
+}
+
+/* Scaling of the gmm sparse matrix-vector products and of the level 1
+   kernels used by the Krylov solvers with respect to the number of OpenMP
+   threads, on the matrix of a scalar Laplacian. */
+static void test_gmm_kernels(int N, int NX, int pK, int nbrep) {
+  cout << "\n\n-------------------------------------\n"
+       <<     "gmm kernels in dimension " << N << " with P" << pK
+       <<   " elements\n-------------------------------------"
+       << endl << endl;
+  char Ns[5]; snprintf(Ns, 5, "%d", N);
+  char Ks[5]; snprintf(Ks, 5, "%d", pK);
+  getfem::mesh m;
+  bgeot::pgeometric_trans pgt =
+    bgeot::geometric_trans_descriptor
+    ((std::string("GT_PK(") + Ns + ",1)").c_str());
+  std::vector<size_type> nsubdiv(N, NX);
+  getfem::regular_unit_mesh(m, nsubdiv, pgt);
+  getfem::mesh_fem mf(m);
+  mf.set_finite_element(m.convex_index(), getfem::fem_descriptor
+                        ((std::string("FEM_PK(") + Ns + "," + Ks + ")").c_str()));
+  getfem::mesh_im mim(m);
+  mim.set_integration_method(m.convex_index(), 2*pK);
+  size_type nd = mf.nb_dof();
+
+  sparse_matrix_type K(nd, nd);
+  getfem::asm_stiffness_matrix_for_homogeneous_laplacian(K, mim, mf);
+  gmm::csr_matrix<scalar_type> Kr; gmm::copy(K, Kr);
+  gmm::csc_matrix<scalar_type> Kc; gmm::copy(K, Kc);
+  gmm::col_matrix<gmm::rsvector<scalar_type> > Krs(nd, nd); gmm::copy(K, Krs);
+  cout << "ndof = " << nd << " nnz = " << gmm::nnz(Kr)
+       << " threshold = " << gmm::parallel_threshold() << endl;
+
+  linalg_vector x(nd), y(nd), z(nd);
+  for (size_type i = 0; i < nd; ++i) x[i] = 1.0 + scalar_type(i % 7);
+  gmm::mult(Kr, x, z);
+
+  int max_threads = 1;
+#ifdef _OPENMP
+  max_threads = 64;
+#endif
+  for (int nt = 1; nt <= max_threads; nt *= 2) {
+#ifdef _OPENMP
+    omp_set_num_threads(nt);
+#endif
+    chrono ch; scalar_type res(0);
+    cout << "threads = " << std::setw(2) << nt << endl;
+    ch.init(); ch.tic();
+    for (int k = 0; k < nbrep; ++k) gmm::mult(Kr, x, y);
+    ch.toc(); cout << "SpMV csr              : " << ch << endl;
+    GMM_ASSERT1(gmm::vect_dist2(y, z) < 1E-10 * gmm::vect_norm2(z), "error");
+    ch.init(); ch.tic();
+    for (int k = 0; k < nbrep; ++k) gmm::mult(Kc, x, y);
+    ch.toc(); cout << "SpMV csc              : " << ch << endl;
+    GMM_ASSERT1(gmm::vect_dist2(y, z) < 1E-10 * gmm::vect_norm2(z), "error");
+    ch.init(); ch.tic();
+    for (int k = 0; k < nbrep; ++k) gmm::mult(Krs, x, y);
+    ch.toc(); cout << "SpMV col_matrix       : " << ch << endl;
+    GMM_ASSERT1(gmm::vect_dist2(y, z) < 1E-10 * gmm::vect_norm2(z), "error");
+    ch.init(); ch.tic();
+    for (int k = 0; k < nbrep; ++k) res += gmm::vect_sp(x, y);
+    ch.toc(); cout << "dot                   : " << ch << endl;
+    ch.init(); ch.tic();
+    for (int k = 0; k < nbrep; ++k) res += gmm::vect_norm2(y);
+    ch.toc(); cout << "norm                  : " << ch << endl;
+    ch.init(); ch.tic();
+    for (int k = 0; k < nbrep; ++k) gmm::add(gmm::scaled(x, 1E-3), y);
+    ch.toc(); cout << "axpy                  : " << ch << endl;
+    ch.init(); ch.tic();
+    for (int k = 0; k < nbrep; ++k)
+      res += gmm::add_and_norm2_sqr(gmm::scaled(x, -1E-3), y);
+    ch.toc(); cout << "fused axpy + norm     : " << ch << endl;
+    GMM_ASSERT1(res > 0, "error");
+  }
+#ifdef _OPENMP
+  omp_set_num_threads(max_threads);
+#endif
+}
+
 int main(int /* argc */, char * /* argv */[]) {
 
   GMM_SET_EXCEPTION_DEBUG; // Exceptions make a memory fault, to debug.
@@ -711,6 +825,19 @@ int main(int /* argc */, char * /* argv */[]) {
   // Homogeneous elas     : 2.74 | 5.23 | 0.82 | 1.41 | 0.01 | 1.32 |
   // Non-homogeneous elast: 2.66 | 47.4 | 0.82 | 1.41 | 0.01 | 1.24 |
 
+  if (all || only_one == 6) { // ndofu = 1283202 and 1167051
+    test_dof_enumeration(2, 400, 2);
+    test_dof_enumeration(3, 36, 2);
+  }
+  //                       kd-tree | hash (1 thread) |
+  // Dof enum. (2D, P2)  :   2.20  |  0.79  |
+  // Dof enum. (3D, P2)  :   4.37  |  1.48  |
+
+  if (all || only_one == 7) { // ndof = 641601 and 389017
+    test_gmm_kernels(2, 800, 1, 100);
+    test_gmm_kernels(3, 36, 2, 50);
+  }
+
   // Conclusions :
   // - Deactivation of debug test has no sensible effect.
   // - Compile time of assembly strings is negligible (< 0.0004)
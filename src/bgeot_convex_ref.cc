@@ -176,6 +176,15 @@ namespace bgeot {
       }
       return true;
     }
+    size_t hash() const override {
+      size_t h = dal::key_hasher<size_type>()(pspt->size());
+      for (const base_node &pt : *pspt) {
+        h = dal::hash_combine(h, pt.size());
+        for (const scalar_type &x : pt)
+          h = dal::hash_combine(h, dal::key_hasher<scalar_type>()(x));
+      }
+      return h;
+    }
     stored_point_tab_key(const stored_point_tab *p) : pspt(p) {}
   };
 
@@ -239,6 +248,10 @@ namespace bgeot {
       if (nf != o.nf) return false;
       return true;
     }
+    size_t hash() const override {
+      return dal::hash_combine(dal::hash_combine(size_t(type), N),
+                               dal::hash_combine(K, nf));
+    }
     convex_of_reference_key(int t, dim_type NN, short_type KK = 0,
                             short_type nnf = 0)
       : type(t), N(NN), K(KK), nf(nnf) {}
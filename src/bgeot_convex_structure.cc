@@ -102,6 +102,10 @@ namespace bgeot {
       if (nf != o.nf) return false;
       return true;
     }
+    size_t hash() const override {
+      return dal::hash_combine(dal::hash_combine(size_t(type), N),
+                               dal::hash_combine(K, nf));
+    }
     convex_structure_key(int t, dim_type NN, short_type KK = 0,
                          short_type nnf = 0)
       : type(t), N(NN), K(KK), nf(nnf)  {}
@@ -78,6 +78,23 @@ namespace bgeot
                            project_into_element);
   }
 
+  bool geotrans_inv_convex::invert_from_guess(const base_node& n,
+                                              base_node& n_ref,
+                                              bool &converged,
+                                              scalar_type IN_EPS,
+                                              bool project_into_element) {
+    assert(pgt);
+    converged = true;
+    if (pgt->is_linear()) {
+      n_ref.resize(pgt->structure()->dim());
+      return invert_lin(n, n_ref, IN_EPS);
+    }
+    bool use_guess = (n_ref.size() == pgt->structure()->dim());
+    n_ref.resize(pgt->structure()->dim());
+    return invert_nonlin(n, n_ref, IN_EPS, converged, false,
+                         project_into_element, use_guess);
+  }
+
   /* inversion for linear geometric transformations */
   bool geotrans_inv_convex::invert_lin(const base_node& n, base_node& n_ref,
                                        scalar_type IN_EPS) {
@@ -186,9 +203,11 @@ namespace bgeot
                                           scalar_type IN_EPS,
                                           bool &converged,
                                           bool /* throw_except */,
-                                          bool project_into_element) {
+                                          bool project_into_element,
+                                          bool use_guess) {
     converged = false;
-    base_node x0_ref(P), x0_real(N), diff(N);
+    base_node x0_ref(P), x0_real(N), diff(N), x_guess;
+    if (use_guess) x_guess = xref;
     scalar_type maxnormG = gmm::mat_maxnorm(G); // element size
     { // find initial guess
       x0_ref = pgt->geometric_nodes()[0];
@@ -224,9 +243,19 @@ namespace bgeot
         res0 = gmm::vect_dist2(pgt->transform(xref, G), xreal);
       }
 
-      if (res < res0) gmm::copy(x0_ref, xref);
-      if (res < IN_EPS)      // TODO: fix this too intrusive hack
-        xref *= 0.999888783; // For pyramid element to avoid the singularity
+      scalar_type resg = std::numeric_limits<scalar_type>::max();
+      if (use_guess) {
+        if (project_into_element) project_into_convex(x_guess, pgt);
+        resg = gmm::vect_dist2(pgt->transform(x_guess, G), xreal);
+      }
+
+      if (resg < std::min(res, res0))
+        gmm::copy(x_guess, xref);
+      else {
+        if (res < res0) gmm::copy(x0_ref, xref);
+        if (res < IN_EPS)      // TODO: fix this too intrusive hack
+          xref *= 0.999888783; // For pyramid element to avoid the singularity
+      }
     }
     
     add(pgt->transform(xref, G), gmm::scaled(xreal, -1.0), diff);
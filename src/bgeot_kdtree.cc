@@ -235,7 +235,127 @@ namespace bgeot {
     }
   }
 
-  void kdtree::clear_tree() { tree = std::unique_ptr<kdtree_elt_base>(); }
+  void kdtree::clear_tree() {
+    tree = std::unique_ptr<kdtree_elt_base>();
+    flat_nodes.clear(); flat_coords.clear();
+  }
+
+  /* copy of the tree into its flat version, in depth first order */
+  static size_type flatten_tree_(const kdtree_elt_base *t, unsigned dir,
+                                 size_type N, const kdtree_tab_type &pts,
+                                 std::vector<kdtree_flat_node> &nodes) {
+    if (!t) return size_type(-1);
+    size_type i = nodes.size();
+    nodes.push_back(kdtree_flat_node{scalar_type(0), size_type(-1),
+                                     size_type(-1), 0, 0, dir});
+    if (t->isleaf()) {
+      const kdtree_leaf *tl = static_cast<const kdtree_leaf*>(t);
+      nodes[i].first = std::distance(pts.begin(), tl->it);
+      nodes[i].nb = tl->n;
+    } else {
+      const kdtree_node *tn = static_cast<const kdtree_node*>(t);
+      nodes[i].split_v = tn->split_v;
+      size_type l = flatten_tree_(tn->left.get(), unsigned((dir+1)%N),
+                                  N, pts, nodes);
+      nodes[i].left = l;
+      size_type r = flatten_tree_(tn->right.get(), unsigned((dir+1)%N),
+                                  N, pts, nodes);
+      nodes[i].right = r;
+    }
+    return i;
+  }
+
+  void kdtree::build_flat_tree() {
+    if (tree == 0) tree = build_tree_(pts.begin(), pts.end(), 0);
+    if (!tree || !flat_nodes.empty()) return;
+    flatten_tree_(tree.get(), 0, N, pts, flat_nodes);
+    flat_coords.resize(pts.size() * N);
+    for (size_type i = 0; i < pts.size(); ++i)
+      std::copy(pts[i].n.begin(), pts[i].n.end(), flat_coords.begin()+i*N);
+  }
+
+  /* lookup for the points inside a given box on the flat tree, with the
+     same order of visit as points_in_box_ */
+  static void points_in_box_flat_(const std::vector<kdtree_flat_node> &nodes,
+                                  const std::vector<scalar_type> &coords,
+                                  const kdtree_tab_type &pts, size_type N,
+                                  const scalar_type *bmin,
+                                  const scalar_type *bmax,
+                                  std::vector<size_type> &stack,
+                                  std::vector<size_type> &ids) {
+    stack.resize(0);
+    stack.push_back(0);
+    while (!stack.empty()) {
+      const kdtree_flat_node &fn = nodes[stack.back()]; stack.pop_back();
+      if (fn.nb) {
+        const scalar_type *it = &(coords[fn.first*N]);
+        for (size_type i = fn.first; i < fn.first+fn.nb; ++i, it += N) {
+          bool is_in = true;
+          for (size_type k=0; k < N; ++k)
+            if (it[k] < bmin[k] || it[k] > bmax[k]) { is_in = false; break; }
+          if (is_in) ids.push_back(pts[i].i);
+        }
+      } else {
+        if (bmax[fn.dir] > fn.split_v && fn.right != size_type(-1))
+          stack.push_back(fn.right);
+        if (bmin[fn.dir] <= fn.split_v && fn.left != size_type(-1))
+          stack.push_back(fn.left);
+      }
+    }
+  }
+
+  void kdtree::points_in_boxes(const std::vector<base_node> &bmin,
+                               const std::vector<base_node> &bmax,
+                               std::vector<size_type> &idptr,
+                               std::vector<size_type> &idvec,
+                               bool parallel) {
+    GMM_ASSERT1(bmin.size() == bmax.size(), "Dimensions mismatch");
+    size_type nq = bmin.size();
+    idptr.assign(nq+1, 0); idvec.resize(0);
+    build_flat_tree();
+    if (flat_nodes.empty()) return;
+    for (size_type i = 0; i < nq; ++i)
+      GMM_ASSERT1(bmin[i].size() == N && bmax[i].size() == N,
+                  "Dimensions mismatch");
+
+    // Each partition searches for a contiguous range of boxes, the
+    // results are concatenated in the order of the boxes.
+    size_type nbchunks = 1;
+    if (parallel && !getfem::me_is_multithreaded_now())
+      nbchunks = std::max(size_type(1), std::min(nq,
+                          getfem::global_thread_policy::num_threads()));
+    std::vector<std::vector<size_type> > chunk_ids(nbchunks);
+    auto search_chunk = [&](size_type c) {
+      if (c >= nbchunks) return;
+      std::vector<size_type> stack, &ids = chunk_ids[c];
+      for (size_type i = (nq*c)/nbchunks; i < (nq*(c+1))/nbchunks; ++i) {
+        size_type n0 = ids.size();
+        bool empty_box = false;
+        for (size_type k = 0; k < N; ++k)
+          if (bmin[i][k] > bmax[i][k]) empty_box = true;
+        if (!empty_box)
+          points_in_box_flat_(flat_nodes, flat_coords, pts, N,
+                              &(*(bmin[i].const_begin())),
+                              &(*(bmax[i].const_begin())), stack, ids);
+        idptr[i+1] = ids.size() - n0;
+      }
+    };
+    if (nbchunks > 1) {
+      GETFEM_OMP_PARALLEL(
+        search_chunk(getfem::global_thread_policy::this_thread());
+      )
+    } else search_chunk(0);
+
+    for (size_type i = 0; i < nq; ++i) idptr[i+1] += idptr[i];
+    if (nbchunks == 1)
+      idvec.swap(chunk_ids[0]);
+    else {
+      idvec.resize(idptr[nq]);
+      auto it = idvec.begin();
+      for (const auto &ids : chunk_ids)
+        it = std::copy(ids.begin(), ids.end(), it);
+    }
+  }
 
   void kdtree::points_in_box(kdtree_tab_type &ipts,
 			     const base_node &min, 
@@ -21,6 +21,7 @@
 
 
 #include "getfem/bgeot_mesh_structure.h"
+#include <mutex>
 
 namespace bgeot {
 
@@ -45,6 +46,7 @@ namespace bgeot {
 
   void mesh_structure::swap_points(size_type i, size_type j) {
     if (i == j) return;
+    invalidate_connectivity();
     std::vector<size_type> doubles;
 
     for (size_type k = 0; k < points_tab[i].size(); ++k) {
@@ -67,6 +69,7 @@ namespace bgeot {
 
   void mesh_structure::swap_convex(size_type i, size_type j) {
     if (i == j) return;
+    invalidate_connectivity();
     std::vector<size_type> doubles;
 
     if (is_convex_valid(i))
@@ -98,6 +101,7 @@ namespace bgeot {
 
   void mesh_structure::sup_convex(size_type ic) {
     if (!(is_convex_valid(ic))) return;
+    invalidate_connectivity();
     for (size_type l = 0; l < convex_tab[ic].pts.size(); ++l) {
       size_type &ind = convex_tab[ic].pts[l];
       std::vector<size_type>::iterator it1= points_tab[ind].begin(), it2 = it1;
@@ -184,9 +188,57 @@ namespace bgeot {
       mems += convex_tab[i].pts.size() * sizeof(size_type);
     for (size_type i = 0; i < points_tab.size(); ++i)
       mems += points_tab[i].size() * sizeof(size_type);
+    pmesh_structure_connectivity pc = valid_connectivity();
+    if (pc) mems += pc->memsize();
     return mems;
   }
 
+  size_type mesh_structure_connectivity::memsize() const {
+    return sizeof(mesh_structure_connectivity)
+      + sizeof(size_type) * (cv_faces_ptr.size() + face_neighbor.size())
+      + sizeof(short_type) * face_neighbor_face.size();
+  }
+
+  pmesh_structure_connectivity mesh_structure::connectivity() const {
+    pmesh_structure_connectivity pc = valid_connectivity();
+    if (pc) return pc;
+    static std::mutex mtx;
+    std::lock_guard<std::mutex> lock(mtx);
+    pc = valid_connectivity();
+    if (pc) return pc;
+
+    auto c = std::make_shared<mesh_structure_connectivity>();
+    size_type ncv = nb_convex() ? nb_allocated_convex() : 0;
+    c->cv_faces_ptr.assign(ncv+1, 0);
+    for (dal::bv_visitor cv(convex_index()); !cv.finished(); ++cv)
+      c->cv_faces_ptr[cv+1] = nb_faces_of_convex(cv);
+    for (size_type cv = 0; cv < ncv; ++cv)
+      c->cv_faces_ptr[cv+1] += c->cv_faces_ptr[cv];
+
+    // Same search as neighbor_of_convex and adjacent_face, done once.
+    size_type nbf = c->cv_faces_ptr[ncv];
+    c->face_neighbor.assign(nbf, size_type(-1));
+    c->face_neighbor_face.assign(nbf, short_type(-1));
+    for (dal::bv_visitor cv(convex_index()); !cv.finished(); ++cv) {
+      for (short_type f = 0; f < nb_faces_of_convex(cv); ++f) {
+        ind_pt_face_ct pt = ind_points_of_face_of_convex(cv, f);
+        if (pt.size() == 0) continue;
+        size_type icv = neighbor_of_convex(cv, f);
+        if (icv == size_type(-1)) continue;
+        size_type k = c->cv_faces_ptr[cv] + f;
+        c->face_neighbor[k] = icv;
+        pconvex_structure pcs = structure_of_convex(icv);
+        for (short_type ff = 0; ff < pcs->nb_faces(); ++ff)
+          if (is_convex_face_having_points(icv, ff, pcs->nb_points_of_face(ff),
+                                           pt.begin()))
+            { c->face_neighbor_face[k] = ff; break; }
+      }
+    }
+    pc = c;
+    std::atomic_store(&pconn, pc);
+    return pc;
+  }
+
   void mesh_structure::optimize_structure() {
     size_type i, j = nb_convex();
     for (i = 0; i < j; i++)
@@ -202,6 +254,7 @@ namespace bgeot {
   }
 
   void mesh_structure::clear(void) {
+    invalidate_connectivity();
     points_tab = dal::dynamic_tas<ind_cv_ct, 8>();
     convex_tab = dal::dynamic_tas<mesh_convex_structure, 8>();
 
@@ -295,6 +348,8 @@ namespace bgeot {
 
   size_type mesh_structure::neighbor_of_convex(size_type ic,
                                                 short_type iff) const {
+    pmesh_structure_connectivity pc = valid_connectivity();
+    if (pc) return pc->neighbor_of_convex(ic, iff);
     ind_pt_face_ct pt = ind_points_of_face_of_convex(ic, iff);
 
     for (size_type i = 0; i < points_tab[pt[0]].size(); ++i) {
@@ -308,6 +363,14 @@ namespace bgeot {
   }
 
   convex_face mesh_structure::adjacent_face(size_type cv, short_type f) const {
+    pmesh_structure_connectivity pc = valid_connectivity();
+    if (pc) {
+      size_type icv = pc->neighbor_of_convex(cv, f);
+      short_type ff = pc->neighbor_face(cv, f);
+      if (icv == size_type(-1) || ff == short_type(-1))
+        return convex_face::invalid_face();
+      return {icv, ff};
+    }
     size_type neighbor_element = neighbor_of_convex(cv, f);
     if (neighbor_element == size_type(-1)) return convex_face::invalid_face();
     auto pcs = structure_of_convex(neighbor_element);
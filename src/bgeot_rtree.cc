@@ -185,6 +185,7 @@ namespace bgeot {
       GMM_WARNING3("Add a box when the tree is already built cancel the tree. "
                    "Unefficient operation.");
       tree_built = false; root = std::unique_ptr<rtree_elt_base>();
+      flat.clear();
     }
     bi.min = &nodes[nodes.add_node(min, EPS)];
     bi.max = &nodes[nodes.add_node(max, EPS)];
@@ -198,6 +199,7 @@ namespace bgeot {
 
   void rtree::clear() {
     root = std::unique_ptr<rtree_elt_base>();
+    flat.clear();
     boxes.clear();
     nodes.clear();
     tree_built = false;
@@ -277,6 +279,209 @@ namespace bgeot {
                            intersect_line_and_box(org, dirv, bmin, bmax, EPS));
   }
 
+  /* predicates for the searches on the flat tree, on raw bounds */
+  struct flat_has_point_p {
+    const scalar_type *P;
+    size_type N;
+    scalar_type EPS;
+    bool operator()(const scalar_type *min2, const scalar_type *max2) const {
+      for (size_type i = 0; i < N; ++i)
+        if (P[i] < min2[i]-EPS || P[i] > max2[i]+EPS) return false;
+      return true;
+    }
+  };
+
+  struct flat_intersection_p {
+    const scalar_type *min, *max;
+    size_type N;
+    scalar_type EPS;
+    bool operator()(const scalar_type *min2, const scalar_type *max2) const {
+      for (size_type i = 0; i < N; ++i)
+        if (max[i] < min2[i]-EPS || min[i] > max2[i]+EPS) return false;
+      return true;
+    }
+  };
+
+  /* depth first search on the flat tree with an explicit stack, the ids
+     of the matching boxes are appended to ids (with possible repetitions
+     for the boxes lying in several leaves). */
+  template <typename Predicate>
+  static void find_matching_flat_(const rtree_flat_tree &t,
+                                  const Predicate &p,
+                                  std::vector<size_type> &stack,
+                                  std::vector<size_type> &ids) {
+    if (t.nodes.empty()) return;
+    size_type N2 = 2*t.N;
+    stack.resize(0);
+    stack.push_back(0);
+    while (!stack.empty()) {
+      size_type i = stack.back(); stack.pop_back();
+      const scalar_type *b = &(t.node_bounds[N2*i]);
+      if (!p(b, b+t.N)) continue;
+      const rtree_flat_node &fn = t.nodes[i];
+      if (fn.nb) {
+        const scalar_type *bb = &(t.box_bounds[N2*fn.first]);
+        for (size_type j = fn.first; j < fn.first+fn.nb; ++j, bb += N2)
+          if (p(bb, bb+t.N)) ids.push_back(t.box_ids[j]);
+      } else {
+        stack.push_back(fn.right);
+        stack.push_back(i+1);
+      }
+    }
+  }
+
+  /* search for nq queries, pred_of(i) being the predicate of the query i,
+     into a compressed row storage. In parallel, each partition searches
+     for a contiguous range of queries and the results are concatenated
+     in the order of the queries. */
+  template <typename PredicateOf>
+  static void batched_search_(const rtree_flat_tree &t, size_type nq,
+                              const PredicateOf &pred_of,
+                              std::vector<size_type> &idptr,
+                              std::vector<size_type> &idvec, bool parallel) {
+    size_type nbchunks = 1;
+    if (parallel && !getfem::me_is_multithreaded_now())
+      nbchunks = std::max(size_type(1), std::min(nq,
+                          getfem::global_thread_policy::num_threads()));
+    std::vector<std::vector<size_type> > chunk_ids(nbchunks);
+    idptr.assign(nq+1, 0);
+
+    auto search_chunk = [&](size_type c) {
+      if (c >= nbchunks) return;
+      std::vector<size_type> stack, &ids = chunk_ids[c];
+      for (size_type i = (nq*c)/nbchunks; i < (nq*(c+1))/nbchunks; ++i) {
+        size_type n0 = ids.size();
+        find_matching_flat_(t, pred_of(i), stack, ids);
+        std::sort(ids.begin()+n0, ids.end());
+        ids.erase(std::unique(ids.begin()+n0, ids.end()), ids.end());
+        idptr[i+1] = ids.size() - n0;
+      }
+    };
+    if (nbchunks > 1) {
+      GETFEM_OMP_PARALLEL(
+        search_chunk(getfem::global_thread_policy::this_thread());
+      )
+    } else search_chunk(0);
+
+    for (size_type i = 0; i < nq; ++i) idptr[i+1] += idptr[i];
+    if (nbchunks == 1)
+      idvec.swap(chunk_ids[0]);
+    else {
+      idvec.resize(idptr[nq]);
+      auto it = idvec.begin();
+      for (const auto &ids : chunk_ids)
+        it = std::copy(ids.begin(), ids.end(), it);
+    }
+  }
+
+  static void flat_find_boxes_at_points(const rtree_flat_tree &flat,
+                                        scalar_type EPS,
+                                        const std::vector<base_node> &pts,
+                                        std::vector<size_type> &idptr,
+                                        std::vector<size_type> &idvec,
+                                        bool parallel) {
+    for (const base_node &P : pts)
+      GMM_ASSERT1(flat.nodes.empty() || P.size() == flat.N,
+                  "Dimensions mismatch");
+    batched_search_(flat, pts.size(), [&](size_type i) {
+        return flat_has_point_p{&(*(pts[i].const_begin())), flat.N, EPS};
+      }, idptr, idvec, parallel);
+  }
+
+  static void flat_find_intersecting_boxes(const rtree_flat_tree &flat,
+                                           scalar_type EPS,
+                                           const std::vector<base_node> &bmin,
+                                           const std::vector<base_node> &bmax,
+                                           std::vector<size_type> &idptr,
+                                           std::vector<size_type> &idvec,
+                                           bool parallel) {
+    GMM_ASSERT1(bmin.size() == bmax.size(), "Dimensions mismatch");
+    for (size_type i = 0; i < bmin.size(); ++i)
+      GMM_ASSERT1(flat.nodes.empty() || (bmin[i].size() == flat.N
+                                         && bmax[i].size() == flat.N),
+                  "Dimensions mismatch");
+    batched_search_(flat, bmin.size(), [&](size_type i) {
+        return flat_intersection_p{&(*(bmin[i].const_begin())),
+                                   &(*(bmax[i].const_begin())),
+                                   flat.N, EPS};
+      }, idptr, idvec, parallel);
+  }
+
+  void rtree::find_boxes_at_points(const std::vector<base_node> &pts,
+                                   std::vector<size_type> &idptr,
+                                   std::vector<size_type> &idvec,
+                                   bool parallel) const {
+    GMM_ASSERT1(tree_built, "Boxtree not initialised.");
+    flat_find_boxes_at_points(flat, EPS, pts, idptr, idvec, parallel);
+  }
+
+  void rtree::find_intersecting_boxes(const std::vector<base_node> &bmin,
+                                      const std::vector<base_node> &bmax,
+                                      std::vector<size_type> &idptr,
+                                      std::vector<size_type> &idvec,
+                                      bool parallel) const {
+    GMM_ASSERT1(tree_built, "Boxtree not initialised.");
+    flat_find_intersecting_boxes(flat, EPS, bmin, bmax, idptr, idvec,
+                                 parallel);
+  }
+
+  flat_rtree::flat_rtree(rtree &t) : EPS(t.EPS), nb_boxes_(0) {
+    t.build_tree();
+    nb_boxes_ = t.nb_boxes();
+    flat = t.flat;
+  }
+
+  void flat_rtree::find_boxes_at_points(const std::vector<base_node> &pts,
+                                        std::vector<size_type> &idptr,
+                                        std::vector<size_type> &idvec,
+                                        bool parallel) const
+  { flat_find_boxes_at_points(flat, EPS, pts, idptr, idvec, parallel); }
+
+  void flat_rtree::find_intersecting_boxes(const std::vector<base_node> &bmin,
+                                           const std::vector<base_node> &bmax,
+                                           std::vector<size_type> &idptr,
+                                           std::vector<size_type> &idvec,
+                                           bool parallel) const {
+    flat_find_intersecting_boxes(flat, EPS, bmin, bmax, idptr, idvec,
+                                 parallel);
+  }
+
+  void flat_rtree::refit(const std::vector<base_node> &bmin,
+                         const std::vector<base_node> &bmax) {
+    GMM_ASSERT1(bmin.size() == bmax.size(), "Dimensions mismatch");
+    if (flat.nodes.empty()) return;
+    size_type N = flat.N, N2 = 2*N;
+    for (size_type j = 0; j < flat.box_ids.size(); ++j) {
+      size_type id = flat.box_ids[j];
+      GMM_ASSERT1(id < bmin.size() && bmin[id].size() == N
+                  && bmax[id].size() == N, "Dimensions mismatch");
+      scalar_type *bb = &(flat.box_bounds[N2*j]);
+      std::copy(bmin[id].begin(), bmin[id].end(), bb);
+      std::copy(bmax[id].begin(), bmax[id].end(), bb+N);
+    }
+
+    /* the children of a node follow it in the depth first order, so that
+       a backward loop updates them before their parent. */
+    for (size_type i = flat.nodes.size(); i-- > 0; ) {
+      const rtree_flat_node &fn = flat.nodes[i];
+      scalar_type *b = &(flat.node_bounds[N2*i]);
+      const scalar_type *b1, *b2, *b2_end;
+      if (fn.nb) {
+        b1 = &(flat.box_bounds[N2*fn.first]);
+        b2 = b1 + N2; b2_end = b1 + N2*fn.nb;
+      } else {
+        b1 = &(flat.node_bounds[N2*(i+1)]);
+        b2 = &(flat.node_bounds[N2*fn.right]); b2_end = b2 + N2;
+      }
+      std::copy(b1, b1+N2, b);
+      for (; b2 != b2_end; b2 += N2)
+        for (size_type k = 0; k < N; ++k) {
+          b[k] = std::min(b[k], b2[k]);
+          b[N+k] = std::max(b[N+k], b2[N+k]);
+        }
+    }
+  }
+
   /*
      try to split at the approximate center of the box. Could be much more
      sophisticated
@@ -359,6 +564,31 @@ namespace bgeot {
     }
   }
 
+  /* copy of the tree into its flat version, in depth first order */
+  static void flatten_tree_(const rtree_elt_base *p, rtree_flat_tree &t) {
+    size_type i = t.nodes.size();
+    t.nodes.push_back(rtree_flat_node{0, 0, 0});
+    t.node_bounds.insert(t.node_bounds.end(), p->rmin.begin(), p->rmin.end());
+    t.node_bounds.insert(t.node_bounds.end(), p->rmax.begin(), p->rmax.end());
+    if (p->isleaf()) {
+      const rtree_leaf *rl = static_cast<const rtree_leaf*>(p);
+      t.nodes[i].first = t.box_ids.size();
+      t.nodes[i].nb = rl->lst.size();
+      for (const box_index *pbi : rl->lst) {
+        t.box_bounds.insert(t.box_bounds.end(),
+                            pbi->min->begin(), pbi->min->end());
+        t.box_bounds.insert(t.box_bounds.end(),
+                            pbi->max->begin(), pbi->max->end());
+        t.box_ids.push_back(pbi->id);
+      }
+    } else {
+      const rtree_node *rn = static_cast<const rtree_node*>(p);
+      flatten_tree_(rn->left.get(), t);
+      t.nodes[i].right = t.nodes.size();
+      flatten_tree_(rn->right.get(), t);
+    }
+  }
+
   void rtree::build_tree() {
     if (!tree_built) {
       if (boxes.size() == 0) { tree_built = true; return; }
@@ -372,6 +602,9 @@ namespace bgeot {
         *b_it++ = &(*it);
       }
       root = build_tree_(b, bmin, bmax, 0);
+      flat.clear();
+      flat.N = bmin.size();
+      flatten_tree_(root.get(), flat);
       tree_built = true;
     }
   }
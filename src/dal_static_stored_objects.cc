@@ -408,24 +408,140 @@ namespace dal {
     return num_objects;
   }
 
+/**
+  STORED_OBJECT_INDEX -----------------------------------------------------
+*/
+
+  static size_t stored_key_hash(const static_stored_object_key &k)
+  { return hash_combine(typeid(k).hash_code(), k.hash()); }
+
+  /* Hash index of the keys of a stored_object_tab, with chained buckets.
+     The chains are only modified by the writers (under the mutex of the
+     table) with atomic stores, so that a search may traverse them at
+     the same time. The removed nodes are kept in the list "retired" until
+     no search is running. */
+  struct stored_object_index {
+    struct node {
+      size_t h;
+      pstatic_stored_object_key k;
+      pstatic_stored_object p;
+      std::atomic<node *> next;
+      node(size_t hh, pstatic_stored_object_key kk, pstatic_stored_object pp)
+        : h(hh), k(kk), p(pp), next(nullptr) {}
+    };
+
+    size_t nb_buckets, nb_nodes;
+    std::unique_ptr<std::atomic<node *>[]> buckets;
+    std::vector<node *> retired;
+
+    std::atomic<node *> &bucket(size_t h) const
+    { return buckets[h & (nb_buckets-1)]; }
+
+    pstatic_stored_object find(const static_stored_object_key &k,
+                               size_t h) const {
+      for (node *n = bucket(h).load(std::memory_order_acquire); n;
+           n = n->next.load(std::memory_order_acquire))
+        if (n->h == h && !(k < *(n->k)) && !(*(n->k) < k)) return n->p;
+      return nullptr;
+    }
+
+    void insert(node *n) {
+      std::atomic<node *> &b = bucket(n->h);
+      n->next.store(b.load(std::memory_order_relaxed),
+                    std::memory_order_relaxed);
+      b.store(n, std::memory_order_release);
+      ++nb_nodes;
+    }
+
+    void erase(size_t h, const pstatic_stored_object &o) {
+      std::atomic<node *> *pn = &(bucket(h));
+      for (node *n = pn->load(); n; pn = &(n->next), n = pn->load())
+        if (n->p == o) {
+          pn->store(n->next.load(), std::memory_order_release);
+          retired.push_back(n);
+          --nb_nodes;
+          return;
+        }
+    }
+
+    void clear_retired() {
+      for (node *n : retired) delete n;
+      retired.clear();
+    }
+
+    explicit stored_object_index(size_t nb)
+      : nb_buckets(nb), nb_nodes(0), buckets(new std::atomic<node *>[nb]) {
+      for (size_t i = 0; i < nb; ++i) buckets[i].store(nullptr);
+    }
+
+    ~stored_object_index() {
+      clear_retired();
+      for (size_t i = 0; i < nb_buckets; ++i)
+        for (node *n = buckets[i].load(), *nn; n; n = nn)
+          { nn = n->next.load(); delete n; }
+    }
+  };
+
 /**
   STATIC_STORED_TAB -------------------------------------------------------
 */
   stored_object_tab::stored_object_tab()
     : std::map<enr_static_stored_object_key, enr_static_stored_object>(),
-      locks_{}, stored_keys_{}{
+      locks_{}, stored_keys_{}, index_(new stored_object_index(64)),
+      nb_searches_(0) {
       ON_STORED_DEBUG(dal_static_stored_tab_valid__ = true;)
     }
 
   stored_object_tab::~stored_object_tab(){
     ON_STORED_DEBUG(dal_static_stored_tab_valid__ = false;)
+    for (stored_object_index *idx : retired_indexes_) delete idx;
+    delete index_.load();
   }
 
   pstatic_stored_object
   stored_object_tab::search_stored_object(pstatic_stored_object_key k) const{
-    auto guard = locks_.get_lock();
-    auto it = find(enr_static_stored_object_key(k));
-    return (it != end()) ? it->second.p : nullptr;
+    size_t h = stored_key_hash(*k);
+    struct search_count {
+      std::atomic<size_t> &n;
+      search_count(std::atomic<size_t> &nn) : n(nn) { ++n; }
+      ~search_count() { --n; }
+    } count(nb_searches_);
+    return index_.load()->find(*k, h);
+  }
+
+  /* Frees the retired nodes and indexes if no search is running. They are
+     detached first since the destruction of a stored object may delete
+     other stored objects. */
+  void stored_object_tab::reclaim_() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (nb_searches_.load() != 0) return;
+    std::vector<stored_object_index *> indexes;
+    std::vector<stored_object_index::node *> nodes;
+    std::swap(indexes, retired_indexes_);
+    std::swap(nodes, index_.load()->retired);
+    for (stored_object_index::node *n : nodes) delete n;
+    for (stored_object_index *idx : indexes) delete idx;
+  }
+
+  void stored_object_tab::index_insert_(pstatic_stored_object_key k,
+                                        pstatic_stored_object o) {
+    stored_object_index *idx = index_.load();
+    if (idx->nb_nodes >= idx->nb_buckets) { // rehash in a new index
+      stored_object_index *idx2 = new stored_object_index(2*idx->nb_buckets);
+      for (size_t i = 0; i < idx->nb_buckets; ++i)
+        for (auto n = idx->buckets[i].load(); n; n = n->next.load())
+          idx2->insert(new stored_object_index::node(n->h, n->k, n->p));
+      index_.store(idx2);
+      retired_indexes_.push_back(idx);
+      idx = idx2;
+    }
+    idx->insert(new stored_object_index::node(stored_key_hash(*k), k, o));
+    reclaim_();
+  }
+
+  void stored_object_tab::index_erase_(const static_stored_object_key &k,
+                                       const pstatic_stored_object &o) {
+    index_.load()->erase(stored_key_hash(k), o);
   }
 
   bool stored_object_tab::add_dependency_(pstatic_stored_object o1,
@@ -446,8 +562,9 @@ namespace dal {
     GMM_ASSERT1(stored_keys_.find(o) == stored_keys_.end(),
       "This object has already been stored, possibly with another key");
     stored_keys_[o] = k;
-    insert(std::make_pair(enr_static_stored_object_key(k),
-                          enr_static_stored_object(o, perm)));
+    if (insert(std::make_pair(enr_static_stored_object_key(k),
+                              enr_static_stored_object(o, perm))).second)
+      index_insert_(k, o);
     auto t = singleton<stored_object_tab>::this_thread();
     GMM_ASSERT2(stored_keys_.size() == size() && t != size_t(-1),
       "stored_keys are not consistent with stored_object tab");
@@ -520,10 +637,12 @@ namespace dal {
           stored_keys_.erase(itk);
       }
       if (ito != end()){
+        index_erase_(*(ito->first.p), ito->second.p);
         erase(ito);
         it = to_delete.erase(it);
       } else ++it;
     }
+    reclaim_();
   }
 
 }/* end of namespace dal                                                             */
\ No newline at end of file
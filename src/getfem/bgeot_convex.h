@@ -195,6 +195,8 @@ namespace bgeot {
       auto poo_key = dal::key_of_stored_object(o.p);
       return *pkey == *poo_key;
     }
+    size_t hash() const override
+    { return std::hash<pconvex_structure>()(p); }
     special_convex_structure_key_(pconvex_structure pp) : p(pp) {}
   };
 
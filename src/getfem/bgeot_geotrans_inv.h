@@ -132,11 +132,22 @@ namespace bgeot {
     */
     bool invert(const base_node& n, base_node& n_ref, bool &converged, 
                 scalar_type IN_EPS=1e-12, bool project_into_element=false);
+
+    /**
+       Same as the previous function, except that for a non-linear
+       transformation, the value of n_ref on input is used as the initial
+       guess of the Newton iterations when it is closer to the solution
+       than the default one (warm start, for instance with the result of a
+       previous inversion of a close point).
+    */
+    bool invert_from_guess(const base_node& n, base_node& n_ref,
+                           bool &converged, scalar_type IN_EPS=1e-12,
+                           bool project_into_element=false);
   private:
     bool invert_lin(const base_node& n, base_node& n_ref, scalar_type IN_EPS);
     bool invert_nonlin(const base_node& n, base_node& n_ref,
                        scalar_type IN_EPS, bool &converged, bool throw_except,
-                       bool project_into_element);
+                       bool project_into_element, bool use_guess = false);
     bool update_B(); // returns true if successful
     void update_linearization(); // TODO: return success state
 
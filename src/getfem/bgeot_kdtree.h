@@ -66,6 +66,15 @@ namespace bgeot {
   /// store a set of points with associated indexes.
   typedef std::vector<index_node_pair> kdtree_tab_type;
 
+  /* Node of the flat copy of the kdtree. Missing children are
+     size_type(-1). A leaf (nb > 0) refers to the points [first, first+nb[
+     in the order of the tree. */
+  struct kdtree_flat_node {
+    scalar_type split_v;
+    size_type left, right, first, nb;
+    unsigned dir;
+  };
+
   /** Balanced tree over a set of points.
 
   Once the tree have been built, it is possible to query very
@@ -135,8 +144,24 @@ namespace bgeot {
        pos and returns the square of the distance to this point*/
     scalar_type nearest_neighbor(index_node_pair &ipt,
                                  const base_node &pos);
+    /** Batched version of points_in_box: the indexes of the points lying
+        in the box [bmin[i], bmax[i]] are stored in
+        idvec[idptr[i]] ... idvec[idptr[i+1]-1] (compressed row storage),
+        in the order given by points_in_box. The search runs on a flat
+        copy of the tree (contiguous coordinates, no allocation per box).
+        With parallel = true, the boxes are shared out among the
+        partitions of the threads.
+    */
+    void points_in_boxes(const std::vector<base_node> &bmin,
+                         const std::vector<base_node> &bmax,
+                         std::vector<size_type> &idptr,
+                         std::vector<size_type> &idvec,
+                         bool parallel = false);
   private:
     typedef std::vector<size_type>::const_iterator ITER;
+    std::vector<kdtree_flat_node> flat_nodes;
+    std::vector<scalar_type> flat_coords; /* N values per point */
+    void build_flat_tree();
     void clear_tree();
   };
 }
@@ -38,6 +38,7 @@
 #define BGEOT_MESH_STRUCTURE_H__
 
 #include <set>
+#include <memory>
 #include "bgeot_convex_structure.h"
 #include "dal_tree_sorted.h"
 
@@ -63,6 +64,31 @@ namespace bgeot {
     static convex_face invalid_face() {return {size_type(-1), short_type(-1)};}
   };
 
+  /** Compact (CSR) face adjacency of a mesh_structure, built on demand by
+      mesh_structure::connectivity() and invalidated by any modification of
+      the structure. Convexes keep their indices in the mesh_structure
+      (invalid ones have no faces).
+  */
+  struct APIDECL mesh_structure_connectivity {
+    std::vector<size_type> cv_faces_ptr;        // convex -> its first face
+    std::vector<size_type> face_neighbor;       // face -> neighbor convex
+    std::vector<short_type> face_neighbor_face; // face -> face of neighbor
+
+    /// Number of faces of ic.
+    size_type nb_faces_of_convex(size_type ic) const
+    { return cv_faces_ptr[ic+1] - cv_faces_ptr[ic]; }
+    /// First neighbor of face f of ic (size_type(-1) if none).
+    size_type neighbor_of_convex(size_type ic, short_type f) const
+    { return face_neighbor[cv_faces_ptr[ic] + f]; }
+    /// Face of neighbor_of_convex(ic, f) adjacent to face f of ic.
+    short_type neighbor_face(size_type ic, short_type f) const
+    { return face_neighbor_face[cv_faces_ptr[ic] + f]; }
+    size_type memsize() const;
+  };
+
+  typedef std::shared_ptr<const mesh_structure_connectivity>
+  pmesh_structure_connectivity;
+
   /**@addtogroup mesh */
   ///@{
   /** Mesh structure definition.
@@ -83,6 +109,11 @@ namespace bgeot {
 
     dal::dynamic_tas<mesh_convex_structure, 8> convex_tab;
     point_ct points_tab;
+    mutable pmesh_structure_connectivity pconn;
+
+    void invalidate_connectivity() { pconn.reset(); }
+    pmesh_structure_connectivity valid_connectivity() const
+    { return std::atomic_load(&pconn); }
 
   public :
 
@@ -185,6 +216,15 @@ namespace bgeot {
                                                 short_type f) const;
 
     size_type memsize() const;
+    /** Return the compact face adjacency of the structure, building it if
+        the structure has been modified since the last call. Once built,
+        neighbor_of_convex and adjacent_face use it until the next
+        modification. The returned table stays valid after a modification
+        of the structure, but is then outdated. Thread safe.
+    */
+    pmesh_structure_connectivity connectivity() const;
+    /// True if the compact connectivity is built and up to date.
+    bool has_connectivity() const { return bool(valid_connectivity()); }
     /** Reorder the convex IDs and point IDs, such that there is no
         hole in their numbering. */
     void optimize_structure();
@@ -292,6 +332,7 @@ namespace bgeot {
     mesh_convex_structure s; s.cstruct = cs;
     size_type nb = cs->nb_points();
 
+    invalidate_connectivity();
     if (is != size_type(-1)) { sup_convex(is); convex_tab.add_to_index(is,s); }
     else is = convex_tab.add(s);
 
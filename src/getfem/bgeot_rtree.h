@@ -86,6 +86,28 @@ namespace bgeot {
     virtual ~rtree_elt_base() {}
   };
 
+  /* Node of the flat copy of the tree. The left child of an inner node i
+     is the node i+1 and its right child is the node `right`. A leaf
+     (nb > 0) refers to the box entries [first, first+nb[. */
+  struct rtree_flat_node {
+    size_type right, first, nb;
+  };
+
+  /* Flat copy of the tree, built with it, for the batched searches: the
+     nodes are in depth first order and the bounds (min then max, 2*N
+     values per node or per box entry) are stored contiguously. The boxes
+     lying in several leaves have one entry per leaf. */
+  struct rtree_flat_tree {
+    size_type N = 0;
+    std::vector<rtree_flat_node> nodes;
+    std::vector<scalar_type> node_bounds, box_bounds;
+    std::vector<size_type> box_ids;
+    void clear() {
+      N = 0; nodes.clear(); node_bounds.clear();
+      box_bounds.clear(); box_ids.clear();
+    }
+  };
+
   /** Balanced tree of n-dimensional rectangles.
    *
    * This is not a dynamic structure. Once a query has been made on the
@@ -164,6 +186,26 @@ namespace bgeot {
       pbox_set_to_idvec(bs, idvec);
     }
 
+    /** Batched version of find_boxes_at_point. The ids of the boxes
+        containing pts[i] are stored, sorted, in
+        idvec[idptr[i]] ... idvec[idptr[i+1]-1] (compressed row storage).
+        The search runs on the flat copy of the tree without allocation
+        per point. With parallel = true, the points are shared out among
+        the partitions of the threads. The tree has to be built.
+    */
+    void find_boxes_at_points(const std::vector<base_node> &pts,
+                              std::vector<size_type> &idptr,
+                              std::vector<size_type> &idvec,
+                              bool parallel = false) const;
+    /** Batched version of find_intersecting_boxes for the boxes
+        [bmin[i], bmax[i]], with the same output as find_boxes_at_points.
+    */
+    void find_intersecting_boxes(const std::vector<base_node> &bmin,
+                                 const std::vector<base_node> &bmax,
+                                 std::vector<size_type> &idptr,
+                                 std::vector<size_type> &idvec,
+                                 bool parallel = false) const;
+
     void dump();
     void build_tree();
   private:
@@ -177,8 +219,54 @@ namespace bgeot {
     node_tab nodes;
     box_cont boxes;
     std::unique_ptr<rtree_elt_base> root;
+    rtree_flat_tree flat;
     bool tree_built;
     getfem::lock_factory locks_;
+
+    friend class flat_rtree;
+  };
+
+  /** Copy of the flat version of an rtree, which can be refitted to moved
+   *  boxes.
+   *
+   * The rtree it is copied from is not modified and keeps the bounds given
+   * to add_box, so that all its searches remain valid. Only the batched
+   * searches are available on the copy.
+   */
+  class flat_rtree {
+  public:
+    flat_rtree() : EPS(0), nb_boxes_(0) {}
+    /** Copy of the tree t, which is built if necessary. */
+    explicit flat_rtree(rtree &t);
+
+    size_type nb_boxes() const { return nb_boxes_; }
+
+    /** Same as rtree::find_boxes_at_points. */
+    void find_boxes_at_points(const std::vector<base_node> &pts,
+                              std::vector<size_type> &idptr,
+                              std::vector<size_type> &idvec,
+                              bool parallel = false) const;
+    /** Same as rtree::find_intersecting_boxes (batched version). */
+    void find_intersecting_boxes(const std::vector<base_node> &bmin,
+                                 const std::vector<base_node> &bmax,
+                                 std::vector<size_type> &idptr,
+                                 std::vector<size_type> &idvec,
+                                 bool parallel = false) const;
+
+    /** Refit to moved boxes: the box of id i gets the bounds
+        [bmin[i], bmax[i]] and the bounds of the nodes are recomputed
+        bottom-up, keeping the topology of the tree. This is much cheaper
+        than a new build, but the searches slow down when the boxes move
+        far from their initial places. The ids of the boxes have to be
+        less than bmin.size().
+    */
+    void refit(const std::vector<base_node> &bmin,
+               const std::vector<base_node> &bmax);
+
+  private:
+    scalar_type EPS;
+    size_type nb_boxes_;
+    rtree_flat_tree flat;
   };
 
 }
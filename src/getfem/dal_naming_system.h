@@ -99,6 +99,9 @@ namespace dal {
 	      return name == o.name;
       }
 
+      size_t hash() const override
+      { return std::hash<std::string>()(name); }
+
       method_key(const std::string &name_) : name(name_) {}
     };
 
@@ -127,6 +127,8 @@ namespace dal {
 
     ~singleton_instance() {
       if (!pointer()) return;
+      // the number of partitions may have grown since the creation
+      pointer()->on_thread_update();
       for(size_t i = 0; i != pointer()->num_threads(); ++i) {
         auto &p_singleton = (*pointer())(i);
         if(p_singleton){
@@ -72,6 +72,9 @@ std::shared_ptr are used.
 #include "dal_singleton.h"
 #include <set>
 #include <list>
+#include <map>
+#include <vector>
+#include <functional>
 
 
 #include "getfem/getfem_arch_config.h"
@@ -124,6 +127,13 @@ namespace dal {
     virtual bool equal(const static_stored_object_key &) const = 0;
 
   public :
+    /** Hash value used for the lookups of the stored objects. Two keys
+        which are equivalent for the order defined by compare should have
+        the same hash value. The default value is valid, but makes the
+        lookup linear in the number of stored keys of the same type, so it
+        should be overloaded. */
+    virtual size_t hash() const { return 0; }
+
     bool operator < (const static_stored_object_key &o) const {
       // comparaison des noms d'objet
       if (typeid(*this).before(typeid(o))) return true;
@@ -143,10 +153,32 @@ namespace dal {
     virtual ~static_stored_object_key() {}
   };
 
+  inline size_t hash_combine(size_t seed, size_t h)
+  { return seed ^ (h + 0x9e3779b9 + (seed << 6) + (seed >> 2)); }
+
+  /* Hash of the value of a simple_key. The types without std::hash
+     (and which are not pairs) have a zero hash. */
+  template <typename T, typename = void> struct key_hasher {
+    size_t operator()(const T &) const { return 0; }
+  };
+
+  template <typename T>
+  struct key_hasher<T, decltype(void(std::hash<T>()(std::declval<T>())))> {
+    size_t operator()(const T &a) const { return std::hash<T>()(a); }
+  };
+
+  template <typename T1, typename T2> struct key_hasher<std::pair<T1, T2> > {
+    size_t operator()(const std::pair<T1, T2> &a) const {
+      return hash_combine(key_hasher<T1>()(a.first),
+                          key_hasher<T2>()(a.second));
+    }
+  };
+
   template <typename var_type>
   class simple_key : virtual public static_stored_object_key {
     var_type a;
   public :
+    size_t hash() const override { return key_hasher<var_type>()(a); }
      bool compare(const static_stored_object_key &oo) const override {
       auto &o = dynamic_cast<const simple_key &>(oo);
       return a < o.a;
@@ -316,7 +348,14 @@ namespace dal {
 
 
 
-  /** Table of stored objects. Thread safe, uses thread specific mutexes. */
+  struct stored_object_index;
+
+  /** Table of stored objects. Thread safe, uses thread specific mutexes.
+      The searches by key do not lock: they use a hash index of the keys,
+      which is modified under the mutex. The nodes removed from the index
+      are freed only when no search is running on the table, so that the
+      objects which are deleted may survive until then.
+  */
   struct stored_object_tab :
     public std::map<enr_static_stored_object_key, enr_static_stored_object> {
 
@@ -358,6 +397,15 @@ namespace dal {
 
     getfem::lock_factory locks_;
     stored_key_tab stored_keys_;
+
+  private:
+    std::atomic<stored_object_index *> index_;
+    mutable std::atomic<size_t> nb_searches_; // searches running
+    std::vector<stored_object_index *> retired_indexes_;
+    void index_insert_(pstatic_stored_object_key k, pstatic_stored_object o);
+    void index_erase_(const static_stored_object_key &k,
+                      const pstatic_stored_object &o);
+    void reclaim_();
   };
 
 
@@ -0,0 +1,162 @@
+/* -*- c++ -*- (enables emacs c++ mode) */
+/*===========================================================================
+
+ Copyright (C) 2026 agent.
+
+ This file is a part of GetFEM
+
+ GetFEM  is  free software;  you  can  redistribute  it  and/or modify it
+ under  the  terms  of the  GNU  Lesser General Public License as published
+ by  the  Free Software Foundation;  either version 3 of the License,  or
+ (at your option) any later version along with the GCC Runtime Library
+ Exception either version 3.1 or (at your option) any later version.
+ This program  is  distributed  in  the  hope  that it will be useful,  but
+ WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ or  FITNESS  FOR  A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ License and GCC Runtime Library Exception for more details.
+ You  should  have received a copy of the GNU Lesser General Public License
+ along  with  this program. If not, see https://www.gnu.org/licenses/.
+
+ As a special exception, you  may use  this file  as it is a part of a free
+ software  library  without  restriction.  Specifically,  if   other  files
+ instantiate  templates  or  use macros or inline functions from this file,
+ or  you compile this  file  and  link  it  with other files  to produce an
+ executable, this file  does  not  by itself cause the resulting executable
+ to be covered  by the GNU Lesser General Public License.  This   exception
+ does not  however  invalidate  any  other  reasons why the executable file
+ might be covered by the GNU Lesser General Public License.
+
+===========================================================================*/
+
+/**@file getfem_binary_io.h
+   @author  agent <agent@local>
+   @date October 17, 2026.
+   @brief Versioned binary container used by the binary mesh and mesh_fem
+   files.
+
+   A binary file starts with a 24 bytes header (magic string, format
+   version, endianness tag and reserved word) followed by a sequence of
+   sections. Each section has a tag, a byte size and a payload made of
+   contiguous arrays, each array being padded to 8 bytes. Sections with an
+   unknown tag are skipped by the readers, which allows to extend the format
+   without breaking older files. Files are read through a memory map when
+   the platform allows it, so that the arrays can be used in place.
+*/
+
+#ifndef GETFEM_BINARY_IO_H__
+#define GETFEM_BINARY_IO_H__
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include "bgeot_config.h"
+
+namespace getfem {
+  using bgeot::size_type;
+  using bgeot::scalar_type;
+
+  /// Tags of the sections of the binary files.
+  enum binary_section_tag {
+    BINARY_END = 0,
+    BINARY_MESH_NODES = 1,       // dim, n, ids[n], coords[n*dim]
+    BINARY_MESH_GEOTRANS = 2,    // string table of geotrans names
+    BINARY_MESH_CONVEXES = 3,    // n, ids[n], types[n], ptr[n+1], pts[]
+    BINARY_MESH_REGION = 4,      // id, n, cvs[n], faces[n] (16 bits)
+    BINARY_MF_FEMS = 16,         // string table of fem names
+    BINARY_MF_CONVEXES = 17,     // qdim, n, ids[n], fems[n]
+    BINARY_MF_DOF_PARTITION = 18,// n, partition[n] (32 bits)
+    BINARY_MF_DOF_ENUMERATION = 19, // nb_dof, n, ptr[n+1], dofs[]
+    BINARY_MF_REDUCTION = 20     // R (csc) and E (csr) matrices
+  };
+
+  /// Current version of the binary format.
+  const gmm::uint32_type BINARY_FORMAT_VERSION = 1;
+
+  /// Return true if the file exists and is a GetFEM binary file.
+  bool APIDECL is_binary_file(const std::string &name);
+
+  /** Write a binary file section by section. Arrays are written in the
+      native byte order.
+  */
+  class APIDECL binary_file_writer {
+    std::ostream &ost;
+    std::streampos section_pos;
+    gmm::uint64_type section_size;
+    bool in_section;
+
+    void pad();
+
+  public :
+    void begin_section(binary_section_tag t);
+    void end_section();
+    void write_raw(const void *p, size_t nbytes);
+    void write(gmm::uint64_type v) { write_raw(&v, sizeof(v)); pad(); }
+    template <typename T> void write_array(const T *p, size_t n)
+    { write_raw(p, n * sizeof(T)); pad(); }
+    template <typename T> void write_array(const std::vector<T> &v)
+    { write_array(v.data(), v.size()); }
+    /// Write a table of strings (offsets followed by characters).
+    void write_strings(const std::vector<std::string> &s);
+
+    /// Write the header. The stream has to be opened in binary mode.
+    explicit binary_file_writer(std::ostream &o);
+    /// Write the end section.
+    ~binary_file_writer();
+  };
+
+  /** Read-only access to the sections of a binary file. The file is memory
+      mapped (or read in one block if memory mapping is not available) and
+      the arrays returned point directly into the mapped data.
+  */
+  class APIDECL binary_file_reader {
+  public :
+    /// Cursor on the payload of a section.
+    class section {
+      const char *p, *e;
+    public :
+      gmm::uint64_type read();
+      template <typename T> const T *read_array(size_t n)
+      { return reinterpret_cast<const T *>(read_raw(n * sizeof(T))); }
+      const char *read_raw(size_t nbytes);
+      std::vector<std::string> read_strings();
+      section(const char *b, const char *en) : p(b), e(en) {}
+    };
+
+  protected :
+    /* Memory mapping of the file, released by its destructor, including
+       when the constructor of the reader throws. */
+    struct file_mapping {
+      const char *data = nullptr;
+      size_t size = 0;
+      file_mapping() = default;
+      file_mapping(const file_mapping &) = delete;
+      file_mapping &operator =(const file_mapping &) = delete;
+      ~file_mapping();
+    };
+
+    std::string name_;
+    file_mapping mapping;
+    const char *data;
+    size_t size_;
+    std::vector<gmm::uint64_type> buffer; // if not memory mapped
+    struct section_info {
+      gmm::uint64_type tag; const char *begin, *end;
+    };
+    std::vector<section_info> sections;
+
+  public :
+    /// Number of sections having the tag t.
+    size_type nb_sections(binary_section_tag t) const;
+    /// i-th section having the tag t.
+    section get_section(binary_section_tag t, size_type i = 0) const;
+    const std::string &name() const { return name_; }
+
+    explicit binary_file_reader(const std::string &name);
+    binary_file_reader(const binary_file_reader &) = delete;
+    binary_file_reader &operator =(const binary_file_reader &) = delete;
+  };
+
+}  /* end of namespace getfem.                                             */
+
+
+#endif /* GETFEM_BINARY_IO_H__ */
@@ -488,8 +488,16 @@ namespace getfem {
         : ind_boundary(ib), ind_element(ie), ind_face(iff), mean_normal(n) {}
     };
 
-    bgeot::rtree element_boxes;                  // influence boxes
+    bgeot::flat_rtree element_boxes;             // influence boxes
     std::vector<influence_box> element_boxes_info;
+    // The tree of influence boxes is kept from a computation of the contact
+    // pairs to the next one. It is refitted to the moved boxes as long as
+    // they stay within boxes_rebuild_distance of their bounds at the last
+    // build, and rebuilt otherwise or if the set of master faces changes.
+    std::vector<base_node> element_boxes_min, element_boxes_max;
+    std::vector<base_node> built_boxes_min, built_boxes_max;
+    scalar_type boxes_rebuild_distance;
+    size_type nb_boxes_rebuilds, nb_boxes_refits;
 
     //
     // Stored points (for Delaunay and slave nodal boundaries)
@@ -524,10 +532,10 @@ namespace getfem {
     void normal_cone_simplification(void);
 
     bool test_normal_cones_compatibility(const normal_cone &nc1,
-                                         const normal_cone &nc2);
+                                         const normal_cone &nc2) const;
 
     bool test_normal_cones_compatibility(const base_small_vector &n,
-                                         const normal_cone &nc2);
+                                         const normal_cone &nc2) const;
 
     dal::bit_vector aux_dof_cv; // An auxiliary variable for are_dof_linked
     // function (in order to be of constant complexity).
@@ -627,6 +635,18 @@ namespace getfem {
 
     void clear_aux_info(void); // Delete auxiliary information
 
+    // Steps of compute_contact_pairs for the boundary point ip, nx being
+    // its unit normal vector. The projection on the master faces starts
+    // from the master point of the previous contact pair of the point, if
+    // any, and can be run in parallel on different points.
+    base_small_vector slave_normal(const boundary_point &bpinfo) const;
+    bool rigid_obstacle_contact_pair(size_type ip, const base_small_vector &nx,
+                                     contact_pair &ct);
+    void master_face_contact_pair(size_type ip, const base_small_vector &nx,
+                                  const contact_pair *previous,
+                                  contact_pair &ct, bool &found,
+                                  size_type &nbwarn) const;
+
   public:
 
     size_type dim(void) const { return N; }
@@ -668,6 +688,15 @@ namespace getfem {
     bool is_slave_boundary(size_type n) const { return contact_boundaries[n].slave; }
     void set_raytrace(bool b) { raytrace = b; }
     void set_nodes_mode(int m) { nodes_mode = m; }
+    // Displacement of the influence boxes beyond which their tree is
+    // rebuilt instead of refitted (the release distance by default).
+    void set_boxes_rebuild_distance(scalar_type d)
+    { boxes_rebuild_distance = d; }
+    // Number of builds and refits of the tree of influence boxes so far.
+    size_type nb_influence_boxes_rebuilds(void) const
+    { return nb_boxes_rebuilds; }
+    size_type nb_influence_boxes_refits(void) const
+    { return nb_boxes_refits; }
     size_type nb_contact_pairs(void) const { return contact_pairs.size(); }
     const contact_pair &get_contact_pair(size_type i)
     { return contact_pairs[i]; }
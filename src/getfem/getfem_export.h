@@ -63,6 +63,13 @@ namespace getfem {
       legacy and serial vtkUnstructuredGrid)
 
       A vtk_export can store multiple scalar/vector fields.
+
+      In the VTU format, binary data is by default base64 encoded inline.
+      With set_appended_data(), the arrays are instead gathered in a single
+      raw "AppendedData" section at the end of the file, optionally zlib
+      compressed. Independent pieces of a partitioned result (one per MPI
+      process or per thread) can be gathered with write_pvtu() and a time
+      series with pvd_export.
   */
   class vtk_export {
   protected:
@@ -78,6 +85,14 @@ namespace getfem {
     dim_type dim_;
     bool reverse_endian;
     std::vector<unsigned char> vals;
+    bool appended, compressed;
+    std::vector<unsigned char> appended_data;
+    struct data_array {
+      std::string name;
+      size_type nb_comp;
+      bool cell_data;
+    };
+    std::vector<data_array> data_arrays; // written datasets, for write_pvtu
     enum { EMPTY, HEADER_WRITTEN, STRUCTURE_WRITTEN, IN_CELL_DATA,
            IN_POINT_DATA } state;
 
@@ -87,6 +102,7 @@ namespace getfem {
     void write_separ();
     void clear_vals();
     void write_vals();
+    void write_format();
 
   public:
     vtk_export(const std::string& fname, bool ascii_ = false, bool vtk_= true);
@@ -101,7 +117,19 @@ namespace getfem {
        you can put whatever you want -- call this before any write_dataset
        or write_mesh */
     void set_header(const std::string& s);
+    /** VTU only: write the binary data (uncompressed, or zlib compressed
+        if compress is true) in raw form in an appended section instead of
+        base64 encoding it inline. Has to be called before anything is
+        written. The appended section is kept in memory and written when
+        the vtk_export object is destroyed. */
+    void set_appended_data(bool compress = false);
     void write_mesh();
+    /** VTU only: write a .pvtu file gathering the pieces of a partitioned
+        result. Each piece is a .vtu file (given relatively to the location
+        of the .pvtu file) which is supposed to contain the same datasets,
+        in the same order, as the ones written by this vtk_export. */
+    void write_pvtu(const std::string &pvtu_fname,
+                    const std::vector<std::string> &pieces) const;
 
     /** append a new scalar or vector field defined on mf to the .vtk/.vtu file.
         If you are exporting a slice, or if mf != get_exported_mesh_fem(), U
@@ -163,12 +191,8 @@ namespace getfem {
           for (size_type i=0; i < sizeof(v)/2; ++i)
             std::swap(p[i], p[sizeof(v)-i-1]);
         os.write(p, sizeof(T));
-      } else {
-        union { T value; unsigned char bytes[sizeof(T)]; } UNION;
-        UNION.value = v;
-        for (size_type i=0; i < sizeof(T); i++)
-          vals.push_back(UNION.bytes[i]);
-      }
+      } else
+        vals.insert(vals.end(), p, p + sizeof(T));
     }
   }
 
@@ -254,23 +278,30 @@ namespace getfem {
                 "inconsistency in the size of the dataset: "
                 << gmm::vect_size(U) << " != " << nb_val << "*" << Q);
     if (vtk) write_separ();
-    if (!vtk && !ascii) write_val(float(gmm::vect_size(U)));
+    size_type nb_comp = (Q == 1) ? 1 : ((Q <= 3) ? 3 : 9);
+    if (!vtk) {
+      data_arrays.push_back(data_array{remove_spaces(name), nb_comp,
+                                       cell_data});
+      if (!ascii) vals.reserve(nb_val * nb_comp * sizeof(float));
+    }
     if (Q == 1) {
       if (vtk)
         os << "SCALARS " << remove_spaces(name) << " float 1\n"
            << "LOOKUP_TABLE default\n";
-      else
-        os << "<DataArray type=\"Float32\" Name=\"" << remove_spaces(name) << "\" "
-           << (ascii ? "format=\"ascii\">\n" : "format=\"binary\">\n");
+      else {
+        os << "<DataArray type=\"Float32\" Name=\"" << remove_spaces(name) << "\" ";
+        write_format();
+      }
       for (size_type i=0; i < nb_val; ++i)
         write_val(float(U[i]));
     } else if (Q <= 3) {
       if (vtk)
         os << "VECTORS " << remove_spaces(name) << " float\n";
-      else
+      else {
         os << "<DataArray type=\"Float32\" Name=\"" << remove_spaces(name) << "\" "
-           << "NumberOfComponents=\"3\" "
-           << (ascii ? "format=\"ascii\">\n" : "format=\"binary\">\n");
+           << "NumberOfComponents=\"3\" ";
+        write_format();
+      }
       for (size_type i=0; i < nb_val; ++i)
         write_vec(U.begin() + i*Q, Q);
     } else if (Q == gmm::sqr(dim_)) {
@@ -279,10 +310,11 @@ namespace getfem {
        */
       if (vtk)
         os << "TENSORS " << remove_spaces(name) << " float\n";
-      else
+      else {
         os << "<DataArray type=\"Float32\" Name=\"" << remove_spaces(name)
-           << "\" NumberOfComponents=\"9\" "
-           << (ascii ? "format=\"ascii\">\n" : "format=\"binary\">\n");
+           << "\" NumberOfComponents=\"9\" ";
+        write_format();
+      }
       for (size_type i=0; i < nb_val; ++i)
         write_3x3tensor(U.begin() + i*Q);
     } else
@@ -300,6 +332,28 @@ namespace getfem {
     vtu_export(std::ostream &os_, bool ascii_ = false) : vtk_export(os_, ascii_, false) {}
   };
 
+  /** @brief ParaView .pvd collection of files, for time series.
+
+      Each call to add_time_step rewrites the .pvd file, so that it stays
+      valid during the computation. The files (.vtu or .pvtu) are given
+      relatively to the location of the .pvd file.
+   */
+  class pvd_export {
+    std::string fname;
+    struct pvd_dataset {
+      scalar_type time;
+      int part;
+      std::string file;
+    };
+    std::vector<pvd_dataset> datasets;
+  public:
+    pvd_export(const std::string &fname_) : fname(fname_) {}
+    /** add a file for the time t. Several files can be given for the same
+        time step with different part numbers. */
+    void add_time_step(scalar_type t, const std::string &file, int part = 0);
+    size_type nb_time_steps() const { return datasets.size(); }
+  };
+
   /** @brief A (quite large) class for exportation of data to IBM OpenDX.
 
                      http://www.opendx.org/
@@ -741,6 +741,89 @@ namespace getfem {
   };
 
 
+  /** Returns true if pf is a scalar tensor product of one dimensional
+      Lagrange elements (FEM_QK, FEM_QK_DISCONTINUOUS with the standard
+      nodes, FEM_PRODUCT of FEM_PK(1,k) ...), i.e. if the sum factorization
+      of fem_sum_factorization_ may apply to it.
+  */
+  bool is_tensor_product_fem(pfem pf);
+
+  class fem_sum_factorization_;
+  typedef std::shared_ptr<const fem_sum_factorization_>
+  pfem_sum_factorization;
+
+  /**
+     Sum factorization of a tensor product finite element on a tensor
+     product set of points (the interior points of IM_GAUSS_PARALLELEPIPED
+     for instance). The values and the gradients on the reference element
+     of a field are computed at all the points at once by applying the one
+     dimensional base function matrices dimension by dimension. This costs
+     O(N (k+1)^(N+1)) operations per component instead of the
+     O((k+1)^(2N)) operations needed with the complete tables of
+     fem_precomp_.
+
+     The transposed operations accumulate the integrals against the base
+     functions (the test functions of a residual) of some values or
+     reference gradient coefficients given at the points, with the same
+     complexity.
+
+     Coefficients and results have the component as fastest index:
+     coeff[q + Q*j] for the base function j, val[q + Q*i] for the
+     point i and grad[q + Q*(i + nb_points()*k)] for the derivative with
+     respect to the k-th reference coordinate.
+  */
+  class fem_sum_factorization_ : virtual public dal::static_stored_object {
+  protected:
+    dim_type N;
+    size_type nbpt;
+    std::vector<size_type> nd, nq;  // 1D base functions and points by dim.
+    std::vector<base_matrix> B, D;  // 1D values and derivatives (nq x nd)
+    std::vector<size_type> dof_grid, point_grid;
+    bool valid;
+
+    void apply(const base_vector &coeff, size_type Q, size_type kder,
+               scalar_type *res, base_vector &w1, base_vector &w2) const;
+    void apply_transposed(const scalar_type *val, size_type Q,
+                          size_type kder, base_vector &coeff,
+                          base_vector &w1, base_vector &w2) const;
+  public:
+    /// false if the fem or the points have no tensor product structure.
+    bool is_valid() const { return valid; }
+    /// number of points on which the factorization is defined.
+    size_type nb_points() const { return nbpt; }
+    /// values of the field at all the points. w1 and w2 are work vectors.
+    void values(const base_vector &coeff, size_type Q, base_vector &val,
+                base_vector &w1, base_vector &w2) const;
+    /// gradients of the field on the reference element at all the points.
+    void ref_gradients(const base_vector &coeff, size_type Q,
+                       base_vector &grad,
+                       base_vector &w1, base_vector &w2) const;
+    /// coeff[q + Q*j] += sum_i val[q + Q*i] phi_j(x_i).
+    void add_transposed_values(const base_vector &val, size_type Q,
+                               base_vector &coeff, base_vector &w1,
+                               base_vector &w2) const;
+    /** coeff[q + Q*j] += sum_i sum_k grad[q + Q*(i + nb_points()*k)]
+        d_k phi_j(x_i), d_k being the derivative with respect to the k-th
+        reference coordinate. */
+    void add_transposed_ref_gradients(const base_vector &grad, size_type Q,
+                                      base_vector &coeff, base_vector &w1,
+                                      base_vector &w2) const;
+    fem_sum_factorization_(pfem pf, bgeot::pstored_point_tab pspt,
+                           size_type nbpt_);
+    ~fem_sum_factorization_()
+    { DAL_STORED_OBJECT_DEBUG_DESTROYED(this, "Fem_sum_factorization"); }
+  };
+
+  /** Returns the sum factorization of pf on the nbpt first points of pspt
+      (the interior points of an integration method), or a null pointer if
+      they do not have a compatible tensor product structure. The result
+      is cached as for fem_precomp.
+  */
+  pfem_sum_factorization fem_sum_factorization(pfem pf,
+                                               bgeot::pstored_point_tab pspt,
+                                               size_type nbpt);
+
+
   /** structure passed as the argument of fem interpolation
       functions. This structure can be partially filled (for example
       the xreal will be computed if needed as long as pgp+ii is known).
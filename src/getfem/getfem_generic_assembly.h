@@ -38,9 +38,13 @@
 #ifndef GETFEM_GENERIC_ASSEMBLY_H__
 #define GETFEM_GENERIC_ASSEMBLY_H__
 
+#include <array>
+#include <deque>
 #include <map>
+#include <tuple>
 #include "getfem/getfem_interpolation.h"
 #include "getfem/getfem_mesh_slice.h"
+#include "gmm/gmm_precond_diagonal.h"
 
 
 #ifdef _WIN32
@@ -54,6 +58,7 @@
 namespace getfem {
 
   struct ga_tree;
+  struct ga_instruction_set;
   class model;
   class ga_workspace;
 
@@ -254,6 +259,41 @@ namespace getfem {
   void ga_undefine_function(const std::string &name);
   bool ga_function_exists(const std::string &name);
 
+  //=========================================================================
+  // Positions of the element contributions in the stored entries of an
+  // assembled matrix whose sparsity pattern is kept from one assembly to
+  // the next (see model::set_reuse_tangent_matrix_pattern).
+  //=========================================================================
+
+  struct ga_matrix_slots {
+    // Index of each entry of the element matrices of an assembly term in
+    // the stored entries of its column (unsigned(-1) if the entry is not
+    // stored), in compressed row format: the positions of the element cv,
+    // in the order the term adds them, are pos[offset[cv]] ...
+    // pos[offset[cv+1]-1]. The terms are numbered in the order of their
+    // compilation.
+    struct term_slots {
+      std::vector<size_type> offset;
+      std::vector<unsigned> pos;
+      bool has_element(size_type cv) const
+      { return cv+1 < offset.size() && offset[cv] != offset[cv+1]; }
+    };
+    std::vector<term_slots> terms;
+
+    // Positions of the elements which are not in the tables yet, found
+    // by each thread during an assembly and added to the tables by
+    // merge(), out of the parallel sections.
+    struct recorded_slots {
+      std::vector<std::array<size_type, 3> > elts; // (term, cv, nb of pos)
+      std::vector<unsigned> pos;
+      bool outdated = false; // the sequence of element matrices changed
+    };
+    omp_distribute<recorded_slots> recorded;
+
+    void merge();
+    void clear();
+  };
+
   //=========================================================================
   // Structure dealing with user defined environment : constant, variables,
   // functions, operators.
@@ -373,6 +413,36 @@ namespace getfem {
     base_tensor assemb_t;
     bool include_empty_int_pts = false;
 
+    // Compiled instruction sets kept from one call of assembly() to the
+    // next one when the compilation cache is enabled. The instructions are
+    // bound to the proxy targets below, whose content is swapped with the
+    // actual assembled matrices and vectors around each execution.
+    struct compilation_cache : public context_dependencies {
+      // key: order, condensation, 0 or 1 + partition in matrix-free mode
+      std::map<std::tuple<size_type, bool, size_type>,
+               std::shared_ptr<ga_instruction_set> > sets;
+      void update_from_context() const {}
+    };
+    bool use_compilation_cache = false;
+    std::shared_ptr<compilation_cache> ccache;
+    model_real_sparse_matrix K_proxy, KQJpr_proxy;
+    base_vector V_proxy;
+    void invalidate_compilation_cache() { ccache.reset(); }
+    std::shared_ptr<ga_instruction_set>
+    compiled_instruction_set(size_type order, bool condensation);
+
+    ga_matrix_slots *K_slots = nullptr;
+
+    // Vectors of the matrix-free mode (see matrix_free_product()). An
+    // instruction set is compiled for each partition of the elements, with
+    // mf_part set to its number, and adds the contributions of the
+    // partition to its own vectors *(mf_Y[mf_part]) and *(mf_D[mf_part]).
+    bool matrix_free = false;
+    size_type mf_part = 0;
+    const base_vector *mf_X = nullptr;
+    std::deque<base_vector *> mf_Y, mf_D; // stable references
+    std::vector<base_vector> mf_Yloc, mf_Dloc;
+
   public:
     // setter functions
     void set_assembled_matrix(model_real_sparse_matrix &K_) {
@@ -383,6 +453,20 @@ namespace getfem {
       V = std::shared_ptr<base_vector>
           (std::shared_ptr<base_vector>(), &V_); // alias
     }
+    /** The element matrices of the terms between non reduced fem
+        variables are added to the assembled matrix through the positions
+        of their entries recorded in slots. This is only efficient if the
+        sparsity pattern of the matrix does not change between two
+        assemblies. A null pointer disables the use of the slots. */
+    void set_assembled_matrix_slots(ga_matrix_slots *slots)
+    { K_slots = slots; }
+    ga_matrix_slots *const &assembled_matrix_slots() const { return K_slots; }
+    // getter functions for the matrix-free mode (internal use)
+    bool is_matrix_free() const { return matrix_free; }
+    const base_vector *const &matrix_free_input() const { return mf_X; }
+    base_vector *const &matrix_free_output() const { return mf_Y[mf_part]; }
+    base_vector *const &matrix_free_diagonal() const
+    { return mf_D[mf_part]; }
     // getter functions
     const model_real_sparse_matrix &assembled_matrix() const { return *K; }
     model_real_sparse_matrix &assembled_matrix() { return *K; }
@@ -540,8 +624,10 @@ namespace getfem {
     interpolate_transformation(const std::string &name) const;
 
     void add_elementary_transformation(const std::string &name,
-                                       pelementary_transformation ptrans)
-    { elem_transformations[name] = ptrans; }
+                                       pelementary_transformation ptrans) {
+      elem_transformations[name] = ptrans;
+      invalidate_compilation_cache();
+    }
 
     bool elementary_transformation_exists(const std::string &name) const;
 
@@ -563,6 +649,37 @@ namespace getfem {
 
     void assembly(size_type order, bool condensation=false);
 
+    /** Matrix-free application of the order 2 terms (tangent terms) of
+        the workspace: Y += K*X, and D += diag(K) if D is not null, where
+        X, Y and D are vectors on the primary dofs. The element matrices are
+        computed by the same compiled instructions as for assembly(2) but
+        are directly applied to X instead of being assembled, so that K is
+        never stored. Only the terms between non reduced fem variables and
+        without interpolate transformation are supported. The sums of
+        terms c*Grad_u:Grad_Test_u and c*u.Test_u of a variable on a
+        uniform tensor product fem, c being an optional scalar coefficient,
+        are applied by sum factorization, without computing the element
+        matrices, except for the diagonal. As for
+        the assembly, the partitions of the regions are processed in
+        parallel with OpenMP. It is advised to enable the compilation
+        cache when this function is called repeatedly (for instance in an
+        iterative solver). */
+    void matrix_free_product(const base_vector &X, base_vector &Y,
+                             base_vector *D = nullptr);
+
+    /** Keep the compiled instruction sets between two calls of assembly().
+        They are recompiled only when the expressions, variables or
+        transformations of the workspace change, or when one of the meshes,
+        mesh_fems, mesh_ims or im_datas involved is modified (context
+        dependencies). Changes made in a parent workspace or in the
+        structure of a model (added variables or bricks) are not detected,
+        clear_compilation_cache() has to be called in that case. */
+    void enable_compilation_cache(bool b = true)
+    { use_compilation_cache = b; invalidate_compilation_cache(); }
+    bool is_compilation_cache_enabled() const
+    { return use_compilation_cache; }
+    void clear_compilation_cache() { invalidate_compilation_cache(); }
+
     void set_include_empty_int_points(bool include);
     bool include_empty_int_points() const;
 
@@ -596,6 +713,69 @@ namespace getfem {
 
   };
 
+  /** Linear operator x -> K*x, K being the matrix of the order 2 terms of
+      the expressions of a workspace, applied without assembling K (see
+      ga_workspace::matrix_free_product()). It can be used in place of a
+      matrix in the iterative solvers of gmm (gmm::cg, gmm::gmres ...),
+      possibly with the Jacobi preconditioner given by jacobi_precond().
+      The compilation cache of the workspace is enabled so that the
+      expressions are compiled only once.
+  */
+  class ga_matrix_free_operator {
+    ga_workspace &workspace;
+    mutable base_vector X, Y;
+
+  public:
+    size_type nrows() const { return workspace.nb_primary_dof(); }
+    size_type ncols() const { return workspace.nb_primary_dof(); }
+
+    template <typename V1, typename V2> void mult(const V1 &x, V2 &y) const {
+      gmm::resize(X, gmm::vect_size(x)); gmm::copy(x, X);
+      gmm::resize(Y, gmm::vect_size(x)); gmm::clear(Y);
+      workspace.matrix_free_product(X, Y);
+      gmm::copy(Y, y);
+    }
+
+    /** Diagonal of K, computed elementwise. */
+    void diagonal(base_vector &D) const {
+      gmm::resize(X, nrows()); gmm::clear(X);
+      gmm::resize(Y, nrows()); gmm::clear(Y);
+      gmm::resize(D, nrows()); gmm::clear(D);
+      workspace.matrix_free_product(X, Y, &D);
+    }
+
+    /** Jacobi preconditioner built on the diagonal of K. */
+    void jacobi_precond
+    (gmm::diagonal_precond<model_real_sparse_matrix> &P) const {
+      base_vector D;
+      diagonal(D);
+      P.diag.resize(D.size());
+      for (size_type i = 0; i < D.size(); ++i) {
+        scalar_type d = gmm::abs(D[i]);
+        if (d == scalar_type(0)) {
+          d = scalar_type(1);
+          GMM_WARNING2("The matrix has a zero on its diagonal");
+        }
+        P.diag[i] = scalar_type(1) / d;
+      }
+    }
+
+    explicit ga_matrix_free_operator(ga_workspace &w) : workspace(w)
+    { w.enable_compilation_cache(); }
+  };
+
+  template <typename V1, typename V2> inline
+  void mult(const ga_matrix_free_operator &K, const V1 &x, V2 &y)
+  { K.mult(x, y); }
+
+  template <typename V1, typename V2> inline
+  void mult(const ga_matrix_free_operator &K, const V1 &x, const V2 &y)
+  { K.mult(x, const_cast<V2 &>(y)); }
+
+  template <typename V1, typename V2, typename V3> inline
+  void mult(const ga_matrix_free_operator &K, const V1 &x, const V2 &b,
+            V3 &y) { K.mult(x, y); gmm::add(b, y); }
+
   // Small tool to make basic substitutions into an assembly string
   std::string ga_substitute(const std::string &expr,
                             const std::map<std::string, std::string> &dict);
@@ -745,6 +925,11 @@ namespace getfem {
       CAUTION: For the moment, the derivative of the transformation with
       respect to any of these variables is not taken into account in the model
       solve.
+      If `cache_points` is true, the element of the target mesh and the
+      reference point found for each integration point are stored (one
+      cache per thread). They are reused as long as the expression gives
+      the same point, and are otherwise the starting point of the search.
+      The cache is cleared when one of the meshes is modified.
   */
   void add_interpolate_transformation_from_expression
   (ga_workspace &workspace, const std::string &transname,
@@ -752,14 +937,16 @@ namespace getfem {
   void add_interpolate_transformation_from_expression
   (ga_workspace &workspace, const std::string &transname,
    const mesh &source_mesh, const mesh &target_mesh,
-   size_type target_region, const std::string &expr);
+   size_type target_region, const std::string &expr,
+   bool cache_points = false);
   void add_interpolate_transformation_from_expression
   (model &md, const std::string &transname,
    const mesh &source_mesh, const mesh &target_mesh, const std::string &expr);
   void add_interpolate_transformation_from_expression
   (model &md, const std::string &transname,
    const mesh &source_mesh, const mesh &target_mesh,
-   size_type target_region, const std::string &expr);
+   size_type target_region, const std::string &expr,
+   bool cache_points = false);
 
   /** Add a transformation to the workspace that creates an identity mapping
       between two meshes in deformed state. Conceptually, it can be viewed
@@ -790,6 +977,13 @@ namespace getfem {
   */
   pinterpolate_transformation interpolate_transformation_neighbor_instance();
 
+  /** The same as above, but the inversions of the geometric transformation
+      done on the mesh `m` are cached for each integration point (one cache
+      per thread), until `m` is modified.
+  */
+  pinterpolate_transformation
+  interpolate_transformation_neighbor_instance(const mesh &m);
+
   /* Add a special interpolation transformation which represents the identity
      transformation but allows to evaluate the expression on another element
      than the current element by polynomial extrapolation. It is used for
@@ -94,6 +94,8 @@ namespace getfem {
     fem_precomp_pool fp_pool;
     std::map<gauss_pt_corresp, bgeot::pstored_point_tab> neighbor_corresp;
     std::set<std::pair<std::string,std::string>> unreduced_terms;
+    size_type nb_slot_terms = 0;   // Number of the matrix assembly terms
+                                   // in the slots of the workspace
 
     scalar_type ONE=1;
 
@@ -195,8 +197,13 @@ namespace getfem {
         instructions;        // Instructions executed on each
                              // integration/interpolation point
       std::map<scalar_type, std::list<pga_tree_node> > node_list;
+      // Last compiled product node (GA_DOT, GA_COLON or GA_MULT) with the
+      // instruction computing it.
+      const ga_tree_node *last_product_node;
+      const ga_instruction *last_product_instruction;
 
-      region_mim_instructions(): m(0), im(0) {}
+      region_mim_instructions()
+        : m(0), im(0), last_product_node(0), last_product_instruction(0) {}
     };
 
     std::list<ga_tree> trees; // The trees are stored mainly because they
@@ -79,6 +79,13 @@ namespace getfem {
        in Gmsh, that which does not occur in GetFEM since there is
        only one "type of region".
 
+       The ascii formats 1, 2 and 4 and the binary format 4.1 are
+       supported. For the format 4.1, the region of an element is the
+       first physical tag of its entity, given by the $Entities section
+       (or the entity tag if the entity has no physical tag). Binary
+       files are read by blocks and their nodes, identified by their
+       tag, are not merged with the existing ones.
+
 
       - "cdb" for meshes generated by ANSYS (in blocked format).
 
@@ -738,6 +738,108 @@ namespace getfem {
   }
 
 
+  /**
+     @brief Interpolation plan of mf_source on mf_target (different meshes).
+
+     For each point of the Lagrange target mesh_fem, the plan records the
+     source convex and the reference coordinates of the point in it, and
+     the corresponding rows of the interpolation matrix. The plan is built
+     in parallel over the points (the source convexes containing a point
+     are found with a batched search in an rtree of their bounding boxes,
+     and the inversions of the geometric transformations are done by each
+     thread on its own range of points). Applying the plan is then a
+     sparse matrix-vector product, without any point location or
+     inversion. The plan is rebuilt, at the next application, when one of
+     the two mesh_fems or meshes is modified.
+
+     The parameters are the ones of interpolation(mf_source, mf_target,
+     U, V, ...). With extrapolation = 2 the points which are outside the
+     source mesh are located afterwards by a mesh_trans_inv.
+     The source field should be continuous. Torus mesh_fems are not
+     supported.
+  */
+  class interpolation_plan : public context_dependencies {
+  protected :
+    const mesh_fem &mf_source, &mf_target;
+    int extrapolation;
+    scalar_type EPS;
+    mesh_region rg_source, rg_target;
+
+    mutable bool plan_built;
+    // For each target point: its id (basic dof of mf_target / qdim), its
+    // source convex (size_type(-1) if it has not been found) and its
+    // reference coordinates in this convex.
+    mutable std::vector<size_type> pt_ids, cv_of_pt;
+    mutable std::vector<base_node> ref_coords;
+    mutable dal::bit_vector missed_ids;
+    // Interpolation matrix in compressed row storage, the rows of the
+    // point i are i*qdim_s ... (i+1)*qdim_s-1 and the columns are the
+    // basic dofs of mf_source.
+    mutable std::vector<size_type> row_ptr, col_ind;
+    mutable std::vector<scalar_type> values;
+
+    void build() const;
+    void update_from_context() const { plan_built = false; }
+
+  public :
+
+    size_type nb_points() const { build(); return pt_ids.size(); }
+    /// Id of the target point i (basic dof of mf_target divided by qdim).
+    size_type id_of_point(size_type i) const { build(); return pt_ids[i]; }
+    /// Source convex of the target point i, size_type(-1) if not found.
+    size_type convex_of_point(size_type i) const
+    { build(); return cv_of_pt[i]; }
+    const base_node &reference_coords(size_type i) const
+    { build(); return ref_coords[i]; }
+    /// Ids of the target points which have not been found.
+    const dal::bit_vector &missed_points() const
+    { build(); return missed_ids; }
+
+    /** V = interpolation of U. The values of V at the target points
+        which have not been found are left unchanged.
+    */
+    template<typename VECTU, typename VECTV>
+    void apply(const VECTU &UU, VECTV &VV) const;
+
+    interpolation_plan(const mesh_fem &mf_source_,
+                       const mesh_fem &mf_target_, int extrapolation_ = 0,
+                       double EPS_ = 1E-10,
+                       mesh_region rg_source_=mesh_region::all_convexes(),
+                       mesh_region rg_target_=mesh_region::all_convexes());
+  };
+
+  template<typename VECTU, typename VECTV>
+  void interpolation_plan::apply(const VECTU &UU, VECTV &VV) const {
+    typedef typename gmm::linalg_traits<VECTU>::value_type T;
+    context_check(); build();
+    GMM_ASSERT1((gmm::vect_size(UU) % mf_source.nb_dof()) == 0
+                && (gmm::vect_size(VV) % mf_target.nb_dof()) == 0
+                && gmm::vect_size(VV) != 0, "Dimensions mismatch");
+    size_type qdim_s = mf_source.get_qdim();
+    size_type qqdim = gmm::vect_size(UU) / mf_source.nb_dof();
+    size_type qqdimt = qqdim * qdim_s / mf_target.get_qdim();
+    std::vector<T> U(mf_source.nb_basic_dof()*qqdim);
+    std::vector<T> V(mf_target.nb_basic_dof()*qqdimt);
+    mf_source.extend_vector(UU, U);
+    mf_target.extend_vector(VV, V);
+
+    std::vector<T> val(qqdim);
+    for (size_type i = 0; i < pt_ids.size(); ++i) {
+      if (cv_of_pt[i] == size_type(-1)) continue;
+      size_type pos = pt_ids[i] * qdim_s;
+      for (size_type k = 0; k < qdim_s; ++k) {
+        size_type r = i*qdim_s + k;
+        std::fill(val.begin(), val.end(), T(0));
+        for (size_type l = row_ptr[r]; l < row_ptr[r+1]; ++l)
+          for (size_type qq = 0; qq < qqdim; ++qq)
+            val[qq] += values[l] * U[col_ind[l]*qqdim+qq];
+        for (size_type qq = 0; qq < qqdim; ++qq)
+          V[(pos + k)*qqdim+qq] = val[qq];
+      }
+    }
+    mf_target.reduce_vector(V, VV);
+  }
+
   /**Interpolate mesh_fem data to im_data.
    The qdim of mesh_fem must be equal to im_data nb_tensor_elem.
    Both im_data and mesh_fem must reside in the same mesh.
@@ -51,6 +51,8 @@ namespace getfem {
   /* Version counter for convexes. */
   gmm::uint64_type APIDECL act_counter();
 
+  class binary_file_writer;
+  class binary_file_reader;
   class integration_method;
   typedef std::shared_ptr<const integration_method> pintegration_method;
 
@@ -120,6 +122,7 @@ namespace getfem {
 
     mutable bool cuthill_mckee_uptodate;
     dal::dynamic_array<gmm::uint64_type> cvs_v_num;
+    gmm::uint64_type v_num;
     mutable std::vector<size_type> cmk_order; // cuthill-mckee
     void init();
 
@@ -132,7 +135,7 @@ namespace getfem {
 
     void touch() {
       modified = true; cuthill_mckee_uptodate = false;
-      context_dependencies::touch();
+      v_num = act_counter(); context_dependencies::touch();
     }
     void compute_mpi_region() const ;
     void compute_mpi_sub_region(size_type) const;
@@ -150,7 +153,10 @@ namespace getfem {
     void intersect_with_mpi_region(mesh_region &rg) const;
 #else
     void touch()
-    { cuthill_mckee_uptodate = false; context_dependencies::touch(); }
+    {
+      cuthill_mckee_uptodate = false; v_num = act_counter();
+      context_dependencies::touch();
+    }
   public :
     const mesh_region get_mpi_region() const
     { return mesh_region::all_convexes(); }
@@ -214,6 +220,10 @@ namespace getfem {
     gmm::uint64_type convex_version_number(size_type ic) const
     { return cvs_v_num[ic]; }
 
+    /** return the version number of the mesh, changed each time the mesh
+        or one of its regions is modified. */
+    gmm::uint64_type version_number() const { return v_num; }
+
     /** Add a convex to the mesh.
         This methods assume that the convex nodes have already been
         added to the mesh.
@@ -475,6 +485,22 @@ namespace getfem {
         @see getfem::import_mesh.
     */
     void read_from_file(std::istream &ist);
+    /** Write the mesh to a binary file (see getfem_binary_io.h). The
+        point, convex and region numbering is kept as in the text format,
+        but the file is loaded without any parsing, through a memory map.
+        read_from_file(name) recognizes binary files.
+        @param name the file name.
+    */
+    void write_to_binary_file(const std::string &name) const;
+    /** Load the mesh from a binary file written by write_to_binary_file
+        or by mesh_fem::write_to_binary_file.
+        @param name the file name.
+    */
+    void read_from_binary_file(const std::string &name);
+    /// Write the mesh sections of a binary file.
+    void write_binary_sections(binary_file_writer &w) const;
+    /// Read the mesh sections of a binary file.
+    void read_binary_sections(const binary_file_reader &r);
     /** Clone a mesh */
     void copy_from(const mesh& m); /* might be the copy constructor */
     size_type memsize() const;
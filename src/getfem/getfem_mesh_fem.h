@@ -178,6 +178,10 @@ namespace getfem {
     std::vector<size_type> dof_partition;
     mutable gmm::uint64_type v_num_update, v_num;
     bool use_reduction;    /* A reduction matrix is applied or not.       */
+    bool hash_dof_enumeration; /* Algorithm used by enumerate_dof.        */
+
+    void enumerate_dof_kdtree() const;
+    bool enumerate_dof_hash() const;
 
   public :
     typedef base_node point_type;
@@ -549,6 +553,18 @@ namespace getfem {
     /** Renumber the degrees of freedom. You should not have
      * to call this function, as it is done automatically */
     virtual void enumerate_dof() const;
+    /** Select the algorithm used to enumerate the degrees of freedom.
+        The default one identifies the dofs shared by several elements with
+        a hash table keyed by the mesh points supporting each dof, the
+        element loop being parallelized. The original algorithm, which uses
+        a kd-tree per element, is used if b is false, for finite element
+        methods defined on the real element and for meshes mixing dimensions
+        or degrees of geometric transformations. Both give the same
+        numbering when the dofs shared by two elements have the same support
+        in both of them (conforming meshes).
+     */
+    void set_hash_dof_enumeration(bool b) { hash_dof_enumeration = b; }
+    bool is_hash_dof_enumeration() const { return hash_dof_enumeration; }
 
 #if GETFEM_PARA_LEVEL > 1
     void enumerate_dof_para()const;
@@ -635,6 +651,29 @@ namespace getfem {
         saved to the file.
     */
     void write_to_file(const std::string &name, bool with_mesh=false) const;
+    /* internal usage. */
+    void write_basic_binary_sections(binary_file_writer &w) const;
+    /* internal usage. */
+    void write_reduction_binary_section(binary_file_writer &w) const;
+    /** Write the mesh_fem sections of a binary file. */
+    virtual void write_binary_sections(binary_file_writer &w) const;
+    /** Read the mesh_fem sections of a binary file. */
+    virtual void read_binary_sections(const binary_file_reader &r);
+    /** Write the mesh_fem (fems, dof partition, dof enumeration and
+        reduction matrices) to a binary file (see getfem_binary_io.h).
+        read_from_file(name) recognizes binary files.
+
+        @param name the file name
+
+        @param with_mesh if set, then the linked_mesh() will also be
+        saved to the file.
+    */
+    void write_to_binary_file(const std::string &name,
+                              bool with_mesh=false) const;
+    /** Read the mesh_fem from a binary file. The dof enumeration stored
+        in the file is used as it is.
+        @param name the file name. */
+    void read_from_binary_file(const std::string &name);
   };
 
   /** Gives the descriptor of a classical finite element method of degree K
@@ -652,6 +691,25 @@ namespace getfem {
   /** Dummy mesh_fem for default parameter of functions. */
   const mesh_fem &dummy_mesh_fem();
 
+  /** Greedy coloring of the convexes of `cvs` such that two convexes of a
+      same color do not share any basic dof of the mesh_fems `mfs` (which
+      should be defined on the same mesh). The elements of a color can
+      then be assembled concurrently into shared matrices and vectors.
+      On output, `colors[c]` is the set of convexes of color c.
+  */
+  void color_convexes_by_dofs(const std::vector<const mesh_fem *> &mfs,
+                              const dal::bit_vector &cvs,
+                              std::vector<dal::bit_vector> &colors);
+
+  /** Near null space of the operators of elasticity on `mf`, to be used
+      by algebraic multigrid preconditioners (gmm::amg_precond): the
+      translations and infinitesimal rotations when the qdim of `mf` is
+      the dimension of its mesh, the constant fields of each component
+      otherwise. On output, the columns of `B` (of size mf.nb_dof())
+      are the modes.
+  */
+  void rigid_body_modes(const mesh_fem &mf, base_matrix &B);
+
 
   /** Given a mesh_fem @param mf and a vector @param vec of size equal to
    *  mf.nb_basic_dof(), the output vector @param coeff will contain the
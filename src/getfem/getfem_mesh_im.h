@@ -150,6 +150,16 @@ namespace getfem {
   /** Dummy mesh_im for default parameter of functions. */
   const mesh_im &dummy_mesh_im();
 
+  class mesh_fem;
+
+  /** Give cost balanced multithreaded partitions to the region `rg` of
+      the mesh of `mim`. The cost of an element is estimated as its number
+      of integration points times its number of local dofs on `mf` (if
+      given), and the partitions follow the Cuthill-McKee ordering of the
+      mesh. @see mesh_region::set_partition_costs */
+  void balance_region_partitions(mesh_region &rg, const mesh_im &mim,
+                                 const mesh_fem *mf = nullptr);
+
 }  /* end of namespace getfem.                                             */
 
 
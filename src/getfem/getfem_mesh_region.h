@@ -40,6 +40,7 @@
 #include <bitset>
 #include <iostream>
 #include <map>
+#include <vector>
 
 #include "dal_bit_vector.h"
 #include "bgeot_convex_structure.h"
@@ -60,10 +61,23 @@ namespace getfem {
 
     using const_iterator = map_t::const_iterator;
 
+    /* atomic counter which can be copied with the region data */
+    struct atomic_stamp : public std::atomic<size_type> {
+      atomic_stamp() : std::atomic<size_type>(0) {}
+      atomic_stamp(const atomic_stamp &s)
+        : std::atomic<size_type>(s.load(std::memory_order_acquire)) {}
+      atomic_stamp &operator =(const atomic_stamp &s)
+      { store(s.load(std::memory_order_acquire), std::memory_order_release);
+        return *this; }
+    };
+
     struct impl {
       mutable map_t m;
       mutable omp_distribute<dal::bit_vector> index_;
       mutable dal::bit_vector serial_index_;
+      mutable atomic_stamp stamp;       /* changed at each modification    */
+      std::vector<scalar_type> costs;   /* estimated cost of each convex   */
+      std::vector<size_type> cv_order;  /* traversal order for partitions  */
     };
     std::shared_ptr<impl> p;  /* the real region data */
 
@@ -82,20 +96,32 @@ namespace getfem {
                           a mesh (to provide feedback) */
 
 
-    //caching iterators for partitions
-    mutable omp_distribute<const_iterator> itbegin;
-    mutable omp_distribute<const_iterator> itend;
+    //partitions, computed once for all threads after each modification
+    //or change of the number of partitions: boundaries of equal size
+    //partitions of the region map, or the partitions themselves when costs
+    //have been given. part_owner, part_stamp and part_nb identify the
+    //region data, its version and the number of partitions they have been
+    //computed for. part_owner is published last (release) and read first
+    //(acquire), so that the partitions are complete when it is valid.
+    mutable std::vector<const_iterator> part_bounds;
+    mutable std::vector<map_t> part_maps;
+    mutable std::atomic<const impl *> part_owner;
+    mutable std::atomic<size_type> part_stamp;
+    mutable std::atomic<size_type> part_nb;
+
+    bool partitions_valid(size_type nb_parts) const;
 
     //flags for all the caches
     mutable omp_distribute<bool> index_updated;
-    mutable omp_distribute<bool> partitions_updated;
     mutable bool serial_index_updated;
 
     void mark_region_changed() const;
 
+    void invalidate_index() const;
+
     void update_index() const;
 
-    void update_partition_iterators() const;
+    void update_partitions() const;
 
     impl &wp() { return *p.get(); }
     const impl &rp() const { return *p.get(); }
@@ -178,6 +204,22 @@ namespace getfem {
 
     bool is_partitioning_allowed() const;
 
+    /** Use cost balanced partitions in multithreaded code. `costs[cv]` is
+    the estimated cost of the convex cv (convexes beyond the size of `costs`
+    have a unit cost). If `order` is not empty, partitions are cut as
+    contiguous chunks of this list of convexes (typically
+    mesh::cuthill_mckee_ordering()) to improve the cache reuse, instead of
+    the order of the convex numbers. Partitions are computed only once
+    after each modification of the region. Calling it with empty costs
+    restores the default partitions of equal size.
+    @see balance_region_partitions */
+    void set_partition_costs(const std::vector<scalar_type> &costs,
+                             const std::vector<size_type> &order
+                             = std::vector<size_type>());
+
+    bool has_partition_costs() const
+    { return p && !(rp().costs.empty()); }
+
     /** Extract the next region number
     that does not yet exists in the mesh*/
     static size_type free_region_id(const getfem::mesh& m);
@@ -98,6 +98,13 @@ namespace getfem {
       No output is produced by this object, the real output obtained
       with the side-effect of certain getfem::mesh_slicer objects
       (such as getfem::slicer_build_stored_mesh_slice).
+
+      When several threads are available, the leading actions which are
+      thread safe (see slicer_action::is_thread_safe) are applied in
+      parallel on blocks of convexes, each thread having its own nodes
+      and simplexes buffers. The remaining actions are then applied in
+      the order of the convexes, so that the output does not depend on
+      the number of threads.
   */
   class mesh_slicer {
     std::deque<slicer_action*> action; /* pointed actions are not deleted */
@@ -179,8 +186,20 @@ namespace getfem {
     const bgeot::mesh_structure &
     refined_simplex_mesh_for_convex_faces_cut_by_level_set(short_type f);
  
+    /* refinement of the current convex, kept from a convex to the next */
+    std::vector<base_node> cvm_pts;
+    const bgeot::basic_mesh *cvm;
+    const bgeot::mesh_structure *cvms;
+    bgeot::geotrans_precomp_pool gppool;
+    bgeot::pgeotrans_precomp pgp;
+    std::vector<slice_node::faces_ct> points_on_faces;
+    size_type prev_nrefine;
+    bool prev_discont;
+
     void update_cv_data(size_type cv_, short_type f_ = short_type(-1));
+    void init_convex(size_type cv_, short_type f_, short_type nrefine);
     void init_indexes();
+    void apply_actions(size_type i0, size_type i1);
     void apply_slicers();
   };
 
@@ -237,6 +256,10 @@ namespace getfem {
   public:
     static const float EPS;
     virtual void exec(mesh_slicer &ms) = 0;
+    /** Should return true if exec may be called concurrently on distinct
+        mesh_slicer objects, i.e. if the action has no side-effect and
+        keeps its scratch data per thread. */
+    virtual bool is_thread_safe() const { return false; }
     virtual ~slicer_action() {}
   };
 
@@ -245,6 +268,7 @@ namespace getfem {
   public:
     slicer_none() {}
     void exec(mesh_slicer &/*ms*/) {}
+    bool is_thread_safe() const { return true; }
     static slicer_none& static_instance();
   };
 
@@ -261,17 +285,22 @@ namespace getfem {
     slicer_boundary(const mesh& m,
                     slicer_action &sA = slicer_none::static_instance());
     void exec(mesh_slicer &ms);
+    bool is_thread_safe() const { return !A || A->is_thread_safe(); }
   };
 
   /* Apply a precomputed deformation to the slice nodes */
   class slicer_apply_deformation : public slicer_action {
     mesh_slice_cv_dof_data_base *defdata;
-    pfem pf;
-    fem_precomp_pool fprecomp;
-    std::vector<base_node> ref_pts;
+    struct deformation_data {
+      pfem pf;
+      std::unique_ptr<fem_precomp_pool> fprecomp;
+      std::vector<base_node> ref_pts;
+      deformation_data() : pf(0), fprecomp(new fem_precomp_pool) {}
+    };
+    omp_distribute<deformation_data> data; /* scratch data of each thread */
  public:
     slicer_apply_deformation(mesh_slice_cv_dof_data_base &defdata_) 
-      : defdata(&defdata_), pf(0) {
+      : defdata(&defdata_) {
       if (defdata &&
           defdata->pmf->get_qdim() != defdata->pmf->linked_mesh().dim()) 
         GMM_ASSERT1(false, "wrong Q(=" << int(defdata->pmf->get_qdim()) 
@@ -280,6 +309,7 @@ namespace getfem {
                     << int(defdata->pmf->linked_mesh().dim()));
     }
     void exec(mesh_slicer &ms);
+    bool is_thread_safe() const { return true; }
   };
 
   /**
@@ -299,18 +329,20 @@ namespace getfem {
         untils no simplex crosses the boundary
     */
     int orient;
-    dal::bit_vector pt_in, pt_bin;    
+    /* points inside the slice and on its boundary, for each thread */
+    omp_distribute<dal::bit_vector> pt_in, pt_bin;
     
     /** Overload either 'prepare' or 'test_point'.
      */
     virtual void prepare(size_type /*cv*/,
                          const mesh_slicer::cs_nodes_ct& nodes,
                          const dal::bit_vector& nodes_index) {
-      pt_in.clear(); pt_bin.clear();
+      dal::bit_vector &in_ = pt_in, &bin_ = pt_bin;
+      in_.clear(); bin_.clear();
       for (dal::bv_visitor i(nodes_index); !i.finished(); ++i) {
         bool in, bin; test_point(nodes[i].pt, in, bin);        
-        if (bin || ((orient > 0) ? !in : in)) pt_in.add(i);
-        if (bin) pt_bin.add(i);
+        if (bin || ((orient > 0) ? !in : in)) in_.add(i);
+        if (bin) bin_.add(i);
       }
     }
     virtual void test_point(const base_node&, bool& in, bool& bound) const
@@ -331,6 +363,7 @@ namespace getfem {
                        std::bitset<32> spbin);
   public:
     void exec(mesh_slicer &ms);
+    bool is_thread_safe() const { return true; }
   };
 
   /**
@@ -390,7 +423,7 @@ namespace getfem {
     std::unique_ptr<const mesh_slice_cv_dof_data_base> mfU;
     scalar_type val;
     scalar_type val_scaling; /* = max(abs(U)) */
-    std::vector<scalar_type> Uval;
+    omp_distribute<std::vector<scalar_type>> Uval;
     void prepare(size_type cv, const mesh_slicer::cs_nodes_ct& nodes,
                  const dal::bit_vector& nodes_index);
     scalar_type edge_intersect(size_type iA, size_type iB,
@@ -432,6 +465,8 @@ namespace getfem {
     slicer_union(const slicer_action &sA, const slicer_action &sB) : 
       A(&const_cast<slicer_action&>(sA)), B(&const_cast<slicer_action&>(sB)) {}
     void exec(mesh_slicer &ms);
+    bool is_thread_safe() const
+    { return A->is_thread_safe() && B->is_thread_safe(); }
   };
 
   /**
@@ -442,6 +477,8 @@ namespace getfem {
   public:
     slicer_intersect(slicer_action &sA, slicer_action &sB) : A(&sA), B(&sB) {}
     void exec(mesh_slicer &ms);
+    bool is_thread_safe() const
+    { return A->is_thread_safe() && B->is_thread_safe(); }
   };
 
   /**
@@ -452,6 +489,7 @@ namespace getfem {
   public:
     slicer_complementary(slicer_action &sA) : A(&sA) {}
     void exec(mesh_slicer &ms);
+    bool is_thread_safe() const { return A->is_thread_safe(); }
   };
   
   /**
@@ -516,6 +554,7 @@ namespace getfem {
     */
     slicer_explode(scalar_type c) : coef(c) {}
     void exec(mesh_slicer &ms);
+    bool is_thread_safe() const { return true; }
   };
 
 }
@@ -81,72 +81,151 @@ namespace getfem {
   struct abstract_linear_solver {
     typedef MAT MATRIX;
     typedef VECT VECTOR;
+    typedef gmm::csc_matrix<typename gmm::linalg_traits<MAT>::value_type>
+      CSC_MATRIX;
     virtual void operator ()(const MAT &, VECT &, const VECT &,
                              gmm::iteration &) const = 0;
+    /** Solve with a compressed sparse column copy MC of M, kept up to date
+        by the model (see model::set_reuse_tangent_matrix_pattern). The
+        solvers which only read the matrix work directly on MC, the others
+        on M.
+    */
+    virtual void operator ()(const MAT &M, const CSC_MATRIX &,
+                             VECT &x, const VECT &b,
+                             gmm::iteration &iter) const
+    { (*this)(M, x, b, iter); }
     virtual ~abstract_linear_solver() {}
   };
 
   template <typename MAT, typename VECT>
   struct linear_solver_cg_preconditioned_ildlt
     : public abstract_linear_solver<MAT, VECT> {
-    void operator ()(const MAT &M, VECT &x, const VECT &b,
-                     gmm::iteration &iter)  const {
-      gmm::ildlt_precond<MAT> P(M);
+    typedef typename abstract_linear_solver<MAT, VECT>::CSC_MATRIX CSC_MATRIX;
+    template <typename M2> void solve(const M2 &M, VECT &x, const VECT &b,
+                                      gmm::iteration &iter) const {
+      gmm::ildlt_precond<M2> P(M);
       gmm::cg(M, x, b, P, iter);
       if (!iter.converged()) GMM_WARNING2("cg did not converge!");
     }
+    void operator ()(const MAT &M, VECT &x, const VECT &b,
+                     gmm::iteration &iter)  const { solve(M, x, b, iter); }
+    void operator ()(const MAT &, const CSC_MATRIX &MC, VECT &x,
+                     const VECT &b, gmm::iteration &iter)  const
+    { solve(MC, x, b, iter); }
   };
 
+  /** Conjugate gradient preconditioned by a smoothed aggregation
+      algebraic multigrid (gmm::amg_precond), for large symmetric positive
+      definite problems. When pmf is given and describes all the dofs of
+      the system, its rigid body modes are used as near null space and
+      the components of its vector dofs are aggregated together.
+      The hierarchy is kept in the solver object and is built again only
+      when the matrix changes.
+  */
   template <typename MAT, typename VECT>
-  struct linear_solver_gmres_preconditioned_ilu
+  struct linear_solver_cg_preconditioned_amg
     : public abstract_linear_solver<MAT, VECT> {
+    typedef typename abstract_linear_solver<MAT, VECT>::CSC_MATRIX CSC_MATRIX;
+    const mesh_fem *pmf;
+    mutable gmm::amg_precond<MAT> P;
+    template <typename M2> void solve(const MAT &M, const M2 &MC, VECT &x,
+                                      const VECT &b,
+                                      gmm::iteration &iter) const {
+      if (!P.is_built_with(M)) {
+        if (pmf && pmf->nb_dof() == gmm::mat_nrows(M)) {
+          base_matrix B;
+          rigid_body_modes(*pmf, B);
+          P.build_with(M, B, pmf->is_reduced() ? 1 : pmf->get_qdim());
+        } else
+          P.build_with(M);
+      }
+      gmm::cg(MC, x, b, P, iter);
+      if (!iter.converged()) GMM_WARNING2("cg did not converge!");
+    }
     void operator ()(const MAT &M, VECT &x, const VECT &b,
-                     gmm::iteration &iter)  const {
-      gmm::ilu_precond<MAT> P(M);
+                     gmm::iteration &iter)  const { solve(M, M, x, b, iter); }
+    void operator ()(const MAT &M, const CSC_MATRIX &MC, VECT &x,
+                     const VECT &b, gmm::iteration &iter)  const
+    { solve(M, MC, x, b, iter); }
+    linear_solver_cg_preconditioned_amg(const mesh_fem *pmf_ = 0)
+      : pmf(pmf_) {}
+  };
+
+  template <typename MAT, typename VECT>
+  struct linear_solver_gmres_preconditioned_ilu
+    : public abstract_linear_solver<MAT, VECT> {
+    typedef typename abstract_linear_solver<MAT, VECT>::CSC_MATRIX CSC_MATRIX;
+    template <typename M2> void solve(const M2 &M, VECT &x, const VECT &b,
+                                      gmm::iteration &iter) const {
+      gmm::ilu_precond<M2> P(M);
       gmm::gmres(M, x, b, P, 500, iter);
       if (!iter.converged()) GMM_WARNING2("gmres did not converge!");
     }
+    void operator ()(const MAT &M, VECT &x, const VECT &b,
+                     gmm::iteration &iter)  const { solve(M, x, b, iter); }
+    void operator ()(const MAT &, const CSC_MATRIX &MC, VECT &x,
+                     const VECT &b, gmm::iteration &iter)  const
+    { solve(MC, x, b, iter); }
   };
 
   template <typename MAT, typename VECT>
   struct linear_solver_gmres_unpreconditioned
     : public abstract_linear_solver<MAT, VECT> {
-    void operator ()(const MAT &M, VECT &x, const VECT &b,
-                     gmm::iteration &iter)  const {
+    typedef typename abstract_linear_solver<MAT, VECT>::CSC_MATRIX CSC_MATRIX;
+    template <typename M2> void solve(const M2 &M, VECT &x, const VECT &b,
+                                      gmm::iteration &iter) const {
       gmm::identity_matrix P;
       gmm::gmres(M, x, b, P, 500, iter);
       if (!iter.converged()) GMM_WARNING2("gmres did not converge!");
     }
+    void operator ()(const MAT &M, VECT &x, const VECT &b,
+                     gmm::iteration &iter)  const { solve(M, x, b, iter); }
+    void operator ()(const MAT &, const CSC_MATRIX &MC, VECT &x,
+                     const VECT &b, gmm::iteration &iter)  const
+    { solve(MC, x, b, iter); }
   };
 
   template <typename MAT, typename VECT>
   struct linear_solver_gmres_preconditioned_ilut
     : public abstract_linear_solver<MAT, VECT> {
-    void operator ()(const MAT &M, VECT &x, const VECT &b,
-                     gmm::iteration &iter)  const {
-      gmm::ilut_precond<MAT> P(M, 40, 1E-7);
+    typedef typename abstract_linear_solver<MAT, VECT>::CSC_MATRIX CSC_MATRIX;
+    template <typename M2> void solve(const M2 &M, VECT &x, const VECT &b,
+                                      gmm::iteration &iter) const {
+      gmm::ilut_precond<M2> P(M, 40, 1E-7);
       gmm::gmres(M, x, b, P, 500, iter);
       if (!iter.converged()) GMM_WARNING2("gmres did not converge!");
     }
+    void operator ()(const MAT &M, VECT &x, const VECT &b,
+                     gmm::iteration &iter)  const { solve(M, x, b, iter); }
+    void operator ()(const MAT &, const CSC_MATRIX &MC, VECT &x,
+                     const VECT &b, gmm::iteration &iter)  const
+    { solve(MC, x, b, iter); }
   };
 
   template <typename MAT, typename VECT>
   struct linear_solver_gmres_preconditioned_ilutp
     : public abstract_linear_solver<MAT, VECT> {
-    void operator ()(const MAT &M, VECT &x, const VECT &b,
-                     gmm::iteration &iter)  const {
-      gmm::ilutp_precond<MAT> P(M, 20, 1E-7);
+    typedef typename abstract_linear_solver<MAT, VECT>::CSC_MATRIX CSC_MATRIX;
+    template <typename M2> void solve(const M2 &M, VECT &x, const VECT &b,
+                                      gmm::iteration &iter) const {
+      gmm::ilutp_precond<M2> P(M, 20, 1E-7);
       gmm::gmres(M, x, b, P, 500, iter);
       if (!iter.converged()) GMM_WARNING2("gmres did not converge!");
     }
+    void operator ()(const MAT &M, VECT &x, const VECT &b,
+                     gmm::iteration &iter)  const { solve(M, x, b, iter); }
+    void operator ()(const MAT &, const CSC_MATRIX &MC, VECT &x,
+                     const VECT &b, gmm::iteration &iter)  const
+    { solve(MC, x, b, iter); }
   };
 
 #if defined(GMM_USES_SUPERLU)
   template <typename MAT, typename VECT>
   struct linear_solver_superlu
     : public abstract_linear_solver<MAT, VECT> {
-    void operator ()(const MAT &M, VECT &x, const VECT &b,
-                     gmm::iteration &iter)  const {
+    typedef typename abstract_linear_solver<MAT, VECT>::CSC_MATRIX CSC_MATRIX;
+    template <typename M2> void solve(const M2 &M, VECT &x, const VECT &b,
+                                      gmm::iteration &iter) const {
       double rcond;
       /*gmm::HarwellBoeing_IO::write("test.hb", M);
       std::fstream f("bbb", std::ios::out);
@@ -155,6 +234,13 @@ namespace getfem {
       iter.enforce_converged(info == 0);
       if (iter.get_noisy()) cout << "condition number: " << 1.0/rcond<< endl;
     }
+    void operator ()(const MAT &M, VECT &x, const VECT &b,
+                     gmm::iteration &iter)  const { solve(M, x, b, iter); }
+    // SuperLU equilibrates its matrix: MC is still copied, but without
+    // any conversion.
+    void operator ()(const MAT &, const CSC_MATRIX &MC, VECT &x,
+                     const VECT &b, gmm::iteration &iter)  const
+    { solve(MC, x, b, iter); }
   };
 #endif
 
@@ -173,19 +259,74 @@ namespace getfem {
 #if defined(GMM_USES_MUMPS)
   template <typename MAT, typename VECT>
   struct linear_solver_mumps : public abstract_linear_solver<MAT, VECT> {
+    typedef typename abstract_linear_solver<MAT, VECT>::CSC_MATRIX CSC_MATRIX;
     void operator ()(const MAT &M, VECT &x, const VECT &b,
                      gmm::iteration &iter) const {
       bool ok = gmm::MUMPS_solve(M, x, b, false);
       iter.enforce_converged(ok);
     }
+    void operator ()(const MAT &, const CSC_MATRIX &MC, VECT &x,
+                     const VECT &b, gmm::iteration &iter) const {
+      bool ok = gmm::MUMPS_solve(MC, x, b, false);
+      iter.enforce_converged(ok);
+    }
   };
   template <typename MAT, typename VECT>
   struct linear_solver_mumps_sym : public abstract_linear_solver<MAT, VECT> {
+    typedef typename abstract_linear_solver<MAT, VECT>::CSC_MATRIX CSC_MATRIX;
     void operator ()(const MAT &M, VECT &x, const VECT &b,
                      gmm::iteration &iter) const {
       bool ok = gmm::MUMPS_solve(M, x, b, true);
       iter.enforce_converged(ok);
     }
+    void operator ()(const MAT &, const CSC_MATRIX &MC, VECT &x,
+                     const VECT &b, gmm::iteration &iter) const {
+      bool ok = gmm::MUMPS_solve(MC, x, b, true);
+      iter.enforce_converged(ok);
+    }
+  };
+
+  /** MUMPS solver keeping its analysis and factors from one call to the
+      next, for sequences of systems sharing a sparsity pattern (Newton
+      iterations, time steps). The analysis is redone only when the
+      pattern changes, otherwise only the numerical factorization is.
+      If reuse_factors is true, the factors of a previous tangent matrix
+      are first tried as a preconditioner of gmres on the new system,
+      starting from the given x (modified Newton), and the matrix is
+      factorized again only when gmres does not converge within
+      max_reuse_iter iterations. The state
+      lives in the solver object, which has to be kept between the calls
+      of standard_solve to be of any use.
+  */
+  template <typename MAT, typename VECT>
+  struct linear_solver_mumps_persistent
+    : public abstract_linear_solver<MAT, VECT> {
+    typedef typename gmm::linalg_traits<MAT>::value_type T;
+    mutable gmm::mumps_factorization<T> F;
+    bool reuse_factors;
+    size_type max_reuse_iter;
+    mutable size_type nb_reused_solves;
+
+    void operator ()(const MAT &M, VECT &x, const VECT &b,
+                     gmm::iteration &iter) const {
+      if (reuse_factors && F.is_factorized()
+          && F.nrows() == gmm::mat_nrows(M)) {
+        gmm::iteration iter_reuse(iter.get_resmax(), 0, max_reuse_iter);
+        gmm::gmres(M, x, b, F, max_reuse_iter, iter_reuse);
+        if (iter_reuse.converged()) {
+          ++nb_reused_solves;
+          iter.enforce_converged(true);
+          return;
+        }
+      }
+      bool ok = F.factorize(M) && F.solve(x, b);
+      iter.enforce_converged(ok);
+    }
+
+    linear_solver_mumps_persistent(bool sym = false, bool reuse = false,
+                                   size_type maxit = 10)
+      : F(sym), reuse_factors(reuse), max_reuse_iter(maxit),
+        nb_reused_solves(0) {}
   };
 #endif
 
@@ -689,11 +830,32 @@ namespace getfem {
 # endif
 #else
       GMM_ASSERT1(false, "Mumps is not interfaced");
+#endif
+    }
+    else if (bgeot::casecmp(name, "mumps_persistent") == 0 ||
+             bgeot::casecmp(name, "mumps_persistent/reuse") == 0) {
+#if defined(GMM_USES_MUMPS) && GETFEM_PARA_LEVEL <= 1
+      return std::make_shared<linear_solver_mumps_persistent<MATRIX, VECTOR>>
+        (md.is_symmetric(), bgeot::casecmp(name, "mumps_persistent") != 0);
+#else
+      GMM_ASSERT1(false, "Mumps is not interfaced or is distributed");
 #endif
     }
     else if (bgeot::casecmp(name, "cg/ildlt") == 0)
       return std::make_shared
         <linear_solver_cg_preconditioned_ildlt<MATRIX, VECTOR>>();
+    else if (bgeot::casecmp(name, "cg/amg") == 0) {
+      // The near null space is taken from the mesh_fem of the unknown
+      // when there is only one.
+      std::set<std::string> vl;
+      for (dal::bv_visitor ib(md.get_active_bricks()); !ib.finished(); ++ib)
+        for (const std::string &v : md.varnamelist_of_brick(ib))
+          if (!md.is_data(v)) vl.insert(v);
+      const mesh_fem *pmf = 0;
+      if (vl.size() == 1) pmf = md.pmesh_fem_of_variable(*(vl.begin()));
+      return std::make_shared
+        <linear_solver_cg_preconditioned_amg<MATRIX, VECTOR>>(pmf);
+    }
     else if (bgeot::casecmp(name, "gmres/ilu") == 0)
       return std::make_shared
         <linear_solver_gmres_preconditioned_ilu<MATRIX, VECTOR>>();
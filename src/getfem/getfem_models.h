@@ -132,6 +132,16 @@ namespace getfem {
     mutable bool act_size_to_be_done;
     dim_type leading_dim;
     getfem::lock_factory locks_;
+    bool colored_assembly_;
+    bool reuse_tangent_pattern_;
+    mutable bool tangent_pattern_valid_;
+    // positions of the element matrices in the stored entries of rTM
+    mutable ga_matrix_slots tangent_slots_;
+    // compressed copy of rTM for the linear solvers, when the pattern is kept
+    mutable gmm::csc_matrix<scalar_type> rTM_csc;
+    mutable bool rTM_csc_valid_;
+    void update_tangent_matrix_csc() const;
+    bool generic_assembly_cache_;
 
     // Variables and parameters of the model
 
@@ -383,12 +393,39 @@ namespace getfem {
 
     mutable std::list<gen_expr> generic_expressions;
 
+    // Workspaces kept from one assembly to the next (one per partition)
+    // with the generic expressions they have been built for.
+    mutable omp_distribute<std::shared_ptr<ga_workspace> > generic_workspaces;
+    mutable std::list<gen_expr> cached_generic_expressions;
+    void invalidate_generic_workspaces() const;
+    void update_generic_workspaces() const;
+
     // Groups of variables for interpolation on different meshes
     // generic assembly
     std::map<std::string, std::vector<std::string> > variable_groups;
 
     ga_macro_dictionary macro_dict;
-    
+
+    // Regions of the generic expressions restricted to each color of a
+    // coloring of the elements by dofs. Return false if the colored
+    // assembly cannot be applied to the current generic expressions.
+    // The result is kept in coloring_cache and only recomputed when the
+    // expressions or the version of a mesh or mesh_fem involved change.
+    const std::vector<std::vector<mesh_region> > *
+    colored_expression_regions() const;
+
+    struct coloring_cache_struct {
+      bool valid, colorable;
+      std::vector<std::string> exprs;
+      std::vector<const mesh_im *> mims;
+      std::vector<size_type> regions;
+      std::vector<std::pair<const mesh *, gmm::uint64_type> > meshes;
+      std::vector<std::pair<const mesh_fem *, gmm::uint64_type> > mfs;
+      std::vector<std::vector<mesh_region> > rgs;
+      bool is_up_to_date(const std::list<gen_expr> &ges) const;
+      coloring_cache_struct() : valid(false), colorable(false) {}
+    };
+    mutable coloring_cache_struct coloring_cache;
 
     virtual void actualize_sizes() const;
     bool check_name_validity(const std::string &name, bool assert=true) const;
@@ -457,7 +494,8 @@ namespace getfem {
       return (variable_groups.find(group_name))->second;
     }
 
-    void clear_assembly_assignments(void) { assignments.clear(); }
+    void clear_assembly_assignments(void)
+    { assignments.clear(); invalidate_generic_workspaces(); }
     void add_assembly_assignments(const std::string &dataname,
                                   const std::string &expr,
                                   size_type rg = size_type(-1),
@@ -920,6 +958,15 @@ namespace getfem {
       return internal ? internal_rTM : rTM;
     }
 
+    /** Compressed sparse column copy of the real tangent matrix, kept
+        when the pattern of the tangent matrix is reused (see
+        set_reuse_tangent_matrix_pattern()). Null if it is not up to date
+        with the last assembly of the tangent matrix. */
+    const gmm::csc_matrix<scalar_type> *real_tangent_matrix_csc() const {
+      context_check(); if (act_size_to_be_done) actualize_sizes();
+      return rTM_csc_valid_ ? &rTM_csc : nullptr;
+    }
+
     /** Gives the access to the tangent matrix. For the complex version. */
     const model_complex_sparse_matrix &complex_tangent_matrix() const {
       GMM_ASSERT1(complex_version, "This model is a real one");
@@ -1073,6 +1120,52 @@ namespace getfem {
     scalar_type get_init_time_step() const { return init_time_step; }
     int is_time_integration() const { return time_integration; }
     void set_time_integration(int ti) { time_integration = ti; }
+    /** Parallel assembly of the generic expressions with a coloring of the
+        elements: the elements of a color share no dof, so that they are
+        assembled by all the threads directly into the tangent matrix and
+        the right hand side, without a copy per thread and a final
+        reduction. The standard assembly is used when the coloring is not
+        applicable (test functions on reduced fems, on fixed size variables
+        or through interpolate transformations, secondary domains,
+        assignments and internal variables). Disabled by default.
+     */
+    void set_colored_assembly(bool b) { colored_assembly_ = b; }
+    bool is_colored_assembly() const { return colored_assembly_; }
+
+    /** Keep the sparsity pattern of the tangent matrix from one assembly
+        to the next while the dofs of the model do not change: the stored
+        values are only set to zero, and the positions of the entries of
+        each element matrix of the generic assembly terms in the stored
+        entries are recorded, so that the following assemblies add the
+        element contributions through these positions, without searching
+        the entries or reallocating the columns. This is interesting for
+        Newton and time stepping loops on a fixed mesh. Entries which
+        vanish remain stored as explicit zeros. A compressed sparse column
+        copy of the real tangent matrix is also kept, whose values only are
+        updated after each assembly (see real_tangent_matrix_csc()), and
+        which is given to the linear solvers of the model. Disabled by
+        default.
+     */
+    void set_reuse_tangent_matrix_pattern(bool b) {
+      reuse_tangent_pattern_ = b;
+      tangent_pattern_valid_ = rTM_csc_valid_ = false;
+    }
+    bool is_tangent_matrix_pattern_reused() const
+    { return reuse_tangent_pattern_; }
+
+    /** Keep the workspaces of the generic assembly, with their compiled
+        instructions, from one assembly to the next. The expressions of the
+        bricks are only compiled again when they change or when the dofs of
+        the model, a mesh, a mesh_fem or a mesh_im they depend on are
+        modified. This saves the compilation time in Newton and time
+        stepping loops with many expressions. Disabled by default.
+     */
+    void set_generic_assembly_cache(bool b) {
+      generic_assembly_cache_ = b;
+      invalidate_generic_workspaces();
+    }
+    bool is_generic_assembly_cache() const { return generic_assembly_cache_; }
+
     bool is_init_step() const { return init_step; }
     void cancel_init_step() { init_step = false; }
     void call_init_affine_dependent_variables(int version);
@@ -1109,6 +1202,7 @@ namespace getfem {
         GMM_ASSERT1(name.compare("neighbor_element"), "neighbor_element is a "
                     "reserved interpolate transformation name");
        transformations[name] = ptrans;
+       invalidate_generic_workspaces();
     }
 
     /** Get a pointer to the interpolate transformation `name`.
@@ -1132,6 +1226,7 @@ namespace getfem {
     void add_elementary_transformation(const std::string &name,
                                        pelementary_transformation ptrans) {
        elem_transformations[name] = ptrans;
+       invalidate_generic_workspaces();
     }
 
     /** Get a pointer to the elementary transformation `name`.
@@ -1159,6 +1254,7 @@ namespace getfem {
       if (interpolate_transformation_exists(name))
         GMM_ASSERT1(false, "An interpolate transformation with the same "
                     "name already exists");secondary_domains[name] = ptrans;
+      invalidate_generic_workspaces();
     }
 
     /** Get a pointer to the interpolate transformation `name`.
@@ -374,6 +374,13 @@ namespace getfem
 
   enum class thread_behaviour {true_threads, partition_threads};
 
+  /** Distribution of the partitions between the threads in parallel
+      sections: either a fixed set of partitions per thread, or partitions
+      pulled dynamically by the threads from a shared counter, which
+      balances elements of different costs when there are (much) more
+      partitions than threads.*/
+  enum class partition_scheduling {static_partitions, dynamic_partitions};
+
   /**
     A singleton that Manages partitions on individual threads.
   */
@@ -395,6 +402,18 @@ namespace getfem
        The later makes the partitioning independent of the number of the threads set*/
     void set_behaviour(thread_behaviour);
 
+    /**Sets the distribution of the partitions between the threads. Dynamic
+       scheduling is only meaningful with thread_behaviour::partition_threads
+       and a number of partitions larger than the number of threads
+       (see set_nb_partitions). Static scheduling is the default.*/
+    void set_scheduling(partition_scheduling);
+
+    partition_scheduling get_scheduling() const { return scheduling; }
+
+    /**Wall clock time spent by each thread in the last parallel execution.
+       It allows to measure the load imbalance between the threads.*/
+    const std::vector<double> &thread_times() const { return thread_times_; }
+
     /**active partition on the thread. If number of threads is equal to the
     max concurrency of the system, then it's also the index of the actual thread*/
     size_type get_current_partition() const;
@@ -413,6 +432,15 @@ namespace getfem
 
     void rewind_partitions();
 
+    /**next partition to be processed in dynamic scheduling,
+       or a value >= get_nb_partitions() when they are exhausted*/
+    size_type next_dynamic_partition();
+
+    /**record the time spent by the current thread, and report the
+       imbalance at the end of the parallel execution*/
+    void set_thread_time(double t);
+    void report_thread_times() const;
+
     //Parallel execution of a lambda. Please use the macros below
     friend void parallel_execution(std::function<void(void)> lambda, bool iterate_over_partitions);
 
@@ -429,6 +457,9 @@ namespace getfem
     omp_distribute<size_type, true_thread_policy> current_partition;
     std::atomic<size_type> nb_user_threads;
     thread_behaviour behaviour = thread_behaviour::partition_threads;
+    partition_scheduling scheduling = partition_scheduling::static_partitions;
+    std::atomic<size_type> dynamic_counter{0};
+    std::vector<double> thread_times_;
     std::atomic<bool> partitions_updated{false};
     size_type nb_partitions;
     bool partitions_set_by_user = false;
@@ -149,6 +149,9 @@ namespace getfem {
     { GMM_ASSERT1(false, "You cannot directly read this kind of mesh_fem"); }
     void write_to_file(std::ostream &ost) const;
     void write_to_file(const std::string &name, bool with_mesh=false) const;
+    void read_binary_sections(const binary_file_reader &)
+    { GMM_ASSERT1(false, "You cannot directly read this kind of mesh_fem"); }
+    void write_binary_sections(binary_file_writer &w) const;
 
     partial_mesh_fem(const mesh_fem &mef);
     partial_mesh_fem(const mesh_fem *mef);
@@ -17,1400 +17,1131 @@
  along  with  this program. If not, see https://www.gnu.org/licenses/.
 
 ===========================================================================*/
-
-
-#include "getfem/getfem_HHO.h"
-
-
-namespace getfem {
-
-  THREAD_SAFE_STATIC bgeot::geotrans_precomp_pool HHO_pgp_pool;
-  THREAD_SAFE_STATIC fem_precomp_pool HHO_pfp_pool;
-
-  // To be optimized:
-  // - The fact that (when pf2->target_dim() = 1) the
-  //   problem can be solved componentwise can be more exploited in
-  //   avoiding the computation of the whole matrix M2.
-  // - The vectorization can be avoided in most cases
-  // - Avoid some multiple ctx
-  
-
-  class _HHO_reconstructed_gradient
-    : public virtual_elementary_transformation {
-
-  public:
-
-    virtual void give_transformation(const mesh_fem &mf1, const mesh_fem &mf2,
-                                     size_type cv, base_matrix &M) const {
-
-      // The reconstructed Gradient "G" is described on mf2 and computed by
-      // the formula on the element T :
-      // \int_T G.w = \int_T Grad(v_T).w + \int_{dT}(v_{dT} - v_T).(w.n)
-      // where "w" is the test function arbitrary in mf2, "v_T" is the field
-      // inside the element whose gradient is to be reconstructed,
-      // "v_{dT}" is the field on the boundary of T and "n" is the outward
-      // unit normal.
-
-      // Obtaining the fem descriptors
-      pfem pf1 = mf1.fem_of_element(cv);
-      pfem pf2 = mf2.fem_of_element(cv);
-      pfem pfi = interior_fem_of_hho_method(pf1);
-
-      size_type degree = std::max(pf1->estimated_degree(),
-                                  pf2->estimated_degree());
-      bgeot::pgeometric_trans pgt = mf1.linked_mesh().trans_of_convex(cv);
-      papprox_integration pim
-        = classical_approx_im(pgt, dim_type(2*degree))->approx_method();
-
-      base_matrix G;
-      bgeot::vectors_to_base_matrix(G, mf1.linked_mesh().points_of_convex(cv));
-
-      bgeot::pgeotrans_precomp pgp
-        = HHO_pgp_pool(pgt, pim->pintegration_points());
-      pfem_precomp pfp1 = HHO_pfp_pool(pf1, pim->pintegration_points());
-      pfem_precomp pfp2 = HHO_pfp_pool(pf2, pim->pintegration_points());
-      pfem_precomp pfpi = HHO_pfp_pool(pfi, pim->pintegration_points());
-      
-      fem_interpolation_context ctx1(pgp, pfp1, 0, G, cv);
-      fem_interpolation_context ctx2(pgp, pfp2, 0, G, cv);
-      fem_interpolation_context ctxi(pgp, pfpi, 0, G, cv);
-
-      size_type Q = mf1.get_qdim(), N = mf1.linked_mesh().dim();
-      base_vector un(N);
-      size_type qmult1 =  Q / pf1->target_dim();
-      size_type ndof1 = pf1->nb_dof(cv) * qmult1;
-      size_type qmult2 =  Q*N / pf2->target_dim();
-      size_type ndof2 = pf2->nb_dof(cv) * qmult2;
-      size_type qmulti =  Q / pfi->target_dim();
-      size_type ndofi = pfi->nb_dof(cv) * qmulti;
-      
-      base_tensor t1, t2, ti, tv1;
-      base_matrix tv2, tv1p, tvi;
-      base_matrix M1(ndof2, ndof1), M2(ndof2, ndof2), M2inv(ndof2, ndof2);
-      base_matrix aux2(ndof2, ndof2);
-
-      // Integrals on the element : \int_T G.w (M2) and  \int_T Grad(v_T).w (M1)
-      for (size_type ipt = 0; ipt < pim->nb_points_on_convex(); ++ipt) {
-        ctx1.set_ii(ipt); ctx2.set_ii(ipt);
-        scalar_type coeff = pim->coeff(ipt) * ctx1.J();
-        
-        ctx1.grad_base_value(t1);
-        vectorize_grad_base_tensor(t1, tv1, ndof1, pf1->target_dim(), Q);
-
-        ctx2.base_value(t2);
-        vectorize_base_tensor(t2, tv2, ndof2, pf2->target_dim(), Q*N);
-       
-        gmm::mult(tv2, gmm::transposed(tv2), aux2);
-        gmm::add(gmm::scaled(aux2, coeff), M2);
-
-        for (size_type i = 0; i < ndof1; ++i) // To be optimized
-          for (size_type j = 0; j < ndof2; ++j)
-            for (size_type k = 0; k < Q*N; ++k)
-              M1(j, i) += coeff * tv1.as_vector()[i+k*ndof1] * tv2(j, k);
-      }
-
-      // Integrals on the faces : \int_{dT}(v_{dT} - v_T).(w.n) (M1)
-      for (short_type ifc = 0; ifc < pgt->structure()->nb_faces(); ++ifc) {
-        ctx1.set_face_num(ifc); ctx2.set_face_num(ifc); ctxi.set_face_num(ifc);
-        size_type first_ind = pim->ind_first_point_on_face(ifc);
-        for (size_type ipt = 0; ipt < pim->nb_points_on_face(ifc); ++ipt) {
-          ctx1.set_ii(first_ind+ipt);
-          ctx2.set_ii(first_ind+ipt);
-          ctxi.set_ii(first_ind+ipt);
-          scalar_type coeff = pim->coeff(first_ind+ipt) * ctx1.J();
-          gmm::mult(ctx1.B(), pgt->normals()[ifc], un);
-          
-          ctx2.base_value(t2);
-          vectorize_base_tensor(t2, tv2, ndof2, pf2->target_dim(), Q*N);
-
-          ctx1.base_value(t1);
-          vectorize_base_tensor(t1, tv1p, ndof1, pf1->target_dim(), Q);
-          
-          ctxi.base_value(ti);
-          vectorize_base_tensor(ti, tvi, ndofi, pfi->target_dim(), Q);
-          
-          for (size_type i = 0; i < ndof1; ++i) // To be optimized
-            for (size_type j = 0; j < ndof2; ++j)
-              for (size_type k1 = 0; k1 < Q; ++k1) {
-                scalar_type b(0), a = coeff *
-                  (tv1p(i, k1) - (i < ndofi ? tvi(i, k1) : 0.));
-                for (size_type k2 = 0; k2 < N; ++k2)
-                  b += a * tv2(j, k1 + k2*Q) * un[k2];
-                M1(j, i) += b;
-              }
-        }
-      }
-
-      if (pf2->target_dim() == 1) {
-        gmm::sub_slice I(0, ndof2/(N*Q), N*Q);
-        gmm::lu_inverse(gmm::sub_matrix(M2, I, I));
-        for (size_type i = 0; i < N*Q; ++i) {
-          gmm::sub_slice I2(i, ndof2/(N*Q), N*Q);
-          gmm::copy(gmm::sub_matrix(M2, I, I), gmm::sub_matrix(M2inv, I2, I2));
-        }
-      } else { gmm::copy(M2, M2inv); gmm::lu_inverse(M2inv); }
-      
-      gmm::mult(M2inv, M1, M);
-      gmm::clean(M, gmm::vect_norminf(M.as_vector()) * 1E-13);
-    }
-  };
-
-  void add_HHO_reconstructed_gradient(model &md, std::string name) {
-    pelementary_transformation
-      p = std::make_shared<_HHO_reconstructed_gradient>();
-    md.add_elementary_transformation(name, p);
-  }
-
-
-  class _HHO_reconstructed_sym_gradient
-    : public virtual_elementary_transformation {
-
-  public:
-
-    virtual void give_transformation(const mesh_fem &mf1, const mesh_fem &mf2,
-                                     size_type cv, base_matrix &M) const {
-
-      // The reconstructed symmetric Gradient "G" is described on mf2 and
-      // computed by the formula on the element T :
-      // \int_T G:w =   (1/2)*\int_T 0.5*Grad(v_T):(w+w^T)
-      //              + (1/2)*\int_{dT}(v_{dT} - v_T).((w+w^T).n)
-      // where "w" is the test function arbitrary in mf2, "v_T" is the field
-      // inside the element whose gradient is to be reconstructed,
-      // "v_{dT}" is the field on the boundary of T and "n" is the outward
-      // unit normal.
-      
-      // Obtaining the fem descriptors
-      pfem pf1 = mf1.fem_of_element(cv);
-      pfem pf2 = mf2.fem_of_element(cv);
-      pfem pfi = interior_fem_of_hho_method(pf1);
-
-      size_type degree = std::max(pf1->estimated_degree(),
-                                  pf2->estimated_degree());
-      bgeot::pgeometric_trans pgt = mf1.linked_mesh().trans_of_convex(cv);
-      papprox_integration pim
-        = classical_approx_im(pgt, dim_type(2*degree))->approx_method();
-
-      base_matrix G;
-      bgeot::vectors_to_base_matrix(G, mf1.linked_mesh().points_of_convex(cv));
-
-      bgeot::pgeotrans_precomp pgp
-        = HHO_pgp_pool(pgt, pim->pintegration_points());
-      pfem_precomp pfp1 = HHO_pfp_pool(pf1, pim->pintegration_points());
-      pfem_precomp pfp2 = HHO_pfp_pool(pf2, pim->pintegration_points());
-      pfem_precomp pfpi = HHO_pfp_pool(pfi, pim->pintegration_points());
-      
-      fem_interpolation_context ctx1(pgp, pfp1, 0, G, cv);
-      fem_interpolation_context ctx2(pgp, pfp2, 0, G, cv);
-      fem_interpolation_context ctxi(pgp, pfpi, 0, G, cv);
-
-      size_type Q = mf1.get_qdim(), N = mf1.linked_mesh().dim();
-      GMM_ASSERT1(Q == N, "This transformation works only for vector fields "
-                  "having the same dimension as the domain");
-      base_vector un(N);
-      size_type qmult1 =  N / pf1->target_dim();
-      size_type ndof1 = pf1->nb_dof(cv) * qmult1;
-      size_type qmult2 =  N*N / pf2->target_dim();
-      size_type ndof2 = pf2->nb_dof(cv) * qmult2;
-      size_type qmulti =  N / pfi->target_dim();
-      size_type ndofi = pfi->nb_dof(cv) * qmulti;
-
-      
-      base_tensor t1, t2, ti, tv1;
-      base_matrix tv2, tv1p, tvi;
-      base_matrix M1(ndof2, ndof1), M2(ndof2, ndof2), M2inv(ndof2, ndof2);
-      base_matrix aux2(ndof2, ndof2);
-
-      // Integrals on the element : \int_T G:w (M2)
-      //                 and  (1/2)*\int_T 0.5*Grad(v_T):(w+w^T)
-      for (size_type ipt = 0; ipt < pim->nb_points_on_convex(); ++ipt) {
-        ctx1.set_ii(ipt); ctx2.set_ii(ipt);
-        scalar_type coeff = pim->coeff(ipt) * ctx1.J();
-        
-        ctx1.grad_base_value(t1);
-        vectorize_grad_base_tensor(t1, tv1, ndof1, pf1->target_dim(), N);
-
-        ctx2.base_value(t2);
-        vectorize_base_tensor(t2, tv2, ndof2, pf2->target_dim(), N*N);
-       
-        gmm::mult(tv2, gmm::transposed(tv2), aux2);
-        gmm::add(gmm::scaled(aux2, coeff), M2);
-
-        for (size_type i = 0; i < ndof1; ++i) // To be optimized
-          for (size_type j = 0; j < ndof2; ++j)
-            for (size_type k1 = 0; k1 < N; ++k1) 
-              for (size_type k2 = 0; k2 < N; ++k2)
-                M1(j, i) += coeff * tv1.as_vector()[i+(k1+k2*N)*ndof1]
-                  * 0.5 * (tv2(j, k1+k2*N) + tv2(j, k2+k1*N));
-      }
-      
-      // Integrals on the faces : (1/2)*\int_{dT}(v_{dT} - v_T).((w+w^T).n) (M1)
-      for (short_type ifc = 0; ifc < pgt->structure()->nb_faces(); ++ifc) {
-        ctx1.set_face_num(ifc); ctx2.set_face_num(ifc); ctxi.set_face_num(ifc);
-        size_type first_ind = pim->ind_first_point_on_face(ifc);
-        for (size_type ipt = 0; ipt < pim->nb_points_on_face(ifc); ++ipt) {
-          ctx1.set_ii(first_ind+ipt);
-          ctx2.set_ii(first_ind+ipt);
-          ctxi.set_ii(first_ind+ipt);
-          scalar_type coeff = pim->coeff(first_ind+ipt) * ctx1.J();
-          gmm::mult(ctx1.B(), pgt->normals()[ifc], un);
-         
-          ctx2.base_value(t2);
-          vectorize_base_tensor(t2, tv2, ndof2, pf2->target_dim(), N*N);
-
-          ctx1.base_value(t1);
-          vectorize_base_tensor(t1, tv1p, ndof1, pf1->target_dim(), N);
-          
-          ctxi.base_value(ti);
-          vectorize_base_tensor(ti, tvi, ndofi, pfi->target_dim(), N);
-
-          for (size_type i = 0; i < ndof1; ++i) // To be optimized
-            for (size_type j = 0; j < ndof2; ++j)
-              for (size_type k1 = 0; k1 < N; ++k1) {
-                scalar_type b(0), a = coeff *
-                  (tv1p(i, k1) - (i < ndofi ? tvi(i, k1) : 0.));
-                for (size_type k2 = 0; k2 < N; ++k2)
-                  b += a*0.5*(tv2(j, k1 + k2*N) + tv2(j, k2 + k1*N)) * un[k2];
-                M1(j, i) += b;
-              }
-        }
-
-      }
-            
-      if (pf2->target_dim() == 1) {
-        gmm::sub_slice I(0, ndof2/(N*Q), N*Q);
-        gmm::lu_inverse(gmm::sub_matrix(M2, I, I));
-        for (size_type i = 0; i < N*Q; ++i) {
-          gmm::sub_slice I2(i, ndof2/(N*Q), N*Q);
-          gmm::copy(gmm::sub_matrix(M2, I, I), gmm::sub_matrix(M2inv, I2, I2));
-        }
-      } else 
-        { gmm::copy(M2, M2inv); gmm::lu_inverse(M2inv); }
-      
-      gmm::mult(M2inv, M1, M);
-      gmm::clean(M, gmm::vect_norminf(M.as_vector()) * 1E-13);
-    }
-  };
-
-  void add_HHO_reconstructed_symmetrized_gradient(model &md, std::string name) {
-    pelementary_transformation
-      p = std::make_shared<_HHO_reconstructed_sym_gradient>();
-    md.add_elementary_transformation(name, p);
-  }
-
-  
-
-  class _HHO_reconstructed_value
-    : public virtual_elementary_transformation {
-
-  public:
-
-    virtual void give_transformation(const mesh_fem &mf1, const mesh_fem &mf2,
-                                     size_type cv, base_matrix &M) const {
-      // The reconstructed variable "D" is described on mf2 and computed by
-      // the formula on the element T :
-      //   \int_T Grad(D).Grad(w) =   \int_T Grad(v_T).Grad(w)
-      //                            + \int_{dT}(v_{dT} - v_T).(Grad(w).n)
-      // with the constraint
-      //   \int_T D = \int_T v_T
-      // where "w" is the test function arbitrary in mf2, "v_T" is the field
-      // inside the element whose gradient is to be reconstructed,
-      // "v_{dT}" is the field on the boundary of T and "n" is the outward
-      // unit normal.
-
-      // Obtaining the fem descriptors
-      pfem pf1 = mf1.fem_of_element(cv);
-      pfem pf2 = mf2.fem_of_element(cv);
-      pfem pfi = interior_fem_of_hho_method(pf1);
-
-      size_type degree = std::max(pf1->estimated_degree(),
-                                  pf2->estimated_degree());
-      bgeot::pgeometric_trans pgt = mf1.linked_mesh().trans_of_convex(cv);
-      papprox_integration pim
-        = classical_approx_im(pgt, dim_type(2*degree))->approx_method();
-
-      base_matrix G;
-      bgeot::vectors_to_base_matrix(G, mf1.linked_mesh().points_of_convex(cv));
-
-      bgeot::pgeotrans_precomp pgp
-        = HHO_pgp_pool(pgt, pim->pintegration_points());
-      pfem_precomp pfp1 = HHO_pfp_pool(pf1, pim->pintegration_points());
-      pfem_precomp pfp2 = HHO_pfp_pool(pf2, pim->pintegration_points());
-      pfem_precomp pfpi = HHO_pfp_pool(pfi, pim->pintegration_points());
-      
-      fem_interpolation_context ctx1(pgp, pfp1, 0, G, cv);
-      fem_interpolation_context ctx2(pgp, pfp2, 0, G, cv);
-      fem_interpolation_context ctxi(pgp, pfpi, 0, G, cv);
-
-      size_type Q = mf1.get_qdim(), N = mf1.linked_mesh().dim();
-      base_vector un(N);
-      size_type qmult1 =  Q / pf1->target_dim();
-      size_type ndof1 = pf1->nb_dof(cv) * qmult1;
-      size_type qmult2 =  Q / pf2->target_dim();
-      size_type ndof2 = pf2->nb_dof(cv) * qmult2;
-      size_type qmulti =  Q / pfi->target_dim();
-      size_type ndofi = pfi->nb_dof(cv) * qmulti;
-
-      
-      base_tensor t1, t2, ti, tv1, tv2, t1p, t2p;
-      base_matrix tv1p, tv2p, tvi;
-      base_matrix M1(ndof2, ndof1), M2(ndof2, ndof2), M2inv(ndof2, ndof2);
-      base_matrix M3(Q, ndof1), M4(Q, ndof2);
-      base_matrix aux1(ndof2, ndof1), aux2(ndof2, ndof2);
-      scalar_type area(0);
-
-      // Integrals on the element : \int_T Grad(D).Grad(w) (M2)
-      //                            \int_T Grad(v_T).Grad(w) (M1)
-      //                            \int_T D (M4)  and \int_T v_T (M3)
-      for (size_type ipt = 0; ipt < pim->nb_points_on_convex(); ++ipt) {
-        ctx1.set_ii(ipt); ctx2.set_ii(ipt);
-        scalar_type coeff = pim->coeff(ipt) * ctx1.J();
-        area += coeff;
-        
-        ctx1.grad_base_value(t1);
-        vectorize_grad_base_tensor(t1, tv1, ndof1, pf1->target_dim(), Q);
-
-        ctx1.base_value(t1p);
-        vectorize_base_tensor(t1p, tv1p, ndof1, pf1->target_dim(), Q);
-
-        ctx2.grad_base_value(t2);
-        vectorize_grad_base_tensor(t2, tv2, ndof2, pf2->target_dim(), Q);
-
-        ctx2.base_value(t2p);
-        vectorize_base_tensor(t2p, tv2p, ndof2, pf2->target_dim(), Q);
-
-        for (size_type i = 0; i < ndof2; ++i) // To be optimized
-          for (size_type j = 0; j < ndof2; ++j)
-            for (size_type k = 0; k < Q*N; ++k)
-              M2(j, i) += coeff * tv2.as_vector()[i+k*ndof2]
-                                * tv2.as_vector()[j+k*ndof2];
-
-        for (size_type i = 0; i < ndof2; ++i)
-          for (size_type k = 0; k < Q; ++k)
-            M4(k,  i) += coeff * tv2p(i, k);
-              
-        for (size_type i = 0; i < ndof1; ++i) // To be optimized
-          for (size_type j = 0; j < ndof2; ++j)
-            for (size_type k = 0; k < Q*N; ++k)
-              M1(j, i) += coeff * tv1.as_vector()[i+k*ndof1]
-                                * tv2.as_vector()[j+k*ndof2];
-
-        for (size_type i = 0; i < ndof1; ++i)
-          for (size_type k = 0; k < Q; ++k)
-            M3(k,  i) += coeff * tv1p(i, k);
-
-      }
-
-      // Integrals on the faces : \int_{dT}(v_{dT} - v_T).(Grad(w).n) (M1)
-      for (short_type ifc = 0; ifc < pgt->structure()->nb_faces(); ++ifc) {
-        ctx1.set_face_num(ifc); ctx2.set_face_num(ifc); ctxi.set_face_num(ifc);
-        size_type first_ind = pim->ind_first_point_on_face(ifc);
-        for (size_type ipt = 0; ipt < pim->nb_points_on_face(ifc); ++ipt) {
-          ctx1.set_ii(first_ind+ipt);
-          ctx2.set_ii(first_ind+ipt);
-          ctxi.set_ii(first_ind+ipt);
-          scalar_type coeff = pim->coeff(first_ind+ipt) * ctx1.J();
-          gmm::mult(ctx1.B(), pgt->normals()[ifc], un);
-          
-          ctx2.grad_base_value(t2);
-          vectorize_grad_base_tensor(t2, tv2, ndof2, pf2->target_dim(), Q);
-
-          ctx1.base_value(t1);
-          vectorize_base_tensor(t1, tv1p, ndof1, pf1->target_dim(), Q);
-          
-          ctxi.base_value(ti);
-          vectorize_base_tensor(ti, tvi, ndofi, pfi->target_dim(), Q);
-
-          for (size_type i = 0; i < ndof1; ++i) // To be optimized
-            for (size_type j = 0; j < ndof2; ++j)
-              for (size_type k1 = 0; k1 < Q; ++k1) {
-                scalar_type b(0), a = coeff *
-                  (tv1p(i, k1) - (i < ndofi ? tvi(i, k1) : 0.));
-                for (size_type k2 = 0; k2 < N; ++k2)
-                  b += a * tv2.as_vector()[j+(k1+k2*Q)*ndof2] * un[k2];
-                M1(j, i) += b;
-              }
-        }
-
-      }
-
-      // Add the constraint with penalization
-      scalar_type coeff_p = pow(area, -1. - 2./scalar_type(N));
-      gmm::mult(gmm::transposed(M4), M4, aux2);
-      gmm::add (gmm::scaled(aux2, coeff_p), M2);
-      gmm::mult(gmm::transposed(M4), M3, aux1);
-      gmm::add (gmm::scaled(aux1, coeff_p), M1);
-      
-      if (pf2->target_dim() == 1 && Q > 1) {
-        gmm::sub_slice I(0, ndof2/Q, Q);
-        gmm::lu_inverse(gmm::sub_matrix(M2, I, I));
-        for (size_type i = 0; i < Q; ++i) {
-          gmm::sub_slice I2(i, ndof2/Q, Q);
-          gmm::copy(gmm::sub_matrix(M2, I, I), gmm::sub_matrix(M2inv, I2, I2));
-        }
-      } else 
-        { gmm::copy(M2, M2inv); gmm::lu_inverse(M2inv); }
-      
-      gmm::mult(M2inv, M1, M);
-      gmm::clean(M, gmm::vect_norminf(M.as_vector()) * 1E-13);
-    }
-  };
-
-  void add_HHO_reconstructed_value(model &md, std::string name) {
-    pelementary_transformation
-      p = std::make_shared<_HHO_reconstructed_value>();
-    md.add_elementary_transformation(name, p);
-  }
-
-
-  class _HHO_reconstructed_sym_value
-    : public virtual_elementary_transformation {
-
-  public:
-
-    virtual void give_transformation(const mesh_fem &mf1, const mesh_fem &mf2,
-                                     size_type cv, base_matrix &M) const {
-      // The reconstructed variable "D" is described on mf2 and computed by
-      // the formula on the element T :
-      //   \int_T Sym(Grad(D)).Grad(w) =   \int_T Sym(Grad(v_T)).Grad(w)
-      //                            + \int_{dT}(v_{dT} - v_T).(Sym(Grad(w)).n)
-      // with the constraints
-      //   \int_T D = \int_T v_T
-      //   \int_T Skew(Grad(D)) = 0.5\int_{dT}(n x v_{dT} - v_{dT} x n)
-      // where "w" is the test function arbitrary in mf2, "v_T" is the field
-      // inside the element whose gradient is to be reconstructed,
-      // "v_{dT}" is the field on the boundary of T and "n" is the outward
-      // unit normal.
-      
-      // Obtaining the fem descriptors
-      pfem pf1 = mf1.fem_of_element(cv);
-      pfem pf2 = mf2.fem_of_element(cv);
-      pfem pfi = interior_fem_of_hho_method(pf1);
-
-      size_type degree = std::max(pf1->estimated_degree(),
-                                  pf2->estimated_degree());
-      bgeot::pgeometric_trans pgt = mf1.linked_mesh().trans_of_convex(cv);
-      papprox_integration pim
-        = classical_approx_im(pgt, dim_type(2*degree))->approx_method();
-
-      base_matrix G;
-      bgeot::vectors_to_base_matrix(G, mf1.linked_mesh().points_of_convex(cv));
-
-      bgeot::pgeotrans_precomp pgp
-        = HHO_pgp_pool(pgt, pim->pintegration_points());
-      pfem_precomp pfp1 = HHO_pfp_pool(pf1, pim->pintegration_points());
-      pfem_precomp pfp2 = HHO_pfp_pool(pf2, pim->pintegration_points());
-      pfem_precomp pfpi = HHO_pfp_pool(pfi, pim->pintegration_points());
-      
-      fem_interpolation_context ctx1(pgp, pfp1, 0, G, cv);
-      fem_interpolation_context ctx2(pgp, pfp2, 0, G, cv);
-      fem_interpolation_context ctxi(pgp, pfpi, 0, G, cv);
-
-      size_type Q = mf1.get_qdim(), N = mf1.linked_mesh().dim();
-      GMM_ASSERT1(Q == N, "This transformation works only for vector fields "
-                  "having the same dimension as the domain");
-      base_vector un(N);
-      size_type qmult1 =  N / pf1->target_dim();
-      size_type ndof1 = pf1->nb_dof(cv) * qmult1;
-      size_type qmult2 =  N / pf2->target_dim();
-      size_type ndof2 = pf2->nb_dof(cv) * qmult2;
-      size_type qmulti =  N / pfi->target_dim();
-      size_type ndofi = pfi->nb_dof(cv) * qmulti;
-
-      
-      base_tensor t1, t2, ti, tv1, tv2, t1p, t2p;
-      base_matrix tv1p, tv2p, tvi;
-      base_matrix M1(ndof2, ndof1), M2(ndof2, ndof2), M2inv(ndof2, ndof2);;
-      base_matrix M3(N, ndof1), M4(N, ndof2);
-      base_matrix M5(N*N, ndof1), M6(N*N, ndof2);
-      base_matrix aux1(ndof2, ndof1), aux2(ndof2, ndof2);
-      scalar_type area(0);
-      
-      // Integrals on the element : \int_T Sym(Grad(D)).Grad(w) (M2)
-      //                            \int_T Sym(Grad(v_T)).Grad(w) (M1)
-      //                            \int_T D (M4)  and \int_T v_T (M3)
-      //                            \int_T Skew(Grad(D)) (M6)
-      for (size_type ipt = 0; ipt < pim->nb_points_on_convex(); ++ipt) {
-        ctx1.set_ii(ipt); ctx2.set_ii(ipt);
-        scalar_type coeff = pim->coeff(ipt) * ctx1.J();
-        area += coeff;
-        
-        ctx1.grad_base_value(t1);
-        vectorize_grad_base_tensor(t1, tv1, ndof1, pf1->target_dim(), N);
-
-        ctx1.base_value(t1p);
-        vectorize_base_tensor(t1p, tv1p, ndof1, pf1->target_dim(), N);
-
-        ctx2.grad_base_value(t2);
-        vectorize_grad_base_tensor(t2, tv2, ndof2, pf2->target_dim(), N);
-
-        ctx2.base_value(t2p);
-        vectorize_base_tensor(t2p, tv2p, ndof2, pf2->target_dim(), N);
-
-        for (size_type i = 0; i < ndof2; ++i) // To be optimized
-          for (size_type j = 0; j < ndof2; ++j)
-            for (size_type k1 = 0; k1 < N; ++k1)
-              for (size_type k2 = 0; k2 < N; ++k2)
-                M2(j, i) += coeff * tv2.as_vector()[i+(k1+k2*N)*ndof2]
-                  * 0.5 * (tv2.as_vector()[j+(k1+k2*N)*ndof2] +
-                           tv2.as_vector()[j+(k2+k1*N)*ndof2]);
-
-        for (size_type i = 0; i < ndof2; ++i)
-          for (size_type k = 0; k < N; ++k)
-            M4(k,  i) += coeff * tv2p(i, k);
-
-        for (size_type i = 0; i < ndof2; ++i)
-          for (size_type k1 = 0; k1 < N; ++k1)
-            for (size_type k2 = 0; k2 < N; ++k2)
-              M6(k1+k2*N, i) += 0.5*coeff*(tv2.as_vector()[i+(k1+k2*N)*ndof2] -
-                                           tv2.as_vector()[i+(k2+k1*N)*ndof2]);
-              
-        for (size_type i = 0; i < ndof1; ++i) // To be optimized
-          for (size_type j = 0; j < ndof2; ++j)
-            for (size_type k1 = 0; k1 < N; ++k1)
-              for (size_type k2 = 0; k2 < N; ++k2)
-                M1(j, i) += coeff * tv1.as_vector()[i+(k1+k2*N)*ndof1]
-                  * 0.5 * (tv2.as_vector()[j+(k1+k2*N)*ndof2] +
-                           tv2.as_vector()[j+(k2+k1*N)*ndof2]);
-
-        for (size_type i = 0; i < ndof1; ++i)
-          for (size_type k = 0; k < N; ++k)
-            M3(k,  i) += coeff * tv1p(i, k);
-
-      }
-
-      // Integrals on the faces : \int_{dT}(v_{dT} - v_T).(Sym(Grad(w)).n) (M1)
-      //                          \int_{dT} n x v_{dT} - v_{dT} x n (M5)
-      for (short_type ifc = 0; ifc < pgt->structure()->nb_faces(); ++ifc) {
-        ctx1.set_face_num(ifc); ctx2.set_face_num(ifc); ctxi.set_face_num(ifc);
-        size_type first_ind = pim->ind_first_point_on_face(ifc);
-        for (size_type ipt = 0; ipt < pim->nb_points_on_face(ifc); ++ipt) {
-          ctx1.set_ii(first_ind+ipt);
-          ctx2.set_ii(first_ind+ipt);
-          ctxi.set_ii(first_ind+ipt);
-          scalar_type coeff = pim->coeff(first_ind+ipt) * ctx1.J();
-          gmm::mult(ctx1.B(), pgt->normals()[ifc], un);
-          
-          ctx2.grad_base_value(t2);
-          vectorize_grad_base_tensor(t2, tv2, ndof2, pf2->target_dim(), N);
-
-          ctx1.base_value(t1);
-          vectorize_base_tensor(t1, tv1p, ndof1, pf1->target_dim(), N);
-          
-          ctxi.base_value(ti);
-          vectorize_base_tensor(ti, tvi, ndofi, pfi->target_dim(), N);
-
-          for (size_type i = 0; i < ndof1; ++i) // To be optimized
-            for (size_type j = 0; j < ndof2; ++j)
-              for (size_type k1 = 0; k1 < N; ++k1) {
-                scalar_type b(0), a = coeff *
-                  (tv1p(i, k1) - (i < ndofi ? tvi(i, k1) : 0.));
-                for (size_type k2 = 0; k2 < N; ++k2)
-                  b += a * 0.5 * (tv2.as_vector()[j+(k1+k2*N)*ndof2] +
-                                  tv2.as_vector()[j+(k2+k1*N)*ndof2]) * un[k2];
-                M1(j, i) += b;
-              }
-
-          for (size_type i = 0; i < ndof1; ++i)
-            for (size_type k1 = 0; k1 < N; ++k1)
-              for (size_type k2 = 0; k2 < N; ++k2)
-                M5(k1+k2*N, i) += 0.5 * coeff * (tv1p(i, k1) * un[k2] -
-                                                 tv1p(i, k2) * un[k1]);
-        }
-      }
-
-      // Add the constraint with penalization
-      scalar_type coeff_p1 = pow(area, -1. - 2./scalar_type(N));
-      scalar_type coeff_p2 = pow(area, -1. - 1./scalar_type(N));
-      gmm::mult(gmm::transposed(M4), M4, aux2);
-      gmm::add (gmm::scaled(aux2, coeff_p1), M2);
-      gmm::mult(gmm::transposed(M6), M6, aux2);
-      gmm::add (gmm::scaled(aux2, coeff_p2), M2);
-      gmm::mult(gmm::transposed(M4), M3, aux1);
-      gmm::add (gmm::scaled(aux1, coeff_p1), M1);
-      gmm::mult(gmm::transposed(M6), M5, aux1);
-      gmm::add (gmm::scaled(aux1, coeff_p2), M1);
-      
-      gmm::copy(M2, M2inv); gmm::lu_inverse(M2inv);
-
-      gmm::mult(M2inv, M1, M);
-      gmm::clean(M, gmm::vect_norminf(M.as_vector()) * 1E-13);
-    }
-  };
-
-  void add_HHO_reconstructed_symmetrized_value(model &md, std::string name) {
-    pelementary_transformation
-      p = std::make_shared<_HHO_reconstructed_sym_value>();
-    md.add_elementary_transformation(name, p);
-  }
-
-#if 0 //  Old single mef version
-
-class _HHO_stabilization
-    : public virtual_elementary_transformation {
-
-  public:
-
-    virtual void give_transformation(const mesh_fem &mf1, const mesh_fem &mf2,
-                                     size_type cv, base_matrix &M) const {
-      // The reconstructed variable "S" is described on mf2 and computed by
-      // S(v) = P_{\dT}(v_{dT} - D(v)  - P_T(v_T - D(v)))
-      // where P__{\dT} et P_T are L2 projections on the boundary and on the
-      // interior of T on the corresponding discrete spaces.
-      // Note that P_{\dT}(v_{dT}) = v_{dT} and P_T(v_T) = v_T and D is
-      // the reconstructed value on P^{k+1} given by the formula:
-      //   \int_T Grad(D).Grad(w) =   \int_T Grad(v_T).Grad(w)
-      //                            + \int_{dT}(v_{dT} - v_T).(Grad(w).n)
-      // with the constraint
-      //   \int_T D = \int_T v_T
-      // where "w" is the test function arbitrary in mf2, "v_T" is the field
-      // inside the element whose gradient is to be reconstructed,
-      // "v_{dT}" is the field on the boundary of T and "n" is the outward
-      // unit normal.
-      // The implemented formula is
-      // S(v) = v_{dT} - P_{\dT}D(v) - P_{\dT}(v_T) + P_{\dT}(P_T(D(v)))
-      // by the mean of the projection matrix from P^{k+1} to the original space
-      // and the projection matrix from interior space to the boundary space.
-      // As it is built, S(v) is zero on interior dofs.
-      
-      GMM_ASSERT1(&mf1 == &mf2, "The HHO stabilization transformation is "
-                  "only defined on the HHO space to itself");
-
-      // Obtaining the fem descriptors
-      pfem pf1 = mf1.fem_of_element(cv);
-      short_type degree = pf1->estimated_degree();
-      bgeot::pgeometric_trans pgt = mf1.linked_mesh().trans_of_convex(cv);
-      pfem pf2 = classical_fem(pgt, short_type(degree + 1)); // Should be
-                                         // changed for an interior PK method
-      pfem pfi = interior_fem_of_hho_method(pf1);
-
-      papprox_integration pim
-        = classical_approx_im(pgt, dim_type(2*degree+2))->approx_method();
-
-      base_matrix G;
-      bgeot::vectors_to_base_matrix(G, mf1.linked_mesh().points_of_convex(cv));
-
-      bgeot::pgeotrans_precomp pgp
-        = HHO_pgp_pool(pgt, pim->pintegration_points());
-      pfem_precomp pfp1 = HHO_pfp_pool(pf1, pim->pintegration_points());
-      pfem_precomp pfp2 = HHO_pfp_pool(pf2, pim->pintegration_points());
-      pfem_precomp pfpi = HHO_pfp_pool(pfi, pim->pintegration_points());
-      
-      fem_interpolation_context ctx1(pgp, pfp1, 0, G, cv);
-      fem_interpolation_context ctx2(pgp, pfp2, 0, G, cv);
-      fem_interpolation_context ctxi(pgp, pfpi, 0, G, cv);
-
-      size_type Q = mf1.get_qdim(), N = mf1.linked_mesh().dim();
-      base_vector un(N);
-      size_type qmult1 =  Q / pf1->target_dim();
-      size_type ndof1 = pf1->nb_dof(cv) * qmult1;
-      size_type qmult2 =  Q / pf2->target_dim();
-      size_type ndof2 = pf2->nb_dof(cv) * qmult2;
-      size_type qmulti =  Q / pfi->target_dim();
-      size_type ndofi = pfi->nb_dof(cv) * qmulti;
-
-      
-      base_tensor t1, t2, ti, tv1, tv2, t1p, t2p;
-      base_matrix tv1p, tv2p, tvi;
-      base_matrix M1(ndof2, ndof1), M2(ndof2, ndof2), M2inv(ndof2, ndof2);
-      base_matrix M3(Q, ndof1), M4(Q, ndof2);
-      base_matrix aux1(ndof2, ndof1), aux2(ndof2, ndof2);
-      base_matrix M7(ndof1, ndof1), M7inv(ndof1, ndof1), M8(ndof1, ndof2);
-      base_matrix M9(ndof1, ndof1), MD(ndof2, ndof1);
-      scalar_type area(0);
-
-      // Integrals on the element : \int_T Grad(D).Grad(w) (M2)
-      //                            \int_T Grad(v_T).Grad(w) (M1)
-      //                            \int_T D (M4)  and \int_T v_T (M3)
-      for (size_type ipt = 0; ipt < pim->nb_points_on_convex(); ++ipt) {
-        ctx1.set_ii(ipt); ctx2.set_ii(ipt);
-        scalar_type coeff = pim->coeff(ipt) * ctx1.J();
-        area += coeff;
-        
-        ctx1.grad_base_value(t1);
-        vectorize_grad_base_tensor(t1, tv1, ndof1, pf1->target_dim(), Q);
-
-        ctx1.base_value(t1p);
-        vectorize_base_tensor(t1p, tv1p, ndof1, pf1->target_dim(), Q);
-
-        ctx2.grad_base_value(t2);
-        vectorize_grad_base_tensor(t2, tv2, ndof2, pf2->target_dim(), Q);
-
-        ctx2.base_value(t2p);
-        vectorize_base_tensor(t2p, tv2p, ndof2, pf2->target_dim(), Q);
-
-        for (size_type i = 0; i < ndof2; ++i) // To be optimized
-          for (size_type j = 0; j < ndof2; ++j)
-            for (size_type k = 0; k < Q*N; ++k)
-              M2(j, i) += coeff * tv2.as_vector()[i+k*ndof2]
-                                * tv2.as_vector()[j+k*ndof2];
-
-        for (size_type i = 0; i < ndof2; ++i)
-          for (size_type k = 0; k < Q; ++k)
-            M4(k,  i) += coeff * tv2p(i, k);
-              
-        for (size_type i = 0; i < ndof1; ++i) // To be optimized
-          for (size_type j = 0; j < ndof2; ++j)
-            for (size_type k = 0; k < Q*N; ++k)
-              M1(j, i) += coeff * tv1.as_vector()[i+k*ndof1]
-                                * tv2.as_vector()[j+k*ndof2];
-
-        for (size_type i = 0; i < ndof1; ++i)
-          for (size_type k = 0; k < Q; ++k)
-            M3(k,  i) += coeff * tv1p(i, k);
-
-        for (size_type i = 0; i < ndof1; ++i) // To be optimized
-          for (size_type j = 0; j < ndof1; ++j)
-            for (size_type k = 0; k < Q; ++k)
-              M7(i, j) += coeff * tv1p(i, k) * tv1p(j, k);
-        
-        for (size_type i = 0; i < ndof1; ++i) // To be optimized
-          for (size_type j = 0; j < ndof2; ++j)
-            for (size_type k = 0; k < Q; ++k)
-              M8(i, j) += coeff * tv1p(i, k) * tv2p(j, k);
-
-      }
-
-      // Integrals on the faces : \int_{dT}(v_{dT} - v_T).(Grad(w).n) (M1)
-      for (short_type ifc = 0; ifc < pgt->structure()->nb_faces(); ++ifc) {
-        ctx1.set_face_num(ifc); ctx2.set_face_num(ifc); ctxi.set_face_num(ifc);
-        size_type first_ind = pim->ind_first_point_on_face(ifc);
-        for (size_type ipt = 0; ipt < pim->nb_points_on_face(ifc); ++ipt) {
-          ctx1.set_ii(first_ind+ipt);
-          ctx2.set_ii(first_ind+ipt);
-          ctxi.set_ii(first_ind+ipt);
-          scalar_type coeff = pim->coeff(first_ind+ipt) * ctx1.J();
-          gmm::mult(ctx1.B(), pgt->normals()[ifc], un);
-          scalar_type normun = gmm::vect_norm2(un);
-          
-          ctx2.grad_base_value(t2);
-          vectorize_grad_base_tensor(t2, tv2, ndof2, pf2->target_dim(), Q);
-
-          ctx2.base_value(t2p);
-          vectorize_base_tensor(t2p, tv2p, ndof2, pf2->target_dim(), Q);
-
-          ctx1.base_value(t1);
-          vectorize_base_tensor(t1, tv1p, ndof1, pf1->target_dim(), Q);
-          
-          ctxi.base_value(ti);
-          vectorize_base_tensor(ti, tvi, ndofi, pfi->target_dim(), Q);
-
-
-          for (size_type i = 0; i < ndof1; ++i) // To be optimized
-            for (size_type j = 0; j < ndof2; ++j)
-              for (size_type k1 = 0; k1 < Q; ++k1) {
-                scalar_type b(0), a = coeff *
-                  (tv1p(i, k1) - (i < ndofi ? tvi(i, k1) : 0.));
-                for (size_type k2 = 0; k2 < N; ++k2)
-                  b += a * tv2.as_vector()[j+(k1 + k2*Q)*ndof2] * un[k2];
-                M1(j, i) += b;
-              }
-
-          for (size_type i = 0; i < ndof1; ++i) // To be optimized
-            for (size_type j = 0; j < ndof1; ++j)
-              for (size_type k = 0; k < Q; ++k)
-                M7(i, j) += coeff * normun * tv1p(i,k) * tv1p(j, k);
-
-          for (size_type i = 0; i < ndof1; ++i) // To be optimized
-            for (size_type j = 0; j < ndof2; ++j)
-              for (size_type k = 0; k < Q; ++k)
-                M8(i, j) += coeff * normun * tv1p(i,k) * tv2p(j, k);
-
-          for (size_type i = 0; i < ndof1; ++i) // To be optimized
-            for (size_type j = 0; j < ndofi; ++j)
-              for (size_type k = 0; k < Q; ++k)
-                M9(i, j) += coeff * normun * tv1p(i,k) * tvi(j, k); 
-        }
-      }
-
-      // Add the constraint with penalization
-      scalar_type coeff_p = pow(area, -1. - 2./scalar_type(N));
-      gmm::mult(gmm::transposed(M4), M4, aux2);
-      gmm::add (gmm::scaled(aux2, coeff_p), M2);
-      gmm::mult(gmm::transposed(M4), M3, aux1);
-      gmm::add (gmm::scaled(aux1, coeff_p), M1);
-
-      if (pf2->target_dim() == 1 && Q > 1) {
-        gmm::sub_slice I(0, ndof2/Q, Q);
-        gmm::lu_inverse(gmm::sub_matrix(M2, I, I));
-        for (size_type i = 0; i < Q; ++i) {
-          gmm::sub_slice I2(i, ndof2/Q, Q);
-          gmm::copy(gmm::sub_matrix(M2, I, I), gmm::sub_matrix(M2inv, I2, I2));
-        }
-      } else 
-        { gmm::copy(M2, M2inv); gmm::lu_inverse(M2inv); }
-      
-      if (pf1->target_dim() == 1 && Q > 1) {
-        gmm::sub_slice I(0, ndof1/Q, Q);
-        gmm::lu_inverse(gmm::sub_matrix(M7, I, I));
-        for (size_type i = 0; i < Q; ++i) {
-          gmm::sub_slice I2(i, ndof1/Q, Q);
-          gmm::copy(gmm::sub_matrix(M7, I, I), gmm::sub_matrix(M7inv, I2, I2));
-        }
-      } else
-        { gmm::copy(M7, M7inv); gmm::lu_inverse(M7inv); }
-      
-      gmm::mult(M2inv, M1, MD);
-      gmm::clean(MD, gmm::vect_norminf(MD.as_vector()) * 1E-13);
-
-      // S  = (I - inv(M7)*M9)(I - inv(M7)*M8*MD)
-      base_matrix MPB(ndof1, ndof1);
-      gmm::mult(M7inv, M9, MPB);
-      gmm::copy(gmm::identity_matrix(), M9);
-      gmm::add(gmm::scaled(MPB, scalar_type(-1)), M9);
-
-      base_matrix MPC(ndof1, ndof1), MPD(ndof1, ndof1);
-      gmm::mult(M8, MD, MPC);
-      gmm::mult(M7inv, MPC, MPD);
-      gmm::copy(gmm::identity_matrix(), M7);
-      gmm::add(gmm::scaled(MPD, scalar_type(-1)), M7);
-
-      gmm::mult(M9, M7, M);
-      gmm::clean(M, 1E-13);
-    }
-  };
-
-  void add_HHO_stabilization(model &md, std::string name) {
-    pelementary_transformation
-      p = std::make_shared<_HHO_stabilization>();
-    md.add_elementary_transformation(name, p);
-  }
-
-
-#else
-  
-
-  class _HHO_stabilization
-    : public virtual_elementary_transformation {
-
-  public:
-
-    virtual void give_transformation(const mesh_fem &mf1, const mesh_fem &mf2,
-                                     size_type cv, base_matrix &M) const {
-      // The reconstructed variable "S" is described on mf2 and computed by
-      // S(v) = P_{\dT}(v_{dT} - D(v)  - P_T(v_T - D(v)))
-      // where P_{\dT} et P_T are L2 projections on the boundary and on the
-      // interior of T on the corresponding discrete spaces.
-      // Note that P_{\dT}(v_{dT}) = v_{dT} and P_T(v_T) = v_T and D is
-      // the reconstructed value on P^{k+1} given by the formula:
-      //   \int_T Grad(D).Grad(w) =   \int_T Grad(v_T).Grad(w)
-      //                            + \int_{dT}(v_{dT} - v_T).(Grad(w).n)
-      // with the constraint
-      //   \int_T D = \int_T v_T
-      // where "w" is the test function arbitrary in mf2, "v_T" is the field
-      // inside the element whose gradient is to be reconstructed,
-      // "v_{dT}" is the field on the boundary of T and "n" is the outward
-      // unit normal.
-      // The implemented formula is
-      // S(v) = P_{\dT}(v_{dT} - D(v) - P_T(v_T - D(v)) )
-      // by the mean of the projection matrix from P^{k+1} to the target space
-      // and the projection matrix from interior space to the boundary space.
-      // As it is built, S(v) is zero on interior dofs.
-      
-      // Obtaining the fem descriptors
-      pfem pf1 = mf1.fem_of_element(cv);
-      short_type degree = pf1->estimated_degree();
-      bgeot::pgeometric_trans pgt = mf1.linked_mesh().trans_of_convex(cv);
-      pfem pf2 = classical_fem(pgt, short_type(degree + 1)); // Should be
-                                         // changed for an interior PK method
-      pfem pf3 = mf2.fem_of_element(cv);
-      pfem pf1i = interior_fem_of_hho_method(pf1);
-      pfem pf3i = interior_fem_of_hho_method(pf3);
-
-      papprox_integration pim
-        = classical_approx_im(pgt, dim_type(2*degree+2))->approx_method();
-
-      base_matrix G;
-      bgeot::vectors_to_base_matrix(G, mf1.linked_mesh().points_of_convex(cv));
-
-      bgeot::pgeotrans_precomp pgp
-        = HHO_pgp_pool(pgt, pim->pintegration_points());
-      pfem_precomp pfp1 = HHO_pfp_pool(pf1, pim->pintegration_points());
-      pfem_precomp pfp2 = HHO_pfp_pool(pf2, pim->pintegration_points());
-      pfem_precomp pfp3 = HHO_pfp_pool(pf3, pim->pintegration_points());
-      pfem_precomp pfp1i = HHO_pfp_pool(pf1i, pim->pintegration_points());
-      pfem_precomp pfp3i = HHO_pfp_pool(pf3i, pim->pintegration_points());
-      
-      fem_interpolation_context ctx1(pgp, pfp1, 0, G, cv);
-      fem_interpolation_context ctx2(pgp, pfp2, 0, G, cv);
-      fem_interpolation_context ctx3(pgp, pfp3, 0, G, cv);
-      fem_interpolation_context ctx1i(pgp, pfp1i, 0, G, cv);
-      fem_interpolation_context ctx3i(pgp, pfp3i, 0, G, cv);
-
-      size_type Q = mf1.get_qdim(), N = mf1.linked_mesh().dim();
-      base_vector un(N);
-      size_type qmult1 =  Q / pf1->target_dim();
-      size_type ndof1 = pf1->nb_dof(cv) * qmult1;
-      size_type qmult2 =  Q / pf2->target_dim();
-      size_type ndof2 = pf2->nb_dof(cv) * qmult2;
-      size_type qmult3 =  Q / pf3->target_dim();
-      size_type ndof3 = pf3->nb_dof(cv) * qmult3;
-      size_type qmult1i =  Q / pf1i->target_dim();
-      size_type ndof1i = pf1i->nb_dof(cv) * qmult1i;
-      size_type qmult3i =  Q / pf3i->target_dim();
-      size_type ndof3i = pf3i->nb_dof(cv) * qmult3i;
-
-      
-      base_tensor t1, t2, t3, t1i, t3i, tv1, tv2, t1p, t2p;
-      base_matrix tv1p, tv2p, tv3p, tv1i, tv3i;
-      base_matrix M1(ndof2, ndof1), M2(ndof2, ndof2), M2inv(ndof2, ndof2);
-      base_matrix M3(Q, ndof1), M4(Q, ndof2);
-      base_matrix aux1(ndof2, ndof1), aux2(ndof2, ndof2);
-      base_matrix M7(ndof3, ndof3), M7inv(ndof3, ndof3), M8(ndof3, ndof2);
-      base_matrix M9(ndof3, ndof1), M10(ndof3, ndof3), MD(ndof2, ndof1);
-      scalar_type area(0);
-
-      // Integrals on the element : \int_T Grad(D).Grad(w) (M2)
-      //                            \int_T Grad(v_T).Grad(w) (M1)
-      //                            \int_T D (M4)  and \int_T v_T (M3)
-      for (size_type ipt = 0; ipt < pim->nb_points_on_convex(); ++ipt) {
-        ctx1.set_ii(ipt); ctx2.set_ii(ipt); ctx3.set_ii(ipt);
-        scalar_type coeff = pim->coeff(ipt) * ctx1.J();
-        area += coeff;
-        
-        ctx1.grad_base_value(t1);
-        vectorize_grad_base_tensor(t1, tv1, ndof1, pf1->target_dim(), Q);
-
-        ctx1.base_value(t1p);
-        vectorize_base_tensor(t1p, tv1p, ndof1, pf1->target_dim(), Q);
-
-        ctx2.grad_base_value(t2);
-        vectorize_grad_base_tensor(t2, tv2, ndof2, pf2->target_dim(), Q);
-
-        ctx2.base_value(t2p);
-        vectorize_base_tensor(t2p, tv2p, ndof2, pf2->target_dim(), Q);
-
-        ctx3.base_value(t3);
-        vectorize_base_tensor(t3, tv3p, ndof3, pf3->target_dim(), Q);
-
-        for (size_type i = 0; i < ndof2; ++i) // To be optimized
-          for (size_type j = 0; j < ndof2; ++j)
-            for (size_type k = 0; k < Q*N; ++k)
-              M2(j, i) += coeff * tv2.as_vector()[i+k*ndof2]
-                                * tv2.as_vector()[j+k*ndof2];
-
-        for (size_type i = 0; i < ndof2; ++i)
-          for (size_type k = 0; k < Q; ++k)
-            M4(k,  i) += coeff * tv2p(i, k);
-              
-        for (size_type i = 0; i < ndof1; ++i) // To be optimized
-          for (size_type j = 0; j < ndof2; ++j)
-            for (size_type k = 0; k < Q*N; ++k)
-              M1(j, i) += coeff * tv1.as_vector()[i+k*ndof1]
-                                * tv2.as_vector()[j+k*ndof2];
-
-        for (size_type i = 0; i < ndof1; ++i)
-          for (size_type k = 0; k < Q; ++k)
-            M3(k,  i) += coeff * tv1p(i, k);
-
-        for (size_type i = 0; i < ndof3; ++i) // To be optimized
-          for (size_type j = 0; j < ndof3; ++j)
-            for (size_type k = 0; k < Q; ++k)
-              M7(i, j) += coeff * tv3p(i, k) * tv3p(j, k);
-        
-        for (size_type i = 0; i < ndof3; ++i) // To be optimized
-          for (size_type j = 0; j < ndof2; ++j)
-            for (size_type k = 0; k < Q; ++k)
-              M8(i, j) += coeff * tv3p(i, k) * tv2p(j, k);
-
-        for (size_type i = 0; i < ndof3; ++i) // To be optimized
-          for (size_type j = 0; j < ndof1; ++j)
-            for (size_type k = 0; k < Q; ++k)
-              M9(i, j) += coeff * tv3p(i, k) * tv1p(j, k);
-      }
-
-      // Integrals on the faces : \int_{dT}(v_{dT} - v_T).(Grad(w).n) (M1)
-      for (short_type ifc = 0; ifc < pgt->structure()->nb_faces(); ++ifc) {
-        ctx1.set_face_num(ifc); ctx2.set_face_num(ifc); ctx3.set_face_num(ifc);
-        ctx1i.set_face_num(ifc); ctx3i.set_face_num(ifc);
-        size_type first_ind = pim->ind_first_point_on_face(ifc);
-        for (size_type ipt = 0; ipt < pim->nb_points_on_face(ifc); ++ipt) {
-          ctx1.set_ii(first_ind+ipt); ctx2.set_ii(first_ind+ipt);
-          ctx3.set_ii(first_ind+ipt); ctx1i.set_ii(first_ind+ipt);
-          ctx3i.set_ii(first_ind+ipt);
-          scalar_type coeff = pim->coeff(first_ind+ipt) * ctx1.J();
-          gmm::mult(ctx1.B(), pgt->normals()[ifc], un);
-          scalar_type normun = gmm::vect_norm2(un);
-          
-          ctx2.grad_base_value(t2);
-          vectorize_grad_base_tensor(t2, tv2, ndof2, pf2->target_dim(), Q);
-
-          ctx2.base_value(t2p);
-          vectorize_base_tensor(t2p, tv2p, ndof2, pf2->target_dim(), Q);
-
-          ctx1.base_value(t1);
-          vectorize_base_tensor(t1, tv1p, ndof1, pf1->target_dim(), Q);
-          
-          ctx1i.base_value(t1i);
-          vectorize_base_tensor(t1i, tv1i, ndof1i, pf1i->target_dim(), Q);
-
-          ctx3i.base_value(t3i);
-          vectorize_base_tensor(t3i, tv3i, ndof3i, pf3i->target_dim(), Q);
-
-          ctx3.base_value(t3);
-          vectorize_base_tensor(t3, tv3p, ndof3, pf3->target_dim(), Q);
-
-          
-          for (size_type i = 0; i < ndof1; ++i) // To be optimized
-            for (size_type j = 0; j < ndof2; ++j)
-              for (size_type k1 = 0; k1 < Q; ++k1) {
-                scalar_type b(0), a = coeff *
-                  (tv1p(i, k1) - (i < ndof1i ? tv1i(i, k1) : 0.));
-                for (size_type k2 = 0; k2 < N; ++k2)
-                  b += a * tv2.as_vector()[j+(k1 + k2*Q)*ndof2] * un[k2];
-                M1(j, i) += b;
-              }
-
-          for (size_type i = 0; i < ndof3; ++i) // To be optimized
-            for (size_type j = 0; j < ndof3; ++j)
-              for (size_type k = 0; k < Q; ++k)
-                M7(i, j) += coeff * normun * tv3p(i,k) * tv3p(j, k);
-
-          for (size_type i = 0; i < ndof3; ++i) // To be optimized
-            for (size_type j = 0; j < ndof2; ++j)
-              for (size_type k = 0; k < Q; ++k)
-                M8(i, j) += coeff * normun * tv3p(i,k) * tv2p(j, k);
-
-          for (size_type i = 0; i < ndof3; ++i) // To be optimized
-            for (size_type j = 0; j < ndof1; ++j)
-              for (size_type k = 0; k < Q; ++k)
-                M9(i, j) += coeff * normun * tv3p(i, k) * tv1p(j, k);
-
-          for (size_type i = 0; i < ndof3; ++i) // To be optimized
-            for (size_type j = 0; j < ndof3i; ++j)
-              for (size_type k = 0; k < Q; ++k)
-                M10(i, j) += coeff * normun * tv3p(i,k) * tv3i(j, k); 
-        }
-      }
-      
-      // Add the constraint with penalization
-      scalar_type coeff_p = pow(area, -1. - 2./scalar_type(N));
-      gmm::mult(gmm::transposed(M4), M4, aux2);
-      gmm::add (gmm::scaled(aux2, coeff_p), M2);
-      gmm::mult(gmm::transposed(M4), M3, aux1);
-      gmm::add (gmm::scaled(aux1, coeff_p), M1);
-
-      if (pf2->target_dim() == 1 && Q > 1) {
-        gmm::sub_slice I(0, ndof2/Q, Q);
-        gmm::lu_inverse(gmm::sub_matrix(M2, I, I));
-        for (size_type i = 0; i < Q; ++i) {
-          gmm::sub_slice I2(i, ndof2/Q, Q);
-          gmm::copy(gmm::sub_matrix(M2, I, I), gmm::sub_matrix(M2inv, I2, I2));
-        }
-      } else 
-        { gmm::copy(M2, M2inv); gmm::lu_inverse(M2inv); }
-      
-      if (pf3->target_dim() == 1 && Q > 1) {
-        gmm::sub_slice I(0, ndof3/Q, Q);
-        gmm::lu_inverse(gmm::sub_matrix(M7, I, I));
-        for (size_type i = 0; i < Q; ++i) {
-          gmm::sub_slice I2(i, ndof3/Q, Q);
-          gmm::copy(gmm::sub_matrix(M7, I, I), gmm::sub_matrix(M7inv, I2, I2));
-        }
-      } else
-        { gmm::copy(M7, M7inv); gmm::lu_inverse(M7inv); }
-      
-      gmm::mult(M2inv, M1, MD);
-      gmm::clean(MD, gmm::vect_norminf(MD.as_vector()) * 1E-13);
-
-      // S  = (I - inv(M7)*M10)*inv(M7)*(M9 - M8*MD)
-      base_matrix MPB(ndof3, ndof3);
-      gmm::mult(M7inv, M10, MPB);
-      gmm::copy(gmm::identity_matrix(), M10);
-      gmm::add(gmm::scaled(MPB, scalar_type(-1)), M10);
-
-      base_matrix MPC(ndof3, ndof1);
-      gmm::mult(gmm::scaled(M8, scalar_type(-1)), MD, MPC);
-      gmm::add(M9, MPC);
-      gmm::mult(M7inv, MPC, M9);
-      gmm::mult(M10, M9, M);
-      gmm::clean(M, 1E-13);
-    }
-  };
-
-  void add_HHO_stabilization(model &md, std::string name) {
-    pelementary_transformation
-      p = std::make_shared<_HHO_stabilization>();
-    md.add_elementary_transformation(name, p);
-  }
-
-#endif
-
-  class _HHO_symmetrized_stabilization
-    : public virtual_elementary_transformation {
-
-  public:
-
-    virtual void give_transformation(const mesh_fem &mf1, const mesh_fem &mf2,
-                                     size_type cv, base_matrix &M) const {
-      // The reconstructed variable "S" is described on mf2 and computed by
-      // S(v) = P_{\dT}(v_{dT} - D(v)  - P_T(v_T - D(v)))
-      // where P_{\dT} et P_T are L2 projections on the boundary and on the
-      // interior of T on the corresponding discrete spaces.
-      // Note that P_{\dT}(v_{dT}) = v_{dT} and P_T(v_T) = v_T and D is
-      // the reconstructed value on P^{k+1} given by the formula:
-      //   \int_T Sym(Grad(D)).Grad(w) =   \int_T Sym(Grad(v_T)).Grad(w)
-      //                            + \int_{dT}(v_{dT} - v_T).(Sym(Grad(w)).n)
-      // with the constraints
-      //   \int_T D = \int_T v_T
-      //   \int_T Skew(Grad(D)) = 0.5\int_{dT}(n x v_{dT} - v_{dT} x n)
-      // where "w" is the test function arbitrary in mf2, "v_T" is the field
-      // inside the element whose gradient is to be reconstructed,
-      // "v_{dT}" is the field on the boundary of T and "n" is the outward
-      // unit normal.
-      // The implemented formula is
-      // S(v) = P_{\dT}(v_{dT} - D(v) - P_T(v_T - D(v)) )
-      // by the mean of the projection matrix from P^{k+1} to the target space
-      // and the projection matrix from interior space to the boundary space.
-      // As it is built, S(v) is zero on interior dofs.
-       
-      // Obtaining the fem descriptors
-      pfem pf1 = mf1.fem_of_element(cv);
-      short_type degree = pf1->estimated_degree();
-      bgeot::pgeometric_trans pgt = mf1.linked_mesh().trans_of_convex(cv);
-      pfem pf2 = classical_fem(pgt, short_type(degree + 1)); // Should be changed to an
-                                                 // interior PK method
-      pfem pf3 = mf2.fem_of_element(cv);
-      pfem pf1i = interior_fem_of_hho_method(pf1);
-      pfem pf3i = interior_fem_of_hho_method(pf3);
-
-      papprox_integration pim
-        = classical_approx_im(pgt, dim_type(2*degree+2))->approx_method();
-
-      base_matrix G;
-      bgeot::vectors_to_base_matrix(G, mf1.linked_mesh().points_of_convex(cv));
-
-      bgeot::pgeotrans_precomp pgp
-        = HHO_pgp_pool(pgt, pim->pintegration_points());
-      pfem_precomp pfp1 = HHO_pfp_pool(pf1, pim->pintegration_points());
-      pfem_precomp pfp2 = HHO_pfp_pool(pf2, pim->pintegration_points());
-      pfem_precomp pfp3 = HHO_pfp_pool(pf3, pim->pintegration_points());
-      pfem_precomp pfp1i = HHO_pfp_pool(pf1i, pim->pintegration_points());
-      pfem_precomp pfp3i = HHO_pfp_pool(pf3i, pim->pintegration_points());
-      
-      fem_interpolation_context ctx1(pgp, pfp1, 0, G, cv);
-      fem_interpolation_context ctx2(pgp, pfp2, 0, G, cv);
-      fem_interpolation_context ctx3(pgp, pfp3, 0, G, cv);
-      fem_interpolation_context ctx1i(pgp, pfp1i, 0, G, cv);
-      fem_interpolation_context ctx3i(pgp, pfp3i, 0, G, cv);
-
-      size_type Q = mf1.get_qdim(), N = mf1.linked_mesh().dim();
-      GMM_ASSERT1(Q == N, "This transformation works only for vector fields "
-                  "having the same dimension as the domain");
-      base_vector un(N);
-      size_type qmult1 =  N / pf1->target_dim();
-      size_type ndof1 = pf1->nb_dof(cv) * qmult1;
-      size_type qmult2 =  N / pf2->target_dim();
-      size_type ndof2 = pf2->nb_dof(cv) * qmult2;
-      size_type qmult3 =  Q / pf3->target_dim();
-      size_type ndof3 = pf3->nb_dof(cv) * qmult3;
-      size_type qmult1i =  Q / pf1i->target_dim();
-      size_type ndof1i = pf1i->nb_dof(cv) * qmult1i;
-      size_type qmult3i =  Q / pf3i->target_dim();
-      size_type ndof3i = pf3i->nb_dof(cv) * qmult3i;
-
-      
-      base_tensor t1, t2, t3, t1i, t3i, tv1, tv2, t1p, t2p;
-      base_matrix tv1p, tv2p, tv3p, tv1i, tv3i;
-      base_matrix M1(ndof2, ndof1), M2(ndof2, ndof2), M2inv(ndof2, ndof2);
-      base_matrix M3(N, ndof1), M4(N, ndof2);
-      base_matrix aux1(ndof2, ndof1), aux2(ndof2, ndof2);
-      base_matrix M5(N*N, ndof1), M6(N*N, ndof2);
-      base_matrix M7(ndof3, ndof3), M7inv(ndof3, ndof3), M8(ndof3, ndof2);
-      base_matrix M9(ndof3, ndof1), M10(ndof3, ndof3), MD(ndof2, ndof1);
-      scalar_type area(0);
-      
-      // Integrals on the element : \int_T Sym(Grad(D)).Grad(w) (M2)
-      //                            \int_T Sym(Grad(v_T)).Grad(w) (M1)
-      //                            \int_T D (M4)  and \int_T v_T (M3)
-      //                            \int_T Skew(Grad(D)) (M6)
-      for (size_type ipt = 0; ipt < pim->nb_points_on_convex(); ++ipt) {
-        ctx1.set_ii(ipt); ctx2.set_ii(ipt); ctx3.set_ii(ipt);
-        scalar_type coeff = pim->coeff(ipt) * ctx1.J();
-        area += coeff;
-        
-        ctx1.grad_base_value(t1);
-        vectorize_grad_base_tensor(t1, tv1, ndof1, pf1->target_dim(), Q);
-
-        ctx1.base_value(t1p);
-        vectorize_base_tensor(t1p, tv1p, ndof1, pf1->target_dim(), Q);
-
-        ctx2.grad_base_value(t2);
-        vectorize_grad_base_tensor(t2, tv2, ndof2, pf2->target_dim(), Q);
-
-        ctx2.base_value(t2p);
-        vectorize_base_tensor(t2p, tv2p, ndof2, pf2->target_dim(), Q);
-
-        ctx3.base_value(t3);
-        vectorize_base_tensor(t3, tv3p, ndof3, pf3->target_dim(), Q);
-
-        for (size_type i = 0; i < ndof2; ++i) // To be optimized
-          for (size_type j = 0; j < ndof2; ++j)
-           for (size_type k1 = 0; k1 < N; ++k1)
-             for (size_type k2 = 0; k2 < N; ++k2)
-               M2(j, i) += coeff * tv2.as_vector()[i+(k1+k2*N)*ndof2]
-                 * 0.5 * (tv2.as_vector()[j+(k1+k2*N)*ndof2] +
-                          tv2.as_vector()[j+(k2+k1*N)*ndof2]);
-        
-        for (size_type i = 0; i < ndof2; ++i)
-          for (size_type k = 0; k < N; ++k)
-            M4(k,  i) += coeff * tv2p(i, k);
-              
-        for (size_type i = 0; i < ndof2; ++i)
-          for (size_type k1 = 0; k1 < N; ++k1)
-            for (size_type k2 = 0; k2 < N; ++k2)
-              M6(k1+k2*N, i) += 0.5*coeff*(tv2.as_vector()[i+(k1+k2*N)*ndof2] -
-                                           tv2.as_vector()[i+(k2+k1*N)*ndof2]);
-
-        for (size_type i = 0; i < ndof1; ++i) // To be optimized
-          for (size_type j = 0; j < ndof2; ++j)
-            for (size_type k1 = 0; k1 < N; ++k1)
-              for (size_type k2 = 0; k2 < N; ++k2)
-                M1(j, i) += coeff * tv1.as_vector()[i+(k1+k2*N)*ndof1]
-                  * 0.5 * (tv2.as_vector()[j+(k1+k2*N)*ndof2] +
-                           tv2.as_vector()[j+(k2+k1*N)*ndof2]);
-        
-        for (size_type i = 0; i < ndof1; ++i)
-          for (size_type k = 0; k < N; ++k)
-            M3(k,  i) += coeff * tv1p(i, k);
-
-        for (size_type i = 0; i < ndof3; ++i) // To be optimized
-          for (size_type j = 0; j < ndof3; ++j)
-            for (size_type k = 0; k < N; ++k)
-              M7(i, j) += coeff * tv3p(i,k) * tv3p(j, k);
-
-        for (size_type i = 0; i < ndof3; ++i) // To be optimized
-          for (size_type j = 0; j < ndof2; ++j)
-            for (size_type k = 0; k < N; ++k)
-              M8(i, j) += coeff * tv3p(i,k) * tv2p(j, k);
-
-        for (size_type i = 0; i < ndof3; ++i) // To be optimized
-          for (size_type j = 0; j < ndof1; ++j)
-            for (size_type k = 0; k < Q; ++k)
-              M9(i, j) += coeff * tv3p(i, k) * tv1p(j, k);
-      }
-
-      // Integrals on the faces : \int_{dT}(v_{dT} - v_T).(Grad(w).n) (M1)
-      //                          \int_{dT} Skew(n x v_{dT} - v_{dT} x n) (M5)
-      for (short_type ifc = 0; ifc < pgt->structure()->nb_faces(); ++ifc) {
-        ctx1.set_face_num(ifc); ctx2.set_face_num(ifc); ctx3.set_face_num(ifc);
-        ctx1i.set_face_num(ifc); ctx3i.set_face_num(ifc);
-        size_type first_ind = pim->ind_first_point_on_face(ifc);
-        for (size_type ipt = 0; ipt < pim->nb_points_on_face(ifc); ++ipt) {
-          ctx1.set_ii(first_ind+ipt); ctx2.set_ii(first_ind+ipt);
-          ctx3.set_ii(first_ind+ipt); ctx1i.set_ii(first_ind+ipt);
-          ctx3i.set_ii(first_ind+ipt);
-          scalar_type coeff = pim->coeff(first_ind+ipt) * ctx1.J();
-          gmm::mult(ctx1.B(), pgt->normals()[ifc], un);
-          scalar_type normun = gmm::vect_norm2(un);
-          
-          ctx2.grad_base_value(t2);
-          vectorize_grad_base_tensor(t2, tv2, ndof2, pf2->target_dim(), Q);
-
-          ctx2.base_value(t2p);
-          vectorize_base_tensor(t2p, tv2p, ndof2, pf2->target_dim(), Q);
-
-          ctx1.base_value(t1);
-          vectorize_base_tensor(t1, tv1p, ndof1, pf1->target_dim(), Q);
-          
-          ctx1i.base_value(t1i);
-          vectorize_base_tensor(t1i, tv1i, ndof1i, pf1i->target_dim(), Q);
-
-          ctx3i.base_value(t3i);
-          vectorize_base_tensor(t3i, tv3i, ndof3i, pf3i->target_dim(), Q);
-          
-          ctx3.base_value(t3);
-          vectorize_base_tensor(t3, tv3p, ndof3, pf3->target_dim(), Q);
-
-          for (size_type i = 0; i < ndof1; ++i) // To be optimized
-            for (size_type j = 0; j < ndof2; ++j)
-              for (size_type k1 = 0; k1 < N; ++k1) {
-                scalar_type b(0), a = coeff *
-                  (tv1p(i, k1) - (i < ndof1i ? tv1i(i, k1) : 0.));
-                for (size_type k2 = 0; k2 < N; ++k2)
-                  b += a * 0.5 * (tv2.as_vector()[j+(k1 + k2*N)*ndof2] +
-                                  tv2.as_vector()[j+(k2 + k1*N)*ndof2])* un[k2];
-                M1(j, i) += b;
-              }
-
-          for (size_type i = 0; i < ndof1; ++i)
-            for (size_type k1 = 0; k1 < N; ++k1)
-              for (size_type k2 = 0; k2 < N; ++k2)
-                M5(k1+k2*N, i) += 0.5 * coeff * (tv1p(i, k1) * un[k2] -
-                                                 tv1p(i, k2) * un[k1]);
-
-          for (size_type i = 0; i < ndof3; ++i) // To be optimized
-            for (size_type j = 0; j < ndof3; ++j)
-              for (size_type k = 0; k < N; ++k)
-                M7(i, j) += coeff * normun * tv3p(i,k) * tv3p(j, k);
-
-          for (size_type i = 0; i < ndof3; ++i) // To be optimized
-            for (size_type j = 0; j < ndof2; ++j)
-              for (size_type k = 0; k < N; ++k)
-                M8(i, j) += coeff * normun * tv3p(i,k) * tv2p(j, k);
-
-          for (size_type i = 0; i < ndof3; ++i) // To be optimized
-            for (size_type j = 0; j < ndof1; ++j)
-              for (size_type k = 0; k < Q; ++k)
-                M9(i, j) += coeff * normun * tv3p(i, k) * tv1p(j, k);
-
-          for (size_type i = 0; i < ndof3; ++i) // To be optimized
-            for (size_type j = 0; j < ndof3i; ++j)
-              for (size_type k = 0; k < N; ++k)
-                M10(i, j) += coeff * normun * tv3p(i,k) * tv3i(j, k);
-        }
-      }
-
-      // Add the constraint with penalization
-      scalar_type coeff_p1 = pow(area, -1. - 2./scalar_type(N));
-      scalar_type coeff_p2 = pow(area, -1. - 1./scalar_type(N));
-      gmm::mult(gmm::transposed(M4), M4, aux2);
-      gmm::add (gmm::scaled(aux2, coeff_p1), M2);
-      gmm::mult(gmm::transposed(M6), M6, aux2);
-      gmm::add (gmm::scaled(aux2, coeff_p2), M2);
-      gmm::mult(gmm::transposed(M4), M3, aux1);
-      gmm::add (gmm::scaled(aux1, coeff_p1), M1);
-      gmm::mult(gmm::transposed(M6), M5, aux1);
-      gmm::add (gmm::scaled(aux1, coeff_p2), M1);
-
-      gmm::copy(M2, M2inv); gmm::lu_inverse(M2inv);
-      
-      if (pf3->target_dim() == 1 && Q > 1) {
-        gmm::sub_slice I(0, ndof3/Q, Q);
-        gmm::lu_inverse(gmm::sub_matrix(M7, I, I));
-        for (size_type i = 0; i < Q; ++i) {
-          gmm::sub_slice I2(i, ndof3/Q, Q);
-          gmm::copy(gmm::sub_matrix(M7, I, I), gmm::sub_matrix(M7inv, I2, I2));
-        }
-      } else
-        { gmm::copy(M7, M7inv); gmm::lu_inverse(M7inv); }
-      
-      gmm::mult(M2inv, M1, MD);
-      gmm::clean(MD, gmm::vect_norminf(MD.as_vector()) * 1E-13);
-      
-      // S  = (I - inv(M7)*M10)*inv(M7)*(M9 - M8*MD)
-      base_matrix MPB(ndof3, ndof3);
-      gmm::mult(M7inv, M10, MPB);
-      gmm::copy(gmm::identity_matrix(), M10);
-      gmm::add(gmm::scaled(MPB, scalar_type(-1)), M10);
-
-      base_matrix MPC(ndof3, ndof1);
-      gmm::mult(gmm::scaled(M8, scalar_type(-1)), MD, MPC);
-      gmm::add(M9, MPC);
-      gmm::mult(M7inv, MPC, M9);
-      gmm::mult(M10, M9, M);
-      gmm::clean(M, 1E-13);
-    }
-  };
-
-  void add_HHO_symmetrized_stabilization(model &md, std::string name) {
-    pelementary_transformation
-      p = std::make_shared<_HHO_symmetrized_stabilization>();
-    md.add_elementary_transformation(name, p);
-  }
-
-
-
-
-
-}  /* end of namespace getfem.                                             */
-
+
+
+#include "getfem/getfem_HHO.h"
+
+#if defined(GMM_USES_BLAS)
+#define HHO_USES_BLAS
+#endif
+
+namespace getfem {
+
+  // The precomputations are stored objects released with the fems and
+  // integration methods, they are not kept in static pools (which would be
+  // destroyed after the table of stored objects at exit).
+
+  // To be optimized:
+  // - The fact that (when pf2->target_dim() = 1) the
+  //   problem can be solved componentwise can be more exploited in
+  //   avoiding the computation of the whole matrix M2.
+  // - The vectorization can be avoided in most cases
+
+  /* ******************************************************************** */
+  /*  Batched computation of the elementary integrals.                    */
+  /*                                                                      */
+  /*  The values of a (vectorized) fem with K components at all the       */
+  /*  integration points of an element are stored in a single matrix      */
+  /*  having one row per local dof and the columns k + K*ipt for the      */
+  /*  component k at the integration point ipt. The gradients are stored  */
+  /*  in the same way with K*N components (q + K*d for the derivative d   */
+  /*  of the component q). Each integral is then computed with a single   */
+  /*  matrix-matrix product for all the integration points.               */
+  /*  The values and reference gradients of standard fems are computed    */
+  /*  once for each (fem, integration method) and only the Jacobian of    */
+  /*  the geometric transformation is applied on each element.            */
+  /*  The elements are distributed on the threads by the assembly, so     */
+  /*  that the caches are thread local.                                   */
+  /* ******************************************************************** */
+
+  // Values and reference gradients of a standard fem, vectorized on K
+  // components, at the points of an integration method. Stored as a
+  // static stored object depending on the fem and on the integration
+  // method, so that it is deleted with them.
+  struct HHO_reference_values : virtual public dal::static_stored_object {
+    base_matrix val, grad;        // Values and gradients on the reference
+    mutable base_matrix mass_inv; // Inverse of the reference mass matrix
+    HHO_reference_values(pfem pf, pintegration_method ppi, size_type K);
+  };
+
+  HHO_reference_values::HHO_reference_values(pfem pf,
+                                             pintegration_method ppi,
+                                             size_type K) {
+    papprox_integration pim = ppi->approx_method();
+    pfem_precomp pfp = fem_precomp(pf, pim->pintegration_points(), 0);
+    size_type ndof = pf->nb_dof(0) * (K / pf->target_dim());
+    size_type npt = pim->nb_points(), P = pf->dim();
+    gmm::resize(val, ndof, K*npt);
+    gmm::resize(grad, ndof, K*P*npt);
+    base_matrix tv; base_tensor tg;
+    for (size_type ipt = 0; ipt < npt; ++ipt) {
+      vectorize_base_tensor(pfp->val(ipt), tv, ndof, pf->target_dim(), K);
+      std::copy(tv.begin(), tv.end(), val.begin() + ndof*K*ipt);
+      vectorize_grad_base_tensor(pfp->grad(ipt), tg, ndof,
+                                 pf->target_dim(), K);
+      std::copy(tg.begin(), tg.end(), grad.begin() + ndof*K*P*ipt);
+    }
+  }
+
+  typedef std::shared_ptr<const HHO_reference_values> pHHO_reference_values;
+
+  DAL_TRIPLE_KEY(HHO_reference_key_, pfem, pintegration_method, size_type);
+
+  static pHHO_reference_values
+  HHO_reference(pfem pf, pintegration_method ppi, size_type K) {
+    dal::pstatic_stored_object_key
+      pk = std::make_shared<HHO_reference_key_>(pf, ppi, K);
+    dal::pstatic_stored_object o = dal::search_stored_object(pk);
+    if (o) return std::dynamic_pointer_cast<const HHO_reference_values>(o);
+    pHHO_reference_values p
+      = std::make_shared<HHO_reference_values>(pf, ppi, K);
+    dal::add_stored_object(pk, p, dal::AUTODELETE_STATIC_OBJECT);
+    if (dal::exists_stored_object(pf)) dal::add_dependency(p, pf);
+    if (dal::exists_stored_object(ppi)) dal::add_dependency(p, ppi);
+    return p;
+  }
+
+  // M += A_I diag(w) B_I^T where A_I (resp. B_I) is the set of columns of
+  // A (resp. B) corresponding to the integration points ipt0 <= ipt < ipt1,
+  // K columns for each point. M may be larger than the result.
+  static void HHO_add_product(const base_matrix &A, const base_matrix &B,
+                              size_type K, size_type ipt0, size_type ipt1,
+                              const base_vector &w, base_matrix &M) {
+    size_type m = gmm::mat_nrows(A), n = gmm::mat_nrows(B);
+    size_type nc = K*(ipt1 - ipt0);
+    if (!m || !n || !nc) return;
+    GMM_ASSERT1(gmm::mat_nrows(M) >= m && gmm::mat_ncols(M) >= n,
+                "Dimensions mismatch");
+    base_matrix Bw(n, nc);
+    auto itw = Bw.begin();
+    for (size_type ipt = ipt0; ipt < ipt1; ++ipt) {
+      auto it = B.begin() + n*K*ipt;
+      for (size_type l = 0; l < n*K; ++l) *itw++ = w[ipt] * (*it++);
+    }
+#if defined(HHO_USES_BLAS)
+    const BLAS_INT m_ = BLAS_INT(m), n_ = BLAS_INT(n), k_ = BLAS_INT(nc);
+    const BLAS_INT ldm = BLAS_INT(gmm::mat_nrows(M));
+    constexpr char notrans = 'N', trans = 'T';
+    constexpr scalar_type one(1);
+    gmm::dgemm_(&notrans, &trans, &m_, &n_, &k_, &one, &(A(0, K*ipt0)), &m_,
+                &(Bw(0, 0)), &n_, &one, &(M(0, 0)), &ldm);
+#else
+    for (size_type c = 0; c < nc; ++c) {
+      auto ita = A.begin() + m*(K*ipt0 + c);
+      for (size_type j = 0; j < n; ++j) {
+        scalar_type b = Bw(j, c);
+        if (b != scalar_type(0)) {
+          auto itm = M.begin() + gmm::mat_nrows(M)*j;
+          for (size_type i = 0; i < m; ++i) itm[i] += b * ita[i];
+        }
+      }
+    }
+#endif
+  }
+
+  // M(k, i) += sum_{ipt < nbc} w[ipt] * A(i, k + K*ipt)
+  static void HHO_add_means(const base_matrix &A, size_type K, size_type nbc,
+                            const base_vector &w, base_matrix &M) {
+    for (size_type ipt = 0; ipt < nbc; ++ipt)
+      for (size_type k = 0; k < K; ++k)
+        gmm::add(gmm::scaled(gmm::mat_col(A, k + K*ipt), w[ipt]),
+                 gmm::mat_row(M, k));
+  }
+
+  // S(j, k1+k2*N + N*N*ipt) = (A(j, k1+k2*N + ..) + sgn*A(j, k2+k1*N + ..))/2
+  static void HHO_symmetrize(const base_matrix &A, size_type N,
+                             scalar_type sgn, base_matrix &S) {
+    size_type n = gmm::mat_nrows(A), nc = gmm::mat_ncols(A);
+    gmm::resize(S, n, nc);
+    for (size_type c0 = 0; c0 < nc; c0 += N*N)
+      for (size_type k1 = 0; k1 < N; ++k1)
+        for (size_type k2 = 0; k2 < N; ++k2)
+          gmm::add(gmm::scaled(gmm::mat_col(A, c0 + k1 + k2*N), 0.5),
+                   gmm::scaled(gmm::mat_col(A, c0 + k2 + k1*N), 0.5*sgn),
+                   gmm::mat_col(S, c0 + k1 + k2*N));
+  }
+
+  // D = V - Vi on the first rows (the interior dofs of the HHO method).
+  static void HHO_face_jump(const base_matrix &V, const base_matrix &Vi,
+                            base_matrix &D) {
+    gmm::resize(D, gmm::mat_nrows(V), gmm::mat_ncols(V));
+    gmm::copy(V, D);
+    gmm::sub_interval I(0, gmm::mat_nrows(Vi));
+    gmm::sub_interval J(0, gmm::mat_ncols(V));
+    gmm::add(gmm::scaled(Vi, scalar_type(-1)), gmm::sub_matrix(D, I, J));
+  }
+
+  // Inverse of M. For vectorized scalar fems (nbcomp > 1), only the first
+  // diagonal block is inverted and copied on the other ones.
+  static void HHO_lu_inverse(const base_matrix &M, size_type nbcomp,
+                             base_matrix &Minv) {
+    size_type n = gmm::mat_nrows(M);
+    gmm::resize(Minv, n, n);
+    if (nbcomp > 1) {
+      gmm::sub_slice I(0, n/nbcomp, nbcomp);
+      base_matrix Mb(n/nbcomp, n/nbcomp);
+      gmm::copy(gmm::sub_matrix(M, I, I), Mb);
+      gmm::lu_inverse(Mb);
+      gmm::clear(Minv);
+      for (size_type i = 0; i < nbcomp; ++i) {
+        gmm::sub_slice I2(i, n/nbcomp, nbcomp);
+        gmm::copy(Mb, gmm::sub_matrix(Minv, I2, I2));
+      }
+    } else { gmm::copy(M, Minv); gmm::lu_inverse(Minv); }
+  }
+
+  // Geometric data of an element at the integration points.
+  class HHO_element {
+    size_type cv;
+    bgeot::pgeometric_trans pgt;
+    bgeot::pgeotrans_precomp pgp;
+    base_matrix G;
+    std::vector<base_matrix> B_;  // a single one for affine elements
+    std::vector<short_type> face_num;
+    scalar_type J0;
+
+  public:
+    pintegration_method ppi;
+    papprox_integration pim;
+    size_type N, P, nbc, npt;
+    bool affine;
+    base_vector coeff;    // integration weight times J
+    base_matrix un;       // B.n_ref on face points (N x npt)
+    base_vector normun;   // norm of un
+
+    const base_matrix &B(size_type ipt) const
+    { return B_[affine ? 0 : ipt]; }
+
+    // Values (and gradients if Gr is not null) of pf, vectorized on K
+    // components, at all the integration points.
+    void values(pfem pf, size_type K, base_matrix &V,
+                base_matrix *Gr = 0) const;
+
+    // U(j, q + K*ipt) = sum_d A(j, q + K*d + K*N*ipt) un(d, ipt) for the
+    // face points, A having K*N components.
+    void normal_trace(const base_matrix &A, size_type K,
+                      base_matrix &U) const;
+
+    // Inverse of the mass matrix of V (computed on the reference element
+    // for affine elements and standard fems).
+    void mass_inverse(pfem pf, size_type K, const base_matrix &V,
+                      size_type nbcomp, base_matrix &Minv) const;
+
+    HHO_element(const mesh &m, size_type cv_, pintegration_method ppi_);
+  };
+
+  HHO_element::HHO_element(const mesh &m, size_type cv_,
+                           pintegration_method ppi_)
+    : cv(cv_), pgt(m.trans_of_convex(cv_)), ppi(ppi_),
+      pim(ppi_->approx_method()) {
+    N = m.dim(); P = pgt->dim();
+    nbc = pim->nb_points_on_convex(); npt = pim->nb_points();
+    affine = pgt->is_linear();
+    bgeot::vectors_to_base_matrix(G, m.points_of_convex(cv));
+    pgp = bgeot::geotrans_precomp(pgt, pim->pintegration_points(), 0);
+    bgeot::geotrans_interpolation_context ctx(pgp, 0, G);
+
+    B_.resize(affine ? 1 : npt);
+    coeff.resize(npt); normun.resize(npt);
+    gmm::resize(un, N, npt);
+    face_num.assign(npt, short_type(-1));
+    for (size_type ipt = 0; ipt < npt; ++ipt) {
+      if (!affine || ipt == 0) {
+        ctx.set_ii(ipt); J0 = ctx.J();
+        gmm::resize(B_[affine ? 0 : ipt], N, P);
+        gmm::copy(ctx.B(), B_[affine ? 0 : ipt]);
+      }
+      coeff[ipt] = pim->coeff(ipt) * J0;
+    }
+    for (short_type ifc = 0; ifc < pgt->structure()->nb_faces(); ++ifc) {
+      size_type first_ind = pim->ind_first_point_on_face(ifc);
+      for (size_type ipt = first_ind;
+           ipt < first_ind + pim->nb_points_on_face(ifc); ++ipt) {
+        face_num[ipt] = ifc;
+        gmm::mult(B(ipt), pgt->normals()[ifc], gmm::mat_col(un, ipt));
+        normun[ipt] = gmm::vect_norm2(gmm::mat_col(un, ipt));
+      }
+    }
+  }
+
+  void HHO_element::values(pfem pf, size_type K, base_matrix &V,
+                           base_matrix *Gr) const {
+    size_type ndof = pf->nb_dof(cv) * (K / pf->target_dim());
+    gmm::resize(V, ndof, K*npt);
+    if (Gr) { gmm::resize(*Gr, ndof, K*N*npt); gmm::clear(*Gr); }
+
+    if (pf->is_standard()) {
+      pHHO_reference_values ref = HHO_reference(pf, ppi, K);
+      gmm::copy(ref->val, V);
+      if (Gr) {
+        size_type nb = ndof * K;
+        for (size_type ipt = 0; ipt < npt; ++ipt) {
+          auto itr = ref->grad.begin() + nb*P*ipt;
+          auto itg = Gr->begin() + nb*N*ipt;
+          for (size_type d = 0; d < N; ++d)
+            for (size_type r = 0; r < P; ++r) {
+              scalar_type b = B(ipt)(d, r);
+              for (size_type l = 0; l < nb; ++l)
+                itg[l + nb*d] += b * itr[l + nb*r];
+            }
+        }
+      }
+    } else {
+      pfem_precomp pfp = fem_precomp(pf, pim->pintegration_points(), 0);
+      fem_interpolation_context ctx(pgp, pfp, 0, G, cv);
+      base_tensor t, tg; base_matrix tv;
+      for (size_type ipt = 0; ipt < npt; ++ipt) {
+        ctx.set_face_num(face_num[ipt]); ctx.set_ii(ipt);
+        ctx.base_value(t);
+        vectorize_base_tensor(t, tv, ndof, pf->target_dim(), K);
+        std::copy(tv.begin(), tv.end(), V.begin() + ndof*K*ipt);
+        if (Gr) {
+          ctx.grad_base_value(t);
+          vectorize_grad_base_tensor(t, tg, ndof, pf->target_dim(), K);
+          std::copy(tg.begin(), tg.end(), Gr->begin() + ndof*K*N*ipt);
+        }
+      }
+    }
+  }
+
+  void HHO_element::normal_trace(const base_matrix &A, size_type K,
+                                 base_matrix &U) const {
+    gmm::resize(U, gmm::mat_nrows(A), K*npt);
+    gmm::clear(U);
+    for (size_type ipt = nbc; ipt < npt; ++ipt)
+      for (size_type q = 0; q < K; ++q)
+        for (size_type d = 0; d < N; ++d)
+          gmm::add(gmm::scaled(gmm::mat_col(A, q + K*d + K*N*ipt),
+                               un(d, ipt)), gmm::mat_col(U, q + K*ipt));
+  }
+
+  void HHO_element::mass_inverse(pfem pf, size_type K, const base_matrix &V,
+                                 size_type nbcomp, base_matrix &Minv) const {
+    size_type ndof = gmm::mat_nrows(V);
+    if (affine && pf->is_standard()) {
+      pHHO_reference_values ref = HHO_reference(pf, ppi, K);
+      if (gmm::mat_nrows(ref->mass_inv) != ndof) {
+        base_matrix M(ndof, ndof);
+        base_vector w(nbc);
+        for (size_type ipt = 0; ipt < nbc; ++ipt) w[ipt] = pim->coeff(ipt);
+        HHO_add_product(ref->val, ref->val, K, 0, nbc, w, M);
+        HHO_lu_inverse(M, nbcomp, ref->mass_inv);
+      }
+      gmm::resize(Minv, ndof, ndof);
+      gmm::copy(gmm::scaled(ref->mass_inv, scalar_type(1)/J0), Minv);
+    } else {
+      base_matrix M(ndof, ndof);
+      HHO_add_product(V, V, K, 0, nbc, coeff, M);
+      HHO_lu_inverse(M, nbcomp, Minv);
+    }
+  }
+
+
+  class _HHO_reconstructed_gradient
+    : public virtual_elementary_transformation {
+
+  public:
+
+    virtual void give_transformation(const mesh_fem &mf1, const mesh_fem &mf2,
+                                     size_type cv, base_matrix &M) const {
+
+      // The reconstructed Gradient "G" is described on mf2 and computed by
+      // the formula on the element T :
+      // \int_T G.w = \int_T Grad(v_T).w + \int_{dT}(v_{dT} - v_T).(w.n)
+      // where "w" is the test function arbitrary in mf2, "v_T" is the field
+      // inside the element whose gradient is to be reconstructed,
+      // "v_{dT}" is the field on the boundary of T and "n" is the outward
+      // unit normal.
+
+      // Obtaining the fem descriptors
+      pfem pf1 = mf1.fem_of_element(cv);
+      pfem pf2 = mf2.fem_of_element(cv);
+      pfem pfi = interior_fem_of_hho_method(pf1);
+
+      size_type degree = std::max(pf1->estimated_degree(),
+                                  pf2->estimated_degree());
+      bgeot::pgeometric_trans pgt = mf1.linked_mesh().trans_of_convex(cv);
+      pintegration_method ppi
+        = classical_approx_im(pgt, dim_type(2*degree));
+
+      HHO_element elt(mf1.linked_mesh(), cv, ppi);
+      size_type Q = mf1.get_qdim(), N = elt.N;
+      size_type ndof1 = pf1->nb_dof(cv) * (Q / pf1->target_dim());
+      size_type ndof2 = pf2->nb_dof(cv) * (Q*N / pf2->target_dim());
+
+      base_matrix V1, G1, V2, Vi, U, D;
+      elt.values(pf1, Q, V1, &G1);
+      elt.values(pf2, Q*N, V2);
+      elt.values(pfi, Q, Vi);
+      base_matrix M1(ndof2, ndof1), M2inv;
+
+      // Integrals on the element : \int_T Grad(v_T).w (M1)
+      HHO_add_product(V2, G1, Q*N, 0, elt.nbc, elt.coeff, M1);
+
+      // Integrals on the faces : \int_{dT}(v_{dT} - v_T).(w.n) (M1)
+      elt.normal_trace(V2, Q, U);
+      HHO_face_jump(V1, Vi, D);
+      HHO_add_product(U, D, Q, elt.nbc, elt.npt, elt.coeff, M1);
+
+      // Inverse of \int_T G.w (M2)
+      elt.mass_inverse(pf2, Q*N, V2,
+                       (pf2->target_dim() == 1) ? N*Q : 1, M2inv);
+
+      gmm::mult(M2inv, M1, M);
+      gmm::clean(M, gmm::vect_norminf(M.as_vector()) * 1E-13);
+    }
+  };
+
+  void add_HHO_reconstructed_gradient(model &md, std::string name) {
+    pelementary_transformation
+      p = std::make_shared<_HHO_reconstructed_gradient>();
+    md.add_elementary_transformation(name, p);
+  }
+
+
+  class _HHO_reconstructed_sym_gradient
+    : public virtual_elementary_transformation {
+
+  public:
+
+    virtual void give_transformation(const mesh_fem &mf1, const mesh_fem &mf2,
+                                     size_type cv, base_matrix &M) const {
+
+      // The reconstructed symmetric Gradient "G" is described on mf2 and
+      // computed by the formula on the element T :
+      // \int_T G:w =   (1/2)*\int_T 0.5*Grad(v_T):(w+w^T)
+      //              + (1/2)*\int_{dT}(v_{dT} - v_T).((w+w^T).n)
+      // where "w" is the test function arbitrary in mf2, "v_T" is the field
+      // inside the element whose gradient is to be reconstructed,
+      // "v_{dT}" is the field on the boundary of T and "n" is the outward
+      // unit normal.
+
+      // Obtaining the fem descriptors
+      pfem pf1 = mf1.fem_of_element(cv);
+      pfem pf2 = mf2.fem_of_element(cv);
+      pfem pfi = interior_fem_of_hho_method(pf1);
+
+      size_type degree = std::max(pf1->estimated_degree(),
+                                  pf2->estimated_degree());
+      bgeot::pgeometric_trans pgt = mf1.linked_mesh().trans_of_convex(cv);
+      pintegration_method ppi
+        = classical_approx_im(pgt, dim_type(2*degree));
+
+      HHO_element elt(mf1.linked_mesh(), cv, ppi);
+      size_type Q = mf1.get_qdim(), N = elt.N;
+      GMM_ASSERT1(Q == N, "This transformation works only for vector fields "
+                  "having the same dimension as the domain");
+      size_type ndof1 = pf1->nb_dof(cv) * (N / pf1->target_dim());
+      size_type ndof2 = pf2->nb_dof(cv) * (N*N / pf2->target_dim());
+
+      base_matrix V1, G1, V2, V2s, Vi, U, D;
+      elt.values(pf1, N, V1, &G1);
+      elt.values(pf2, N*N, V2);
+      elt.values(pfi, N, Vi);
+      HHO_symmetrize(V2, N, scalar_type(1), V2s);
+      base_matrix M1(ndof2, ndof1), M2inv;
+
+      // Integrals on the element : (1/2)*\int_T 0.5*Grad(v_T):(w+w^T)
+      HHO_add_product(V2s, G1, N*N, 0, elt.nbc, elt.coeff, M1);
+
+      // Integrals on the faces : (1/2)*\int_{dT}(v_{dT} - v_T).((w+w^T).n)
+      elt.normal_trace(V2s, N, U);
+      HHO_face_jump(V1, Vi, D);
+      HHO_add_product(U, D, N, elt.nbc, elt.npt, elt.coeff, M1);
+
+      // Inverse of \int_T G:w (M2)
+      elt.mass_inverse(pf2, N*N, V2,
+                       (pf2->target_dim() == 1) ? N*Q : 1, M2inv);
+
+      gmm::mult(M2inv, M1, M);
+      gmm::clean(M, gmm::vect_norminf(M.as_vector()) * 1E-13);
+    }
+  };
+
+  void add_HHO_reconstructed_symmetrized_gradient(model &md, std::string name) {
+    pelementary_transformation
+      p = std::make_shared<_HHO_reconstructed_sym_gradient>();
+    md.add_elementary_transformation(name, p);
+  }
+
+
+
+  class _HHO_reconstructed_value
+    : public virtual_elementary_transformation {
+
+  public:
+
+    virtual void give_transformation(const mesh_fem &mf1, const mesh_fem &mf2,
+                                     size_type cv, base_matrix &M) const {
+      // The reconstructed variable "D" is described on mf2 and computed by
+      // the formula on the element T :
+      //   \int_T Grad(D).Grad(w) =   \int_T Grad(v_T).Grad(w)
+      //                            + \int_{dT}(v_{dT} - v_T).(Grad(w).n)
+      // with the constraint
+      //   \int_T D = \int_T v_T
+      // where "w" is the test function arbitrary in mf2, "v_T" is the field
+      // inside the element whose gradient is to be reconstructed,
+      // "v_{dT}" is the field on the boundary of T and "n" is the outward
+      // unit normal.
+
+      // Obtaining the fem descriptors
+      pfem pf1 = mf1.fem_of_element(cv);
+      pfem pf2 = mf2.fem_of_element(cv);
+      pfem pfi = interior_fem_of_hho_method(pf1);
+
+      size_type degree = std::max(pf1->estimated_degree(),
+                                  pf2->estimated_degree());
+      bgeot::pgeometric_trans pgt = mf1.linked_mesh().trans_of_convex(cv);
+      pintegration_method ppi
+        = classical_approx_im(pgt, dim_type(2*degree));
+
+      HHO_element elt(mf1.linked_mesh(), cv, ppi);
+      size_type Q = mf1.get_qdim(), N = elt.N;
+      size_type ndof1 = pf1->nb_dof(cv) * (Q / pf1->target_dim());
+      size_type ndof2 = pf2->nb_dof(cv) * (Q / pf2->target_dim());
+
+      base_matrix V1, G1, V2, G2, Vi, U, D;
+      elt.values(pf1, Q, V1, &G1);
+      elt.values(pf2, Q, V2, &G2);
+      elt.values(pfi, Q, Vi);
+      base_matrix M1(ndof2, ndof1), M2(ndof2, ndof2), M2inv;
+      base_matrix M3(Q, ndof1), M4(Q, ndof2);
+      base_matrix aux1(ndof2, ndof1), aux2(ndof2, ndof2);
+      scalar_type area(0);
+      for (size_type ipt = 0; ipt < elt.nbc; ++ipt) area += elt.coeff[ipt];
+
+      // Integrals on the element : \int_T Grad(D).Grad(w) (M2)
+      //                            \int_T Grad(v_T).Grad(w) (M1)
+      //                            \int_T D (M4)  and \int_T v_T (M3)
+      HHO_add_product(G2, G2, Q*N, 0, elt.nbc, elt.coeff, M2);
+      HHO_add_product(G2, G1, Q*N, 0, elt.nbc, elt.coeff, M1);
+      HHO_add_means(V2, Q, elt.nbc, elt.coeff, M4);
+      HHO_add_means(V1, Q, elt.nbc, elt.coeff, M3);
+
+      // Integrals on the faces : \int_{dT}(v_{dT} - v_T).(Grad(w).n) (M1)
+      elt.normal_trace(G2, Q, U);
+      HHO_face_jump(V1, Vi, D);
+      HHO_add_product(U, D, Q, elt.nbc, elt.npt, elt.coeff, M1);
+
+      // Add the constraint with penalization
+      scalar_type coeff_p = pow(area, -1. - 2./scalar_type(N));
+      gmm::mult(gmm::transposed(M4), M4, aux2);
+      gmm::add (gmm::scaled(aux2, coeff_p), M2);
+      gmm::mult(gmm::transposed(M4), M3, aux1);
+      gmm::add (gmm::scaled(aux1, coeff_p), M1);
+
+      HHO_lu_inverse(M2, (pf2->target_dim() == 1 && Q > 1) ? Q : 1, M2inv);
+
+      gmm::mult(M2inv, M1, M);
+      gmm::clean(M, gmm::vect_norminf(M.as_vector()) * 1E-13);
+    }
+  };
+
+  void add_HHO_reconstructed_value(model &md, std::string name) {
+    pelementary_transformation
+      p = std::make_shared<_HHO_reconstructed_value>();
+    md.add_elementary_transformation(name, p);
+  }
+
+
+  class _HHO_reconstructed_sym_value
+    : public virtual_elementary_transformation {
+
+  public:
+
+    virtual void give_transformation(const mesh_fem &mf1, const mesh_fem &mf2,
+                                     size_type cv, base_matrix &M) const {
+      // The reconstructed variable "D" is described on mf2 and computed by
+      // the formula on the element T :
+      //   \int_T Sym(Grad(D)).Grad(w) =   \int_T Sym(Grad(v_T)).Grad(w)
+      //                            + \int_{dT}(v_{dT} - v_T).(Sym(Grad(w)).n)
+      // with the constraints
+      //   \int_T D = \int_T v_T
+      //   \int_T Skew(Grad(D)) = 0.5\int_{dT}(n x v_{dT} - v_{dT} x n)
+      // where "w" is the test function arbitrary in mf2, "v_T" is the field
+      // inside the element whose gradient is to be reconstructed,
+      // "v_{dT}" is the field on the boundary of T and "n" is the outward
+      // unit normal.
+
+      // Obtaining the fem descriptors
+      pfem pf1 = mf1.fem_of_element(cv);
+      pfem pf2 = mf2.fem_of_element(cv);
+      pfem pfi = interior_fem_of_hho_method(pf1);
+
+      size_type degree = std::max(pf1->estimated_degree(),
+                                  pf2->estimated_degree());
+      bgeot::pgeometric_trans pgt = mf1.linked_mesh().trans_of_convex(cv);
+      pintegration_method ppi
+        = classical_approx_im(pgt, dim_type(2*degree));
+
+      HHO_element elt(mf1.linked_mesh(), cv, ppi);
+      size_type Q = mf1.get_qdim(), N = elt.N;
+      GMM_ASSERT1(Q == N, "This transformation works only for vector fields "
+                  "having the same dimension as the domain");
+      size_type ndof1 = pf1->nb_dof(cv) * (N / pf1->target_dim());
+      size_type ndof2 = pf2->nb_dof(cv) * (N / pf2->target_dim());
+
+      base_matrix V1, G1, V2, G2, G2s, G2k, Vi, U, D;
+      elt.values(pf1, N, V1, &G1);
+      elt.values(pf2, N, V2, &G2);
+      elt.values(pfi, N, Vi);
+      HHO_symmetrize(G2, N, scalar_type(1), G2s);
+      HHO_symmetrize(G2, N, scalar_type(-1), G2k);
+      base_matrix M1(ndof2, ndof1), M2(ndof2, ndof2), M2inv;
+      base_matrix M3(N, ndof1), M4(N, ndof2);
+      base_matrix M5(N*N, ndof1), M6(N*N, ndof2);
+      base_matrix aux1(ndof2, ndof1), aux2(ndof2, ndof2);
+      scalar_type area(0);
+      for (size_type ipt = 0; ipt < elt.nbc; ++ipt) area += elt.coeff[ipt];
+
+      // Integrals on the element : \int_T Sym(Grad(D)).Grad(w) (M2)
+      //                            \int_T Sym(Grad(v_T)).Grad(w) (M1)
+      //                            \int_T D (M4)  and \int_T v_T (M3)
+      //                            \int_T Skew(Grad(D)) (M6)
+      HHO_add_product(G2s, G2, N*N, 0, elt.nbc, elt.coeff, M2);
+      HHO_add_product(G2s, G1, N*N, 0, elt.nbc, elt.coeff, M1);
+      HHO_add_means(V2, N, elt.nbc, elt.coeff, M4);
+      HHO_add_means(G2k, N*N, elt.nbc, elt.coeff, M6);
+      HHO_add_means(V1, N, elt.nbc, elt.coeff, M3);
+
+      // Integrals on the faces : \int_{dT}(v_{dT} - v_T).(Sym(Grad(w)).n) (M1)
+      //                          \int_{dT} n x v_{dT} - v_{dT} x n (M5)
+      elt.normal_trace(G2s, N, U);
+      HHO_face_jump(V1, Vi, D);
+      HHO_add_product(U, D, N, elt.nbc, elt.npt, elt.coeff, M1);
+
+      for (size_type ipt = elt.nbc; ipt < elt.npt; ++ipt)
+        for (size_type k1 = 0; k1 < N; ++k1)
+          for (size_type k2 = 0; k2 < N; ++k2) {
+            scalar_type a1 = 0.5 * elt.coeff[ipt] * elt.un(k2, ipt);
+            scalar_type a2 = 0.5 * elt.coeff[ipt] * elt.un(k1, ipt);
+            for (size_type i = 0; i < ndof1; ++i)
+              M5(k1+k2*N, i) += a1 * V1(i, k1 + N*ipt)
+                              - a2 * V1(i, k2 + N*ipt);
+          }
+
+      // Add the constraint with penalization
+      scalar_type coeff_p1 = pow(area, -1. - 2./scalar_type(N));
+      scalar_type coeff_p2 = pow(area, -1. - 1./scalar_type(N));
+      gmm::mult(gmm::transposed(M4), M4, aux2);
+      gmm::add (gmm::scaled(aux2, coeff_p1), M2);
+      gmm::mult(gmm::transposed(M6), M6, aux2);
+      gmm::add (gmm::scaled(aux2, coeff_p2), M2);
+      gmm::mult(gmm::transposed(M4), M3, aux1);
+      gmm::add (gmm::scaled(aux1, coeff_p1), M1);
+      gmm::mult(gmm::transposed(M6), M5, aux1);
+      gmm::add (gmm::scaled(aux1, coeff_p2), M1);
+
+      HHO_lu_inverse(M2, 1, M2inv);
+
+      gmm::mult(M2inv, M1, M);
+      gmm::clean(M, gmm::vect_norminf(M.as_vector()) * 1E-13);
+    }
+  };
+
+  void add_HHO_reconstructed_symmetrized_value(model &md, std::string name) {
+    pelementary_transformation
+      p = std::make_shared<_HHO_reconstructed_sym_value>();
+    md.add_elementary_transformation(name, p);
+  }
+
+#if 0 //  Old single mef version
+
+class _HHO_stabilization
+    : public virtual_elementary_transformation {
+
+  public:
+
+    virtual void give_transformation(const mesh_fem &mf1, const mesh_fem &mf2,
+                                     size_type cv, base_matrix &M) const {
+      // The reconstructed variable "S" is described on mf2 and computed by
+      // S(v) = P_{\dT}(v_{dT} - D(v)  - P_T(v_T - D(v)))
+      // where P__{\dT} et P_T are L2 projections on the boundary and on the
+      // interior of T on the corresponding discrete spaces.
+      // Note that P_{\dT}(v_{dT}) = v_{dT} and P_T(v_T) = v_T and D is
+      // the reconstructed value on P^{k+1} given by the formula:
+      //   \int_T Grad(D).Grad(w) =   \int_T Grad(v_T).Grad(w)
+      //                            + \int_{dT}(v_{dT} - v_T).(Grad(w).n)
+      // with the constraint
+      //   \int_T D = \int_T v_T
+      // where "w" is the test function arbitrary in mf2, "v_T" is the field
+      // inside the element whose gradient is to be reconstructed,
+      // "v_{dT}" is the field on the boundary of T and "n" is the outward
+      // unit normal.
+      // The implemented formula is
+      // S(v) = v_{dT} - P_{\dT}D(v) - P_{\dT}(v_T) + P_{\dT}(P_T(D(v)))
+      // by the mean of the projection matrix from P^{k+1} to the original space
+      // and the projection matrix from interior space to the boundary space.
+      // As it is built, S(v) is zero on interior dofs.
+      
+      GMM_ASSERT1(&mf1 == &mf2, "The HHO stabilization transformation is "
+                  "only defined on the HHO space to itself");
+
+      // Obtaining the fem descriptors
+      pfem pf1 = mf1.fem_of_element(cv);
+      short_type degree = pf1->estimated_degree();
+      bgeot::pgeometric_trans pgt = mf1.linked_mesh().trans_of_convex(cv);
+      pfem pf2 = classical_fem(pgt, short_type(degree + 1)); // Should be
+                                         // changed for an interior PK method
+      pfem pfi = interior_fem_of_hho_method(pf1);
+
+      papprox_integration pim
+        = classical_approx_im(pgt, dim_type(2*degree+2))->approx_method();
+
+      base_matrix G;
+      bgeot::vectors_to_base_matrix(G, mf1.linked_mesh().points_of_convex(cv));
+
+      bgeot::pgeotrans_precomp pgp
+        = bgeot::geotrans_precomp(pgt, pim->pintegration_points(), 0);
+      pfem_precomp pfp1 = fem_precomp(pf1, pim->pintegration_points(), 0);
+      pfem_precomp pfp2 = fem_precomp(pf2, pim->pintegration_points(), 0);
+      pfem_precomp pfpi = fem_precomp(pfi, pim->pintegration_points(), 0);
+      
+      fem_interpolation_context ctx1(pgp, pfp1, 0, G, cv);
+      fem_interpolation_context ctx2(pgp, pfp2, 0, G, cv);
+      fem_interpolation_context ctxi(pgp, pfpi, 0, G, cv);
+
+      size_type Q = mf1.get_qdim(), N = mf1.linked_mesh().dim();
+      base_vector un(N);
+      size_type qmult1 =  Q / pf1->target_dim();
+      size_type ndof1 = pf1->nb_dof(cv) * qmult1;
+      size_type qmult2 =  Q / pf2->target_dim();
+      size_type ndof2 = pf2->nb_dof(cv) * qmult2;
+      size_type qmulti =  Q / pfi->target_dim();
+      size_type ndofi = pfi->nb_dof(cv) * qmulti;
+
+      
+      base_tensor t1, t2, ti, tv1, tv2, t1p, t2p;
+      base_matrix tv1p, tv2p, tvi;
+      base_matrix M1(ndof2, ndof1), M2(ndof2, ndof2), M2inv(ndof2, ndof2);
+      base_matrix M3(Q, ndof1), M4(Q, ndof2);
+      base_matrix aux1(ndof2, ndof1), aux2(ndof2, ndof2);
+      base_matrix M7(ndof1, ndof1), M7inv(ndof1, ndof1), M8(ndof1, ndof2);
+      base_matrix M9(ndof1, ndof1), MD(ndof2, ndof1);
+      scalar_type area(0);
+
+      // Integrals on the element : \int_T Grad(D).Grad(w) (M2)
+      //                            \int_T Grad(v_T).Grad(w) (M1)
+      //                            \int_T D (M4)  and \int_T v_T (M3)
+      for (size_type ipt = 0; ipt < pim->nb_points_on_convex(); ++ipt) {
+        ctx1.set_ii(ipt); ctx2.set_ii(ipt);
+        scalar_type coeff = pim->coeff(ipt) * ctx1.J();
+        area += coeff;
+        
+        ctx1.grad_base_value(t1);
+        vectorize_grad_base_tensor(t1, tv1, ndof1, pf1->target_dim(), Q);
+
+        ctx1.base_value(t1p);
+        vectorize_base_tensor(t1p, tv1p, ndof1, pf1->target_dim(), Q);
+
+        ctx2.grad_base_value(t2);
+        vectorize_grad_base_tensor(t2, tv2, ndof2, pf2->target_dim(), Q);
+
+        ctx2.base_value(t2p);
+        vectorize_base_tensor(t2p, tv2p, ndof2, pf2->target_dim(), Q);
+
+        for (size_type i = 0; i < ndof2; ++i) // To be optimized
+          for (size_type j = 0; j < ndof2; ++j)
+            for (size_type k = 0; k < Q*N; ++k)
+              M2(j, i) += coeff * tv2.as_vector()[i+k*ndof2]
+                                * tv2.as_vector()[j+k*ndof2];
+
+        for (size_type i = 0; i < ndof2; ++i)
+          for (size_type k = 0; k < Q; ++k)
+            M4(k,  i) += coeff * tv2p(i, k);
+              
+        for (size_type i = 0; i < ndof1; ++i) // To be optimized
+          for (size_type j = 0; j < ndof2; ++j)
+            for (size_type k = 0; k < Q*N; ++k)
+              M1(j, i) += coeff * tv1.as_vector()[i+k*ndof1]
+                                * tv2.as_vector()[j+k*ndof2];
+
+        for (size_type i = 0; i < ndof1; ++i)
+          for (size_type k = 0; k < Q; ++k)
+            M3(k,  i) += coeff * tv1p(i, k);
+
+        for (size_type i = 0; i < ndof1; ++i) // To be optimized
+          for (size_type j = 0; j < ndof1; ++j)
+            for (size_type k = 0; k < Q; ++k)
+              M7(i, j) += coeff * tv1p(i, k) * tv1p(j, k);
+        
+        for (size_type i = 0; i < ndof1; ++i) // To be optimized
+          for (size_type j = 0; j < ndof2; ++j)
+            for (size_type k = 0; k < Q; ++k)
+              M8(i, j) += coeff * tv1p(i, k) * tv2p(j, k);
+
+      }
+
+      // Integrals on the faces : \int_{dT}(v_{dT} - v_T).(Grad(w).n) (M1)
+      for (short_type ifc = 0; ifc < pgt->structure()->nb_faces(); ++ifc) {
+        ctx1.set_face_num(ifc); ctx2.set_face_num(ifc); ctxi.set_face_num(ifc);
+        size_type first_ind = pim->ind_first_point_on_face(ifc);
+        for (size_type ipt = 0; ipt < pim->nb_points_on_face(ifc); ++ipt) {
+          ctx1.set_ii(first_ind+ipt);
+          ctx2.set_ii(first_ind+ipt);
+          ctxi.set_ii(first_ind+ipt);
+          scalar_type coeff = pim->coeff(first_ind+ipt) * ctx1.J();
+          gmm::mult(ctx1.B(), pgt->normals()[ifc], un);
+          scalar_type normun = gmm::vect_norm2(un);
+          
+          ctx2.grad_base_value(t2);
+          vectorize_grad_base_tensor(t2, tv2, ndof2, pf2->target_dim(), Q);
+
+          ctx2.base_value(t2p);
+          vectorize_base_tensor(t2p, tv2p, ndof2, pf2->target_dim(), Q);
+
+          ctx1.base_value(t1);
+          vectorize_base_tensor(t1, tv1p, ndof1, pf1->target_dim(), Q);
+          
+          ctxi.base_value(ti);
+          vectorize_base_tensor(ti, tvi, ndofi, pfi->target_dim(), Q);
+
+
+          for (size_type i = 0; i < ndof1; ++i) // To be optimized
+            for (size_type j = 0; j < ndof2; ++j)
+              for (size_type k1 = 0; k1 < Q; ++k1) {
+                scalar_type b(0), a = coeff *
+                  (tv1p(i, k1) - (i < ndofi ? tvi(i, k1) : 0.));
+                for (size_type k2 = 0; k2 < N; ++k2)
+                  b += a * tv2.as_vector()[j+(k1 + k2*Q)*ndof2] * un[k2];
+                M1(j, i) += b;
+              }
+
+          for (size_type i = 0; i < ndof1; ++i) // To be optimized
+            for (size_type j = 0; j < ndof1; ++j)
+              for (size_type k = 0; k < Q; ++k)
+                M7(i, j) += coeff * normun * tv1p(i,k) * tv1p(j, k);
+
+          for (size_type i = 0; i < ndof1; ++i) // To be optimized
+            for (size_type j = 0; j < ndof2; ++j)
+              for (size_type k = 0; k < Q; ++k)
+                M8(i, j) += coeff * normun * tv1p(i,k) * tv2p(j, k);
+
+          for (size_type i = 0; i < ndof1; ++i) // To be optimized
+            for (size_type j = 0; j < ndofi; ++j)
+              for (size_type k = 0; k < Q; ++k)
+                M9(i, j) += coeff * normun * tv1p(i,k) * tvi(j, k); 
+        }
+      }
+
+      // Add the constraint with penalization
+      scalar_type coeff_p = pow(area, -1. - 2./scalar_type(N));
+      gmm::mult(gmm::transposed(M4), M4, aux2);
+      gmm::add (gmm::scaled(aux2, coeff_p), M2);
+      gmm::mult(gmm::transposed(M4), M3, aux1);
+      gmm::add (gmm::scaled(aux1, coeff_p), M1);
+
+      if (pf2->target_dim() == 1 && Q > 1) {
+        gmm::sub_slice I(0, ndof2/Q, Q);
+        gmm::lu_inverse(gmm::sub_matrix(M2, I, I));
+        for (size_type i = 0; i < Q; ++i) {
+          gmm::sub_slice I2(i, ndof2/Q, Q);
+          gmm::copy(gmm::sub_matrix(M2, I, I), gmm::sub_matrix(M2inv, I2, I2));
+        }
+      } else 
+        { gmm::copy(M2, M2inv); gmm::lu_inverse(M2inv); }
+      
+      if (pf1->target_dim() == 1 && Q > 1) {
+        gmm::sub_slice I(0, ndof1/Q, Q);
+        gmm::lu_inverse(gmm::sub_matrix(M7, I, I));
+        for (size_type i = 0; i < Q; ++i) {
+          gmm::sub_slice I2(i, ndof1/Q, Q);
+          gmm::copy(gmm::sub_matrix(M7, I, I), gmm::sub_matrix(M7inv, I2, I2));
+        }
+      } else
+        { gmm::copy(M7, M7inv); gmm::lu_inverse(M7inv); }
+      
+      gmm::mult(M2inv, M1, MD);
+      gmm::clean(MD, gmm::vect_norminf(MD.as_vector()) * 1E-13);
+
+      // S  = (I - inv(M7)*M9)(I - inv(M7)*M8*MD)
+      base_matrix MPB(ndof1, ndof1);
+      gmm::mult(M7inv, M9, MPB);
+      gmm::copy(gmm::identity_matrix(), M9);
+      gmm::add(gmm::scaled(MPB, scalar_type(-1)), M9);
+
+      base_matrix MPC(ndof1, ndof1), MPD(ndof1, ndof1);
+      gmm::mult(M8, MD, MPC);
+      gmm::mult(M7inv, MPC, MPD);
+      gmm::copy(gmm::identity_matrix(), M7);
+      gmm::add(gmm::scaled(MPD, scalar_type(-1)), M7);
+
+      gmm::mult(M9, M7, M);
+      gmm::clean(M, 1E-13);
+    }
+  };
+
+  void add_HHO_stabilization(model &md, std::string name) {
+    pelementary_transformation
+      p = std::make_shared<_HHO_stabilization>();
+    md.add_elementary_transformation(name, p);
+  }
+
+
+#else
+  
+
+  class _HHO_stabilization
+    : public virtual_elementary_transformation {
+
+  public:
+
+    virtual void give_transformation(const mesh_fem &mf1, const mesh_fem &mf2,
+                                     size_type cv, base_matrix &M) const {
+      // The reconstructed variable "S" is described on mf2 and computed by
+      // S(v) = P_{\dT}(v_{dT} - D(v)  - P_T(v_T - D(v)))
+      // where P_{\dT} et P_T are L2 projections on the boundary and on the
+      // interior of T on the corresponding discrete spaces.
+      // Note that P_{\dT}(v_{dT}) = v_{dT} and P_T(v_T) = v_T and D is
+      // the reconstructed value on P^{k+1} given by the formula:
+      //   \int_T Grad(D).Grad(w) =   \int_T Grad(v_T).Grad(w)
+      //                            + \int_{dT}(v_{dT} - v_T).(Grad(w).n)
+      // with the constraint
+      //   \int_T D = \int_T v_T
+      // where "w" is the test function arbitrary in mf2, "v_T" is the field
+      // inside the element whose gradient is to be reconstructed,
+      // "v_{dT}" is the field on the boundary of T and "n" is the outward
+      // unit normal.
+      // The implemented formula is
+      // S(v) = P_{\dT}(v_{dT} - D(v) - P_T(v_T - D(v)) )
+      // by the mean of the projection matrix from P^{k+1} to the target space
+      // and the projection matrix from interior space to the boundary space.
+      // As it is built, S(v) is zero on interior dofs.
+
+      // Obtaining the fem descriptors
+      pfem pf1 = mf1.fem_of_element(cv);
+      short_type degree = pf1->estimated_degree();
+      bgeot::pgeometric_trans pgt = mf1.linked_mesh().trans_of_convex(cv);
+      pfem pf2 = classical_fem(pgt, short_type(degree + 1)); // Should be
+                                         // changed for an interior PK method
+      pfem pf3 = mf2.fem_of_element(cv);
+      pfem pf1i = interior_fem_of_hho_method(pf1);
+      pfem pf3i = interior_fem_of_hho_method(pf3);
+
+      pintegration_method ppi
+        = classical_approx_im(pgt, dim_type(2*degree+2));
+
+      HHO_element elt(mf1.linked_mesh(), cv, ppi);
+      size_type Q = mf1.get_qdim(), N = elt.N;
+      size_type ndof1 = pf1->nb_dof(cv) * (Q / pf1->target_dim());
+      size_type ndof2 = pf2->nb_dof(cv) * (Q / pf2->target_dim());
+      size_type ndof3 = pf3->nb_dof(cv) * (Q / pf3->target_dim());
+
+      base_matrix V1, G1, V2, G2, V3, V1i, V3i, U, D;
+      elt.values(pf1, Q, V1, &G1);
+      elt.values(pf2, Q, V2, &G2);
+      elt.values(pf3, Q, V3);
+      elt.values(pf1i, Q, V1i);
+      elt.values(pf3i, Q, V3i);
+      base_matrix M1(ndof2, ndof1), M2(ndof2, ndof2), M2inv;
+      base_matrix M3(Q, ndof1), M4(Q, ndof2);
+      base_matrix aux1(ndof2, ndof1), aux2(ndof2, ndof2);
+      base_matrix M7(ndof3, ndof3), M7inv, M8(ndof3, ndof2);
+      base_matrix M9(ndof3, ndof1), M10(ndof3, ndof3), MD(ndof2, ndof1);
+      scalar_type area(0);
+      for (size_type ipt = 0; ipt < elt.nbc; ++ipt) area += elt.coeff[ipt];
+      base_vector coeffb(elt.coeff); // weights for the L2 projections
+      for (size_type ipt = elt.nbc; ipt < elt.npt; ++ipt)
+        coeffb[ipt] *= elt.normun[ipt];
+
+      // Integrals on the element : \int_T Grad(D).Grad(w) (M2)
+      //                            \int_T Grad(v_T).Grad(w) (M1)
+      //                            \int_T D (M4)  and \int_T v_T (M3)
+      HHO_add_product(G2, G2, Q*N, 0, elt.nbc, elt.coeff, M2);
+      HHO_add_product(G2, G1, Q*N, 0, elt.nbc, elt.coeff, M1);
+      HHO_add_means(V2, Q, elt.nbc, elt.coeff, M4);
+      HHO_add_means(V1, Q, elt.nbc, elt.coeff, M3);
+
+      // Integrals on the faces : \int_{dT}(v_{dT} - v_T).(Grad(w).n) (M1)
+      elt.normal_trace(G2, Q, U);
+      HHO_face_jump(V1, V1i, D);
+      HHO_add_product(U, D, Q, elt.nbc, elt.npt, elt.coeff, M1);
+
+      // Integrals on the element and on the faces for the L2 projections
+      HHO_add_product(V3, V3, Q, 0, elt.npt, coeffb, M7);
+      HHO_add_product(V3, V2, Q, 0, elt.npt, coeffb, M8);
+      HHO_add_product(V3, V1, Q, 0, elt.npt, coeffb, M9);
+      HHO_add_product(V3, V3i, Q, elt.nbc, elt.npt, coeffb, M10);
+
+      // Add the constraint with penalization
+      scalar_type coeff_p = pow(area, -1. - 2./scalar_type(N));
+      gmm::mult(gmm::transposed(M4), M4, aux2);
+      gmm::add (gmm::scaled(aux2, coeff_p), M2);
+      gmm::mult(gmm::transposed(M4), M3, aux1);
+      gmm::add (gmm::scaled(aux1, coeff_p), M1);
+
+      HHO_lu_inverse(M2, (pf2->target_dim() == 1 && Q > 1) ? Q : 1, M2inv);
+      HHO_lu_inverse(M7, (pf3->target_dim() == 1 && Q > 1) ? Q : 1, M7inv);
+
+      gmm::mult(M2inv, M1, MD);
+      gmm::clean(MD, gmm::vect_norminf(MD.as_vector()) * 1E-13);
+
+      // S  = (I - inv(M7)*M10)*inv(M7)*(M9 - M8*MD)
+      base_matrix MPB(ndof3, ndof3);
+      gmm::mult(M7inv, M10, MPB);
+      gmm::copy(gmm::identity_matrix(), M10);
+      gmm::add(gmm::scaled(MPB, scalar_type(-1)), M10);
+
+      base_matrix MPC(ndof3, ndof1);
+      gmm::mult(gmm::scaled(M8, scalar_type(-1)), MD, MPC);
+      gmm::add(M9, MPC);
+      gmm::mult(M7inv, MPC, M9);
+      gmm::mult(M10, M9, M);
+      gmm::clean(M, 1E-13);
+    }
+  };
+
+  void add_HHO_stabilization(model &md, std::string name) {
+    pelementary_transformation
+      p = std::make_shared<_HHO_stabilization>();
+    md.add_elementary_transformation(name, p);
+  }
+
+#endif
+
+  class _HHO_symmetrized_stabilization
+    : public virtual_elementary_transformation {
+
+  public:
+
+    virtual void give_transformation(const mesh_fem &mf1, const mesh_fem &mf2,
+                                     size_type cv, base_matrix &M) const {
+      // The reconstructed variable "S" is described on mf2 and computed by
+      // S(v) = P_{\dT}(v_{dT} - D(v)  - P_T(v_T - D(v)))
+      // where P_{\dT} et P_T are L2 projections on the boundary and on the
+      // interior of T on the corresponding discrete spaces.
+      // Note that P_{\dT}(v_{dT}) = v_{dT} and P_T(v_T) = v_T and D is
+      // the reconstructed value on P^{k+1} given by the formula:
+      //   \int_T Sym(Grad(D)).Grad(w) =   \int_T Sym(Grad(v_T)).Grad(w)
+      //                            + \int_{dT}(v_{dT} - v_T).(Sym(Grad(w)).n)
+      // with the constraints
+      //   \int_T D = \int_T v_T
+      //   \int_T Skew(Grad(D)) = 0.5\int_{dT}(n x v_{dT} - v_{dT} x n)
+      // where "w" is the test function arbitrary in mf2, "v_T" is the field
+      // inside the element whose gradient is to be reconstructed,
+      // "v_{dT}" is the field on the boundary of T and "n" is the outward
+      // unit normal.
+      // The implemented formula is
+      // S(v) = P_{\dT}(v_{dT} - D(v) - P_T(v_T - D(v)) )
+      // by the mean of the projection matrix from P^{k+1} to the target space
+      // and the projection matrix from interior space to the boundary space.
+      // As it is built, S(v) is zero on interior dofs.
+
+      // Obtaining the fem descriptors
+      pfem pf1 = mf1.fem_of_element(cv);
+      short_type degree = pf1->estimated_degree();
+      bgeot::pgeometric_trans pgt = mf1.linked_mesh().trans_of_convex(cv);
+      pfem pf2 = classical_fem(pgt, short_type(degree + 1)); // Should be changed to an
+                                                 // interior PK method
+      pfem pf3 = mf2.fem_of_element(cv);
+      pfem pf1i = interior_fem_of_hho_method(pf1);
+      pfem pf3i = interior_fem_of_hho_method(pf3);
+
+      pintegration_method ppi
+        = classical_approx_im(pgt, dim_type(2*degree+2));
+
+      HHO_element elt(mf1.linked_mesh(), cv, ppi);
+      size_type Q = mf1.get_qdim(), N = elt.N;
+      GMM_ASSERT1(Q == N, "This transformation works only for vector fields "
+                  "having the same dimension as the domain");
+      size_type ndof1 = pf1->nb_dof(cv) * (N / pf1->target_dim());
+      size_type ndof2 = pf2->nb_dof(cv) * (N / pf2->target_dim());
+      size_type ndof3 = pf3->nb_dof(cv) * (Q / pf3->target_dim());
+
+      base_matrix V1, G1, V2, G2, G2s, G2k, V3, V1i, V3i, U, D;
+      elt.values(pf1, N, V1, &G1);
+      elt.values(pf2, N, V2, &G2);
+      elt.values(pf3, Q, V3);
+      elt.values(pf1i, Q, V1i);
+      elt.values(pf3i, Q, V3i);
+      HHO_symmetrize(G2, N, scalar_type(1), G2s);
+      HHO_symmetrize(G2, N, scalar_type(-1), G2k);
+      base_matrix M1(ndof2, ndof1), M2(ndof2, ndof2), M2inv;
+      base_matrix M3(N, ndof1), M4(N, ndof2);
+      base_matrix aux1(ndof2, ndof1), aux2(ndof2, ndof2);
+      base_matrix M5(N*N, ndof1), M6(N*N, ndof2);
+      base_matrix M7(ndof3, ndof3), M7inv, M8(ndof3, ndof2);
+      base_matrix M9(ndof3, ndof1), M10(ndof3, ndof3), MD(ndof2, ndof1);
+      scalar_type area(0);
+      for (size_type ipt = 0; ipt < elt.nbc; ++ipt) area += elt.coeff[ipt];
+      base_vector coeffb(elt.coeff); // weights for the L2 projections
+      for (size_type ipt = elt.nbc; ipt < elt.npt; ++ipt)
+        coeffb[ipt] *= elt.normun[ipt];
+
+      // Integrals on the element : \int_T Sym(Grad(D)).Grad(w) (M2)
+      //                            \int_T Sym(Grad(v_T)).Grad(w) (M1)
+      //                            \int_T D (M4)  and \int_T v_T (M3)
+      //                            \int_T Skew(Grad(D)) (M6)
+      HHO_add_product(G2s, G2, N*N, 0, elt.nbc, elt.coeff, M2);
+      HHO_add_product(G2s, G1, N*N, 0, elt.nbc, elt.coeff, M1);
+      HHO_add_means(V2, N, elt.nbc, elt.coeff, M4);
+      HHO_add_means(G2k, N*N, elt.nbc, elt.coeff, M6);
+      HHO_add_means(V1, N, elt.nbc, elt.coeff, M3);
+
+      // Integrals on the faces : \int_{dT}(v_{dT} - v_T).(Grad(w).n) (M1)
+      //                          \int_{dT} Skew(n x v_{dT} - v_{dT} x n) (M5)
+      elt.normal_trace(G2s, N, U);
+      HHO_face_jump(V1, V1i, D);
+      HHO_add_product(U, D, N, elt.nbc, elt.npt, elt.coeff, M1);
+
+      for (size_type ipt = elt.nbc; ipt < elt.npt; ++ipt)
+        for (size_type k1 = 0; k1 < N; ++k1)
+          for (size_type k2 = 0; k2 < N; ++k2) {
+            scalar_type a1 = 0.5 * elt.coeff[ipt] * elt.un(k2, ipt);
+            scalar_type a2 = 0.5 * elt.coeff[ipt] * elt.un(k1, ipt);
+            for (size_type i = 0; i < ndof1; ++i)
+              M5(k1+k2*N, i) += a1 * V1(i, k1 + N*ipt)
+                              - a2 * V1(i, k2 + N*ipt);
+          }
+
+      // Integrals on the element and on the faces for the L2 projections
+      HHO_add_product(V3, V3, Q, 0, elt.npt, coeffb, M7);
+      HHO_add_product(V3, V2, Q, 0, elt.npt, coeffb, M8);
+      HHO_add_product(V3, V1, Q, 0, elt.npt, coeffb, M9);
+      HHO_add_product(V3, V3i, Q, elt.nbc, elt.npt, coeffb, M10);
+
+      // Add the constraint with penalization
+      scalar_type coeff_p1 = pow(area, -1. - 2./scalar_type(N));
+      scalar_type coeff_p2 = pow(area, -1. - 1./scalar_type(N));
+      gmm::mult(gmm::transposed(M4), M4, aux2);
+      gmm::add (gmm::scaled(aux2, coeff_p1), M2);
+      gmm::mult(gmm::transposed(M6), M6, aux2);
+      gmm::add (gmm::scaled(aux2, coeff_p2), M2);
+      gmm::mult(gmm::transposed(M4), M3, aux1);
+      gmm::add (gmm::scaled(aux1, coeff_p1), M1);
+      gmm::mult(gmm::transposed(M6), M5, aux1);
+      gmm::add (gmm::scaled(aux1, coeff_p2), M1);
+
+      HHO_lu_inverse(M2, 1, M2inv);
+      HHO_lu_inverse(M7, (pf3->target_dim() == 1 && Q > 1) ? Q : 1, M7inv);
+
+      gmm::mult(M2inv, M1, MD);
+      gmm::clean(MD, gmm::vect_norminf(MD.as_vector()) * 1E-13);
+
+      // S  = (I - inv(M7)*M10)*inv(M7)*(M9 - M8*MD)
+      base_matrix MPB(ndof3, ndof3);
+      gmm::mult(M7inv, M10, MPB);
+      gmm::copy(gmm::identity_matrix(), M10);
+      gmm::add(gmm::scaled(MPB, scalar_type(-1)), M10);
+
+      base_matrix MPC(ndof3, ndof1);
+      gmm::mult(gmm::scaled(M8, scalar_type(-1)), MD, MPC);
+      gmm::add(M9, MPC);
+      gmm::mult(M7inv, MPC, M9);
+      gmm::mult(M10, M9, M);
+      gmm::clean(M, 1E-13);
+    }
+  };
+
+  void add_HHO_symmetrized_stabilization(model &md, std::string name) {
+    pelementary_transformation
+      p = std::make_shared<_HHO_symmetrized_stabilization>();
+    md.add_elementary_transformation(name, p);
+  }
+
+
+
+
+
+}  /* end of namespace getfem.                                             */
+
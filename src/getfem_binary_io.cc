@@ -0,0 +1,202 @@
+/*===========================================================================
+
+ Copyright (C) 2026 agent.
+
+ This file is a part of GetFEM
+
+ GetFEM  is  free software;  you  can  redistribute  it  and/or modify it
+ under  the  terms  of the  GNU  Lesser General Public License as published
+ by  the  Free Software Foundation;  either version 3 of the License,  or
+ (at your option) any later version along with the GCC Runtime Library
+ Exception either version 3.1 or (at your option) any later version.
+ This program  is  distributed  in  the  hope  that it will be useful,  but
+ WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ or  FITNESS  FOR  A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ License and GCC Runtime Library Exception for more details.
+ You  should  have received a copy of the GNU Lesser General Public License
+ along  with  this program. If not, see https://www.gnu.org/licenses/.
+
+===========================================================================*/
+
+#include <fstream>
+#include <cstring>
+#include "getfem/getfem_binary_io.h"
+#ifndef _WIN32
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <fcntl.h>
+#  include <unistd.h>
+#endif
+
+namespace getfem {
+
+  static const char binary_magic[8] = {'G','E','T','F','E','M','B','\n'};
+  static const gmm::uint32_type binary_endian_tag = 0x01020304;
+  static const size_t binary_header_size = 24;
+
+  bool is_binary_file(const std::string &name) {
+    std::ifstream f(name.c_str(), std::ios::binary);
+    char magic[8];
+    if (!f || !f.read(magic, 8)) return false;
+    return !memcmp(magic, binary_magic, 8);
+  }
+
+  /* ******************************************************************** */
+  /*    Writer.                                                           */
+  /* ******************************************************************** */
+
+  binary_file_writer::binary_file_writer(std::ostream &o)
+    : ost(o), section_size(0), in_section(false) {
+    gmm::uint32_type h[2] = { BINARY_FORMAT_VERSION, binary_endian_tag };
+    gmm::uint64_type reserved(0);
+    ost.write(binary_magic, 8);
+    ost.write(reinterpret_cast<const char *>(h), sizeof(h));
+    ost.write(reinterpret_cast<const char *>(&reserved), sizeof(reserved));
+  }
+
+  binary_file_writer::~binary_file_writer() {
+    if (in_section) end_section();
+    begin_section(BINARY_END);
+    end_section();
+    ost.flush();
+  }
+
+  void binary_file_writer::write_raw(const void *p, size_t nbytes) {
+    GMM_ASSERT1(in_section, "Data written outside of a section");
+    ost.write(reinterpret_cast<const char *>(p), std::streamsize(nbytes));
+    section_size += nbytes;
+  }
+
+  void binary_file_writer::pad() {
+    static const char zeros[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    size_t r = size_t(section_size % 8);
+    if (r) write_raw(zeros, 8 - r);
+  }
+
+  void binary_file_writer::begin_section(binary_section_tag t) {
+    GMM_ASSERT1(!in_section, "Unterminated section");
+    gmm::uint64_type h[2] = { gmm::uint64_type(t), 0 };
+    ost.write(reinterpret_cast<const char *>(h), sizeof(h));
+    section_pos = ost.tellp();
+    section_size = 0; in_section = true;
+  }
+
+  void binary_file_writer::end_section() {
+    GMM_ASSERT1(in_section, "No section to terminate");
+    std::streampos pos = ost.tellp();
+    ost.seekp(section_pos - std::streamoff(sizeof(gmm::uint64_type)));
+    ost.write(reinterpret_cast<const char *>(&section_size),
+              sizeof(section_size));
+    ost.seekp(pos);
+    in_section = false;
+    GMM_ASSERT1(ost, "Error while writing a binary file");
+  }
+
+  void binary_file_writer::write_strings(const std::vector<std::string> &s) {
+    std::vector<gmm::uint64_type> ptr(s.size()+1, 0);
+    for (size_type i = 0; i < s.size(); ++i) ptr[i+1] = ptr[i] + s[i].size();
+    write(s.size());
+    write_array(ptr);
+    for (const std::string &str : s) write_raw(str.data(), str.size());
+    pad();
+  }
+
+  /* ******************************************************************** */
+  /*    Reader.                                                           */
+  /* ******************************************************************** */
+
+  const char *binary_file_reader::section::read_raw(size_t nbytes) {
+    size_t padded = (nbytes + 7) & ~size_t(7);
+    GMM_ASSERT1(size_t(e - p) >= padded, "Truncated section in binary file");
+    const char *r = p; p += padded;
+    return r;
+  }
+
+  gmm::uint64_type binary_file_reader::section::read()
+  { return *read_array<gmm::uint64_type>(1); }
+
+  std::vector<std::string> binary_file_reader::section::read_strings() {
+    size_type n = size_type(read());
+    const gmm::uint64_type *ptr = read_array<gmm::uint64_type>(n+1);
+    const char *c = read_raw(size_t(ptr[n]));
+    std::vector<std::string> s(n);
+    for (size_type i = 0; i < n; ++i)
+      s[i] = std::string(c + ptr[i], c + ptr[i+1]);
+    return s;
+  }
+
+  binary_file_reader::file_mapping::~file_mapping() {
+#ifndef _WIN32
+    if (data) munmap(const_cast<char *>(data), size);
+#endif
+  }
+
+  binary_file_reader::binary_file_reader(const std::string &name)
+    : name_(name), data(0), size_(0) {
+#ifndef _WIN32
+    int fd = open(name.c_str(), O_RDONLY);
+    GMM_ASSERT1(fd >= 0, "Binary file '" << name << "' does not exist");
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+      void *p = mmap(0, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+      if (p != MAP_FAILED) {
+        mapping.data = data = static_cast<const char *>(p);
+        mapping.size = size_ = size_t(st.st_size);
+      }
+    }
+    close(fd);
+#endif
+    if (!mapping.data) {
+      std::ifstream f(name.c_str(), std::ios::binary | std::ios::ate);
+      GMM_ASSERT1(f, "Binary file '" << name << "' does not exist");
+      size_ = size_t(f.tellg());
+      buffer.resize((size_ + 7) / 8);
+      f.seekg(0);
+      f.read(reinterpret_cast<char *>(buffer.data()),
+             std::streamsize(size_));
+      GMM_ASSERT1(f, "Error while reading binary file '" << name << "'");
+      data = reinterpret_cast<const char *>(buffer.data());
+    }
+
+    GMM_ASSERT1(size_ >= binary_header_size
+                && !memcmp(data, binary_magic, 8),
+                "'" << name << "' is not a GetFEM binary file");
+    const gmm::uint32_type *h
+      = reinterpret_cast<const gmm::uint32_type *>(data + 8);
+    GMM_ASSERT1(h[1] == binary_endian_tag, "Binary file '" << name
+                << "' has been written with a different byte order");
+    GMM_ASSERT1(h[0] <= BINARY_FORMAT_VERSION, "Binary file '" << name
+                << "' has a format version (" << h[0]
+                << ") more recent than this version of GetFEM");
+
+    const char *p = data + binary_header_size, *e = data + size_;
+    while (true) {
+      GMM_ASSERT1(e - p >= 16, "Truncated binary file '" << name << "'");
+      const gmm::uint64_type *sh
+        = reinterpret_cast<const gmm::uint64_type *>(p);
+      p += 16;
+      if (sh[0] == BINARY_END) break;
+      GMM_ASSERT1(gmm::uint64_type(e - p) >= sh[1] && sh[1] % 8 == 0,
+                  "Corrupted section in binary file '" << name << "'");
+      sections.push_back(section_info{sh[0], p, p + sh[1]});
+      p += sh[1];
+    }
+  }
+
+  size_type binary_file_reader::nb_sections(binary_section_tag t) const {
+    size_type n = 0;
+    for (const section_info &s : sections)
+      if (s.tag == gmm::uint64_type(t)) ++n;
+    return n;
+  }
+
+  binary_file_reader::section
+  binary_file_reader::get_section(binary_section_tag t, size_type i) const {
+    for (const section_info &s : sections)
+      if (s.tag == gmm::uint64_type(t) && i-- == 0)
+        return section(s.begin, s.end);
+    GMM_ASSERT1(false, "Missing section " << int(t) << " in binary file '"
+                << name_ << "'");
+  }
+
+}  /* end of namespace getfem.                                             */
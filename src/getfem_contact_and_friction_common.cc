@@ -20,6 +20,8 @@
 
 #include "getfem/getfem_contact_and_friction_common.h"
 #include "getfem/getfem_generic_assembly.h"
+#include <array>
+#include <random>
 #ifndef _WIN32
 #include <unistd.h>
 #endif
@@ -138,7 +140,7 @@ namespace getfem {
   }
 
   bool multi_contact_frame::test_normal_cones_compatibility
-  (const normal_cone &nc1, const normal_cone &nc2) {
+  (const normal_cone &nc1, const normal_cone &nc2) const {
     for (size_type i = 0; i < nc1.size(); ++i)
       for (size_type j = 0; j < nc2.size(); ++j)
         if (gmm::vect_sp(nc1[i], nc2[j]) < scalar_type(0))
@@ -147,7 +149,7 @@ namespace getfem {
   }
 
   bool multi_contact_frame::test_normal_cones_compatibility
-  (const base_small_vector &n, const normal_cone &nc2) {
+  (const base_small_vector &n, const normal_cone &nc2) const {
     for (size_type j = 0; j < nc2.size(); ++j)
       if (gmm::vect_sp(n, nc2[j]) < scalar_type(0))
         return true;
@@ -199,8 +201,6 @@ namespace getfem {
   void multi_contact_frame::clear_aux_info() {
     boundary_points = std::vector<base_node>();
     boundary_points_info = std::vector<boundary_point>();
-    element_boxes.clear();
-    element_boxes_info = std::vector<influence_box>();
     potential_pairs = std::vector<std::vector<face_info> >();
   }
 
@@ -210,7 +210,9 @@ namespace getfem {
                                            bool rayt, int nmode, bool refc)
     : N(NN), self_contact(selfc), ref_conf(refc), use_delaunay(dela),
       nodes_mode(nmode), raytrace(rayt), release_distance(r_dist),
-      cut_angle(cut_a), EPS(1E-8), md(0), coordinates(N), pt(N) {
+      cut_angle(cut_a), EPS(1E-8), md(0), coordinates(N), pt(N),
+      boxes_rebuild_distance(r_dist), nb_boxes_rebuilds(0),
+      nb_boxes_refits(0) {
     if (N > 0) coordinates[0] = "x";
     if (N > 1) coordinates[1] = "y";
     if (N > 2) coordinates[2] = "z";
@@ -227,7 +229,8 @@ namespace getfem {
     : N(NN), self_contact(selfc), ref_conf(refc),
       use_delaunay(dela), nodes_mode(nmode), raytrace(rayt),
       release_distance(r_dist), cut_angle(cut_a), EPS(1E-8), md(&mdd),
-      coordinates(N), pt(N) {
+      coordinates(N), pt(N), boxes_rebuild_distance(r_dist),
+      nb_boxes_rebuilds(0), nb_boxes_refits(0) {
     if (N > 0) coordinates[0] = "x";
     if (N > 1) coordinates[1] = "y";
     if (N > 2) coordinates[2] = "z";
@@ -555,6 +558,8 @@ namespace getfem {
     bool avert = false;
     base_matrix G;
     model_real_plain_vector coeff;
+    std::vector<influence_box> boxes_info;
+    element_boxes_min.resize(0); element_boxes_max.resize(0);
 
     for (size_type i = 0; i < contact_boundaries.size(); ++i)
       if (!is_slave_boundary(i)) {
@@ -643,12 +648,43 @@ namespace getfem {
             { bmin[k] -= release_distance; bmax[k] += release_distance; }
 
           // Store the influence box and additional information.
-          element_boxes.add_box(bmin, bmax, element_boxes_info.size());
+          element_boxes_min.push_back(bmin);
+          element_boxes_max.push_back(bmax);
           n_mean /= gmm::vect_norm2(n_mean);
-          element_boxes_info.push_back(influence_box(i, cv, v.f(), n_mean));
+          boxes_info.push_back(influence_box(i, cv, v.f(), n_mean));
         }
       }
-    element_boxes.build_tree();
+
+    // Refit of the tree of the previous call if the master faces are the
+    // same and did not move too much since the last build.
+    size_type nbb = boxes_info.size();
+    bool refit = (nbb > 0 && nbb == element_boxes_info.size()
+                  && nbb == element_boxes.nb_boxes());
+    for (size_type j = 0; refit && j < nbb; ++j) {
+      const influence_box &ib1 = boxes_info[j], &ib2 = element_boxes_info[j];
+      refit = (ib1.ind_boundary == ib2.ind_boundary
+               && ib1.ind_element == ib2.ind_element
+               && ib1.ind_face == ib2.ind_face);
+      for (size_type k = 0; refit && k < N; ++k)
+        refit = (gmm::abs(element_boxes_min[j][k] - built_boxes_min[j][k])
+                 <= boxes_rebuild_distance
+                 && gmm::abs(element_boxes_max[j][k] - built_boxes_max[j][k])
+                 <= boxes_rebuild_distance);
+    }
+    element_boxes_info.swap(boxes_info);
+
+    if (refit) {
+      element_boxes.refit(element_boxes_min, element_boxes_max);
+      ++nb_boxes_refits;
+    } else {
+      bgeot::rtree boxes_tree;
+      for (size_type j = 0; j < nbb; ++j)
+        boxes_tree.add_box(element_boxes_min[j], element_boxes_max[j], j);
+      element_boxes = bgeot::flat_rtree(boxes_tree);
+      built_boxes_min = element_boxes_min;
+      built_boxes_max = element_boxes_max;
+      ++nb_boxes_rebuilds;
+    }
   }
 
   void multi_contact_frame::compute_potential_contact_pairs_influence_boxes() {
@@ -658,17 +694,18 @@ namespace getfem {
     potential_pairs = std::vector<std::vector<face_info> >();
     potential_pairs.resize(boundary_points.size());
 
+    // Parallel search of the influence boxes containing the points
+    std::vector<size_type> idptr, idvec;
+    element_boxes.find_boxes_at_points(boundary_points, idptr, idvec, true);
+
     for (size_type ip = 0; ip < boundary_points.size(); ++ip) {
 
-      bgeot::rtree::pbox_set bset;
-      element_boxes.find_boxes_at_point(boundary_points[ip], bset);
       boundary_point *pt_info = &(boundary_points_info[ip]);
       const mesh_fem &mf1 = mfdisp_of_boundary(pt_info->ind_boundary);
       size_type ib1 = pt_info->ind_boundary;
 
-      bgeot::rtree::pbox_set::iterator it = bset.begin();
-      for (; it != bset.end(); ++it) {
-        influence_box &ibx = element_boxes_info[(*it)->id];
+      for (size_type j = idptr[ip]; j < idptr[ip+1]; ++j) {
+        influence_box &ibx = element_boxes_info[idvec[j]];
         size_type ib2 = ibx.ind_boundary;
         const mesh_fem &mf2 = mfdisp_of_boundary(ib2);
 
@@ -821,441 +858,502 @@ namespace getfem {
   };
 
   // Ideas to improve efficiency :
-  // - From an iteration to another, is it possible to simplify the
-  //   computation ? For instance in testing the old contact pairs ...
-  //   But how to detect new contact situations ?
   // - A pre-test before projection (for Delaunay) : if the distance to a
   //   node is greater than the release distance + h then give up.
   // - Case J3 of valid/invalid contact situations is not really taken into
   //   account. How to take it into account in a cheap way ?
 
-  void multi_contact_frame::compute_contact_pairs() {
-    base_matrix G, grad(N,N);
-    model_real_plain_vector coeff;
-    base_small_vector a(N-1), ny(N);
-    base_node y(N);
-    std::vector<base_small_vector> ti(N-1), Ti(N-1);
-    size_type nbwarn(0);
-
-    // double time = dal::uclock_sec();
-
-    clear_aux_info();
-    contact_pairs = std::vector<contact_pair>();
-
-    if (!ref_conf) extend_vectors();
-
-    bool only_slave(true), only_master(true);
-    for (size_type i = 0; i < contact_boundaries.size(); ++i)
-      if (is_slave_boundary(i)) only_master = false;
-      else only_slave = false;
-
-    if (only_master && !self_contact) {
-      GMM_WARNING1("There is only master boundary and no self-contact to detect. Exiting");
-      return;
+  // Random orthonormal basis t_1, ..., t_{N-1} of the hyperplane
+  // orthogonal to the unit vector n. The generator is the one of the slave
+  // point, so that the contact pairs do not depend on the sharing of the
+  // points among the threads.
+  static void random_tangent_basis(const base_small_vector &n,
+                                   std::vector<base_small_vector> &t,
+                                   std::minstd_rand &gen) {
+    std::uniform_real_distribution<scalar_type> distrib(-1., 1.);
+    size_type N = gmm::vect_size(n);
+    for (size_type k = 0; k+1 < N; ++k) {
+      gmm::resize(t[k], N);
+      scalar_type norm(0);
+      while (norm < 1E-5) {
+        for (size_type j = 0; j < N; ++j) t[k][j] = distrib(gen);
+        t[k] -= gmm::vect_sp(t[k], n) * n;
+        for (size_type l = 0; l < k; ++l)
+          t[k] -= gmm::vect_sp(t[k], t[l]) * t[l];
+        norm = gmm::vect_norm2(t[k]);
+      }
+      t[k] /= norm;
     }
+  }
 
-    if (only_slave) {
-      compute_boundary_points();
-      potential_pairs.resize(boundary_points.size());
+  base_small_vector
+  multi_contact_frame::slave_normal(const boundary_point &bpinfo) const {
+    base_small_vector nx = bpinfo.normals[0];
+    if (raytrace) {
+      if (bpinfo.normals.size() > 1) { // take the mean normal vector
+        for (size_type i = 1; i < bpinfo.normals.size(); ++i)
+          gmm::add(bpinfo.normals[i], nx);
+        scalar_type nnx = gmm::vect_norm2(nx);
+        GMM_ASSERT1(nnx != scalar_type(0), "Invalid normal cone");
+        gmm::scale(nx, scalar_type(1)/nnx);
+      }
     }
-    else if (use_delaunay)
-      compute_potential_contact_pairs_delaunay();
-    else
-      compute_potential_contact_pairs_influence_boxes();
-
-    // cout << "Time for computing potential pairs: " << dal::uclock_sec() - time << endl; time = dal::uclock_sec();
-
+    return nx;
+  }
 
-    // Scan of potential pairs
-    for (size_type ip = 0; ip < potential_pairs.size(); ++ip) {
-      bool first_pair_found = false;
-      const base_node &x = boundary_points[ip];
-      boundary_point &bpinfo = boundary_points_info[ip];
-      size_type ibx = bpinfo.ind_boundary;
-      bool slx = is_slave_boundary(ibx);
-      scalar_type d0 = 1E300, d1, d2;
+  bool multi_contact_frame::rigid_obstacle_contact_pair
+  (size_type ip, const base_small_vector &nx, contact_pair &ct) {
+    const base_node &x = boundary_points[ip];
+    const boundary_point &bpinfo = boundary_points_info[ip];
+    scalar_type d0 = 1E300, d1, d2;
+    base_small_vector ny(N);
+    base_node y(N);
 
-      base_small_vector nx = bpinfo.normals[0];
-      if (raytrace) {
-        if (bpinfo.normals.size() > 1) { // take the mean normal vector
-          for (size_type i = 1; i < bpinfo.normals.size(); ++i)
-            gmm::add(bpinfo.normals[i], nx);
-          scalar_type nnx = gmm::vect_norm2(nx);
-          GMM_ASSERT1(nnx != scalar_type(0), "Invalid normal cone");
-          gmm::scale(nx, scalar_type(1)/nnx);
+    // Detect here the nearest rigid obstacle (taking into account
+    // the release distance)
+    size_type irigid_obstacle(-1);
+    gmm::copy(x, pt);
+    if (N >= 4) ptw[0] = pt[3];
+    if (N >= 3) ptz[0] = pt[2];
+    if (N >= 2) pty[0] = pt[1];
+    if (N >= 1) ptx[0] = pt[0];
+    for (size_type i = 0; i < obstacles.size(); ++i) {
+      d1 = (obstacles_f[i].eval())[0];
+      if (gmm::abs(d1) < release_distance && d1 < d0) {
+
+        for (size_type j=0; j < bpinfo.normals.size(); ++j) {
+          gmm::add(gmm::scaled(bpinfo.normals[j], EPS), pt);
+          if (N >= 4) ptw[0] = pt[3];
+          if (N >= 3) ptz[0] = pt[2];
+          if (N >= 2) pty[0] = pt[1];
+          if (N >= 1) ptx[0] = pt[0];
+          d2 =  (obstacles_f[i].eval())[0];
+          if (d2 < d1) { d0 = d1; irigid_obstacle = i; break; }
+          gmm::copy(x, pt);
+          if (N >= 4) ptw[0] = pt[3];
+          if (N >= 3) ptz[0] = pt[2];
+          if (N >= 2) pty[0] = pt[1];
+          if (N >= 1) ptx[0] = pt[0];
         }
       }
+    }
 
-      if (self_contact || slx) {
-        // Detect here the nearest rigid obstacle (taking into account
-        // the release distance)
-        size_type irigid_obstacle(-1);
-        gmm::copy(x, pt);
-        if (N >= 4) ptw[0] = pt[3];
-        if (N >= 3) ptz[0] = pt[2];
-        if (N >= 2) pty[0] = pt[1];
-        if (N >= 1) ptx[0] = pt[0];
-        for (size_type i = 0; i < obstacles.size(); ++i) {
-          d1 = (obstacles_f[i].eval())[0];
-          if (gmm::abs(d1) < release_distance && d1 < d0) {
-
-            for (size_type j=0; j < bpinfo.normals.size(); ++j) {
-              gmm::add(gmm::scaled(bpinfo.normals[j], EPS), pt);
-              if (N >= 4) ptw[0] = pt[3];
-              if (N >= 3) ptz[0] = pt[2];
-              if (N >= 2) pty[0] = pt[1];
-              if (N >= 1) ptx[0] = pt[0];
-              d2 =  (obstacles_f[i].eval())[0];
-              if (d2 < d1) { d0 = d1; irigid_obstacle = i; break; }
-              gmm::copy(x, pt);
-              if (N >= 4) ptw[0] = pt[3];
-              if (N >= 3) ptz[0] = pt[2];
-              if (N >= 2) pty[0] = pt[1];
-              if (N >= 1) ptx[0] = pt[0];
-            }
+    if (irigid_obstacle != size_type(-1)) {
+
+      gmm::copy(x, pt);
+      if (N >= 4) ptw[0] = pt[3];
+      if (N >= 3) ptz[0] = pt[2];
+      if (N >= 2) pty[0] = pt[1];
+      if (N >= 1) ptx[0] = pt[0];
+      gmm::copy(x, y);
+      size_type nit = 0, nb_fail = 0;
+      scalar_type alpha(0), beta(0);
+      d1 = d0;
+
+      while (++nit < 50 && nb_fail < 3) {
+        for (size_type k = 0; k < N; ++k) {
+          pt[k] += EPS;
+          switch(N) {
+          case 4: ptw[0] += EPS; break;
+          case 3: ptz[0] += EPS; break;
+          case 2: pty[0] += EPS; break;
+          case 1: ptx[0] += EPS; break;
+          }
+          d2 = (obstacles_f[irigid_obstacle].eval())[0];
+          ny[k] = (d2 - d1) / EPS;
+          pt[k] -= EPS;
+          switch(N) {
+          case 4: ptw[0] -= EPS; break;
+          case 3: ptz[0] -= EPS; break;
+          case 2: pty[0] -= EPS; break;
+          case 1: ptx[0] -= EPS; break;
           }
         }
 
-        if (irigid_obstacle != size_type(-1)) {
+        if (gmm::abs(d1) < 1E-13)
+          break; // point already lies on the rigid obstacle surface
 
-          gmm::copy(x, pt);
+        // ajouter un test de divergence ...
+        for (scalar_type lambda(1); lambda >= 1E-3; lambda /= scalar_type(2)) {
+          if (raytrace) {
+            alpha = beta - lambda * d1 / gmm::vect_sp(ny, nx);
+            gmm::add(x, gmm::scaled(nx, alpha), pt);
+          } else {
+            gmm::add(gmm::scaled(ny, -d1/gmm::vect_norm2_sqr(ny)), y, pt);
+          }
           if (N >= 4) ptw[0] = pt[3];
           if (N >= 3) ptz[0] = pt[2];
           if (N >= 2) pty[0] = pt[1];
           if (N >= 1) ptx[0] = pt[0];
-          gmm::copy(x, y);
-          size_type nit = 0, nb_fail = 0;
-          scalar_type alpha(0), beta(0);
-          d1 = d0;
-
-          while (++nit < 50 && nb_fail < 3) {
-            for (size_type k = 0; k < N; ++k) {
-              pt[k] += EPS;
-              switch(N) {
-              case 4: ptw[0] += EPS; break;
-              case 3: ptz[0] += EPS; break;
-              case 2: pty[0] += EPS; break;
-              case 1: ptx[0] += EPS; break;
-              }
-              d2 = (obstacles_f[irigid_obstacle].eval())[0];
-              ny[k] = (d2 - d1) / EPS;
-              pt[k] -= EPS;
-              switch(N) {
-              case 4: ptw[0] -= EPS; break;
-              case 3: ptz[0] -= EPS; break;
-              case 2: pty[0] -= EPS; break;
-              case 1: ptx[0] -= EPS; break;
-              }
-            }
-
-            if (gmm::abs(d1) < 1E-13)
-              break; // point already lies on the rigid obstacle surface
-
-            // ajouter un test de divergence ...
-            for (scalar_type lambda(1); lambda >= 1E-3; lambda /= scalar_type(2)) {
-              if (raytrace) {
-                alpha = beta - lambda * d1 / gmm::vect_sp(ny, nx);
-                gmm::add(x, gmm::scaled(nx, alpha), pt);
-              } else {
-                gmm::add(gmm::scaled(ny, -d1/gmm::vect_norm2_sqr(ny)), y, pt);
-              }
-              if (N >= 4) ptw[0] = pt[3];
-              if (N >= 3) ptz[0] = pt[2];
-              if (N >= 2) pty[0] = pt[1];
-              if (N >= 1) ptx[0] = pt[0];
-              d2 = (obstacles_f[irigid_obstacle].eval())[0];
+          d2 = (obstacles_f[irigid_obstacle].eval())[0];
 //               if (nit > 10)
 //                 cout << "nit = " << nit << " lambda = " << lambda
 //                      << " alpha = " << alpha << " d2 = " << d2
 //                      << " d1  = " << d1 << endl;
-              if (gmm::abs(d2) < gmm::abs(d1)) break;
-            }
-            if (raytrace &&
-                gmm::abs(beta - d1 / gmm::vect_sp(ny, nx)) > scalar_type(500))
-              nb_fail++;
-            gmm::copy(pt, y); beta = alpha; d1 = d2;
-          }
-
-          if (gmm::abs(d1) > 1E-8) {
-            GMM_WARNING1("Projection/raytrace on rigid obstacle failed");
-            continue;
-          }
-
-          // CRITERION 4 for rigid bodies : Apply the release distance
-          if (gmm::vect_dist2(y, x) > release_distance)
-            continue;
-
-          gmm::copy(pt, y);
-          ny /= gmm::vect_norm2(ny);
-
-          d0 = gmm::vect_dist2(y, x) * gmm::sgn(d0);
-          contact_pair ct(x, nx, bpinfo, y, ny, irigid_obstacle, d0);
-
-          contact_pairs.push_back(ct);
-          first_pair_found = true;
+          if (gmm::abs(d2) < gmm::abs(d1)) break;
         }
+        if (raytrace &&
+            gmm::abs(beta - d1 / gmm::vect_sp(ny, nx)) > scalar_type(500))
+          nb_fail++;
+        gmm::copy(pt, y); beta = alpha; d1 = d2;
       }
 
-      // if (potential_pairs[ip].size())
-      // cout << "number of potential pairs for point " << ip << " : " << potential_pairs[ip].size() << endl;
-      for (size_type ipf = 0; ipf < potential_pairs[ip].size(); ++ipf) {
-        // Point to surface projection. Principle :
-        //  - One parametrizes first the face on the reference element by
-        //    obtaining a point x_0 on that face and t_i, i=1..d-1 some
-        //    orthonormals tangent vectors to the face.
-        //  - Let y_0 be the point to be projected and y the searched
-        //    projected point. Then one searches for the minimum of
-        //    J = (1/2)|| y - x ||
-        //    with
-        //    y = \phi(x0 + a_i t_i)
-        //    (with a summation on i), where \phi = I+u(\tau(x)), and \tau
-        //    the geometric transformation between reference and real
-        //    elements.
-        //  - The gradient of J with respect to a_i is
-        //    \partial_{a_j} J = (\phi(x0 + a_i t_i) - x)
-        //                       . (\nabla \phi(x0 + a_i t_i) t_j
-        //  - A Newton algorithm is applied.
-        //  - If it fails, a BFGS is called.
-
-        const face_info &fi = potential_pairs[ip][ipf];
-        size_type ib = fi.ind_boundary;
-        size_type cv = fi.ind_element;
-        short_type iff = fi.ind_face;
-
-        const mesh_fem &mfu = mfdisp_of_boundary(ib);
-        const mesh &m = mfu.linked_mesh();
-        pfem pf_s = mfu.fem_of_element(cv);
-        bgeot::pgeometric_trans pgt = m.trans_of_convex(cv);
+      if (gmm::abs(d1) > 1E-8) {
+        GMM_WARNING1("Projection/raytrace on rigid obstacle failed");
+        return false;
+      }
 
-        if (!ref_conf)
-          slice_vector_on_basic_dof_of_element(mfu, disp_of_boundary(ib),
-                                               cv, coeff);
-        m.points_of_convex(cv, G);
-        // face_pts is of type bgeot::convex<...>::ref_convex_pt_ct
-        const auto face_pts = pf_s->ref_convex(cv)->points_of_face(iff);
-        const base_node &x0 = face_pts[0];
-        fem_interpolation_context ctx(pgt, pf_s, x0, G, cv, iff);
+      // CRITERION 4 for rigid bodies : Apply the release distance
+      if (gmm::vect_dist2(y, x) > release_distance)
+        return false;
 
-        const base_small_vector &n0 = pf_s->ref_convex(cv)->normals()[iff];
-        for (size_type k = 0; k < N-1; ++k) { // A basis for the face
-          gmm::resize(ti[k], N);
-          scalar_type norm(0);
-          while(norm < 1E-5) {
-            gmm::fill_random(ti[k]);
-            ti[k] -= gmm::vect_sp(ti[k], n0) * n0;
-            for (size_type l = 0; l < k; ++l)
-              ti[k] -= gmm::vect_sp(ti[k], ti[l]) * ti[l];
-            norm = gmm::vect_norm2(ti[k]);
-          }
-          ti[k] /= norm;
-        }
+      gmm::copy(pt, y);
+      ny /= gmm::vect_norm2(ny);
 
-        bool converged = false;
-        scalar_type residual(0);
+      d0 = gmm::vect_dist2(y, x) * gmm::sgn(d0);
+      ct = contact_pair(x, nx, bpinfo, y, ny, irigid_obstacle, d0);
+      return true;
+    }
+    return false;
+  }
 
+  void multi_contact_frame::master_face_contact_pair
+  (size_type ip, const base_small_vector &nx, const contact_pair *previous,
+   contact_pair &ct, bool &found, size_type &nbwarn) const {
+    const base_node &x = boundary_points[ip];
+    const boundary_point &bpinfo = boundary_points_info[ip];
+    base_matrix G, grad(N,N);
+    model_real_plain_vector coeff;
+    base_small_vector a(N-1), ny(N);
+    base_node y(N);
+    std::vector<base_small_vector> ti(N-1), Ti(N-1);
+    std::minstd_rand gen(std::minstd_rand::result_type(ip+1));
+    std::uniform_real_distribution<scalar_type> perturbation(0., 1E-7);
+
+    for (size_type ipf = 0; ipf < potential_pairs[ip].size(); ++ipf) {
+      // Point to surface projection. Principle :
+      //  - One parametrizes first the face on the reference element by
+      //    obtaining a point x_0 on that face and t_i, i=1..d-1 some
+      //    orthonormals tangent vectors to the face.
+      //  - Let y_0 be the point to be projected and y the searched
+      //    projected point. Then one searches for the minimum of
+      //    J = (1/2)|| y - x ||
+      //    with
+      //    y = \phi(x0 + a_i t_i)
+      //    (with a summation on i), where \phi = I+u(\tau(x)), and \tau
+      //    the geometric transformation between reference and real
+      //    elements.
+      //  - The gradient of J with respect to a_i is
+      //    \partial_{a_j} J = (\phi(x0 + a_i t_i) - x)
+      //                       . (\nabla \phi(x0 + a_i t_i) t_j
+      //  - A Newton algorithm is applied.
+      //  - If it fails, a BFGS is called.
+
+      const face_info &fi = potential_pairs[ip][ipf];
+      size_type ib = fi.ind_boundary;
+      size_type cv = fi.ind_element;
+      short_type iff = fi.ind_face;
+
+      const mesh_fem &mfu = mfdisp_of_boundary(ib);
+      const mesh &m = mfu.linked_mesh();
+      pfem pf_s = mfu.fem_of_element(cv);
+      bgeot::pgeometric_trans pgt = m.trans_of_convex(cv);
+
+      if (!ref_conf)
+        slice_vector_on_basic_dof_of_element(mfu, disp_of_boundary(ib),
+                                             cv, coeff);
+      m.points_of_convex(cv, G);
+      // face_pts is of type bgeot::convex<...>::ref_convex_pt_ct
+      const auto face_pts = pf_s->ref_convex(cv)->points_of_face(iff);
+      const base_node &x0 = face_pts[0];
+      fem_interpolation_context ctx(pgt, pf_s, x0, G, cv, iff);
+
+      // A basis for the face
+      random_tangent_basis(pf_s->ref_convex(cv)->normals()[iff], ti, gen);
+
+      // Starting point of the projection/raytrace: the master point of
+      // the previous contact pair of x when it was on the same face, the
+      // first vertex of the face otherwise.
+      base_small_vector a0(N-1);
+      if (previous && previous->irigid_obstacle == size_type(-1)
+          && previous->master_ind_boundary == ib
+          && previous->master_ind_element == cv
+          && previous->master_ind_face == iff)
+        for (size_type k = 0; k < N-1; ++k)
+          a0[k] = gmm::vect_sp(previous->master_point_ref - x0, ti[k]);
+
+      bool converged = false;
+      scalar_type residual(0);
+
+
+      if (raytrace) { // Raytrace search for y by a Newton algorithm
+
+        base_small_vector res(N-1), res2(N-1), dir(N-1), b(N-1);
+
+        base_matrix hessa(N-1, N-1);
+        gmm::copy(a0, a);
+        random_tangent_basis(nx, Ti, gen);
+
+        raytrace_pt_surf_cost_function_object pps(x0, x, ctx, coeff, ti, Ti,
+                                                  ref_conf);
 
-        if (raytrace) { // Raytrace search for y by a Newton algorithm
+        pps(a, res);
+        residual = gmm::vect_norm2(res);
+        scalar_type residual2(0), det(0);
+        bool exited = false;
+        size_type nbfail = 0, niter = 0;
+        for (;residual > 2E-12 && niter <= 30; ++niter) {
 
-          base_small_vector res(N-1), res2(N-1), dir(N-1), b(N-1);
+          for (size_type subiter(0);;) {
+            pps(a, hessa);
+            det = gmm::abs(bgeot::lu_inverse(&(*(hessa.begin())),N-1, false));
+            if (det > 1E-15) break;
+            for (size_type i = 0; i < N-1; ++i)
+              a[i] += perturbation(gen);
+            if (++subiter > 4) break;
+          }
+          if (det <= 1E-15) break;
+          // Computation of the descent direction
+          gmm::mult(hessa, gmm::scaled(res, scalar_type(-1)), dir);
 
-          base_matrix hessa(N-1, N-1);
-          gmm::clear(a);
+          if (gmm::vect_norm2(dir) > scalar_type(10)) nbfail++;
+          if (nbfail >= 4) break;
 
-          for (size_type k = 0; k < N-1; ++k) {
-            gmm::resize(Ti[k], N);
-            scalar_type norm(0);
-            while (norm < 1E-5) {
-              gmm::fill_random(Ti[k]);
-              Ti[k] -= gmm::vect_sp(Ti[k], nx) * nx;
-              for (size_type l = 0; l < k; ++l)
-                Ti[k] -= gmm::vect_sp(Ti[k], Ti[l]) * Ti[l];
-              norm = gmm::vect_norm2(Ti[k]);
-            }
-            Ti[k] /= norm;
+          // Line search
+          scalar_type lambda(1);
+          for (size_type j = 0; j < 5; ++j) {
+            gmm::add(a, gmm::scaled(dir, lambda), b);
+            pps(b, res2);
+            residual2 = gmm::vect_norm2(res2);
+            if (residual2 < residual) break;
+            lambda /= ((j < 3) ? scalar_type(2) : scalar_type(5));
           }
 
-          raytrace_pt_surf_cost_function_object pps(x0, x, ctx, coeff, ti, Ti,
-                                                    ref_conf);
+          residual = residual2;
+          gmm::copy(res2, res);
+          gmm::copy(b, a);
+          scalar_type dist_ref = gmm::vect_norm2(a);
+//             if (niter == 15)
+//               cout << "more than 15 iterations " << a
+//                    << " dir " << dir << " nbfail : " << nbfail << endl;
+          if (niter > 1 && dist_ref > 15) break;
+          if (niter > 5 && dist_ref > 8) break;
+          if ((niter > 1 && dist_ref > 7) || nbfail == 3) exited = true;
+        }
+        converged = (gmm::vect_norm2(res) < 2E-6);
+        GMM_ASSERT1(!((exited && converged &&
+                       pf_s->ref_convex(cv)->is_in(ctx.xref()) < 1E-6)),
+                    "A non conformal case !! " << gmm::vect_norm2(res)
+                    << " : " << nbfail << " : " << niter);
 
-          pps(a, res);
-          residual = gmm::vect_norm2(res);
-          scalar_type residual2(0), det(0);
-          bool exited = false;
-          size_type nbfail = 0, niter = 0;
-          for (;residual > 2E-12 && niter <= 30; ++niter) {
+      } else { // Classical projection for y
 
-            for (size_type subiter(0);;) {
-              pps(a, hessa);
-              det = gmm::abs(bgeot::lu_inverse(&(*(hessa.begin())),N-1, false));
-              if (det > 1E-15) break;
-              for (size_type i = 0; i < N-1; ++i)
-                a[i] += gmm::random() * 1E-7;
-              if (++subiter > 4) break;
-            }
-            if (det <= 1E-15) break;
-            // Computation of the descent direction
-            gmm::mult(hessa, gmm::scaled(res, scalar_type(-1)), dir);
+        proj_pt_surf_cost_function_object pps(x0, x, ctx, coeff, ti,
+                                              EPS, ref_conf);
 
-            if (gmm::vect_norm2(dir) > scalar_type(10)) nbfail++;
-            if (nbfail >= 4) break;
+        // A specific (Quasi) Newton algorithm for computing the projection
+        base_small_vector grada(N-1), dir(N-1), b(N-1);
+        gmm::copy(a0, a);
+        base_matrix hessa(N-1, N-1);
+        scalar_type det(0);
 
-            // Line search
-            scalar_type lambda(1);
-            for (size_type j = 0; j < 5; ++j) {
-              gmm::add(a, gmm::scaled(dir, lambda), b);
-              pps(b, res2);
-              residual2 = gmm::vect_norm2(res2);
-              if (residual2 < residual) break;
-              lambda /= ((j < 3) ? scalar_type(2) : scalar_type(5));
-            }
+        scalar_type dist = pps(a, grada);
+        for (size_type niter = 0;
+             gmm::vect_norm2(grada) > 1E-12 && niter <= 50; ++niter) {
 
-            residual = residual2;
-            gmm::copy(res2, res);
-            gmm::copy(b, a);
-            scalar_type dist_ref = gmm::vect_norm2(a);
-//             if (niter == 15)
-//               cout << "more than 15 iterations " << a
-//                    << " dir " << dir << " nbfail : " << nbfail << endl;
-            if (niter > 1 && dist_ref > 15) break;
-            if (niter > 5 && dist_ref > 8) break;
-            if ((niter > 1 && dist_ref > 7) || nbfail == 3) exited = true;
+          for (size_type subiter(0);;) {
+            pps(a, hessa);
+            det = gmm::abs(bgeot::lu_inverse(&(*(hessa.begin())),N-1, false));
+            if (det > 1E-15) break;
+            for (size_type i = 0; i < N-1; ++i)
+              a[i] += perturbation(gen);
+            if (++subiter > 4) break;
           }
-          converged = (gmm::vect_norm2(res) < 2E-6);
-          GMM_ASSERT1(!((exited && converged &&
-                         pf_s->ref_convex(cv)->is_in(ctx.xref()) < 1E-6)),
-                      "A non conformal case !! " << gmm::vect_norm2(res)
-                      << " : " << nbfail << " : " << niter);
-
-        } else { // Classical projection for y
+          if (det <= 1E-15) break;
+          // Computation of the descent direction
+          gmm::mult(hessa, gmm::scaled(grada, scalar_type(-1)), dir);
 
-          proj_pt_surf_cost_function_object pps(x0, x, ctx, coeff, ti,
-                                                EPS, ref_conf);
+          // Line search
+          for (scalar_type lambda(1);
+               lambda >= 1E-3; lambda /= scalar_type(2)) {
+            gmm::add(a, gmm::scaled(dir, lambda), b);
+            if (pps(b) < dist) break;
+            gmm::add(a, gmm::scaled(dir, -lambda), b);
+            if (pps(b) < dist) break;
+          }
+          gmm::copy(b, a);
+          dist = pps(a, grada);
+        }
 
-          // Projection could be ameliorated by finding a starting point near
-          // x (with respect to the integration method, for instance).
+        converged = (gmm::vect_norm2(grada) < 2E-6);
 
-          // A specific (Quasi) Newton algorithm for computing the projection
-          base_small_vector grada(N-1), dir(N-1), b(N-1);
+        if (!converged) { // Try with BFGS
+          gmm::iteration iter(1E-12, 0 /* noisy*/, 100 /*maxiter*/);
           gmm::clear(a);
-          base_matrix hessa(N-1, N-1);
-          scalar_type det(0);
+          gmm::bfgs(pps, pps, a, 10, iter, 0, 0.5);
+          residual = gmm::abs(iter.get_res());
+          converged = (residual < 2E-5);
+        }
+      }
 
-          scalar_type dist = pps(a, grada);
-          for (size_type niter = 0;
-               gmm::vect_norm2(grada) > 1E-12 && niter <= 50; ++niter) {
+      bool is_in = (pf_s->ref_convex(cv)->is_in(ctx.xref()) < 1E-6);
 
-            for (size_type subiter(0);;) {
-              pps(a, hessa);
-              det = gmm::abs(bgeot::lu_inverse(&(*(hessa.begin())),N-1, false));
-              if (det > 1E-15) break;
-              for (size_type i = 0; i < N-1; ++i)
-                a[i] += gmm::random() * 1E-7;
-              if (++subiter > 4) break;
-            }
-            if (det <= 1E-15) break;
-            // Computation of the descent direction
-            gmm::mult(hessa, gmm::scaled(grada, scalar_type(-1)), dir);
+      if (is_in || (!converged && !raytrace)) {
+        if (!ref_conf) {
+          ctx.pf()->interpolation(ctx, coeff, y, dim_type(N));
+          y += ctx.xreal();
+        } else {
+          y = ctx.xreal();
+        }
+      }
 
-            // Line search
-            for (scalar_type lambda(1);
-                 lambda >= 1E-3; lambda /= scalar_type(2)) {
-              gmm::add(a, gmm::scaled(dir, lambda), b);
-              if (pps(b) < dist) break;
-              gmm::add(a, gmm::scaled(dir, -lambda), b);
-              if (pps(b) < dist) break;
-            }
-            gmm::copy(b, a);
-            dist = pps(a, grada);
-          }
+      // CRITERION 2 : The contact pair is eliminated when
+      //               projection/raytrace do not converge.
+      if (!converged) {
+        if (!raytrace && nbwarn < 4) {
+          GMM_WARNING3("Projection or raytrace algorithm did not converge "
+                       "for point " << x << " residual " << residual
+                       << " projection computed " << y);
+          ++nbwarn;
+        }
+        continue;
+      }
 
-          converged = (gmm::vect_norm2(grada) < 2E-6);
+      // CRITERION 3 : The projected point is inside the element
+      //               The test should be completed: If the point is outside
+      //               the element, a rapid reprojection on the face
+      //               (on the reference element, with a linear algorithm)
+      //               can be applied and a test with a neigbhour element
+      //               to decide if the point is in fact ok ...
+      //               (to be done only if there is no projection on other
+      //               element which coincides and with a test on the
+      //               distance ... ?) To be specified (in this case,
+      //               change xref).
+      if (!is_in) continue;
+
+      // CRITERION 4 : Apply the release distance
+      scalar_type signed_dist = gmm::vect_dist2(y, x);
+      if (signed_dist > release_distance) continue;
+
+      // compute the unit normal vector at y and the signed distance.
+      base_small_vector ny0(N);
+      compute_normal(ctx, iff, ref_conf, coeff, ny0, ny, grad);
+      // ny /= gmm::vect_norm2(ny); // Useful only if the unit normal is kept
+      signed_dist *= gmm::sgn(gmm::vect_sp(x - y, ny));
+
+      // CRITERION 5 : comparison with rigid obstacles
+      // CRITERION 7 : smallest signed distance on contact pairs
+      if (found && ct.signed_dist < signed_dist)
+          continue;
 
-          if (!converged) { // Try with BFGS
-            gmm::iteration iter(1E-12, 0 /* noisy*/, 100 /*maxiter*/);
-            gmm::clear(a);
-            gmm::bfgs(pps, pps, a, 10, iter, 0, 0.5);
-            residual = gmm::abs(iter.get_res());
-            converged = (residual < 2E-5);
-          }
-        }
+      // CRITERION 1 : again on found unit normal vector
+      if (!(test_normal_cones_compatibility(ny, bpinfo.normals)))
+          continue;
 
-        bool is_in = (pf_s->ref_convex(cv)->is_in(ctx.xref()) < 1E-6);
+      // CRITERION 6 : for self-contact only : apply a test on
+      //               unit normals in reference configuration.
+      if (&m == &(mfdisp_of_boundary(bpinfo.ind_boundary).linked_mesh())) {
 
-        if (is_in || (!converged && !raytrace)) {
-          if (!ref_conf) {
-            ctx.pf()->interpolation(ctx, coeff, y, dim_type(N));
-            y += ctx.xreal();
-          } else {
-            y = ctx.xreal();
-          }
-        }
+        base_small_vector diff = bpinfo.ref_point - ctx.xreal();
+        scalar_type ref_dist = gmm::vect_norm2(diff);
 
-        // CRITERION 2 : The contact pair is eliminated when
-        //               projection/raytrace do not converge.
-        if (!converged) {
-          if (!raytrace && nbwarn < 4) {
-            GMM_WARNING3("Projection or raytrace algorithm did not converge "
-                         "for point " << x << " residual " << residual
-                         << " projection computed " << y);
-            ++nbwarn;
-          }
+        if ( (ref_dist < scalar_type(4) * release_distance)
+             && (gmm::vect_sp(diff, ny0) < - 0.01 * ref_dist) )
           continue;
-        }
+      }
 
-        // CRITERION 3 : The projected point is inside the element
-        //               The test should be completed: If the point is outside
-        //               the element, a rapid reprojection on the face
-        //               (on the reference element, with a linear algorithm)
-        //               can be applied and a test with a neigbhour element
-        //               to decide if the point is in fact ok ...
-        //               (to be done only if there is no projection on other
-        //               element which coincides and with a test on the
-        //               distance ... ?) To be specified (in this case,
-        //               change xref).
-        if (!is_in) continue;
+      ct = contact_pair(x, nx, bpinfo, ctx.xref(), y, ny, fi, signed_dist);
+      found = true;
+    }
+  }
 
-        // CRITERION 4 : Apply the release distance
-        scalar_type signed_dist = gmm::vect_dist2(y, x);
-        if (signed_dist > release_distance) continue;
+  void multi_contact_frame::compute_contact_pairs() {
+    // double time = dal::uclock_sec();
 
-        // compute the unit normal vector at y and the signed distance.
-        base_small_vector ny0(N);
-        compute_normal(ctx, iff, ref_conf, coeff, ny0, ny, grad);
-        // ny /= gmm::vect_norm2(ny); // Useful only if the unit normal is kept
-        signed_dist *= gmm::sgn(gmm::vect_sp(x - y, ny));
+    clear_aux_info();
+    // The pairs of the previous call are kept as first guesses.
+    std::vector<contact_pair> previous_pairs;
+    previous_pairs.swap(contact_pairs);
 
-        // CRITERION 5 : comparison with rigid obstacles
-        // CRITERION 7 : smallest signed distance on contact pairs
-        if (first_pair_found && contact_pairs.back().signed_dist < signed_dist)
-            continue;
+    if (!ref_conf) extend_vectors();
 
-        // CRITERION 1 : again on found unit normal vector
-        if (!(test_normal_cones_compatibility(ny, bpinfo.normals)))
-            continue;
+    bool only_slave(true), only_master(true);
+    for (size_type i = 0; i < contact_boundaries.size(); ++i)
+      if (is_slave_boundary(i)) only_master = false;
+      else only_slave = false;
 
-        // CRITERION 6 : for self-contact only : apply a test on
-        //               unit normals in reference configuration.
-        if (&m == &(mfdisp_of_boundary(ibx).linked_mesh())) {
+    if (only_master && !self_contact) {
+      GMM_WARNING1("There is only master boundary and no self-contact to detect. Exiting");
+      return;
+    }
 
-          base_small_vector diff = bpinfo.ref_point - ctx.xreal();
-          scalar_type ref_dist = gmm::vect_norm2(diff);
+    if (only_slave) {
+      compute_boundary_points();
+      potential_pairs.resize(boundary_points.size());
+    }
+    else if (use_delaunay)
+      compute_potential_contact_pairs_delaunay();
+    else
+      compute_potential_contact_pairs_influence_boxes();
 
-          if ( (ref_dist < scalar_type(4) * release_distance)
-               && (gmm::vect_sp(diff, ny0) < - 0.01 * ref_dist) )
-            continue;
-        }
+    // cout << "Time for computing potential pairs: " << dal::uclock_sec() - time << endl; time = dal::uclock_sec();
 
-        contact_pair ct(x, nx, bpinfo, ctx.xref(), y, ny, fi, signed_dist);
-        if (first_pair_found) {
-          contact_pairs.back() = ct;
-        } else {
-          contact_pairs.push_back(ct);
-          first_pair_found = true;
-        }
+    typedef std::array<size_type, 4> slave_key;
+    std::map<slave_key, size_type> previous_index;
+    for (size_type i = 0; i < previous_pairs.size(); ++i) {
+      const contact_pair &cp = previous_pairs[i];
+      previous_index[slave_key{{cp.slave_ind_boundary, cp.slave_ind_element,
+                                size_type(cp.slave_ind_face),
+                                cp.slave_ind_pt}}] = i;
+    }
 
-      }
+    // Scan of potential pairs. The rigid obstacles are evaluated on the
+    // shared coordinate vectors and are thus scanned sequentially. The
+    // points are then shared out among the threads for the projections
+    // on the master faces, each point having at most one contact pair.
+    size_type nbip = potential_pairs.size();
+    std::vector<contact_pair> ip_pairs(nbip);
+    std::vector<char> ip_found(nbip, 0);
+    std::vector<base_small_vector> ip_normals(nbip);
+    std::vector<const contact_pair *> ip_previous(nbip, nullptr);
+    for (size_type ip = 0; ip < nbip; ++ip) {
+      const boundary_point &bpinfo = boundary_points_info[ip];
+      ip_normals[ip] = slave_normal(bpinfo);
+      auto it = previous_index.find(slave_key{{bpinfo.ind_boundary,
+              bpinfo.ind_element, size_type(bpinfo.ind_face), bpinfo.ind_pt}});
+      if (it != previous_index.end())
+        ip_previous[ip] = &(previous_pairs[it->second]);
+
+      if (obstacles.size()
+          && (self_contact || is_slave_boundary(bpinfo.ind_boundary)))
+        ip_found[ip] = rigid_obstacle_contact_pair(ip, ip_normals[ip],
+                                                   ip_pairs[ip]);
     }
 
+    size_type nbchunks = 1;
+    if (!me_is_multithreaded_now())
+      nbchunks = std::max(size_type(1), std::min(nbip,
+                          global_thread_policy::num_threads()));
+    auto scan_chunk = [&](size_type c) {
+      if (c >= nbchunks) return;
+      size_type nbwarn(0);
+      for (size_type ip = (nbip*c)/nbchunks; ip < (nbip*(c+1))/nbchunks;
+           ++ip) {
+        bool found = (ip_found[ip] != 0);
+        master_face_contact_pair(ip, ip_normals[ip], ip_previous[ip],
+                                 ip_pairs[ip], found, nbwarn);
+        ip_found[ip] = found;
+      }
+    };
+    if (nbchunks > 1) {
+      GETFEM_OMP_PARALLEL(
+        scan_chunk(global_thread_policy::this_thread());
+      )
+    } else scan_chunk(0);
+
+    for (size_type ip = 0; ip < nbip; ++ip)
+      if (ip_found[ip]) contact_pairs.push_back(ip_pairs[ip]);
+
     // cout << "Time for computing pairs: " << dal::uclock_sec() - time << endl; time = dal::uclock_sec();
 
     clear_aux_info();
@@ -19,9 +19,13 @@
 ===========================================================================*/
 
 #include <iomanip>
+#include <cstdint>
 #include "getfem/dal_singleton.h"
 #include "getfem/bgeot_comma_init.h"
 #include "getfem/getfem_export.h"
+#ifdef GETFEM_HAVE_ZLIB
+# include <zlib.h>
+#endif
 
 namespace getfem
 {
@@ -213,6 +217,12 @@ namespace getfem
       if (state == IN_POINT_DATA) os << "</PointData>\n";
       os << "</Piece>\n";
       os << "</UnstructuredGrid>\n";
+      if (appended) {
+        os << "<AppendedData encoding=\"raw\">\n_";
+        os.write((const char *)(appended_data.data()),
+                 std::streamsize(appended_data.size()));
+        os << "\n</AppendedData>\n";
+      }
       os << "</VTKFile>\n";
     }
   }
@@ -223,9 +233,22 @@ namespace getfem
     static int test_endian = 0x01234567;
     reverse_endian = (*((char*)&test_endian) == 0x67);
     state = EMPTY;
+    appended = compressed = false;
     clear_vals();
   }
 
+  void vtk_export::set_appended_data(bool compress) {
+    GMM_ASSERT1(!vtk && !ascii, "appended data is only available for "
+                "binary vtu files");
+    GMM_ASSERT1(state == EMPTY, "set_appended_data should be called before "
+                "anything is written");
+#ifndef GETFEM_HAVE_ZLIB
+    GMM_ASSERT1(!compress, "GetFEM has been built without zlib, "
+                "compression is not available");
+#endif
+    appended = true; compressed = compress;
+  }
+
   void vtk_export::switch_to_cell_data() {
     if (state != IN_CELL_DATA) {
       if (vtk) {
@@ -397,7 +420,12 @@ namespace getfem
       os << (ascii ? "ASCII\n" : "BINARY\n");
     } else {
       os << "<?xml version=\"1.0\"?>\n";
-      os << "<VTKFile type=\"UnstructuredGrid\" version=\"0.1\" ";
+      os << "<VTKFile type=\"UnstructuredGrid\" ";
+      if (appended) // 64 bits headers for large arrays
+        os << "version=\"1.0\" header_type=\"UInt64\" ";
+      else
+        os << "version=\"0.1\" ";
+      if (compressed) os << "compressor=\"vtkZLibDataCompressor\" ";
       os << "byte_order=\"" << (reverse_endian ? "LittleEndian" : "BigEndian") << "\">\n";
       os << "<!--" << header << "-->\n";
       os << "<UnstructuredGrid>\n";
@@ -411,11 +439,122 @@ namespace getfem
   void vtk_export::clear_vals()
   { if (!vtk && !ascii) vals.clear(); }
 
+  template <typename H>
+  static void push_header_val(std::vector<unsigned char> &v, size_type i) {
+    H h = H(i);
+    GMM_ASSERT1(size_type(h) == i, "data array too large for the vtu format");
+    const unsigned char *p = (const unsigned char *)(&h);
+    v.insert(v.end(), p, p + sizeof(H));
+  }
+
+  static void push_header(std::vector<unsigned char> &v, size_type i,
+                          bool header64) {
+    if (header64) push_header_val<std::uint64_t>(v, i);
+    else push_header_val<std::uint32_t>(v, i);
+  }
+
+  /* The size header of each array (the number of bytes, or for compressed
+     data the list of block sizes) is computed here from the buffered values,
+     then the whole array is either base64 encoded inline or appended to the
+     raw data section. */
   void vtk_export::write_vals() {
-    if (!vtk && !ascii) {
-      os << base64_encode(vals);
-      clear_vals();
+    if (vtk || ascii) return;
+    std::vector<unsigned char> head;
+    if (compressed) {
+#ifdef GETFEM_HAVE_ZLIB
+      const size_type block_size = 32768; // default of vtkZLibDataCompressor
+      size_type nb_blocks = (vals.size() + block_size - 1) / block_size;
+      std::vector<unsigned char> cdata;
+      std::vector<size_type> csizes(nb_blocks);
+      cdata.reserve(vals.size() / 2 + 64);
+      std::vector<Bytef> buf(compressBound(uLong(block_size)));
+      for (size_type b = 0; b < nb_blocks; ++b) {
+        size_type i0 = b * block_size;
+        size_type n = std::min(block_size, vals.size() - i0);
+        uLongf clen = uLongf(buf.size());
+        int err = compress2(buf.data(), &clen, &vals[i0], uLong(n),
+                            Z_DEFAULT_COMPRESSION);
+        GMM_ASSERT1(err == Z_OK, "zlib compression failed, error " << err);
+        csizes[b] = size_type(clen);
+        cdata.insert(cdata.end(), buf.begin(), buf.begin() + clen);
+      }
+      push_header(head, nb_blocks, appended);
+      push_header(head, block_size, appended);
+      push_header(head, vals.size() % block_size, appended);
+      for (size_type b = 0; b < nb_blocks; ++b)
+        push_header(head, csizes[b], appended);
+      vals.swap(cdata);
+#endif
+    } else
+      push_header(head, vals.size(), appended);
+
+    if (appended) {
+      appended_data.insert(appended_data.end(), head.begin(), head.end());
+      appended_data.insert(appended_data.end(), vals.begin(), vals.end());
+    } else if (compressed) // the header is encoded separately in that case
+      os << base64_encode(head) << base64_encode(vals);
+    else {
+      head.insert(head.end(), vals.begin(), vals.end());
+      os << base64_encode(head);
     }
+    clear_vals();
+  }
+
+  void vtk_export::write_format() {
+    if (ascii)
+      os << "format=\"ascii\">\n";
+    else if (appended)
+      os << "format=\"appended\" offset=\"" << appended_data.size() << "\">\n";
+    else
+      os << "format=\"binary\">\n";
+  }
+
+  void vtk_export::write_pvtu(const std::string &pvtu_fname,
+                              const std::vector<std::string> &pieces) const {
+    GMM_ASSERT1(!vtk, "pvtu files are only available for vtu exports");
+    std::ofstream f(pvtu_fname.c_str());
+    GMM_ASSERT1(f, "impossible to write to file '" << pvtu_fname << "'");
+    f << "<?xml version=\"1.0\"?>\n";
+    f << "<VTKFile type=\"PUnstructuredGrid\" version=\"0.1\" ";
+    f << "byte_order=\"" << (reverse_endian ? "LittleEndian" : "BigEndian") << "\">\n";
+    f << "<!--" << header << "-->\n";
+    f << "<PUnstructuredGrid GhostLevel=\"0\">\n";
+    f << "<PPoints>\n";
+    f << "<PDataArray type=\"Float32\" NumberOfComponents=\"3\"/>\n";
+    f << "</PPoints>\n";
+    for (bool cell_data : {false, true}) {
+      bool first = true;
+      for (const data_array &da : data_arrays)
+        if (da.cell_data == cell_data) {
+          if (first) f << (cell_data ? "<PCellData>\n" : "<PPointData>\n");
+          first = false;
+          f << "<PDataArray type=\"Float32\" Name=\"" << da.name << "\"";
+          if (da.nb_comp > 1)
+            f << " NumberOfComponents=\"" << da.nb_comp << "\"";
+          f << "/>\n";
+        }
+      if (!first) f << (cell_data ? "</PCellData>\n" : "</PPointData>\n");
+    }
+    for (const std::string &piece : pieces)
+      f << "<Piece Source=\"" << piece << "\"/>\n";
+    f << "</PUnstructuredGrid>\n";
+    f << "</VTKFile>\n";
+  }
+
+  void pvd_export::add_time_step(scalar_type t, const std::string &file,
+                                 int part) {
+    datasets.push_back(pvd_dataset{t, part, file});
+    std::ofstream f(fname.c_str());
+    GMM_ASSERT1(f, "impossible to write to file '" << fname << "'");
+    f << "<?xml version=\"1.0\"?>\n";
+    f << "<VTKFile type=\"Collection\" version=\"0.1\">\n";
+    f << "<Collection>\n";
+    f << std::setprecision(16);
+    for (const pvd_dataset &ds : datasets)
+      f << "<DataSet timestep=\"" << ds.time << "\" part=\"" << ds.part
+        << "\" file=\"" << ds.file << "\"/>\n";
+    f << "</Collection>\n";
+    f << "</VTKFile>\n";
   }
 
   void vtk_export::write_mesh() {
@@ -446,8 +585,7 @@ namespace getfem
       os << "<Points>\n";
       os << "<DataArray type=\"Float32\" Name=\"Points\" ";
       os << "NumberOfComponents=\"3\" ";
-      os << (ascii ? "format=\"ascii\">\n" : "format=\"binary\">\n");
-      if (!ascii) write_val(int(sizeof(float)*psl->nb_points()*3));
+      write_format();
     }
     /*
        points are not merge, vtk is mostly fine with that (except for
@@ -472,15 +610,7 @@ namespace getfem
     } else {
       os << "<Cells>\n";
       os << "<DataArray type=\"Int32\" Name=\"connectivity\" ";
-      os << (ascii ? "format=\"ascii\">\n" : "format=\"binary\">\n");
-      if (!ascii) {
-        int size = 0;
-        for (size_type ic=0; ic < psl->nb_convex(); ++ic) {
-          for (const slice_simplex &s : psl->simplexes(ic))
-            size += int((s.dim()+1)*sizeof(int));
-        }
-        write_val(size);
-      }
+      write_format();
     }
     for (size_type ic=0; ic < psl->nb_convex(); ++ic) {
       for (const slice_simplex &s : psl->simplexes(ic)) {
@@ -499,13 +629,7 @@ namespace getfem
     } else {
       os << (ascii ? "" : "\n") << "</DataArray>\n";
       os << "<DataArray type=\"Int32\" Name=\"offsets\" ";
-      os << (ascii ? "format=\"ascii\">\n" : "format=\"binary\">\n");
-      if (!ascii) {
-        int size = 0;
-        for (size_type ic=0; ic < psl->nb_convex(); ++ic)
-          size += int(psl->simplexes(ic).size()*sizeof(int));
-        write_val(size);
-      }
+      write_format();
     }
     int cnt = 0;
     for (size_type ic=0; ic < psl->nb_convex(); ++ic) {
@@ -524,13 +648,7 @@ namespace getfem
     if (!vtk) {
       os << (ascii ? "" : "\n") << "</DataArray>\n";
       os << "<DataArray type=\"Int32\" Name=\"types\" ";
-      os << (ascii ? "format=\"ascii\">\n" : "format=\"binary\">\n");
-      if (!ascii) {
-        int size = 0;
-        for (size_type ic=0; ic < psl->nb_convex(); ++ic)
-          size += int(psl->simplexes(ic).size()*sizeof(int));
-        write_val(size);
-      }
+      write_format();
       for (size_type ic=0; ic < psl->nb_convex(); ++ic)
         for (const slice_simplex &s : psl->simplexes(ic))
           write_val(int(vtk_simplex_code[s.dim()]));
@@ -555,8 +673,7 @@ namespace getfem
       os << "<Points>\n";
       os << "<DataArray type=\"Float32\" Name=\"Points\" ";
       os << "NumberOfComponents=\"3\" ";
-      os << (ascii ? "format=\"ascii\">\n" : "format=\"binary\">\n");
-      if (!ascii) write_val(int(sizeof(float)*pmf_dof_used.card()*3));
+      write_format();
     }
     std::vector<int> dofmap(pmf->nb_dof());
     int cnt = 0;
@@ -580,15 +697,7 @@ namespace getfem
       os << "</Points>\n";
       os << "<Cells>\n";
       os << "<DataArray type=\"Int32\" Name=\"connectivity\" ";
-      os << (ascii ? "format=\"ascii\">\n" : "format=\"binary\">\n");
-      if (!ascii) {
-        int size = 0;
-        for (dal::bv_visitor cv(pmf->convex_index()); !cv.finished(); ++cv) {
-          const std::vector<unsigned> &dmap = select_vtk_dof_mapping(pmf_mapping_type[cv]);
-          size += int(sizeof(int)*dmap.size());
-        }
-        write_val(size);
-      }
+      write_format();
     }
 
     for (dal::bv_visitor cv(pmf->convex_index()); !cv.finished(); ++cv) {
@@ -606,9 +715,7 @@ namespace getfem
     } else {
       os << (ascii ? "" : "\n") << "</DataArray>\n";
       os << "<DataArray type=\"Int32\" Name=\"offsets\" ";
-      os << (ascii ? "format=\"ascii\">\n" : "format=\"binary\">\n");
-      if (!ascii)
-        write_val(int(pmf->convex_index().card()*sizeof(int)));
+      write_format();
       cnt = 0;
       for (dal::bv_visitor cv(pmf->convex_index()); !cv.finished(); ++cv) {
         const std::vector<unsigned> &dmap = select_vtk_dof_mapping(pmf_mapping_type[cv]);
@@ -618,9 +725,7 @@ namespace getfem
       write_vals();
       os << "\n" << "</DataArray>\n";
       os << "<DataArray type=\"Int32\" Name=\"types\" ";
-      os << (ascii ? "format=\"ascii\">\n" : "format=\"binary\">\n");
-      if (!ascii)
-        write_val(int(pmf->convex_index().card()*sizeof(int)));
+      write_format();
     }
     for (dal::bv_visitor cv(pmf->convex_index()); !cv.finished(); ++cv) {
       write_val(int(select_vtk_type(pmf_mapping_type[cv])));
@@ -4776,4 +4776,262 @@ namespace getfem {
   }
 
 
+  /* ******************************************************************** */
+  /*    Sum factorization for tensor product elements.                    */
+  /* ******************************************************************** */
+
+  static void tensor_product_1d_values(pfem pf1, scalar_type x,
+                                       base_vector &v, base_vector &dv) {
+    base_node pt(1); pt[0] = x;
+    base_tensor t;
+    pf1->base_value(pt, t); v.assign(t.begin(), t.end());
+    pf1->grad_base_value(pt, t); dv.assign(t.begin(), t.end());
+  }
+
+  // Identifies the base functions of pf with the products of the base
+  // functions of the one dimensional Lagrange element pf1 thanks to the
+  // dof nodes, and checks the values and gradients on some generic points.
+  static bool tensor_product_structure(pfem pf, pfem &pf1,
+                                       std::vector<size_type> &dof_grid) {
+    if (!pf || pf->target_dim() != 1 || !(pf->is_equivalent())
+        || pf->is_on_real_element() || !(pf->is_polynomial())
+        || pf->dim() == 0) return false;
+    dim_type N = pf->dim();
+    size_type ndof = pf->nb_base(0), nd = 1, ng = 1;
+    while (ng < ndof) {
+      ++nd; ng = 1;
+      for (dim_type d = 0; d < N; ++d) ng *= nd;
+    }
+    if (ng != ndof || nd < 2) return false;
+
+    pf1 = PK_fem(1, short_type(nd-1));
+    if (pf1->nb_base(0) != nd) return false;
+    dof_grid.assign(ndof, 0);
+    std::vector<bool> used(ndof, false);
+    for (size_type j = 0; j < ndof; ++j) {
+      const base_node &x = pf->node_of_dof(0, j);
+      if (x.size() != N) return false;
+      size_type ig = 0, stride = 1;
+      for (dim_type d = 0; d < N; ++d, stride *= nd) {
+        size_type i = 0;
+        while (i < nd && gmm::abs(pf1->node_of_dof(0, i)[0] - x[d]) > 1E-10)
+          ++i;
+        if (i == nd) return false;
+        ig += i * stride;
+      }
+      if (used[ig]) return false;
+      used[ig] = true; dof_grid[j] = ig;
+    }
+
+    std::vector<base_vector> v(N), dv(N);
+    std::vector<size_type> ind(N);
+    base_tensor t, tg;
+    for (size_type ip = 0; ip < 2; ++ip) {
+      base_node x(N);
+      for (dim_type d = 0; d < N; ++d) {
+        x[d] = ip ? 0.7311 - 0.0713*scalar_type(d%8)
+                  : 0.2113 + 0.0917*scalar_type(d%8);
+        tensor_product_1d_values(pf1, x[d], v[d], dv[d]);
+      }
+      pf->base_value(x, t); pf->grad_base_value(x, tg);
+      for (size_type j = 0; j < ndof; ++j) {
+        size_type ig = dof_grid[j];
+        for (dim_type d = 0; d < N; ++d) { ind[d] = ig % nd; ig /= nd; }
+        scalar_type val(1);
+        for (dim_type d = 0; d < N; ++d) val *= v[d][ind[d]];
+        if (gmm::abs(val - t[j]) > 1E-8) return false;
+        for (dim_type k = 0; k < N; ++k) {
+          scalar_type g(1);
+          for (dim_type d = 0; d < N; ++d)
+            g *= (d == k) ? dv[d][ind[d]] : v[d][ind[d]];
+          if (gmm::abs(g - tg[j + ndof*k]) > 1E-8 * (scalar_type(1)+gmm::abs(g)))
+            return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  bool is_tensor_product_fem(pfem pf) {
+    pfem pf1;
+    std::vector<size_type> dof_grid;
+    return tensor_product_structure(pf, pf1, dof_grid);
+  }
+
+  fem_sum_factorization_::fem_sum_factorization_
+  (pfem pf, bgeot::pstored_point_tab pspt, size_type nbpt_)
+    : N(pf->dim()), nbpt(nbpt_), valid(false) {
+    DAL_STORED_OBJECT_DEBUG_CREATED(this, "Fem_sum_factorization");
+    pfem pf1;
+    if (nbpt == 0 || nbpt > pspt->size() || (*pspt)[0].size() != N
+        || !tensor_product_structure(pf, pf1, dof_grid)) return;
+
+    // The distinct coordinates of the points in each direction.
+    std::vector<base_vector> x1(N);
+    std::vector<std::vector<size_type> > ind(N);
+    for (dim_type d = 0; d < N; ++d) {
+      ind[d].resize(nbpt);
+      for (size_type i = 0; i < nbpt; ++i) {
+        scalar_type x = (*pspt)[i][d];
+        size_type q = 0;
+        while (q < x1[d].size() && gmm::abs(x1[d][q] - x) > 1E-12) ++q;
+        if (q == x1[d].size()) x1[d].push_back(x);
+        ind[d][i] = q;
+      }
+    }
+    size_type ngrid = 1;
+    nq.resize(N); nd.assign(N, pf1->nb_base(0));
+    for (dim_type d = 0; d < N; ++d) { nq[d] = x1[d].size(); ngrid *= nq[d]; }
+    if (ngrid != nbpt) return;
+    point_grid.assign(nbpt, 0);
+    std::vector<bool> used(nbpt, false);
+    for (size_type i = 0; i < nbpt; ++i) {
+      size_type ig = 0, stride = 1;
+      for (dim_type d = 0; d < N; ++d) { ig += ind[d][i]*stride; stride *= nq[d]; }
+      if (used[ig]) return;
+      used[ig] = true; point_grid[i] = ig;
+    }
+
+    B.resize(N); D.resize(N);
+    base_vector v, dv;
+    for (dim_type d = 0; d < N; ++d) {
+      B[d].resize(nq[d], nd[d]); D[d].resize(nq[d], nd[d]);
+      for (size_type q = 0; q < nq[d]; ++q) {
+        tensor_product_1d_values(pf1, x1[d][q], v, dv);
+        for (size_type m = 0; m < nd[d]; ++m)
+          { B[d](q, m) = v[m]; D[d](q, m) = dv[m]; }
+      }
+    }
+    valid = true;
+  }
+
+  // Applies the one dimensional matrices dimension by dimension, the
+  // derivative matrix in the direction kder (if any).
+  void fem_sum_factorization_::apply(const base_vector &coeff, size_type Q,
+                                     size_type kder, scalar_type *res,
+                                     base_vector &w1, base_vector &w2) const {
+    size_type ndof = dof_grid.size();
+    GMM_ASSERT1(valid && coeff.size() == Q*ndof, "Wrong size for coeff");
+    w1.resize(Q*ndof);
+    for (size_type j = 0; j < ndof; ++j)
+      for (size_type q = 0; q < Q; ++q)
+        w1[q + Q*dof_grid[j]] = coeff[q + Q*j];
+
+    size_type a = Q, b = ndof;
+    for (dim_type d = 0; d < N; ++d) {
+      const base_matrix &M = (d == kder) ? D[d] : B[d];
+      size_type n = nd[d], m = nq[d];
+      b /= n;
+      w2.resize(a*m*b);
+      for (size_type jb = 0; jb < b; ++jb)
+        for (size_type iq = 0; iq < m; ++iq) {
+          scalar_type *out = &w2[a*(iq + m*jb)];
+          std::fill(out, out+a, scalar_type(0));
+          for (size_type l = 0; l < n; ++l) {
+            scalar_type c = M(iq, l);
+            if (c == scalar_type(0)) continue;
+            const scalar_type *in = &w1[a*(l + n*jb)];
+            for (size_type i = 0; i < a; ++i) out[i] += c * in[i];
+          }
+        }
+      a *= m;
+      std::swap(w1, w2);
+    }
+
+    for (size_type i = 0; i < nbpt; ++i)
+      for (size_type q = 0; q < Q; ++q)
+        res[q + Q*i] = w1[q + Q*point_grid[i]];
+  }
+
+  // Transposed of apply: the values at the points are contracted with the
+  // one dimensional matrices dimension by dimension and added to coeff.
+  void fem_sum_factorization_::apply_transposed(const scalar_type *val,
+                                                size_type Q, size_type kder,
+                                                base_vector &coeff,
+                                                base_vector &w1,
+                                                base_vector &w2) const {
+    size_type ndof = dof_grid.size();
+    GMM_ASSERT1(valid && coeff.size() == Q*ndof, "Wrong size for coeff");
+    w1.resize(Q*nbpt);
+    for (size_type i = 0; i < nbpt; ++i)
+      for (size_type q = 0; q < Q; ++q)
+        w1[q + Q*point_grid[i]] = val[q + Q*i];
+
+    size_type a = Q, b = nbpt;
+    for (dim_type d = 0; d < N; ++d) {
+      const base_matrix &M = (d == kder) ? D[d] : B[d];
+      size_type n = nd[d], m = nq[d];
+      b /= m;
+      w2.resize(a*n*b);
+      for (size_type jb = 0; jb < b; ++jb)
+        for (size_type l = 0; l < n; ++l) {
+          scalar_type *out = &w2[a*(l + n*jb)];
+          std::fill(out, out+a, scalar_type(0));
+          for (size_type iq = 0; iq < m; ++iq) {
+            scalar_type c = M(iq, l);
+            if (c == scalar_type(0)) continue;
+            const scalar_type *in = &w1[a*(iq + m*jb)];
+            for (size_type i = 0; i < a; ++i) out[i] += c * in[i];
+          }
+        }
+      a *= n;
+      std::swap(w1, w2);
+    }
+
+    for (size_type j = 0; j < ndof; ++j)
+      for (size_type q = 0; q < Q; ++q)
+        coeff[q + Q*j] += w1[q + Q*dof_grid[j]];
+  }
+
+  void fem_sum_factorization_::values(const base_vector &coeff, size_type Q,
+                                      base_vector &val, base_vector &w1,
+                                      base_vector &w2) const {
+    val.resize(Q*nbpt);
+    apply(coeff, Q, size_type(-1), &val[0], w1, w2);
+  }
+
+  void fem_sum_factorization_::ref_gradients(const base_vector &coeff,
+                                             size_type Q, base_vector &grad,
+                                             base_vector &w1,
+                                             base_vector &w2) const {
+    grad.resize(Q*nbpt*N);
+    for (dim_type k = 0; k < N; ++k)
+      apply(coeff, Q, k, &grad[Q*nbpt*k], w1, w2);
+  }
+
+  void fem_sum_factorization_::add_transposed_values
+  (const base_vector &val, size_type Q, base_vector &coeff,
+   base_vector &w1, base_vector &w2) const {
+    GMM_ASSERT1(val.size() == Q*nbpt, "Wrong size for val");
+    apply_transposed(&val[0], Q, size_type(-1), coeff, w1, w2);
+  }
+
+  void fem_sum_factorization_::add_transposed_ref_gradients
+  (const base_vector &grad, size_type Q, base_vector &coeff,
+   base_vector &w1, base_vector &w2) const {
+    GMM_ASSERT1(grad.size() == Q*nbpt*N, "Wrong size for grad");
+    for (dim_type k = 0; k < N; ++k)
+      apply_transposed(&grad[Q*nbpt*k], Q, k, coeff, w1, w2);
+  }
+
+  DAL_TRIPLE_KEY(sum_factorization_key_, pfem, bgeot::pstored_point_tab,
+                 size_type);
+
+  pfem_sum_factorization fem_sum_factorization(pfem pf,
+                                               bgeot::pstored_point_tab pspt,
+                                               size_type nbpt) {
+    dal::pstatic_stored_object_key
+      pk = std::make_shared<sum_factorization_key_>(pf, pspt, nbpt);
+    dal::pstatic_stored_object o = dal::search_stored_object(pk);
+    pfem_sum_factorization p;
+    if (o) p = std::dynamic_pointer_cast<const fem_sum_factorization_>(o);
+    else {
+      p = std::make_shared<fem_sum_factorization_>(pf, pspt, nbpt);
+      dal::add_stored_object(pk, p, pspt, dal::AUTODELETE_STATIC_OBJECT);
+      if (dal::exists_stored_object(pf)) dal::add_dependency(p, pf);
+    }
+    return p->is_valid() ? p : pfem_sum_factorization();
+  }
+
+
 }  /* end of namespace getfem.                                            */
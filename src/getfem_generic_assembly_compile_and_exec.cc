@@ -746,6 +746,84 @@ namespace getfem {
 
   };
 
+  // Value or gradient of a variable whose fem and integration method have
+  // a tensor product structure (Qk on parallelepipeds with
+  // IM_GAUSS_PARALLELEPIPED for instance). The values at all the
+  // integration points of the element are computed by sum factorization
+  // on the first point. Falls back to the standard evaluation on faces,
+  // for interpolation or when the structure is not detected.
+  struct ga_instruction_sum_factorized_val : public ga_instruction {
+    base_tensor &t;
+    const base_vector &coeff;
+    fem_interpolation_context &ctx;
+    const mesh_fem &mf;
+    const papprox_integration &pai;
+    const size_type &ipt;
+    size_type qdim;
+    bool grad;
+    base_tensor Z;
+    ga_instruction_val_base base_ins;
+    ga_instruction_grad_base grad_base_ins;
+    ga_instruction_val val_ins;
+    ga_instruction_grad grad_ins;
+    pfem pf_old;
+    papprox_integration pai_old;
+    pfem_sum_factorization psf;
+    size_type cv_old;
+    bool uptodate;
+    base_vector vals, w1, w2;
+
+    virtual int exec() {
+      GA_DEBUG_INFO("Instruction: sum factorized variable value or gradient");
+      if (ipt == 0 || ctx.convex_num() != cv_old) uptodate = false;
+      cv_old = ctx.convex_num();
+      if (ctx.have_pgp() && pai &&
+          ctx.pgp()->get_ppoint_tab() == pai->pintegration_points()) {
+        pfem pf = mf.fem_of_element(ctx.convex_num());
+        if (pf != pf_old || pai != pai_old) {
+          psf = fem_sum_factorization(pf, pai->pintegration_points(),
+                                      pai->nb_points_on_convex());
+          pf_old = pf; pai_old = pai; uptodate = false;
+        }
+        size_type ii = ctx.ii();
+        if (psf && ii < psf->nb_points()) {
+          if (!uptodate) {
+            if (grad) psf->ref_gradients(coeff, qdim, vals, w1, w2);
+            else psf->values(coeff, qdim, vals, w1, w2);
+            uptodate = true;
+          }
+          if (grad) { // t(qdim,N) = grad_ref(qdim,P) B^T
+            const base_matrix &B = ctx.B();
+            size_type N = B.nrows(), P = B.ncols(), nbpt = psf->nb_points();
+            GA_DEBUG_ASSERT(t.size() == qdim*N, "dimensions mismatch");
+            for (size_type k = 0; k < N; ++k)
+              for (size_type q = 0; q < qdim; ++q) {
+                scalar_type a(0);
+                for (size_type p = 0; p < P; ++p)
+                  a += B(k, p) * vals[q + qdim*(ii + nbpt*p)];
+                t[q + qdim*k] = a;
+              }
+          } else
+            std::copy(vals.begin() + qdim*ii, vals.begin() + qdim*(ii+1),
+                      t.begin());
+          return 0;
+        }
+      }
+      if (grad) { grad_base_ins.exec(); grad_ins.exec(); }
+      else { base_ins.exec(); val_ins.exec(); }
+      return 0;
+    }
+
+    ga_instruction_sum_factorized_val
+    (base_tensor &tt, const base_vector &co, fem_interpolation_context &ct,
+     const mesh_fem &mf_, pfem_precomp &pfp, const papprox_integration &pai_,
+     const size_type &ipt_, size_type q, bool grad_)
+      : t(tt), coeff(co), ctx(ct), mf(mf_), pai(pai_), ipt(ipt_), qdim(q),
+        grad(grad_), base_ins(Z, ct, mf_, pfp), grad_base_ins(Z, ct, mf_, pfp),
+        val_ins(tt, Z, co, q), grad_ins(tt, Z, co, q),
+        cv_old(size_type(-1)), uptodate(false) {}
+  };
+
   struct ga_instruction_hess : public ga_instruction_val {
     // Z(ndof,target_dim,N*N), coeff(Qmult,ndof) --> t(target_dim*Qmult,N,N)
     virtual int exec() {
@@ -4734,6 +4812,140 @@ namespace getfem {
     const bool false_=false;
   };
 
+  // Vector assembly of a sum of terms c*Test_u, c.Test_u or
+  // G:Grad_Test_u (see ga_sum_factorized_test_terms) for a variable on a
+  // uniform tensor product fem. Only the coefficients c and G are
+  // evaluated at the integration points. They are stored, multiplied by
+  // the weight, and integrated against the test functions by sum
+  // factorization at the last point. Falls back to the complete base
+  // function tables on faces or when the structure is not detected.
+  struct ga_instruction_sum_factorized_vector_assembly
+    : public ga_instruction {
+    struct term {
+      const base_tensor *c;   // c(qdim) or G(qdim,N)
+      scalar_type sign;
+      bool grad;
+    };
+    std::vector<term> terms;
+    base_vector &V;
+    fem_interpolation_context &ctx;
+    const gmm::sub_interval &I;
+    const mesh_fem &mf;
+    const papprox_integration &pai;
+    const scalar_type &coeff;
+    const size_type &nbpt, &ipt;
+    size_type qdim;
+    bool has_val, has_grad, factorized;
+    base_tensor Zv, Zg;
+    ga_instruction_val_base base_ins;
+    ga_instruction_grad_base grad_base_ins;
+    pfem pf_old;
+    papprox_integration pai_old;
+    pfem_sum_factorization psf;
+    base_vector elem, rv, rg, w1, w2;
+
+    virtual int exec() {
+      GA_DEBUG_INFO("Instruction: sum factorized vector term assembly");
+      if (!ctx.is_convex_num_valid()) return 0;
+      size_type cv = ctx.convex_num();
+      if (ipt == 0) {
+        factorized = false;
+        if (ctx.have_pgp() && pai &&
+            ctx.pgp()->get_ppoint_tab() == pai->pintegration_points()) {
+          pfem pf = mf.fem_of_element(cv);
+          if (pf != pf_old || pai != pai_old) {
+            psf = fem_sum_factorization(pf, pai->pintegration_points(),
+                                        pai->nb_points_on_convex());
+            pf_old = pf; pai_old = pai;
+          }
+          factorized = psf && nbpt == psf->nb_points() && ctx.ii() == 0;
+        }
+        elem.assign(qdim * mf.ind_scalar_basic_dof_of_element(cv).size(),
+                    scalar_type(0));
+        if (factorized) {
+          if (has_val) rv.assign(qdim*nbpt, scalar_type(0));
+          if (has_grad) rg.assign(qdim*nbpt*ctx.B().ncols(), scalar_type(0));
+        }
+      }
+
+      if (coeff != scalar_type(0)) {
+        if (factorized) {
+          size_type ii = ctx.ii();
+          for (const term &tm : terms) {
+            const base_tensor &c = *(tm.c);
+            scalar_type s = coeff * tm.sign;
+            if (tm.grad) { // rg(qdim,P) += s G(qdim,N) B
+              const base_matrix &B = ctx.B();
+              size_type N = B.nrows(), P = B.ncols();
+              for (size_type p = 0; p < P; ++p)
+                for (size_type q = 0; q < qdim; ++q) {
+                  scalar_type a(0);
+                  for (size_type k = 0; k < N; ++k)
+                    a += c[q + qdim*k] * B(k, p);
+                  rg[q + qdim*(ii + nbpt*p)] += s * a;
+                }
+            } else
+              for (size_type q = 0; q < qdim; ++q)
+                rv[q + qdim*ii] += s * c[q];
+          }
+        } else {
+          if (has_val) base_ins.exec();
+          if (has_grad) grad_base_ins.exec();
+          size_type ndof = elem.size() / qdim;
+          for (const term &tm : terms) {
+            const base_tensor &c = *(tm.c);
+            scalar_type s = coeff * tm.sign;
+            if (tm.grad) { // Zg(ndof,1,N)
+              size_type N = Zg.sizes()[2];
+              for (size_type k = 0; k < N; ++k)
+                for (size_type j = 0; j < ndof; ++j) {
+                  scalar_type z = s * Zg[j + ndof*k];
+                  for (size_type q = 0; q < qdim; ++q)
+                    elem[q + qdim*j] += z * c[q + qdim*k];
+                }
+            } else
+              for (size_type j = 0; j < ndof; ++j) {
+                scalar_type z = s * Zv[j];
+                for (size_type q = 0; q < qdim; ++q)
+                  elem[q + qdim*j] += z * c[q];
+              }
+          }
+        }
+      }
+
+      if (ipt == nbpt-1) { // finalize
+        if (factorized) {
+          if (has_val) psf->add_transposed_values(rv, qdim, elem, w1, w2);
+          if (has_grad)
+            psf->add_transposed_ref_gradients(rg, qdim, elem, w1, w2);
+        }
+        GA_DEBUG_ASSERT(V.size() >= I.first() + mf.nb_basic_dof(),
+                        "Bad assembly vector size");
+        auto itr = elem.cbegin();
+        auto itw = V.begin() + I.first();
+        for (const auto &dof : mf.ind_scalar_basic_dof_of_element(cv))
+          for (size_type q = 0; q < qdim; ++q)
+            *(itw+dof+q) += *itr++;
+        GMM_ASSERT1(itr == elem.end(), "Internal error");
+      }
+      return 0;
+    }
+
+    ga_instruction_sum_factorized_vector_assembly
+    (const std::vector<term> &terms_, base_vector &V_,
+     fem_interpolation_context &ctx_, const gmm::sub_interval &I_,
+     const mesh_fem &mf_, pfem_precomp &pfp, const papprox_integration &pai_,
+     const scalar_type &coeff_, const size_type &nbpt_,
+     const size_type &ipt_)
+      : terms(terms_), V(V_), ctx(ctx_), I(I_), mf(mf_), pai(pai_),
+        coeff(coeff_), nbpt(nbpt_), ipt(ipt_), qdim(mf_.get_qdim()),
+        has_val(false), has_grad(false), factorized(false),
+        base_ins(Zv, ctx_, mf_, pfp), grad_base_ins(Zg, ctx_, mf_, pfp) {
+      for (const term &tm : terms)
+        { if (tm.grad) has_grad = true; else has_val = true; }
+    }
+  };
+
   struct ga_instruction_vector_assembly_imd : public ga_instruction {
     const base_tensor &t;
     base_vector &V;
@@ -4936,6 +5148,121 @@ namespace getfem {
   }
 
 
+  // Positions of the entries (dofs1[i], dofs2[j]) in the stored entries of
+  // the columns of K, unsigned(-1) for the entries which are not stored.
+  inline void find_elem_matrix_slots
+  (gmm::col_matrix<gmm::rsvector<scalar_type>> &K,
+   const std::vector<size_type> &dofs1, const std::vector<size_type> &dofs2,
+   unsigned *slots) {
+    for (const size_type &dof2 : dofs2) {
+      const std::vector<gmm::elt_rsvector_<scalar_type>> &col = K[dof2];
+      for (const size_type &dof1 : dofs1) {
+        auto itc = std::lower_bound(col.begin(), col.end(),
+                                    gmm::elt_rsvector_<scalar_type>(dof1));
+        *slots++ = (itc != col.end() && itc->c == dof1)
+                 ? unsigned(itc - col.begin()) : unsigned(-1);
+      }
+    }
+  }
+
+  // Addition of an element matrix through the positions of its entries
+  // recorded in slots by a previous assembly. A position which does not
+  // point to the right row any more (the pattern has changed) falls back
+  // to the search of the entry, and the positions are then updated.
+  inline void add_elem_matrix_slots
+  (gmm::col_matrix<gmm::rsvector<scalar_type>> &K,
+   const std::vector<size_type> &dofs1, const std::vector<size_type> &dofs2,
+   const base_vector &elem, scalar_type threshold, unsigned *slots) {
+    bool outdated(false);
+    base_vector::const_iterator it = elem.cbegin();
+    const unsigned *its = slots;
+    for (const size_type &dof2 : dofs2) {
+      std::vector<gmm::elt_rsvector_<scalar_type>> &col = K[dof2];
+      for (const size_type &dof1 : dofs1) {
+        size_type k = *its++;
+        if (k < col.size() && col[k].c == dof1)
+          col[k].e += *it;
+        else if (gmm::abs(*it) > threshold) {
+          K(dof1, dof2) += *it;
+          outdated = true;
+        }
+        ++it;
+      }
+    }
+    if (outdated) find_elem_matrix_slots(K, dofs1, dofs2, slots);
+  }
+
+  void ga_matrix_slots::clear() {
+    terms.clear();
+    recorded.on_thread_update();
+    for (size_type t = 0; t < recorded.num_threads(); ++t)
+      recorded(t) = recorded_slots();
+  }
+
+  void ga_matrix_slots::merge() {
+    recorded.on_thread_update();
+    bool outdated(false), added(false);
+    for (size_type t = 0; t < recorded.num_threads(); ++t) {
+      outdated = outdated || recorded(t).outdated;
+      added = added || !(recorded(t).elts.empty());
+    }
+    if (outdated) { clear(); return; }
+    if (!added) return;
+
+    // Number of positions of each element of each term, from the tables
+    // and the recorded positions (an element is recorded by one thread).
+    std::vector<std::vector<size_type> > counts(terms.size());
+    for (size_type t = 0; t < recorded.num_threads(); ++t)
+      for (const auto &e : recorded(t).elts)
+        if (e[0] >= counts.size()) counts.resize(e[0]+1);
+    for (size_type i = 0; i < terms.size(); ++i)
+      if (terms[i].offset.size()) {
+        counts[i].assign(terms[i].offset.size()-1, 0);
+        for (size_type cv = 0; cv+1 < terms[i].offset.size(); ++cv)
+          counts[i][cv] = terms[i].offset[cv+1] - terms[i].offset[cv];
+      }
+    for (size_type t = 0; t < recorded.num_threads(); ++t)
+      for (const auto &e : recorded(t).elts) {
+        std::vector<size_type> &c = counts[e[0]];
+        if (e[1] >= c.size()) c.resize(e[1]+1, 0);
+        c[e[1]] += e[2];
+      }
+
+    // New tables: the positions of the elements already in the tables are
+    // copied, the recorded ones are appended in their order.
+    std::vector<term_slots> new_terms(counts.size());
+    for (size_type i = 0; i < counts.size(); ++i) {
+      term_slots &ts = new_terms[i];
+      if (counts[i].empty()) continue;
+      ts.offset.resize(counts[i].size()+1);
+      ts.offset[0] = 0;
+      for (size_type cv = 0; cv < counts[i].size(); ++cv)
+        ts.offset[cv+1] = ts.offset[cv] + counts[i][cv];
+      ts.pos.resize(ts.offset.back());
+      if (i < terms.size())
+        for (size_type cv = 0; cv+1 < terms[i].offset.size(); ++cv)
+          std::copy(terms[i].pos.begin() + terms[i].offset[cv],
+                    terms[i].pos.begin() + terms[i].offset[cv+1],
+                    ts.pos.begin() + ts.offset[cv]);
+      counts[i].assign(counts[i].size(), 0); // --> filling cursors
+      if (i < terms.size())
+        for (size_type cv = 0; cv+1 < terms[i].offset.size(); ++cv)
+          counts[i][cv] = terms[i].offset[cv+1] - terms[i].offset[cv];
+    }
+    for (size_type t = 0; t < recorded.num_threads(); ++t) {
+      auto itp = recorded(t).pos.cbegin();
+      for (const auto &e : recorded(t).elts) {
+        term_slots &ts = new_terms[e[0]];
+        std::copy(itp, itp + e[2],
+                  ts.pos.begin() + ts.offset[e[1]] + counts[e[0]][e[1]]);
+        counts[e[0]][e[1]] += e[2];
+        itp += e[2];
+      }
+      recorded(t) = recorded_slots();
+    }
+    terms.swap(new_terms);
+  }
+
   inline void add_elem_matrix_contiguous_rows
   (gmm::col_matrix<gmm::rsvector<scalar_type>> &K,
    const size_type &i1, const size_type &s1,
@@ -5044,6 +5371,58 @@ namespace getfem {
     base_vector elem;
     bool interpolate;
     std::vector<size_type> dofs1, dofs2, dofs1_sort;
+    ga_matrix_slots *const *slots = nullptr; // slots of the workspace
+    size_type slot_term = 0;                 // number of the term in slots
+    size_type slot_cv = size_type(-1), slot_cursor = 0;
+    short_type slot_f = 0;
+    bool slot_record = false;
+    bool use_slots() const { return slots && *slots; }
+    // To be called before the element matrices of an element or of a face
+    // are added: they are added through the positions of the table of the
+    // term, or their positions are recorded if the element is not in it.
+    // The faces of an element are visited in increasing order, a face
+    // number which does not increase is a new assembly.
+    void begin_elem_slots() {
+      if (!use_slots()) return;
+      size_type cv = ctx1.convex_num();
+      short_type f = ctx1.is_on_face() ? ctx1.face_num() : short_type(-1);
+      if (cv != slot_cv || f <= slot_f) {
+        const auto &terms = (*slots)->terms;
+        slot_record = !(slot_term < terms.size()
+                        && terms[slot_term].has_element(cv));
+        slot_cursor = slot_record ? 0 : terms[slot_term].offset[cv];
+        slot_cv = cv;
+      }
+      slot_f = f;
+    }
+    // Adds elem to K, through the slots of the workspace when defined.
+    void add_elem(model_real_sparse_matrix &K,
+                  const std::vector<size_type> &d1,
+                  const std::vector<size_type> &d2,
+                  scalar_type threshold, size_type N) {
+      if (d1.empty() || d2.empty()) return;
+      if (use_slots()) {
+        size_type n = d1.size() * d2.size();
+        if (slot_record) {
+          auto &rec = (*slots)->recorded.thrd_cast();
+          add_elem_matrix(K, d1, d2, dofs1_sort, elem, threshold, N);
+          rec.elts.push_back({{slot_term, slot_cv, n}});
+          rec.pos.resize(rec.pos.size() + n);
+          find_elem_matrix_slots(K, d1, d2, &(rec.pos[rec.pos.size()-n]));
+          return;
+        }
+        auto &ts = (*slots)->terms[slot_term];
+        if (slot_cursor + n <= ts.offset[slot_cv+1])
+          add_elem_matrix_slots(K, d1, d2, elem, threshold,
+                                &(ts.pos[slot_cursor]));
+        else { // not the element matrices of the recording
+          (*slots)->recorded.thrd_cast().outdated = true;
+          add_elem_matrix(K, d1, d2, dofs1_sort, elem, threshold, N);
+        }
+        slot_cursor += n;
+      } else
+        add_elem_matrix(K, d1, d2, dofs1_sort, elem, threshold, N);
+    }
     void add_tensor_to_element_matrix(bool initialize, bool empty_weight) {
       if (initialize) {
         if (empty_weight) elem.resize(0);
@@ -5374,35 +5753,45 @@ namespace getfem {
         // Faster than a daxpy blas call on my config
         add_scaled_4(t, coeff*alpha1*alpha2, elem);
 
-      if (ipt == nbpt-1) { // finalize
-        GA_DEBUG_ASSERT(I1.size() && I2.size(), "Internal error");
-
-        scalar_type ninf = gmm::vect_norminf(elem);
-        if (ninf == scalar_type(0)) return 0;
+      if (ipt == nbpt-1) // finalize
+        assemble_element_matrix();
+      return 0;
+    }
 
-        size_type cv1 = ctx1.convex_num(), cv2 = ctx2.convex_num(), N=ctx1.N();
-        if (cv1 == size_type(-1)) return 0;
-        auto &ct1 = pmf1->ind_scalar_basic_dof_of_element(cv1);
-        GA_DEBUG_ASSERT(ct1.size() == t.sizes()[0], "Internal error");
-        populate_dofs_vector(dofs1, ct1.size(), I1.first(), ct1);
+    void assemble_element_matrix() {
+      GA_DEBUG_ASSERT(I1.size() && I2.size(), "Internal error");
 
-        if (pmf2 == pmf1 && cv1 == cv2) {
-          if (I1.first() == I2.first()) {
-            add_elem_matrix(K, dofs1, dofs1, dofs1_sort, elem, ninf*1E-14, N);
-          } else {
-            populate_dofs_vector(dofs2, dofs1.size(), I2.first() - I1.first(),
-                                 dofs1);
-            add_elem_matrix(K, dofs1, dofs2, dofs1_sort, elem, ninf*1E-14, N);
-          }
+      // With the slots, the zero element matrices keep their place in the
+      // sequence of the element matrices of the term.
+      scalar_type ninf = gmm::vect_norminf(elem);
+      if (ninf == scalar_type(0) && !use_slots()) return;
+
+      size_type cv1 = ctx1.convex_num(), cv2 = ctx2.convex_num(), N=ctx1.N();
+      if (cv1 == size_type(-1)) return;
+      begin_elem_slots();
+      auto &ct1 = pmf1->ind_scalar_basic_dof_of_element(cv1);
+      populate_dofs_vector(dofs1, ct1.size(), I1.first(), ct1);
+
+      // The element matrix is checked rather than t, which is not computed
+      // by the batched version.
+      if (pmf2 == pmf1 && cv1 == cv2) {
+        GA_DEBUG_ASSERT(elem.size() == ct1.size()*ct1.size(),
+                        "Internal error");
+        if (I1.first() == I2.first()) {
+          add_elem(K, dofs1, dofs1, ninf*1E-14, N);
         } else {
-          if (cv2 == size_type(-1)) return 0;
-          auto &ct2 = pmf2->ind_scalar_basic_dof_of_element(cv2);
-          GA_DEBUG_ASSERT(ct2.size() == t.sizes()[1], "Internal error");
-          populate_dofs_vector(dofs2, ct2.size(), I2.first(), ct2);
-          add_elem_matrix(K, dofs1, dofs2, dofs1_sort, elem, ninf*1E-14, N);
+          populate_dofs_vector(dofs2, dofs1.size(), I2.first() - I1.first(),
+                               dofs1);
+          add_elem(K, dofs1, dofs2, ninf*1E-14, N);
         }
+      } else {
+        if (cv2 == size_type(-1)) return;
+        auto &ct2 = pmf2->ind_scalar_basic_dof_of_element(cv2);
+        GA_DEBUG_ASSERT(elem.size() == ct1.size()*ct2.size(),
+                        "Internal error");
+        populate_dofs_vector(dofs2, ct2.size(), I2.first(), ct2);
+        add_elem(K, dofs1, dofs2, ninf*1E-14, N);
       }
-      return 0;
     }
     ga_instruction_matrix_assembly_standard_scalar
     (const base_tensor &t_, model_real_sparse_matrix &K_,
@@ -5417,6 +5806,155 @@ namespace getfem {
         K(K_), I1(I1_), I2(I2_), pmf1(mfn1_), pmf2(mfn2_) {}
   };
 
+  // Element matrix E = A1 * A2^T for a fixed number of rows of A1 and A2
+  // (i.e. of local dofs). The accumulators are kept in a local array of
+  // compile-time size so that the loops are fully unrolled and vectorized.
+  template<int N1, int N2> inline
+  void batched_elem_product__(const base_vector &A1, const base_vector &A2,
+                              size_type nbcol, base_vector &elem) {
+    scalar_type e[N1*N2] = {};
+    auto ita = A1.cbegin(), itb = A2.cbegin();
+    for (size_type k = 0; k < nbcol; ++k, ita += N1, itb += N2)
+      for (int j = 0; j < N2; ++j) {
+        scalar_type b = itb[j];
+        for (int i = 0; i < N1; ++i) e[i+N1*j] += ita[i] * b;
+      }
+    std::copy(e, e+N1*N2, elem.begin());
+  }
+
+  inline bool batched_elem_product_unrolled
+  (size_type n1, size_type n2, const base_vector &A1, const base_vector &A2,
+   size_type nbcol, base_vector &elem) {
+    if (n1 != n2) return false;
+    switch (n1) { // Most common low order elements
+    case 3: batched_elem_product__<3,3>(A1, A2, nbcol, elem); return true;
+    case 4: batched_elem_product__<4,4>(A1, A2, nbcol, elem); return true;
+    case 6: batched_elem_product__<6,6>(A1, A2, nbcol, elem); return true;
+    case 8: batched_elem_product__<8,8>(A1, A2, nbcol, elem); return true;
+    case 10: batched_elem_product__<10,10>(A1, A2, nbcol, elem); return true;
+    default: return false;
+    }
+  }
+
+  // Tile of BI rows and BJ columns of E = A1 * A2^T, at the positions
+  // pointed by a in A1, b in A2 and e in E, with the accumulators in
+  // registers.
+  template<int BI, int BJ> inline
+  void batched_elem_product_tile__(const scalar_type *a, const scalar_type *b,
+                                   size_type n1, size_type n2,
+                                   size_type nbcol, scalar_type *e) {
+    scalar_type acc[BI*BJ] = {};
+    for (size_type k = 0; k < nbcol; ++k, a += n1, b += n2)
+      for (int j = 0; j < BJ; ++j) {
+        scalar_type bj = b[j];
+        for (int i = 0; i < BI; ++i) acc[i+BI*j] += a[i] * bj;
+      }
+    for (int j = 0; j < BJ; ++j)
+      for (int i = 0; i < BI; ++i) e[i+n1*j] = acc[i+BI*j];
+  }
+
+  // Same for the tiles of the last rows and columns, of at most 4 x 4.
+  inline void batched_elem_product_tile
+  (const scalar_type *a, const scalar_type *b, size_type n1, size_type n2,
+   size_type nbcol, scalar_type *e, size_type ri, size_type rj) {
+    scalar_type acc[16] = {};
+    for (size_type k = 0; k < nbcol; ++k, a += n1, b += n2)
+      for (size_type j = 0; j < rj; ++j) {
+        scalar_type bj = b[j];
+        for (size_type i = 0; i < ri; ++i) acc[i+4*j] += a[i] * bj;
+      }
+    for (size_type j = 0; j < rj; ++j)
+      for (size_type i = 0; i < ri; ++i) e[i+n1*j] = acc[i+4*j];
+  }
+
+  // Element matrix E = A1 * A2^T for any number of rows of A1 and A2, by
+  // tiles of 4 x 4 entries: each entry of A1 and A2 loaded is used four
+  // times and the entries of E are written once, instead of being read and
+  // written for each column of A1 and A2.
+  inline void batched_elem_product_blocked
+  (size_type n1, size_type n2, const base_vector &A1, const base_vector &A2,
+   size_type nbcol, base_vector &elem) {
+    for (size_type j0 = 0; j0 < n2; j0 += 4)
+      for (size_type i0 = 0; i0 < n1; i0 += 4) {
+        size_type ri = std::min(size_type(4), n1-i0);
+        size_type rj = std::min(size_type(4), n2-j0);
+        const scalar_type *a = &(A1[i0]), *b = &(A2[j0]);
+        scalar_type *e = &(elem[i0+n1*j0]);
+        if (ri == 4 && rj == 4)
+          batched_elem_product_tile__<4,4>(a, b, n1, n2, nbcol, e);
+        else
+          batched_elem_product_tile(a, b, n1, n2, nbcol, e, ri, rj);
+      }
+  }
+
+  // Minimal number of multiplications of the product of the batched
+  // factors for which a BLAS dgemm call is faster than the plain loops.
+  const size_type GA_BATCHED_DGEMM_MIN_SIZE = 27;
+
+  // Batched version of the previous instruction for a term of the form
+  // A(i,k) B(j,k) where A depends only on the first test function and B only
+  // on the second one. Instead of computing the elementary contribution at
+  // each Gauss point, the scaled values of A and B are gathered for all the
+  // Gauss points of the element in two column-major blocks
+  // A1 = [c_0 A_0 ... c_nq A_nq] and A2 = [B_0 ... B_nq] and the element
+  // matrix is obtained at the last Gauss point by a single product
+  // A1 * A2^T, which is vectorized over the Gauss points (one BLAS gemm call).
+  struct ga_instruction_matrix_assembly_standard_scalar_batched
+    : public ga_instruction_matrix_assembly_standard_scalar
+  {
+    const base_tensor &tA, &tB;
+    base_vector A1, A2;
+    size_type nbcol;
+    virtual int exec() {
+      GA_DEBUG_INFO("Instruction: batched matrix term assembly for standard "
+                    "scalar fems");
+      size_type n1 = tA.sizes()[0], n2 = tB.sizes()[0], nk = tA.size() / n1;
+      GA_DEBUG_ASSERT(tB.size() == n2*nk, "Internal error");
+      if (ipt == 0) {
+        nbcol = 0;
+        A1.resize(n1*nk*nbpt); A2.resize(n2*nk*nbpt);
+      }
+      scalar_type e = coeff*alpha1*alpha2;
+      auto it1 = A1.begin() + n1*nbcol;
+      for (auto it = tA.cbegin(); it != tA.cend(); ++it, ++it1)
+        *it1 = (*it) * e;
+      std::copy(tB.cbegin(), tB.cend(), A2.begin() + n2*nbcol);
+      nbcol += nk;
+
+      if (ipt == nbpt-1) { // finalize
+        elem.resize(n1*n2);
+        bool done = batched_elem_product_unrolled(n1, n2, A1, A2, nbcol, elem);
+#if defined(GA_USES_BLAS)
+        if (!done && n1*n2*nbcol > GA_BATCHED_DGEMM_MIN_SIZE) {
+          BLAS_INT n1_ = BLAS_INT(n1), n2_ = BLAS_INT(n2);
+          BLAS_INT nbcol_ = BLAS_INT(nbcol);
+          char notrans = 'N', trans = 'T';
+          static const scalar_type one(1), zero(0);
+          gmm::dgemm_(&notrans, &trans, &n1_, &n2_, &nbcol_, &one,
+                      &(A1[0]), &n1_, &(A2[0]), &n2_, &zero, &(elem[0]), &n1_);
+          done = true;
+        }
+#endif
+        if (!done)
+          batched_elem_product_blocked(n1, n2, A1, A2, nbcol, elem);
+        assemble_element_matrix();
+      }
+      return 0;
+    }
+    ga_instruction_matrix_assembly_standard_scalar_batched
+    (const base_tensor &t_, const base_tensor &tA_, const base_tensor &tB_,
+     model_real_sparse_matrix &K_,
+     const fem_interpolation_context &ctx1_,
+     const fem_interpolation_context &ctx2_,
+     const gmm::sub_interval &I1_, const gmm::sub_interval &I2_,
+     const mesh_fem *mfn1_, const mesh_fem *mfn2_,
+     const scalar_type &a1, const scalar_type &a2, const scalar_type &coeff_,
+     const size_type &nbpt_, const size_type &ipt_)
+      : ga_instruction_matrix_assembly_standard_scalar
+        (t_, K_, ctx1_, ctx2_, I1_, I2_, mfn1_, mfn2_, a1, a2, coeff_,
+         nbpt_, ipt_), tA(tA_), tB(tB_), nbcol(0) {}
+  };
+
   struct ga_instruction_matrix_assembly_standard_vector
     : public ga_instruction_matrix_assembly_base
   {
@@ -5439,18 +5977,19 @@ namespace getfem {
         GA_DEBUG_ASSERT(I1.size() && I2.size(), "Internal error");
 
         scalar_type ninf = gmm::vect_norminf(elem);
-        if (ninf == scalar_type(0)) return 0;
+        if (ninf == scalar_type(0) && !use_slots()) return 0;
         size_type s1 = t.sizes()[0], s2 = t.sizes()[1], N = ctx1.N();
 
         size_type cv1 = ctx1.convex_num(), cv2 = ctx2.convex_num();
         if (cv1 == size_type(-1)) return 0;
+        begin_elem_slots();
         size_type qmult1 = pmf1->get_qdim();
         if (qmult1 > 1) qmult1 /= pmf1->fem_of_element(cv1)->target_dim();
         populate_dofs_vector(dofs1, s1, I1.first(), qmult1,         // --> dofs1
                              pmf1->ind_scalar_basic_dof_of_element(cv1));
 
         if (pmf2 == pmf1 && cv1 == cv2 && I1.first() == I2.first()) {
-          add_elem_matrix(K, dofs1, dofs1, dofs1_sort, elem, ninf*1E-14, N);
+          add_elem(K, dofs1, dofs1, ninf*1E-14, N);
         } else {
           if (pmf2 == pmf1 && cv1 == cv2) {
             populate_dofs_vector(dofs2, dofs1.size(), I2.first() - I1.first(),
@@ -5462,7 +6001,7 @@ namespace getfem {
             populate_dofs_vector(dofs2, s2, I2.first(), qmult2,      // --> dofs2
                                  pmf2->ind_scalar_basic_dof_of_element(cv2));
           }
-          add_elem_matrix(K, dofs1, dofs2, dofs1_sort, elem, ninf*1E-14, N);
+          add_elem(K, dofs1, dofs2, ninf*1E-14, N);
         }
       }
       return 0;
@@ -5513,11 +6052,12 @@ namespace getfem {
         GA_DEBUG_ASSERT(I1.size() && I2.size(), "Internal error");
 
         scalar_type ninf = gmm::vect_norminf(elem) * 1E-14;
-        if (ninf == scalar_type(0)) return 0;
+        if (ninf == scalar_type(0) && !use_slots()) return 0;
         size_type N = ctx1.N();
         size_type cv1 = ctx1.convex_num(), cv2 = ctx2.convex_num();
         size_type i1 = I1.first(), i2 = I2.first();
         if (cv1 == size_type(-1)) return 0;
+        begin_elem_slots();
         populate_dofs_vector(dofs1, ss1, i1,
                              pmf1->ind_scalar_basic_dof_of_element(cv1));
         bool same_dofs(pmf2 == pmf1 && cv1 == cv2 && i1 == i2);
@@ -5528,14 +6068,14 @@ namespace getfem {
                                pmf2->ind_scalar_basic_dof_of_element(cv2));
         }
         std::vector<size_type> &dofs2_ = same_dofs ? dofs1 : dofs2;
-        add_elem_matrix(K, dofs1, dofs2_, dofs1_sort, elem, ninf, N);
+        add_elem(K, dofs1, dofs2_, ninf, N);
         for (size_type i = 0; i < ss1; ++i) (dofs1[i])++;
         if (!same_dofs) for (size_type i = 0; i < ss2; ++i) (dofs2[i])++;
-        add_elem_matrix(K, dofs1, dofs2_, dofs1_sort, elem, ninf, N);
+        add_elem(K, dofs1, dofs2_, ninf, N);
         if (QQ >= 3) {
           for (size_type i = 0; i < ss1; ++i) (dofs1[i])++;
           if (!same_dofs) for (size_type i = 0; i < ss2; ++i) (dofs2[i])++;
-          add_elem_matrix(K, dofs1, dofs2_, dofs1_sort, elem, ninf, N);
+          add_elem(K, dofs1, dofs2_, ninf, N);
         }
       }
       return 0;
@@ -5559,19 +6099,367 @@ namespace getfem {
   };
 
 
+  // Matrix-free version of the order 2 terms: the element matrix is
+  // multiplied by the local components of X and added to Y (and its
+  // diagonal to D) instead of being assembled in a sparse matrix. The
+  // element matrix is computed from the complete base function tables,
+  // including on tensor product elements.
+  struct ga_instruction_matrix_free_mf_mf
+    : public ga_instruction_matrix_assembly_base
+  {
+    const base_vector *const &X;
+    base_vector *const &Y, *const &D;
+    const gmm::sub_interval &I1, &I2;
+    const mesh_fem *pmf1, *pmf2;
+    virtual int exec() {
+      GA_DEBUG_INFO("Instruction: matrix-free term for mf-mf");
+      if (!ctx1.is_convex_num_valid() || !ctx2.is_convex_num_valid())
+        return 0;
+      add_tensor_to_element_matrix(ipt == 0, coeff == scalar_type(0));
+      if (ipt == nbpt-1) { // finalize
+        size_type s1 = t.sizes()[0], s2 = t.sizes()[1];
+        size_type cv1 = ctx1.convex_num(), cv2 = ctx2.convex_num();
+        size_type qmult1 = pmf1->get_qdim();
+        if (qmult1 > 1) qmult1 /= pmf1->fem_of_element(cv1)->target_dim();
+        populate_dofs_vector(dofs1, s1, I1.first(), qmult1,
+                             pmf1->ind_scalar_basic_dof_of_element(cv1));
+        bool same_dofs = (pmf1 == pmf2 && cv1 == cv2
+                          && I1.first() == I2.first());
+        if (!same_dofs) {
+          size_type qmult2 = pmf2->get_qdim();
+          if (qmult2 > 1) qmult2 /= pmf2->fem_of_element(cv2)->target_dim();
+          populate_dofs_vector(dofs2, s2, I2.first(), qmult2,
+                               pmf2->ind_scalar_basic_dof_of_element(cv2));
+        }
+        const std::vector<size_type> &dofs2_ = same_dofs ? dofs1 : dofs2;
+
+        auto it = elem.cbegin();
+        for (size_type j = 0; j < s2; ++j, it += s1) {
+          scalar_type xj = (*X)[dofs2_[j]];
+          if (xj != scalar_type(0))
+            for (size_type i = 0; i < s1; ++i)
+              (*Y)[dofs1[i]] += it[i] * xj;
+        }
+        if (D) {
+          if (same_dofs)
+            for (size_type i = 0; i < s1; ++i)
+              (*D)[dofs1[i]] += elem[i*(s1+1)];
+          else
+            for (size_type j = 0; j < s2; ++j)
+              for (size_type i = 0; i < s1; ++i)
+                if (dofs1[i] == dofs2_[j])
+                  (*D)[dofs1[i]] += elem[i+j*s1];
+        }
+      }
+      return 0;
+    }
+    ga_instruction_matrix_free_mf_mf
+    (const base_tensor &t_, const base_vector *const &X_,
+     base_vector *const &Y_, base_vector *const &D_,
+     const fem_interpolation_context &ctx1_,
+     const fem_interpolation_context &ctx2_,
+     const gmm::sub_interval &I1_, const gmm::sub_interval &I2_,
+     const mesh_fem *mfn1_, const mesh_fem *mfn2_,
+     const scalar_type &a1, const scalar_type &a2, const scalar_type &coeff_,
+     const size_type &nbpt_, const size_type &ipt_)
+      : ga_instruction_matrix_assembly_base
+        (t_, ctx1_, ctx2_, a1, a2, coeff_, nbpt_, ipt_, false),
+        X(X_), Y(Y_), D(D_), I1(I1_), I2(I2_), pmf1(mfn1_), pmf2(mfn2_) {}
+  };
+
+  // Matrix-free version of a sum of terms c*Grad_u:Grad_Test_u and
+  // c*u.Test_u (see ga_sum_factorized_trial_terms), c being a scalar
+  // coefficient, for a variable on a uniform tensor product fem. Only the
+  // coefficients are evaluated at the integration points and the element
+  // matrix B^T D B is not computed: the values and reference gradients of the local components
+  // of X are computed at all the points by sum factorization, multiplied
+  // by D at each point, and integrated against the test functions by sum
+  // factorization at the last point. Falls back to the complete base
+  // function tables on faces, when the structure is not detected or when
+  // the diagonal is extracted.
+  struct ga_instruction_sum_factorized_matrix_free : public ga_instruction {
+    struct term {
+      const base_tensor *c;   // scalar coefficient, or null for 1
+      scalar_type sign;
+      bool grad;
+    };
+    std::vector<term> terms;
+    const base_vector *const &X;
+    base_vector *const &Y, *const &D;
+    fem_interpolation_context &ctx;
+    const gmm::sub_interval &I;
+    const mesh_fem &mf;
+    const papprox_integration &pai;
+    const scalar_type &alpha, &coeff;
+    const size_type &nbpt, &ipt;
+    size_type qdim;
+    bool has_val, has_grad, factorized;
+    base_tensor Zv, Zg;
+    ga_instruction_val_base base_ins;
+    ga_instruction_grad_base grad_base_ins;
+    pfem pf_old;
+    papprox_integration pai_old;
+    pfem_sum_factorization psf;
+    base_vector xloc, elem, dloc, uv, ug, rv, rg, w1, w2;
+    base_small_vector G;
+
+    virtual int exec() {
+      GA_DEBUG_INFO("Instruction: sum factorized matrix-free term");
+      if (!ctx.is_convex_num_valid()) return 0;
+      size_type cv = ctx.convex_num();
+      const std::vector<size_type> &dofs
+        = mf.ind_scalar_basic_dof_of_element(cv);
+      size_type ndof = dofs.size();
+      if (ipt == 0) {
+        factorized = false;
+        if (!D && ctx.have_pgp() && pai &&
+            ctx.pgp()->get_ppoint_tab() == pai->pintegration_points()) {
+          pfem pf = mf.fem_of_element(cv);
+          if (pf != pf_old || pai != pai_old) {
+            psf = fem_sum_factorization(pf, pai->pintegration_points(),
+                                        pai->nb_points_on_convex());
+            pf_old = pf; pai_old = pai;
+          }
+          factorized = psf && nbpt == psf->nb_points() && ctx.ii() == 0;
+        }
+        xloc.resize(qdim * ndof);
+        auto itx = xloc.begin();
+        for (const auto &dof : dofs)
+          for (size_type q = 0; q < qdim; ++q)
+            *itx++ = (*X)[I.first() + dof + q];
+        elem.assign(qdim * ndof, scalar_type(0));
+        if (D) dloc.assign(qdim * ndof, scalar_type(0));
+        if (factorized) {
+          size_type P = ctx.B().ncols();
+          if (has_val) {
+            psf->values(xloc, qdim, uv, w1, w2);
+            rv.assign(qdim*nbpt, scalar_type(0));
+          }
+          if (has_grad) {
+            psf->ref_gradients(xloc, qdim, ug, w1, w2);
+            rg.assign(qdim*nbpt*P, scalar_type(0));
+          }
+        }
+      }
+
+      if (coeff != scalar_type(0)) {
+        const base_matrix &B = ctx.B();
+        size_type N = B.nrows(), P = B.ncols();
+        if (factorized) {
+          size_type ii = ctx.ii();
+          for (const term &tm : terms) {
+            scalar_type s = coeff * alpha * alpha * tm.sign;
+            if (tm.c) s *= (*(tm.c))[0];
+            if (tm.grad) { // rg(qdim,P) += s (B^T B) gref(qdim,P)
+              G.resize(N);
+              for (size_type q = 0; q < qdim; ++q) {
+                for (size_type k = 0; k < N; ++k) {
+                  scalar_type a(0);
+                  for (size_type p = 0; p < P; ++p)
+                    a += ug[q + qdim*(ii + nbpt*p)] * B(k, p);
+                  G[k] = s * a;
+                }
+                for (size_type p = 0; p < P; ++p) {
+                  scalar_type a(0);
+                  for (size_type k = 0; k < N; ++k) a += G[k] * B(k, p);
+                  rg[q + qdim*(ii + nbpt*p)] += a;
+                }
+              }
+            } else
+              for (size_type q = 0; q < qdim; ++q)
+                rv[q + qdim*ii] += s * uv[q + qdim*ii];
+          }
+        } else {
+          if (has_val) base_ins.exec();
+          if (has_grad) grad_base_ins.exec();
+          for (const term &tm : terms) {
+            scalar_type s = coeff * alpha * alpha * tm.sign;
+            if (tm.c) s *= (*(tm.c))[0];
+            if (tm.grad) { // Zg(ndof,1,N)
+              G.resize(qdim*N);
+              for (size_type k = 0; k < N; ++k)
+                for (size_type q = 0; q < qdim; ++q) {
+                  scalar_type a(0);
+                  for (size_type j = 0; j < ndof; ++j)
+                    a += Zg[j + ndof*k] * xloc[q + qdim*j];
+                  G[q + qdim*k] = s * a;
+                }
+              for (size_type k = 0; k < N; ++k)
+                for (size_type j = 0; j < ndof; ++j) {
+                  scalar_type z = Zg[j + ndof*k];
+                  for (size_type q = 0; q < qdim; ++q)
+                    elem[q + qdim*j] += z * G[q + qdim*k];
+                  if (D)
+                    for (size_type q = 0; q < qdim; ++q)
+                      dloc[q + qdim*j] += s * z * z;
+                }
+            } else {
+              G.resize(qdim);
+              for (size_type q = 0; q < qdim; ++q) {
+                scalar_type a(0);
+                for (size_type j = 0; j < ndof; ++j)
+                  a += Zv[j] * xloc[q + qdim*j];
+                G[q] = s * a;
+              }
+              for (size_type j = 0; j < ndof; ++j) {
+                scalar_type z = Zv[j];
+                for (size_type q = 0; q < qdim; ++q)
+                  elem[q + qdim*j] += z * G[q];
+                if (D)
+                  for (size_type q = 0; q < qdim; ++q)
+                    dloc[q + qdim*j] += s * z * z;
+              }
+            }
+          }
+        }
+      }
+
+      if (ipt == nbpt-1) { // finalize
+        if (factorized) {
+          if (has_val) psf->add_transposed_values(rv, qdim, elem, w1, w2);
+          if (has_grad)
+            psf->add_transposed_ref_gradients(rg, qdim, elem, w1, w2);
+        }
+        auto itr = elem.cbegin();
+        for (const auto &dof : dofs)
+          for (size_type q = 0; q < qdim; ++q)
+            (*Y)[I.first() + dof + q] += *itr++;
+        if (D) {
+          itr = dloc.cbegin();
+          for (const auto &dof : dofs)
+            for (size_type q = 0; q < qdim; ++q)
+              (*D)[I.first() + dof + q] += *itr++;
+        }
+      }
+      return 0;
+    }
+
+    ga_instruction_sum_factorized_matrix_free
+    (const std::vector<term> &terms_, const base_vector *const &X_,
+     base_vector *const &Y_, base_vector *const &D_,
+     fem_interpolation_context &ctx_, const gmm::sub_interval &I_,
+     const mesh_fem &mf_, pfem_precomp &pfp, const papprox_integration &pai_,
+     const scalar_type &alpha_, const scalar_type &coeff_,
+     const size_type &nbpt_, const size_type &ipt_)
+      : terms(terms_), X(X_), Y(Y_), D(D_), ctx(ctx_), I(I_), mf(mf_),
+        pai(pai_), alpha(alpha_), coeff(coeff_), nbpt(nbpt_), ipt(ipt_),
+        qdim(mf_.get_qdim()), has_val(false), has_grad(false),
+        factorized(false),
+        base_ins(Zv, ctx_, mf_, pfp), grad_base_ins(Zg, ctx_, mf_, pfp) {
+      for (const term &tm : terms)
+        { if (tm.grad) has_grad = true; else has_val = true; }
+    }
+  };
+
+
+  // Solves K X = B in place for the local matrix K of size n of a cluster
+  // of condensed variables (K is overwritten by its LU factors) and nrhs
+  // right hand sides. SIZE is either size_type or an integral_constant for
+  // the most common small sizes, in which case the loops are unrolled.
+  template<typename SIZE> inline
+  size_type condensation_lu_solve__(scalar_type *K, SIZE n_, scalar_type *B,
+                                    size_type nrhs) {
+    const size_type n = n_;
+    for (size_type j = 0; j < n; ++j) {
+      size_type jp = j;
+      scalar_type m = gmm::abs(K[j+n*j]);
+      for (size_type i = j+1; i < n; ++i)
+        if (gmm::abs(K[i+n*j]) > m) { m = gmm::abs(K[i+n*j]); jp = i; }
+      if (m == scalar_type(0)) return j+1;
+      if (jp != j) {
+        for (size_type k = 0; k < n; ++k) std::swap(K[j+n*k], K[jp+n*k]);
+        for (size_type r = 0; r < nrhs; ++r) std::swap(B[j+n*r], B[jp+n*r]);
+      }
+      scalar_type piv = scalar_type(1) / K[j+n*j];
+      for (size_type i = j+1; i < n; ++i) K[i+n*j] *= piv;
+      for (size_type k = j+1; k < n; ++k) {
+        scalar_type a = K[j+n*k];
+        if (a != scalar_type(0))
+          for (size_type i = j+1; i < n; ++i) K[i+n*k] -= K[i+n*j] * a;
+      }
+    }
+    for (size_type r = 0; r < nrhs; ++r) {
+      scalar_type *x = B + n*r;
+      for (size_type j = 0; j < n; ++j) {
+        scalar_type xj = x[j];
+        for (size_type i = j+1; i < n; ++i) x[i] -= K[i+n*j] * xj;
+      }
+      for (size_type j = n; j-- > 0; ) {
+        x[j] /= K[j+n*j];
+        scalar_type xj = x[j];
+        for (size_type i = 0; i < j; ++i) x[i] -= K[i+n*j] * xj;
+      }
+    }
+    return 0;
+  }
+
+  // Solvers of K X = B for base tensors, returning 0 or the index of a
+  // null pivot.
+  typedef size_type (*condensation_lu_solver)(base_tensor &K, base_tensor &B,
+                                              gmm::lapack_ipvt &ipvt);
+
+  template<size_type N>
+  size_type condensation_lu_solve_(base_tensor &K, base_tensor &B,
+                                   gmm::lapack_ipvt &) {
+    return condensation_lu_solve__
+      (&(K[0]), std::integral_constant<size_type, N>(), &(B[0]), B.size(1));
+  }
+
+  inline size_type condensation_lu_solve(base_tensor &K, base_tensor &B,
+                                         gmm::lapack_ipvt &ipvt) {
+    size_type n = K.size(0), nrhs = B.size(1);
+#if defined(GMM_USES_LAPACK)
+    if (n >= 48) {
+      BLAS_INT n_ = BLAS_INT(n), nrhs_ = BLAS_INT(nrhs), info(0);
+      char notrans = 'N';
+      ipvt.resize(n);
+      gmm::dgetrf_(&n_, &n_, &(K[0]), &n_, &(ipvt[0]), &info);
+      if (info) return size_type(gmm::abs(info));
+      if (nrhs)
+        gmm::dgetrs_(&notrans, &n_, &nrhs_, &(K[0]), &n_, &(ipvt[0]),
+                     &(B[0]), &n_, &info);
+      return 0;
+    }
+#else
+    GMM_NOPERATION(ipvt);
+#endif
+    return condensation_lu_solve__(&(K[0]), n, &(B[0]), nrhs);
+  }
+
+  // The solver for the local matrices of size n, unrolled for the most
+  // common small sizes.
+  inline condensation_lu_solver condensation_lu_solver_of_size(size_type n) {
+    switch (n) {
+    case 1: return condensation_lu_solve_<1>;
+    case 2: return condensation_lu_solve_<2>;
+    case 3: return condensation_lu_solve_<3>;
+    case 4: return condensation_lu_solve_<4>;
+    case 6: return condensation_lu_solve_<6>;
+    case 8: return condensation_lu_solve_<8>;
+    case 9: return condensation_lu_solve_<9>;
+    case 12: return condensation_lu_solve_<12>;
+    case 16: return condensation_lu_solve_<16>;
+    default: return condensation_lu_solve;
+    }
+  }
+
   struct ga_instruction_condensation_sub : public ga_instruction {
     // one such instruction is used for every cluster of intercoupled
     // condensed variables
     gmm::dense_matrix<base_tensor *> KQJprime;
     std::vector<base_tensor *> RQprime;
     gmm::dense_matrix<base_tensor const *> KQQloc, KQJloc;
-    base_tensor invKqqqq, Kqqjj;
-    base_vector Rqq;
+    base_tensor Kqqqq, Kqqjj;
+    gmm::lapack_ipvt ipvt;
+    // The size of Kqqqq is the same on all the elements: the solver is
+    // selected once for the cluster.
+    condensation_lu_solver lu_solve;
     std::vector<std::array<size_type,3>> partQ, partJ;
     const scalar_type &coeff; // &alpha1, &alpha2 ?
-    virtual int exec() { // implementation can be optimized
+    virtual int exec() {
       GA_DEBUG_INFO("Instruction: variable cluster subdiagonal condensation");
-      // copy from KQQ to invKqqqq
+      // copy from KQQ to Kqqqq
+      gmm::clear(Kqqqq.as_vector());
       for (const auto &qqq1 : partQ) {
         size_type q1 = qqq1[0], qq1start = qqq1[1], qq1end = qqq1[2];
         for (const auto &qqq2 : partQ) {
@@ -5583,12 +6471,10 @@ namespace getfem {
                         "Internal error");
             for (size_type qq2=qq2start; qq2 < qq2end; ++qq2)
               for (size_type qq1=qq1start; qq1 < qq1end; ++qq1)
-                invKqqqq(qq1,qq2) = *itr++;
+                Kqqqq(qq1,qq2) = *itr++;
           }
         }
       }
-      // calculate inverse matrix invKqqqq
-      bgeot::lu_inverse(&(invKqqqq[0]), invKqqqq.size(0));
 
       // Resize Kqqjj as primary variable sizes may change dynamically
       size_type prev_j(0);
@@ -5614,26 +6500,20 @@ namespace getfem {
         jjj[2] = prev_j;
       }
 
-      Kqqjj.adjust_sizes(partQ.back()[2], partJ.back()[2]);
+      // The right hand sides: all the submatrices in KQJloc and, in the
+      // last column, the subvectors in RQprime
+      size_type nq = partQ.back()[2], nj = partJ.back()[2];
+      Kqqjj.adjust_sizes(nq, nj+1);
       gmm::clear(Kqqjj.as_vector());
-      gmm::clear(Rqq);
-
-      // multiply invKqqqq with all submatrices in KQJloc and RQprime and store
-      // the results in Kqqjj and Rqq
       for (const auto &jjj : partJ) {
         size_type j = jjj[0], jjstart = jjj[1], jjend = jjj[2];
         for (const auto &qqq2 : partQ) {
           size_type q2 = qqq2[0], qq2start = qqq2[1], qq2end = qqq2[2];
           if (KQJloc(q2,j)) {
-            auto itr = KQJloc(q2,j)->begin(); // auto &mat = KQJloc(q2,j);
-            for (size_type jj=jjstart; jj < jjend; ++jj) {
-              for (size_type qq2=qq2start; qq2 < qq2end; ++qq2, ++itr) {
-                for (size_type qq1=0; qq1 < partQ.back()[2]; ++qq1) {
-                  Kqqjj(qq1,jj) += invKqqqq(qq1,qq2)*(*itr);
-                  // Kqqjj(qq1,jj) += invKqq(qq1,qq2)*mat(qq2-qqstart,jj-jjstart);
-                } // for qq1
-              } // for qq2
-            } // for jj
+            auto itr = KQJloc(q2,j)->cbegin();
+            for (size_type jj=jjstart; jj < jjend; ++jj)
+              for (size_type qq2=qq2start; qq2 < qq2end; ++qq2, ++itr)
+                Kqqjj(qq2,jj) = *itr;
             GMM_ASSERT1(itr == KQJloc(q2,j)->cend(), "Internal error");
           }
         } // in partQ
@@ -5642,22 +6522,24 @@ namespace getfem {
         size_type q2 = qqq2[0], qq2start = qqq2[1], qq2end = qqq2[2];
         if (RQprime[q2]) {
           auto itr = RQprime[q2]->cbegin();
-          for (size_type qq2=qq2start; qq2 < qq2end; ++qq2, ++itr) {
-            for (size_type qq1=0; qq1 < invKqqqq.size(0); ++qq1)
-              Rqq[qq1] += invKqqqq(qq1,qq2)*(*itr);
-          } // for qq2
+          for (size_type qq2=qq2start; qq2 < qq2end; ++qq2, ++itr)
+            Kqqjj(qq2,nj) = *itr;
           GMM_ASSERT1(itr == RQprime[q2]->cend(), "Internal error");
         }
       } // in partQ
 
-      // distribute the results from Kqqjj/Rqq to KQJprime/RQprime
+      // Factorization of Kqqqq and solve for all the right hand sides
+      size_type info = lu_solve(Kqqqq, Kqqjj, ipvt);
+      GMM_ASSERT1(!info, "Non invertible matrix, pivot = " << info);
+
+      // distribute the results from Kqqjj to KQJprime/RQprime
       // submatrices/subvectors
       for (const auto &qqq1 : partQ) {
         size_type q1 = qqq1[0], qq1start = qqq1[1], qq1end = qqq1[2];
         { // writing into RQprime
           auto itw = RQprime[q1]->begin();
           for (size_type qq1=qq1start; qq1 < qq1end; ++qq1)
-            *itw++ = Rqq[qq1]/coeff;
+            *itw++ = Kqqjj(qq1,nj)/coeff;
         }
         for (const auto &jjj2 : partJ) {
           size_type j2 = jjj2[0], jj2start = jjj2[1], jj2end = jjj2[2];
@@ -5708,8 +6590,8 @@ namespace getfem {
         prev_q += new_q;
         qqq1[2] = prev_q;
       }
-      invKqqqq.adjust_sizes(partQ.back()[2], partQ.back()[2]);
-      Rqq.resize(partQ.back()[2]);
+      Kqqqq.adjust_sizes(partQ.back()[2], partQ.back()[2]);
+      lu_solve = condensation_lu_solver_of_size(partQ.back()[2]);
       // Kqqjj will be resized dynamically due to possible changes in j interval
     }
   };
@@ -5733,12 +6615,23 @@ namespace getfem {
         GMM_ASSERT1(K1.size(0) == m && K2.size(1) == n && K2.size(0) == qqsize,
                     "Internal error");
 
-        base_tensor::iterator it = Kij.begin();
+#if defined(GA_USES_BLAS)
+        if (m*n*qqsize > 27) {
+          BLAS_INT m_ = BLAS_INT(m), n_ = BLAS_INT(n), q_ = BLAS_INT(qqsize);
+          char notrans = 'N';
+          static const scalar_type one(1), mone(-1);
+          gmm::dgemm_(&notrans, &notrans, &m_, &n_, &q_, &mone, &(K1[0]),
+                      &m_, &(K2[0]), &q_, &one, &(Kij[0]), &m_);
+          continue;
+        }
+#endif
         for (size_type jj = 0; jj < n; ++jj)
-          for (size_type ii = 0; ii < m; ++ii, ++it)
-            for (size_type qq = 0; qq < qqsize; ++qq)
-              *it -= K1[ii+qq*m] * K2[qq+jj*qqsize];
-        GA_DEBUG_ASSERT(it == Kij.end(), "Wrong sizes");
+          for (size_type qq = 0; qq < qqsize; ++qq) {
+            scalar_type a = K2[qq+jj*qqsize];
+            auto it = Kij.begin() + jj*m;
+            auto it1 = K1.begin() + qq*m;
+            for (size_type ii = 0; ii < m; ++ii) it[ii] -= it1[ii] * a;
+          }
       }
       return 0;
     }
@@ -5767,11 +6660,12 @@ namespace getfem {
         const base_tensor &K1 = *KiQ[k], &R2 = *RQpr[k];
         size_type qqsize = K1.size(1);
         GMM_ASSERT1(K1.size(0) == m && R2.size(0) == qqsize, "Internal error");
-        base_tensor::iterator it = Ri.begin();
-        for (size_type ii = 0; ii < m; ++ii, ++it)
-          for (size_type qq = 0; qq < qqsize; ++qq)
-            *it -= K1[ii+qq*m] * R2[qq];
-        GA_DEBUG_ASSERT(it == Ri.end(), "Wrong sizes");
+        for (size_type qq = 0; qq < qqsize; ++qq) {
+          scalar_type a = R2[qq];
+          auto it = Ri.begin();
+          auto it1 = K1.begin() + qq*m;
+          for (size_type ii = 0; ii < m; ++ii) it[ii] -= it1[ii] * a;
+        }
       }
       return 0;
     }
@@ -6247,6 +7141,20 @@ namespace getfem {
               rmi.instructions.push_back(std::move(pgai));
             }
 
+            // Sum factorized evaluation for tensor product elements
+            if ((pnode->node_type == GA_NODE_VAL ||
+                 pnode->node_type == GA_NODE_GRAD) && mf->is_uniform() &&
+                mf->convex_index().card() &&
+                is_tensor_product_fem
+                (mf->fem_of_element(mf->convex_index().first_true()))) {
+              pgai = std::make_shared<ga_instruction_sum_factorized_val>
+                (pnode->tensor(), rmi.local_dofs[pnode->name], gis.ctx, *mf,
+                 rmi.pfps[mf], gis.pai, gis.ipt, workspace.qdim(pnode->name),
+                 pnode->node_type == GA_NODE_GRAD);
+              rmi.instructions.push_back(std::move(pgai));
+              break;
+            }
+
             // An instruction for the base value
             pgai = pga_instruction();
             switch (pnode->node_type) {
@@ -7276,6 +8184,8 @@ namespace getfem {
                }
              }
            }
+           rmi.last_product_node = pnode;
+           rmi.last_product_instruction = pgai.get();
            rmi.instructions.push_back(std::move(pgai));
          }
          break;
@@ -7803,6 +8713,7 @@ namespace getfem {
         pga_instruction pgai;
         if (transname.compare("neighbor_element") == 0 ||
             transname.compare("neighbour_elt") == 0) {
+          m.connectivity(); // adjacent faces are queried on each element
           pgai = std::make_shared<ga_instruction_neighbor_transformation_call>
             (workspace, rmi.interpolate_infos[transname],
              workspace.interpolate_transformation(transname), gis.ctx,
@@ -7866,6 +8777,59 @@ namespace getfem {
   }
 
 
+  // Detects if the compiled root of an order two term is a full contraction
+  // A(i,k) B(j,k) of a tensor depending only on the first test function with
+  // a tensor depending only on the second one. In that case, the last
+  // instruction (the contraction itself) is removed, the root node is
+  // withdrawn from the list of reusable nodes and the two factors are
+  // returned so that the contraction can be performed in a batched way for
+  // all the Gauss points of an element.
+  static bool ga_extract_batched_factors
+  (const pga_tree_node root, ga_instruction_set::region_mim_instructions &rmi,
+   const base_tensor *&pA, const base_tensor *&pB) {
+    if (root->node_type != GA_NODE_OP || root->test_function_type != 3 ||
+        root->children.size() != 2 || root->t.sparsity() != 0 ||
+        rmi.instructions.empty())
+      return false;
+    pga_tree_node child0 = root->children[0], child1 = root->children[1];
+    if (child0->test_function_type == 2 && child1->test_function_type == 1)
+      std::swap(child0, child1);
+    if (child0->test_function_type != 1 || child1->test_function_type != 2 ||
+        child0->t.sparsity() != 0 || child1->t.sparsity() != 0 ||
+        child0->tensor_proper_size() != child1->tensor_proper_size())
+      return false;
+    size_type order = child0->tensor_order();
+    if (order != child1->tensor_order()) return false;
+    for (size_type i = 0; i < order; ++i)
+      if (child0->tensor_proper_size(i) != child1->tensor_proper_size(i))
+        return false;
+    bool full_contraction =
+      (root->op_type == GA_DOT && order == 1) ||
+      (root->op_type == GA_COLON && order == 2) ||
+      (root->op_type == GA_MULT && child0->tensor_proper_size() == 1);
+    if (!full_contraction) return false;
+
+    // The root has to be effectively compiled (not a copy of an equivalent
+    // node) for its children to be evaluated.
+    auto itl = rmi.node_list.find(root->hash_value);
+    if (itl == rmi.node_list.end()) return false;
+    auto itn = std::find(itl->second.begin(), itl->second.end(), root);
+    if (itn == itl->second.end()) return false;
+
+    // The instruction computing the product is not executed any more
+    if (rmi.last_product_node != root) return false;
+    const ga_instruction *pgai = rmi.last_product_instruction;
+    auto iti = std::find_if(rmi.instructions.rbegin(), rmi.instructions.rend(),
+                            [pgai](const pga_instruction &p)
+                            { return p.get() == pgai; });
+    if (iti == rmi.instructions.rend()) return false;
+
+    itl->second.erase(itn);
+    rmi.instructions.erase(std::next(iti).base());
+    pA = &(child0->tensor()); pB = &(child1->tensor());
+    return true;
+  }
+
   struct var_set : std::map<std::string,size_type> {
     // This class indexes variable names in the order of their addition
     size_type operator[](const std::string &name) {
@@ -7907,12 +8871,136 @@ namespace getfem {
                                RQpr; // partial solution for condensed variables (initially stores residuals)
   };
 
+  // Decomposes an order one tree into a sum of terms c*Test_u, c.Test_u,
+  // Test_u.c, G:Grad_Test_u, g.Grad_Test_u ... whose coefficients c or G
+  // do not depend on the test function, for the sum factorized vector
+  // assembly. Returns false if one of the terms has another form.
+  static bool ga_sum_factorized_test_terms
+  (const pga_tree_node pnode, scalar_type sign,
+   std::vector<ga_instruction_sum_factorized_vector_assembly::term> &terms,
+   std::vector<pga_tree_node> &coeff_nodes) {
+    if (pnode->node_type != GA_NODE_OP) return false;
+    switch (pnode->op_type) {
+    case GA_PLUS:
+      return ga_sum_factorized_test_terms(pnode->children[0], sign, terms,
+                                          coeff_nodes)
+        && ga_sum_factorized_test_terms(pnode->children[1], sign, terms,
+                                        coeff_nodes);
+    case GA_MINUS:
+      return ga_sum_factorized_test_terms(pnode->children[0], sign, terms,
+                                          coeff_nodes)
+        && ga_sum_factorized_test_terms(pnode->children[1], -sign, terms,
+                                        coeff_nodes);
+    case GA_UNARY_MINUS:
+      return ga_sum_factorized_test_terms(pnode->children[0], -sign, terms,
+                                          coeff_nodes);
+    case GA_MULT: case GA_DOT: case GA_COLON: {
+      if (pnode->tensor_proper_size() != 1) return false;
+      pga_tree_node ptest = pnode->children[0], pc = pnode->children[1];
+      if (pc->node_type == GA_NODE_VAL_TEST ||
+          pc->node_type == GA_NODE_GRAD_TEST) std::swap(ptest, pc);
+      if ((ptest->node_type != GA_NODE_VAL_TEST &&
+           ptest->node_type != GA_NODE_GRAD_TEST) ||
+          pc->test_function_type != 0 ||
+          pc->tensor_proper_size() != ptest->tensor_proper_size())
+        return false;
+      size_type o = ptest->tensor_order();
+      if (pnode->op_type == GA_MULT ? ptest->tensor_proper_size() != 1
+          : (pc->tensor_order() != o || o > (pnode->op_type==GA_DOT ? 1 : 2)))
+        return false;
+      // The coefficient tensor is set once pc is compiled.
+      terms.push_back({nullptr, sign, ptest->node_type == GA_NODE_GRAD_TEST});
+      coeff_nodes.push_back(pc);
+      return true;
+    }
+    default: return false;
+    }
+  }
+
+  // A scalar coefficient c of a product c*(...) or c*Test_u, which does
+  // not depend on the test functions, or null.
+  static pga_tree_node ga_sum_factorized_scalar_coeff
+  (const pga_tree_node pnode, size_type tft) {
+    if (pnode->node_type != GA_NODE_OP || pnode->op_type != GA_MULT)
+      return nullptr;
+    pga_tree_node pc = pnode->children[0], pt = pnode->children[1];
+    if (pc->test_function_type != 0) std::swap(pc, pt);
+    if (pc->test_function_type != 0 || pc->tensor_proper_size() != 1 ||
+        pt->test_function_type != tft)
+      return nullptr;
+    return pc;
+  }
+
+  // Decomposes an order two tree into a sum of terms c*Grad_u:Grad_Test_u,
+  // c*Grad_u.Grad_Test_u, c*u.Test_u or c*u*Test_u, c being an optional
+  // scalar coefficient which may also multiply the trial or the test
+  // function, for the sum factorized matrix-free product. Returns false
+  // if one of the terms has another form.
+  static bool ga_sum_factorized_trial_terms
+  (const pga_tree_node pnode, scalar_type sign,
+   std::vector<ga_instruction_sum_factorized_matrix_free::term> &terms,
+   std::vector<pga_tree_node> &coeff_nodes, pga_tree_node pc = nullptr) {
+    if (pnode->node_type != GA_NODE_OP) return false;
+    switch (pnode->op_type) {
+    case GA_PLUS:
+      return ga_sum_factorized_trial_terms(pnode->children[0], sign, terms,
+                                           coeff_nodes, pc)
+        && ga_sum_factorized_trial_terms(pnode->children[1], sign, terms,
+                                         coeff_nodes, pc);
+    case GA_MINUS:
+      return ga_sum_factorized_trial_terms(pnode->children[0], sign, terms,
+                                           coeff_nodes, pc)
+        && ga_sum_factorized_trial_terms(pnode->children[1], -sign, terms,
+                                         coeff_nodes, pc);
+    case GA_UNARY_MINUS:
+      return ga_sum_factorized_trial_terms(pnode->children[0], -sign, terms,
+                                           coeff_nodes, pc);
+    case GA_MULT: case GA_DOT: case GA_COLON: {
+      if (pnode->tensor_proper_size() != 1) return false;
+      pga_tree_node pc1 = ga_sum_factorized_scalar_coeff(pnode, 3);
+      if (pc1) { // c*(...)
+        if (pc) return false;
+        pga_tree_node pt = pnode->children[0] == pc1 ? pnode->children[1]
+                                                     : pnode->children[0];
+        return ga_sum_factorized_trial_terms(pt, sign, terms, coeff_nodes,
+                                             pc1);
+      }
+      pga_tree_node ptest = pnode->children[0], ptrial = pnode->children[1];
+      if (ptest->test_function_type == 2) std::swap(ptest, ptrial);
+      for (pga_tree_node *pt : {&ptest, &ptrial}) { // (c*Test_u).Test2_u
+        pc1 = ga_sum_factorized_scalar_coeff(*pt, (*pt)->test_function_type);
+        if (pc1) {
+          if (pc) return false;
+          pc = pc1;
+          *pt = (*pt)->children[0] == pc1 ? (*pt)->children[1]
+                                          : (*pt)->children[0];
+        }
+      }
+      if ((ptest->node_type != GA_NODE_VAL_TEST &&
+           ptest->node_type != GA_NODE_GRAD_TEST) ||
+          ptrial->node_type != ptest->node_type ||
+          ptest->test_function_type != 1 || ptrial->test_function_type != 2 ||
+          ptest->name != ptrial->name ||
+          ptest->tensor_proper_size() != ptrial->tensor_proper_size())
+        return false;
+      size_type o = ptest->tensor_order();
+      if (pnode->op_type == GA_MULT ? ptest->tensor_proper_size() != 1
+          : o > (pnode->op_type == GA_DOT ? 1 : 2))
+        return false;
+      // The coefficient tensor is set once pc is compiled.
+      terms.push_back({nullptr, sign, ptest->node_type == GA_NODE_GRAD_TEST});
+      coeff_nodes.push_back(pc);
+      return true;
+    }
+    default: return false;
+    }
+  }
+
   void ga_compile(ga_workspace &workspace,
                   ga_instruction_set &gis, size_type order, bool condensation) {
     gis.transformations.clear();
     gis.all_instructions.clear();
     gis.unreduced_terms.clear();
-    workspace.clear_temporary_variable_intervals();
 
     std::map<const ga_instruction_set::region_mim, condensation_description>
       condensations;
@@ -8043,9 +9131,72 @@ namespace getfem {
             rmi.m = td.m;
             rmi.im = td.mim;
             // rmi.interpolate_infos.clear();
+            // Order one terms on a uniform tensor product fem: only the
+            // coefficients of the test functions are compiled, the
+            // integration against them is sum factorized.
+            std::vector<ga_instruction_sum_factorized_vector_assembly::term>
+              sf_terms;
+            std::vector<pga_tree_node> sf_nodes;
+            const mesh_fem *sf_mf = 0;
+            if (phase == ga_workspace::ASSEMBLY && order == 1 &&
+                root->interpolate_name_test1.empty())
+              sf_mf = workspace.associated_mf(root->name_test1);
+            bool sum_factorized = sf_mf && sf_mf->is_uniform() &&
+              sf_mf->convex_index().card() &&
+              is_tensor_product_fem
+              (sf_mf->fem_of_element(sf_mf->convex_index().first_true())) &&
+              ga_sum_factorized_test_terms(root, scalar_type(1), sf_terms,
+                                           sf_nodes);
+            // Same for the order two terms in matrix-free mode, where the
+            // trial functions are also sum factorized.
+            std::vector<ga_instruction_sum_factorized_matrix_free::term>
+              sf2_terms;
+            std::vector<pga_tree_node> sf2_nodes;
+            if (phase == ga_workspace::ASSEMBLY && order == 2 &&
+                workspace.is_matrix_free() && !psd &&
+                root->interpolate_name_test1.empty() &&
+                root->interpolate_name_test2.empty() &&
+                root->name_test1 == root->name_test2)
+              sf_mf = workspace.associated_mf(root->name_test1);
+            bool sum_factorized2 = order == 2 && sf_mf &&
+              !(sf_mf->is_reduced()) && sf_mf->is_uniform() &&
+              sf_mf->convex_index().card() &&
+              is_tensor_product_fem
+              (sf_mf->fem_of_element(sf_mf->convex_index().first_true())) &&
+              ga_sum_factorized_trial_terms(root, scalar_type(1), sf2_terms,
+                                            sf2_nodes);
+
             ga_compile_interpolate_trans(root, workspace, gis, rmi, *(td.m));
-            ga_compile_node(root, workspace, gis, rmi, *(td.m), false,
-                            rmi.current_hierarchy);
+            if (sum_factorized2) {
+              for (size_type j = 0; j < sf2_nodes.size(); ++j)
+                if (sf2_nodes[j]) { // a coefficient may be shared by terms
+                  if (std::find(sf2_nodes.begin(), sf2_nodes.begin()+j,
+                                sf2_nodes[j]) == sf2_nodes.begin()+j)
+                    ga_compile_node(sf2_nodes[j], workspace, gis, rmi,
+                                    *(td.m), false, rmi.current_hierarchy);
+                  sf2_terms[j].c = &(sf2_nodes[j]->tensor());
+                }
+              if (rmi.pfps.count(sf_mf) == 0) {
+                rmi.pfps[sf_mf] = 0;
+                rmi.begin_instructions.push_back
+                  (std::make_shared<ga_instruction_update_pfp>
+                   (*sf_mf, rmi.pfps[sf_mf], gis.ctx, gis.fp_pool));
+              }
+            } else if (sum_factorized) {
+              for (size_type j = 0; j < sf_nodes.size(); ++j) {
+                ga_compile_node(sf_nodes[j], workspace, gis, rmi, *(td.m),
+                                false, rmi.current_hierarchy);
+                sf_terms[j].c = &(sf_nodes[j]->tensor());
+              }
+              if (rmi.pfps.count(sf_mf) == 0) {
+                rmi.pfps[sf_mf] = 0;
+                rmi.begin_instructions.push_back
+                  (std::make_shared<ga_instruction_update_pfp>
+                   (*sf_mf, rmi.pfps[sf_mf], gis.ctx, gis.fp_pool));
+              }
+            } else
+              ga_compile_node(root, workspace, gis, rmi, *(td.m), false,
+                              rmi.current_hierarchy);
             // cout << "compilation finished "; ga_print_node(root, cout);
             // cout << endl;
 
@@ -8113,9 +9264,16 @@ namespace getfem {
                          ? workspace.temporary_interval_of_variable
                                      (root->name_test1)
                          : workspace.interval_of_variable(root->name_test1);
-                    pgai = std::make_shared<ga_instruction_vector_assembly_mf>
-                           (root->tensor(), V, ctx, I, *mf,
-                            gis.coeff, gis.nbpt, gis.ipt, interpolate);
+                    if (sum_factorized)
+                      pgai = std::make_shared
+                        <ga_instruction_sum_factorized_vector_assembly>
+                        (sf_terms, V, ctx, I, *mf, rmi.pfps[mf], gis.pai,
+                         gis.coeff, gis.nbpt, gis.ipt);
+                    else
+                      pgai = std::make_shared
+                        <ga_instruction_vector_assembly_mf>
+                        (root->tensor(), V, ctx, I, *mf,
+                         gis.coeff, gis.nbpt, gis.ipt, interpolate);
                     if (mf->is_reduced())
                       gis.unreduced_terms.emplace(root->name_test1, "");
                   }
@@ -8189,33 +9347,70 @@ namespace getfem {
                 auto &Kur = workspace.row_unreduced_matrix();
                 auto &Kuu = workspace.row_col_unreduced_matrix();
 
-                if (simple) { // --> Krr
+                if (workspace.is_matrix_free()) { // --> Y += K X
+                  GMM_ASSERT1(simple && !condensation, "Only the terms "
+                              "between non reduced fem variables without "
+                              "interpolate transformation are supported in "
+                              "matrix-free mode");
+                  if (sum_factorized2)
+                    pgai = std::make_shared
+                      <ga_instruction_sum_factorized_matrix_free>
+                      (sf2_terms, workspace.matrix_free_input(),
+                       workspace.matrix_free_output(),
+                       workspace.matrix_free_diagonal(), gis.ctx,
+                       workspace.interval_of_variable(root->name_test1),
+                       *mf1, rmi.pfps[mf1], gis.pai,
+                       workspace.factor_of_variable(root->name_test1),
+                       gis.coeff, gis.nbpt, gis.ipt);
+                  else
+                    pgai = std::make_shared<ga_instruction_matrix_free_mf_mf>
+                      (root->tensor(), workspace.matrix_free_input(),
+                       workspace.matrix_free_output(),
+                       workspace.matrix_free_diagonal(), ctx1, ctx2,
+                       workspace.interval_of_variable(root->name_test1),
+                       workspace.interval_of_variable(root->name_test2),
+                       mf1, mf2,
+                       workspace.factor_of_variable(root->name_test1),
+                       workspace.factor_of_variable(root->name_test2),
+                       gis.coeff, gis.nbpt, gis.ipt);
+                } else if (simple) { // --> Krr
                   const gmm::sub_interval
                     &I1 = workspace.interval_of_variable(root->name_test1),
                     &I2 = workspace.interval_of_variable(root->name_test2);
                   const scalar_type
                     &alpha1 = workspace.factor_of_variable(root->name_test1),
                     &alpha2 = workspace.factor_of_variable(root->name_test2);
-                  if (mf1->get_qdim() == 1 && mf2->get_qdim() == 1)
-                    pgai = std::make_shared
+                  const base_tensor *pA(0), *pB(0);
+                  std::shared_ptr<ga_instruction_matrix_assembly_base> pgaim;
+                  if (mf1->get_qdim() == 1 && mf2->get_qdim() == 1 &&
+                      ga_extract_batched_factors(root, rmi, pA, pB))
+                    pgaim = std::make_shared
+                      <ga_instruction_matrix_assembly_standard_scalar_batched>
+                      (root->tensor(), *pA, *pB, Krr, ctx1, ctx2, I1, I2,
+                       mf1, mf2, alpha1, alpha2, gis.coeff, gis.nbpt, gis.ipt);
+                  else if (mf1->get_qdim() == 1 && mf2->get_qdim() == 1)
+                    pgaim = std::make_shared
                       <ga_instruction_matrix_assembly_standard_scalar>
                       (root->tensor(), Krr, ctx1, ctx2, I1, I2, mf1, mf2,
                        alpha1, alpha2, gis.coeff, gis.nbpt, gis.ipt);
                   else if (root->sparsity() == 10 && root->t.qdim() == 2)
-                    pgai = std::make_shared
+                    pgaim = std::make_shared
                       <ga_instruction_matrix_assembly_standard_vector_opt10<2>>
                       (root->tensor(), Krr, ctx1, ctx2, I1, I2, mf1, mf2,
                        alpha1, alpha2, gis.coeff, gis.nbpt, gis.ipt);
                   else if (root->sparsity() == 10 && root->t.qdim() == 3)
-                    pgai = std::make_shared
+                    pgaim = std::make_shared
                       <ga_instruction_matrix_assembly_standard_vector_opt10<3>>
                       (root->tensor(), Krr, ctx1, ctx2, I1, I2, mf1, mf2,
                        alpha1, alpha2, gis.coeff, gis.nbpt, gis.ipt);
                   else
-                    pgai = std::make_shared
+                    pgaim = std::make_shared
                       <ga_instruction_matrix_assembly_standard_vector>
                       (root->tensor(), Krr, ctx1, ctx2, I1, I2, mf1, mf2,
                        alpha1, alpha2, gis.coeff, gis.nbpt, gis.ipt);
+                  pgaim->slots = &(workspace.assembled_matrix_slots());
+                  pgaim->slot_term = gis.nb_slot_terms++;
+                  pgai = pgaim;
                 } else if (condensation &&
                            workspace.is_internal_variable(root->name_test1) &&
                            workspace.is_internal_variable(root->name_test2)) {
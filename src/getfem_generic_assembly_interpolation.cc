@@ -481,6 +481,38 @@ namespace getfem {
     }
   };
 
+  // Key of a set of integration points for the caches of the
+  // transformations: source mesh, source convex, face and (stored) points
+  // on the reference element.
+  typedef std::tuple<const mesh *, size_type, short_type,
+                     const bgeot::stored_point_tab *> ga_point_cache_key;
+
+  // Result of a transformation stored for an integration point, valid
+  // as long as the transformed point X is the same.
+  struct ga_point_cache_entry {
+    base_node X, P_ref;
+    size_type cv = size_type(-1);
+    short_type face_num = short_type(-1);
+    int ret_type = -1; // -1 : no stored result
+  };
+
+  typedef std::map<ga_point_cache_key, std::vector<ga_point_cache_entry>>
+    ga_point_cache;
+
+  // Entry of the cache for the current integration point of ctx, or nullptr
+  // if the context has no precomputation (no index of integration point).
+  static ga_point_cache_entry *
+  ga_point_cache_entry_of(ga_point_cache &cache, const mesh &m,
+                          const fem_interpolation_context &ctx) {
+    if (!ctx.have_pgp()) return nullptr;
+    const bgeot::stored_point_tab *pspt = ctx.pgp()->get_ppoint_tab().get();
+    auto &entries = cache[ga_point_cache_key(&m, ctx.convex_num(),
+                                             ctx.face_num(), pspt)];
+    if (entries.size() <= ctx.ii())
+      entries.resize(std::max(ctx.ii() + 1, pspt->size()));
+    return &(entries[ctx.ii()]);
+  }
+
   class interpolate_transformation_expression
     : public virtual_interpolate_transformation, public context_dependencies {
 
@@ -505,13 +537,91 @@ namespace getfem {
                      workspace_gis_pair> compiled_derivatives;
     mutable bool extract_variable_done;
     mutable bool extract_data_done;
+    bool cache_points;
+    mutable omp_distribute<ga_point_cache> point_cache;
 
   private:
     mutable std::map<size_type, std::vector<size_type>> box_to_convexes;
 
+    // Search of the element of the target mesh containing P.
+    int find_target_element(const base_node &P, size_type &cv,
+                            short_type &face_num, base_node &P_ref) const {
+      int ret_type = 0;
+      bgeot::rtree::pbox_cont boxes;
+      {
+        bgeot::rtree::pbox_set bset;
+        element_boxes.find_boxes_at_point(P, bset);
+
+        // using a std::set as a sorter
+        std::set<std::pair<scalar_type, const bgeot::box_index*>,
+                 rated_box_index_compare> rated_boxes;
+        for (const auto &box : bset) {
+          scalar_type rating = scalar_type(1);
+          for (size_type i = 0; i < target_mesh.dim(); ++i) {
+            scalar_type h = box->max->at(i) - box->min->at(i);
+            if (h > scalar_type(0)) {
+              scalar_type r = std::min(box->max->at(i) - P[i],
+                                       P[i] - box->min->at(i)) / h;
+              rating = std::min(r, rating);
+            }
+          }
+          rated_boxes.insert(std::make_pair(rating, box));
+        }
+
+        // boxes should now be ordered in increasing rating order
+        for (const auto &p : rated_boxes)
+          boxes.push_back(p.second);
+      }
+
+      scalar_type best_dist(1e10);
+      size_type best_cv(-1);
+      base_node best_P_ref;
+      for (size_type i = boxes.size(); i > 0 && !ret_type; --i) {
+        for (auto convex : box_to_convexes.at(boxes[i-1]->id)) {
+          gic.init(target_mesh.points_of_convex(convex),
+                   target_mesh.trans_of_convex(convex));
+
+          bool converged;
+          bool is_in = gic.invert(P, P_ref, converged, 1E-4);
+          // cout << "cv = " << convex << " P = " << P << " P_ref = " << P_ref;
+          // cout << " is_in = " << int(is_in) << endl;
+          // for (size_type iii = 0;
+          //     iii < target_mesh.points_of_convex(cv).size(); ++iii)
+          //  cout << target_mesh.points_of_convex(cv)[iii] << endl;
+
+          if (converged) {
+            cv = convex;
+            if (is_in) {
+              face_num = short_type(-1); // Should detect potential faces ?
+              ret_type = 1;
+              break;
+            } else {
+              scalar_type dist
+                = target_mesh.trans_of_convex(cv)->convex_ref()->is_in(P_ref);
+              if (dist < best_dist) {
+                best_dist = dist;
+                best_cv = cv;
+                best_P_ref = P_ref;
+              }
+            }
+          }
+        }
+      }
+
+      if (ret_type == 0 && best_dist < 5e-3) {
+        cv = best_cv;
+        P_ref = best_P_ref;
+        face_num = short_type(-1); // Should detect potential faces ?
+        ret_type = 1;
+      }
+      return ret_type;
+    }
+
   public:
     void update_from_context() const {
       recompute_elt_boxes = true;
+      for (size_type t = 0; t < point_cache.num_threads(); ++t)
+        point_cache(t).clear();
     }
 
     void extract_variables(const ga_workspace &workspace,
@@ -545,6 +655,7 @@ namespace getfem {
 
     void init(const ga_workspace &workspace) const {
       size_type N = target_mesh.dim();
+      this->context_check(); // mesh modifications
 
       // Expression compilation
       local_workspace = ga_workspace(workspace, ga_workspace::inherit::ALL);
@@ -668,72 +779,37 @@ namespace getfem {
 
       *m_t = &target_mesh;
 
-      bgeot::rtree::pbox_cont boxes;
-      {
-        bgeot::rtree::pbox_set bset;
-        element_boxes.find_boxes_at_point(P, bset);
-
-        // using a std::set as a sorter
-        std::set<std::pair<scalar_type, const bgeot::box_index*>,
-                 rated_box_index_compare> rated_boxes;
-        for (const auto &box : bset) {
-          scalar_type rating = scalar_type(1);
-          for (size_type i = 0; i < target_mesh.dim(); ++i) {
-            scalar_type h = box->max->at(i) - box->min->at(i);
-            if (h > scalar_type(0)) {
-              scalar_type r = std::min(box->max->at(i) - P[i],
-                                       P[i] - box->min->at(i)) / h;
-              rating = std::min(r, rating);
-            }
-          }
-          rated_boxes.insert(std::make_pair(rating, box));
+      // The cached result is reused if the transformed point is unchanged.
+      // Otherwise, the previous element is tried first, with the previous
+      // reference point as initial guess of the inversion.
+      ga_point_cache_entry *pe = cache_points
+        ? ga_point_cache_entry_of(point_cache.thrd_cast(), m, ctx_x) : nullptr;
+      if (pe && pe->ret_type >= 0 && pe->X.size() == P.size()
+          && gmm::vect_dist2(pe->X, P) == scalar_type(0)) {
+        ret_type = pe->ret_type;
+        if (ret_type) {
+          cv = pe->cv; face_num = pe->face_num; P_ref = pe->P_ref;
         }
-
-        // boxes should now be ordered in increasing rating order
-        for (const auto &p : rated_boxes)
-          boxes.push_back(p.second);
-      }
-
-      scalar_type best_dist(1e10);
-      size_type best_cv(-1);
-      base_node best_P_ref;
-      for (size_type i = boxes.size(); i > 0 && !ret_type; --i) {
-        for (auto convex : box_to_convexes.at(boxes[i-1]->id)) {
-          gic.init(target_mesh.points_of_convex(convex),
-                   target_mesh.trans_of_convex(convex));
-
+      } else {
+        if (pe && pe->ret_type == 1
+            && target_mesh.convex_index().is_in(pe->cv)) {
+          gic.init(target_mesh.points_of_convex(pe->cv),
+                   target_mesh.trans_of_convex(pe->cv));
           bool converged;
-          bool is_in = gic.invert(P, P_ref, converged, 1E-4);
-          // cout << "cv = " << convex << " P = " << P << " P_ref = " << P_ref;
-          // cout << " is_in = " << int(is_in) << endl;
-          // for (size_type iii = 0;
-          //     iii < target_mesh.points_of_convex(cv).size(); ++iii)
-          //  cout << target_mesh.points_of_convex(cv)[iii] << endl;
-
-          if (converged) {
-            cv = convex;
-            if (is_in) {
-              face_num = short_type(-1); // Should detect potential faces ?
-              ret_type = 1;
-              break;
-            } else {
-              scalar_type dist
-                = target_mesh.trans_of_convex(cv)->convex_ref()->is_in(P_ref);
-              if (dist < best_dist) {
-                best_dist = dist;
-                best_cv = cv;
-                best_P_ref = P_ref;
-              }
-            }
+          P_ref = pe->P_ref;
+          if (gic.invert_from_guess(P, P_ref, converged, 1E-4) && converged) {
+            cv = pe->cv;
+            face_num = short_type(-1);
+            ret_type = 1;
           }
         }
-      }
-
-      if (ret_type == 0 && best_dist < 5e-3) {
-        cv = best_cv;
-        P_ref = best_P_ref;
-        face_num = short_type(-1); // Should detect potential faces ?
-        ret_type = 1;
+        if (!ret_type)
+          ret_type = find_target_element(P, cv, face_num, P_ref);
+        if (pe) {
+          pe->X = P; pe->ret_type = ret_type;
+          if (ret_type)
+            { pe->cv = cv; pe->face_num = face_num; pe->P_ref = P_ref; }
+        }
       }
 
       // Note on derivatives of the transformation : for efficiency and
@@ -759,11 +835,14 @@ namespace getfem {
     }
 
     interpolate_transformation_expression
-    (const mesh &sm, const mesh &tm, size_type trg, const std::string &expr_)
+    (const mesh &sm, const mesh &tm, size_type trg, const std::string &expr_,
+     bool cache = false)
       : source_mesh(sm), target_mesh(tm), target_region(trg), expr(expr_),
         recompute_elt_boxes(true), extract_variable_done(false),
-        extract_data_done(false)
-    { this->add_dependency(tm); }
+        extract_data_done(false), cache_points(cache) {
+      this->add_dependency(tm);
+      if (cache && &sm != &tm) this->add_dependency(sm);
+    }
 
   };
 
@@ -777,10 +856,11 @@ namespace getfem {
 
   void add_interpolate_transformation_from_expression
   (ga_workspace &workspace, const std::string &name, const mesh &sm,
-   const mesh &tm, size_type trg, const std::string &expr) {
+   const mesh &tm, size_type trg, const std::string &expr,
+   bool cache_points) {
     pinterpolate_transformation
       p = std::make_shared<interpolate_transformation_expression>
-          (sm, tm, trg, expr);
+          (sm, tm, trg, expr, cache_points);
     workspace.add_interpolate_transformation(name, p);
   }
 
@@ -793,10 +873,10 @@ namespace getfem {
 
   void add_interpolate_transformation_from_expression
   (model &md, const std::string &name, const mesh &sm, const mesh &tm,
-   size_type trg, const std::string &expr) {
+   size_type trg, const std::string &expr, bool cache_points) {
     pinterpolate_transformation
       p = std::make_shared<interpolate_transformation_expression>
-          (sm, tm, trg, expr);
+          (sm, tm, trg, expr, cache_points);
     md.add_interpolate_transformation(name, p);
   }
 
@@ -807,13 +887,20 @@ namespace getfem {
   class interpolate_transformation_neighbor
     : public virtual_interpolate_transformation, public context_dependencies {
 
+    const mesh *cached_mesh; // mesh on which the inversions are cached
+    mutable omp_distribute<ga_point_cache> point_cache;
+
   public:
-    void update_from_context() const {}
+    void update_from_context() const {
+      for (size_type t = 0; t < point_cache.num_threads(); ++t)
+        point_cache(t).clear();
+    }
     void extract_variables(const ga_workspace &/* workspace */,
                            std::set<var_trans_pair> &/* vars */,
                            bool /* ignore_data */, const mesh &/* m */,
                            const std::string &/* interpolate_name */) const {}
-    void init(const ga_workspace &/* workspace */) const {}
+    void init(const ga_workspace &/* workspace */) const
+    { if (cached_mesh) this->context_check(); }
     void finalize() const {}
     
     std::string expression() const { return "X"; }
@@ -837,14 +924,32 @@ namespace getfem {
       auto adj_face = m_x.adjacent_face(cv_x, face_x);
 
       if (adj_face.cv != size_type(-1)) {
-        bgeot::geotrans_inv_convex gic;
-        gic.init(m_x.points_of_convex(adj_face.cv),
-                 m_x.trans_of_convex(adj_face.cv));
-        bool converged = true;
-        gic.invert(ctx_x.xreal(), P_ref, converged);
-        bool is_in = (ctx_x.pgt()->convex_ref()->is_in(P_ref) < 1E-4);
-        GMM_ASSERT1(is_in && converged, "Geometric transformation inversion "
-                    "has failed in neighbor transformation");
+        const base_node &X = ctx_x.xreal();
+        ga_point_cache_entry *pe = (&m_x == cached_mesh)
+          ? ga_point_cache_entry_of(point_cache.thrd_cast(), m_x, ctx_x)
+          : nullptr;
+        if (pe && pe->ret_type == 1 && pe->cv == adj_face.cv
+            && pe->X.size() == X.size()
+            && gmm::vect_dist2(pe->X, X) == scalar_type(0))
+          P_ref = pe->P_ref;
+        else {
+          bgeot::geotrans_inv_convex gic;
+          gic.init(m_x.points_of_convex(adj_face.cv),
+                   m_x.trans_of_convex(adj_face.cv));
+          bool converged = true;
+          if (pe && pe->ret_type == 1 && pe->cv == adj_face.cv) {
+            P_ref = pe->P_ref;
+            gic.invert_from_guess(X, P_ref, converged);
+          } else
+            gic.invert(X, P_ref, converged);
+          bool is_in = (ctx_x.pgt()->convex_ref()->is_in(P_ref) < 1E-4);
+          GMM_ASSERT1(is_in && converged, "Geometric transformation "
+                      "inversion has failed in neighbor transformation");
+          if (pe) {
+            pe->X = X; pe->P_ref = P_ref;
+            pe->cv = adj_face.cv; pe->ret_type = 1;
+          }
+        }
         face_num = adj_face.f;
         cv = adj_face.cv;
         ret_type = 1;
@@ -854,7 +959,8 @@ namespace getfem {
       return ret_type;
     }
 
-    interpolate_transformation_neighbor() { }
+    interpolate_transformation_neighbor(const mesh *m = nullptr)
+      : cached_mesh(m) { if (m) this->add_dependency(*m); }
 
   };
 
@@ -863,6 +969,11 @@ namespace getfem {
     return (std::make_shared<interpolate_transformation_neighbor>());
   }
 
+  pinterpolate_transformation
+  interpolate_transformation_neighbor_instance(const mesh &m) {
+    return (std::make_shared<interpolate_transformation_neighbor>(&m));
+  }
+
   //=========================================================================
   // Interpolate transformation on neighbor element (for extrapolation)
   //=========================================================================
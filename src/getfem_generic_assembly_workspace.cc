@@ -76,6 +76,7 @@ namespace getfem {
                 "The provided interval overlaps with internal dofs");
     nb_prim_dof = std::max(nb_prim_dof, I.last());
     variables.emplace(name, var_description(true, &mf, 0, I, &VV, 1));
+    invalidate_compilation_cache();
   }
 
   void ga_workspace::add_im_variable
@@ -85,6 +86,7 @@ namespace getfem {
                 "The provided interval overlaps with internal dofs");
     nb_prim_dof = std::max(nb_prim_dof, I.last());
     variables.emplace(name, var_description(true, 0, &imd, I, &VV, 1));
+    invalidate_compilation_cache();
   }
 
   void ga_workspace::add_internal_im_variable
@@ -97,6 +99,7 @@ namespace getfem {
     nb_intern_dof += first_intern_dof + nb_intern_dof
                    - std::min(first_intern_dof + nb_intern_dof, I.last());
     variables.emplace(name, var_description(true, 0, &imd, I, &VV, 1, true));
+    invalidate_compilation_cache();
   }
 
   void ga_workspace::add_fixed_size_variable
@@ -107,6 +110,7 @@ namespace getfem {
     nb_prim_dof = std::max(nb_prim_dof, I.last());
     variables.emplace(name, var_description(true, 0, 0, I, &VV,
                                             dim_type(gmm::vect_size(VV))));
+    invalidate_compilation_cache();
   }
 
   void ga_workspace::add_fem_constant
@@ -118,6 +122,7 @@ namespace getfem {
     if (Q == 0) Q = size_type(1);
     variables.emplace(name, var_description(false, &mf, 0,
                                             gmm::sub_interval(), &VV, Q));
+    invalidate_compilation_cache();
   }
 
   void ga_workspace::add_fixed_size_constant
@@ -125,6 +130,7 @@ namespace getfem {
     variables.emplace(name, var_description(false, 0, 0,
                                             gmm::sub_interval(), &VV,
                                             gmm::vect_size(VV)));
+    invalidate_compilation_cache();
   }
 
   void ga_workspace::add_im_data(const std::string &name, const im_data &imd,
@@ -132,6 +138,7 @@ namespace getfem {
     variables.emplace(name, var_description
       (false, 0, &imd, gmm::sub_interval(), &VV,
        gmm::vect_size(VV)/(imd.nb_filtered_index() * imd.nb_tensor_elem())));
+    invalidate_compilation_cache();
   }
 
   bool ga_workspace::is_internal_variable(const std::string &name) const {
@@ -353,6 +360,7 @@ namespace getfem {
       GMM_ASSERT1(name != "neighbor_element", "neighbor_element is a "
                   "reserved interpolate transformation name");
     transformations[name] = ptrans;
+    invalidate_compilation_cache();
   }
 
   bool ga_workspace::interpolate_transformation_exists
@@ -401,6 +409,7 @@ namespace getfem {
       GMM_ASSERT1(false, "An interpolate transformation with the same "
                   "name already exists");
     secondary_domains[name] = psecdom;
+    invalidate_compilation_cache();
   }
 
   bool ga_workspace::secondary_domain_exists
@@ -441,6 +450,7 @@ namespace getfem {
                               size_type add_derivative_order,
                               bool function_expr, operation_type op_type,
                               const std::string varname_interpolation) {
+    invalidate_compilation_cache();
     if (tree.root) {
       // cout << "add tree with tests functions of " <<  tree.root->name_test1
       //     << " and " << tree.root->name_test2 << endl;
@@ -773,6 +783,7 @@ namespace getfem {
       ms.insert(&(mf->linked_mesh()));
     }
     variable_groups[group_name] = nl;
+    invalidate_compilation_cache();
   }
 
 
@@ -788,6 +799,111 @@ namespace getfem {
   }
 
 
+  std::shared_ptr<ga_instruction_set>
+  ga_workspace::compiled_instruction_set(size_type order, bool condensation) {
+    if (!use_compilation_cache) {
+      clear_temporary_variable_intervals();
+      auto pgis = std::make_shared<ga_instruction_set>();
+      ga_compile(*this, *pgis, order, condensation);
+      return pgis;
+    }
+
+    if (ccache && (!ccache->is_context_valid() || ccache->context_check()))
+      ccache.reset();
+    if (!ccache) {
+      // The temporary intervals are shared by all the cached sets and are
+      // only reset together with the cache.
+      ccache = std::make_shared<compilation_cache>();
+      clear_temporary_variable_intervals();
+    }
+    std::shared_ptr<ga_instruction_set>
+      &pgis = ccache->sets[std::make_tuple(order, condensation,
+                                           matrix_free ? mf_part+1 : 0)];
+    if (!pgis) {
+      // Compilation with the proxy targets
+      auto K_ = K, KQJpr_ = KQJpr;
+      auto V_ = V;
+      set_assembled_matrix(K_proxy);
+      set_internal_coupling_matrix(KQJpr_proxy);
+      set_assembled_vector(V_proxy);
+      pgis = std::make_shared<ga_instruction_set>();
+      ga_compile(*this, *pgis, order, condensation);
+      K = K_; KQJpr = KQJpr_; V = V_;
+
+      const ga_workspace *w = this;
+      while (w->parent_workspace) w = w->parent_workspace;
+      if (w->md) ccache->add_dependency(*(w->md));
+      for (const tree_description &td : trees) {
+        if (td.mim) ccache->add_dependency(*(td.mim));
+        if (td.m) ccache->add_dependency(*(td.m));
+      }
+      for (const auto &v : variables) {
+        if (v.second.mf) ccache->add_dependency(*(v.second.mf));
+        if (v.second.imd) ccache->add_dependency(*(v.second.imd));
+      }
+    }
+    return pgis;
+  }
+
+  void ga_workspace::matrix_free_product(const base_vector &X,
+                                         base_vector &Y, base_vector *D) {
+    const ga_workspace *w = this;
+    while (w->parent_workspace) w = w->parent_workspace;
+    if (w->md) w->md->nb_dof(); // To eventually call actualize_sizes()
+
+    GMM_ASSERT1(X.size() == nb_prim_dof && Y.size() == nb_prim_dof &&
+                (!D || D->size() == nb_prim_dof), "Wrong size of vectors "
+                "for the matrix-free product in workspace");
+    // As for the assembly, the elements of each partition of the regions
+    // are visited by a thread, with an instruction set of its own. The
+    // contributions are computed in local vectors of each partition which
+    // are summed over the partitions and the processes before being added
+    // to Y and D.
+    size_type nbp = global_thread_policy::num_threads();
+    while (mf_Y.size() < nbp)
+      { mf_Y.push_back(nullptr); mf_D.push_back(nullptr); }
+    mf_Yloc.resize(nbp);
+    if (D) mf_Dloc.resize(nbp);
+    std::vector<std::shared_ptr<ga_instruction_set> > psets(nbp);
+    auto reset = [this]() {
+      matrix_free = false; mf_part = 0; mf_X = nullptr;
+      std::fill(mf_Y.begin(), mf_Y.end(), nullptr);
+      std::fill(mf_D.begin(), mf_D.end(), nullptr);
+    };
+    matrix_free = true; mf_X = &X;
+    try {
+      for (size_type p = 0; p < nbp; ++p) {
+        gmm::clear(mf_Yloc[p]); gmm::resize(mf_Yloc[p], nb_prim_dof);
+        mf_Y[p] = &(mf_Yloc[p]);
+        if (D) {
+          gmm::clear(mf_Dloc[p]); gmm::resize(mf_Dloc[p], nb_prim_dof);
+          mf_D[p] = &(mf_Dloc[p]);
+        }
+        mf_part = p;
+        psets[p] = compiled_instruction_set(2, false);
+      }
+      // The interpolate transformations are shared by the instruction sets
+      if (psets[0]->transformations.empty()) {
+        GETFEM_OMP_PARALLEL(
+          ga_exec(*(psets[global_thread_policy::this_thread()]), *this);
+        )
+      } else
+        ga_exec(*(psets[0]), *this);
+    } catch (...) {
+      reset();
+      throw;
+    }
+    reset();
+
+    for (size_type p = 1; p < nbp; ++p) {
+      gmm::add(mf_Yloc[p], mf_Yloc[0]);
+      if (D) gmm::add(mf_Dloc[p], mf_Dloc[0]);
+    }
+    MPI_SUM_VECTOR(mf_Yloc[0]);
+    gmm::add(mf_Yloc[0], Y);
+    if (D) { MPI_SUM_VECTOR(mf_Dloc[0]); gmm::add(mf_Dloc[0], *D); }
+  }
+
   void ga_workspace::assembly(size_type order, bool condensation) {
 
     const ga_workspace *w = this;
@@ -795,8 +911,9 @@ namespace getfem {
     if (w->md) w->md->nb_dof(); // To eventually call actualize_sizes()
 
     GA_TIC;
-    ga_instruction_set gis;
-    ga_compile(*this, gis, order, condensation);
+    std::shared_ptr<ga_instruction_set>
+      pgis = compiled_instruction_set(order, condensation);
+    ga_instruction_set &gis = *pgis;
     GA_TOCTIC("Compile time");
 
     size_type nb_tot_dof = condensation ? nb_prim_dof + nb_intern_dof
@@ -848,7 +965,20 @@ namespace getfem {
     gmm::clear(assembled_tensor().as_vector());
 
     GA_TOCTIC("Init time");
-    ga_exec(gis, *this);     // --> unreduced_V, *V,
+    if (use_compilation_cache) { // The cached instructions target the proxies
+      auto swap_targets = [this]() {
+        K->swap(K_proxy); V->swap(V_proxy); KQJpr->swap(KQJpr_proxy);
+      };
+      swap_targets();
+      try {
+        ga_exec(gis, *this); // --> unreduced_V, *V, unreduced_K, *K
+      } catch (...) {
+        swap_targets();
+        throw;
+      }
+      swap_targets();
+    } else
+      ga_exec(gis, *this);     // --> unreduced_V, *V,
     GA_TOCTIC("Exec time");  //     unreduced_K, *K
 
     if (order == 0) {
@@ -959,7 +1089,8 @@ namespace getfem {
     }
   }
 
-  void ga_workspace::clear_expressions() { trees.clear(); }
+  void ga_workspace::clear_expressions()
+  { trees.clear(); invalidate_compilation_cache(); }
 
   void ga_workspace::print(std::ostream &str) {
     for (size_type i = 0; i < trees.size(); ++i)
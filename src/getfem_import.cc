@@ -21,8 +21,10 @@
 #include <iostream>
 #include <iomanip>
 #include <fstream>
+#include <unordered_map>
 
 #include "getfem/getfem_mesh.h"
+#include "getfem/getfem_omp.h"
 #include "getfem/getfem_import.h"
 #include "getfem/getfem_regular_meshes.h"
 
@@ -199,10 +201,9 @@ namespace getfem {
     }
   };
 
-  std::map<std::string, size_type> read_region_names_from_gmsh_mesh_file(std::istream& f)
-  {
+  static std::map<std::string, size_type>
+  read_gmsh_physical_names(std::istream& f) {
     std::map<std::string, size_type> region_map;
-    bgeot::read_until(f, "$PhysicalNames");
     size_type nb_regions;
     f >> nb_regions;
     size_type rt,ri;
@@ -223,6 +224,535 @@ namespace getfem {
     return region_map;
   }
 
+  std::map<std::string, size_type> read_region_names_from_gmsh_mesh_file(std::istream& f)
+  {
+    bgeot::read_until(f, "$PhysicalNames");
+    return read_gmsh_physical_names(f);
+  }
+
+  template <typename T> static T gmsh_read_binary(std::istream& f) {
+    T v; f.read(reinterpret_cast<char *>(&v), sizeof(T));
+    return v;
+  }
+
+  template <typename T>
+  static void gmsh_read_binary(std::istream& f, std::vector<T> &v,
+                               size_type n) {
+    v.resize(n);
+    f.read(reinterpret_cast<char *>(v.data()), std::streamsize(n*sizeof(T)));
+    GMM_ASSERT1(f, "Unexpected end of binary gmsh file");
+  }
+
+  /* MSH 4.1 format: first physical tag of each (dim, tag) entity, read from
+     the $Entities section. */
+  typedef std::map<std::pair<int, int>, int> gmsh_entity_physical_map;
+
+  template <typename T>
+  static T gmsh_read_value(std::istream& f, bool binary) {
+    if (binary) return gmsh_read_binary<T>(f);
+    T v; f >> v;
+    return v;
+  }
+
+  static void read_gmsh4_entities(std::istream& f, bool binary,
+                                  gmsh_entity_physical_map &entity_phys) {
+    typedef gmm::uint64_type u64;
+    size_type nb[4];
+    for (int d = 0; d < 4; ++d)
+      nb[d] = size_type(gmsh_read_value<u64>(f, binary));
+    for (int d = 0; d < 4; ++d)
+      for (size_type i = 0; i < nb[d]; ++i) {
+        int tag = gmsh_read_value<int>(f, binary);
+        for (int k = 0; k < ((d == 0) ? 3 : 6); ++k) /* bounding box */
+          gmsh_read_value<double>(f, binary);
+        size_type nbtags = size_type(gmsh_read_value<u64>(f, binary));
+        for (size_type k = 0; k < nbtags; ++k) {
+          int phys = gmsh_read_value<int>(f, binary);
+          if (k == 0) entity_phys[std::make_pair(d, tag)] = std::abs(phys);
+        }
+        if (d > 0) { /* bounding entities, ignored */
+          size_type nbb = size_type(gmsh_read_value<u64>(f, binary));
+          for (size_type k = 0; k < nbb; ++k)
+            gmsh_read_value<int>(f, binary);
+        }
+      }
+    GMM_ASSERT1(f, "Error while reading the entities of a gmsh file");
+  }
+
+  /* MSH 4.1 format: read the sections preceding $Nodes (physical names,
+     which are in ascii, and entities), the other ones are skipped. */
+  static void read_gmsh4_header_sections
+  (std::istream& f, bool binary, std::map<std::string, size_type> *region_map,
+   gmsh_entity_physical_map &entity_phys) {
+    std::string line;
+    while (std::getline(f, line)) {
+      while (line.size() && isspace(line.back())) line.pop_back();
+      if (line == "$Nodes") return;
+      else if (line == "$PhysicalNames") {
+        std::map<std::string, size_type> names = read_gmsh_physical_names(f);
+        if (region_map != NULL) *region_map = names;
+      } else if (line == "$Entities")
+        read_gmsh4_entities(f, binary, entity_phys);
+    }
+    GMM_ASSERT1(false, "No $Nodes section in gmsh file");
+  }
+
+  /* MSH 4 format: region of a block of elements, which is the first
+     physical tag of its entity (format 4.1) or the entity tag when the
+     entity has no physical tag. */
+  static unsigned gmsh4_block_region(int dimr, int entity,
+                                     const gmsh_entity_physical_map &phys,
+                                     dal::bit_vector &reg) {
+    auto it = phys.find(std::make_pair(dimr, entity));
+    unsigned region = unsigned(entity);
+    if (it != phys.end())
+      region = unsigned(it->second);
+    else if (reg.is_in(region)) {
+      GMM_WARNING2("Two regions share the same number, "
+                   "the region numbering is modified");
+      while (reg.is_in(region)) region += 5;
+    }
+    reg.add(region);
+    return region;
+  }
+
+  /* Node tag to mesh point correspondence. Node tags are usually dense,
+     a map is used otherwise. */
+  struct gmsh_node_numbering {
+    size_type min_tag;
+    std::vector<size_type> dense;
+    std::unordered_map<size_type, size_type> sparse;
+
+    void init(size_type min_t, size_type max_t, size_type nb_node) {
+      min_tag = min_t;
+      if (max_t >= min_t && max_t - min_t < 4 * nb_node + 1024)
+        dense.assign(max_t - min_t + 1, size_type(-1));
+    }
+    void set(size_type tag, size_type ip) {
+      if (dense.size()) {
+        GMM_ASSERT1(tag >= min_tag && tag - min_tag < dense.size(),
+                    "Node tag " << tag << " out of the declared range");
+        dense[tag - min_tag] = ip;
+      } else sparse[tag] = ip;
+    }
+    size_type operator()(size_type tag) const {
+      size_type ip = size_type(-1);
+      if (dense.size()) {
+        if (tag >= min_tag && tag - min_tag < dense.size())
+          ip = dense[tag - min_tag];
+      } else {
+        auto it = sparse.find(tag);
+        if (it != sparse.end()) ip = it->second;
+      }
+      return ip;
+    }
+  };
+
+  /* MSH 4.1 binary format: a block of nodes, read in one piece. The
+     nodes are identified by their tag, so that they are added without
+     searching for an existing point at the same place. */
+  static void read_gmsh4_binary_node_block(std::istream& f, mesh& m,
+                                           gmsh_node_numbering &numbering) {
+    typedef gmm::uint64_type u64;
+    int dimr = gmsh_read_binary<int>(f);
+    gmsh_read_binary<int>(f); // entity tag
+    int parametric = gmsh_read_binary<int>(f);
+    size_type nb = size_type(gmsh_read_binary<u64>(f));
+    size_type stride = 3 + (parametric ? size_type(dimr) : 0);
+    std::vector<u64> tags;
+    std::vector<double> coords;
+    gmsh_read_binary(f, tags, nb);
+    gmsh_read_binary(f, coords, nb * stride);
+    base_node n(3);
+    for (size_type i = 0; i < nb; ++i) {
+      std::copy(coords.begin() + i*stride, coords.begin() + i*stride + 3,
+                n.begin());
+      numbering.set(size_type(tags[i]), m.add_point(n, -1.));
+    }
+  }
+
+  /* Reordering of the nodes of a gmsh element, in place (should be
+     completed ?)
+     http://www.geuz.org/gmsh/doc/texinfo/gmsh.html#Node-ordering */
+  template <typename ITER, typename T>
+  static void gmsh_reorder_nodes(unsigned type, ITER nodes, size_type nbn,
+                                 std::vector<T> &tmp_nodes) {
+    tmp_nodes.assign(nodes, nodes + nbn);
+    switch(type) {
+    case 3 : {
+      nodes[2] = tmp_nodes[3];
+      nodes[3] = tmp_nodes[2];
+    } break;
+    case 5 : { /* First order hexaedron */
+      //nodes[0] = tmp_nodes[0];
+      //nodes[1] = tmp_nodes[1];
+      nodes[2] = tmp_nodes[3];
+      nodes[3] = tmp_nodes[2];
+      //nodes[4] = tmp_nodes[4];
+      //nodes[5] = tmp_nodes[5];
+      nodes[6] = tmp_nodes[7];
+      nodes[7] = tmp_nodes[6];
+    } break;
+    case 6 : { /* First order prism */
+      // no reordering
+    } break;
+    case 7 : { /* first order pyramid */
+      //nodes[0] = tmp_nodes[0];
+      nodes[1] = tmp_nodes[2];
+      nodes[2] = tmp_nodes[1];
+      // nodes[3] = tmp_nodes[3];
+      // nodes[4] = tmp_nodes[4];
+    } break;
+    case 8 : { /* Second order line */
+      //nodes[0] = tmp_nodes[0];
+      nodes[1] = tmp_nodes[2];
+      nodes[2] = tmp_nodes[1];
+    } break;
+    case 9 : { /* Second order triangle */
+      //nodes[0] = tmp_nodes[0];
+      nodes[1] = tmp_nodes[3];
+      nodes[2] = tmp_nodes[1];
+      nodes[3] = tmp_nodes[5];
+      //nodes[4] = tmp_nodes[4];
+      nodes[5] = tmp_nodes[2];
+    } break;
+    case 10 : { /* Second order quadrangle */
+      //nodes[0] = tmp_nodes[0];
+      nodes[1] = tmp_nodes[4];
+      nodes[2] = tmp_nodes[1];
+      nodes[3] = tmp_nodes[7];
+      nodes[4] = tmp_nodes[8];
+      //nodes[5] = tmp_nodes[5];
+      nodes[6] = tmp_nodes[3];
+      nodes[7] = tmp_nodes[6];
+      nodes[8] = tmp_nodes[2];
+    } break;
+    case 11: { /* Second order tetrahedron */
+      //nodes[0] = tmp_nodes[0];
+      nodes[1] = tmp_nodes[4];
+      nodes[2] = tmp_nodes[1];
+      nodes[3] = tmp_nodes[6];
+      nodes[4] = tmp_nodes[5];
+      nodes[5] = tmp_nodes[2];
+      nodes[6] = tmp_nodes[7];
+      nodes[7] = tmp_nodes[9];
+      //nodes[8] = tmp_nodes[8];
+      nodes[9] = tmp_nodes[3];
+    } break;
+    case 12: { /* Second order hexahedron */
+      //nodes[0] = tmp_nodes[0];
+      nodes[1] = tmp_nodes[8];
+      nodes[2] = tmp_nodes[1];
+      nodes[3] = tmp_nodes[9];
+      nodes[4] = tmp_nodes[20];
+      nodes[5] = tmp_nodes[11];
+      nodes[6] = tmp_nodes[3];
+      nodes[7] = tmp_nodes[13];
+      nodes[8] = tmp_nodes[2];
+      nodes[9] = tmp_nodes[10];
+      nodes[10] = tmp_nodes[21];
+      nodes[11] = tmp_nodes[12];
+      nodes[12] = tmp_nodes[22];
+      nodes[13] = tmp_nodes[26];
+      nodes[14] = tmp_nodes[23];
+      //nodes[15] = tmp_nodes[15];
+      nodes[16] = tmp_nodes[24];
+      nodes[17] = tmp_nodes[14];
+      nodes[18] = tmp_nodes[4];
+      nodes[19] = tmp_nodes[16];
+      nodes[20] = tmp_nodes[5];
+      nodes[21] = tmp_nodes[17];
+      nodes[22] = tmp_nodes[25];
+      nodes[23] = tmp_nodes[18];
+      nodes[24] = tmp_nodes[7];
+      nodes[25] = tmp_nodes[19];
+      nodes[26] = tmp_nodes[6];
+    } break;
+    case 13: { /* Second order prism (18-node) */
+      //nodes[0] = tmp_nodes[0];
+      nodes[1] = tmp_nodes[6];
+      nodes[2] = tmp_nodes[1];
+      nodes[3] = tmp_nodes[7];
+      nodes[4] = tmp_nodes[9];
+      nodes[5] = tmp_nodes[2];
+      nodes[6] = tmp_nodes[8];
+      nodes[7] = tmp_nodes[15];
+      nodes[8] = tmp_nodes[10];
+      nodes[9] = tmp_nodes[16];
+      nodes[10] = tmp_nodes[17];
+      //nodes[11] = tmp_nodes[11];
+      nodes[12] = tmp_nodes[3];
+      nodes[13] = tmp_nodes[12];
+      nodes[14] = tmp_nodes[4];
+      nodes[15] = tmp_nodes[13];
+      nodes[16] = tmp_nodes[14];
+      nodes[17] = tmp_nodes[5];
+    } break;
+    case 14: { /* Second order pyramid */
+      //nodes[0] = tmp_nodes[0];
+      nodes[1] = tmp_nodes[5];
+      nodes[2] = tmp_nodes[1];
+      nodes[3] = tmp_nodes[6];
+      nodes[4] = tmp_nodes[13];
+      nodes[5] = tmp_nodes[8];
+      nodes[6] = tmp_nodes[3];
+      nodes[7] = tmp_nodes[10];
+      nodes[8] = tmp_nodes[2];
+      nodes[9] = tmp_nodes[7];
+      nodes[10] = tmp_nodes[9];
+      nodes[11] = tmp_nodes[12];
+      nodes[12] = tmp_nodes[11];
+      nodes[13] = tmp_nodes[4];
+    } break;
+    case 16 : { /* Incomplete second order quadrangle */
+      //nodes[0] = tmp_nodes[0];
+      nodes[1] = tmp_nodes[4];
+      nodes[2] = tmp_nodes[1];
+      nodes[3] = tmp_nodes[7];
+      nodes[4] = tmp_nodes[5];
+      nodes[5] = tmp_nodes[3];
+      nodes[6] = tmp_nodes[6];
+      nodes[7] = tmp_nodes[2];
+    } break;
+    case 17: { /* Incomplete second order hexahedron */
+      //nodes[0] = tmp_nodes[0];
+      nodes[1] = tmp_nodes[8];
+      nodes[2] = tmp_nodes[1];
+      nodes[3] = tmp_nodes[9];
+      nodes[4] = tmp_nodes[11];
+      nodes[5] = tmp_nodes[3];
+      nodes[6] = tmp_nodes[13];
+      nodes[7] = tmp_nodes[2];
+      nodes[8] = tmp_nodes[10];
+      nodes[9] = tmp_nodes[12];
+      nodes[10] = tmp_nodes[15];
+      nodes[11] = tmp_nodes[14];
+      nodes[12] = tmp_nodes[4];
+      nodes[13] = tmp_nodes[16];
+      nodes[14] = tmp_nodes[5];
+      nodes[15] = tmp_nodes[17];
+      nodes[16] = tmp_nodes[18];
+      nodes[17] = tmp_nodes[7];
+      nodes[18] = tmp_nodes[19];
+      nodes[19] = tmp_nodes[6];
+    } break;
+    case 18: { /* Incomplete second order prism (15-node) */
+      //nodes[0] = tmp_nodes[0];
+      nodes[1] = tmp_nodes[6];
+      nodes[2] = tmp_nodes[1];
+      nodes[3] = tmp_nodes[7];
+      nodes[4] = tmp_nodes[9];
+      nodes[5] = tmp_nodes[2];
+      nodes[6] = tmp_nodes[8];
+      nodes[7] = tmp_nodes[10];
+      nodes[8] = tmp_nodes[11];
+      nodes[9] = tmp_nodes[3];
+      nodes[10] = tmp_nodes[12];
+      nodes[11] = tmp_nodes[4];
+      nodes[12] = tmp_nodes[13];
+      nodes[13] = tmp_nodes[14];
+      nodes[14] = tmp_nodes[5];
+    } break;
+    case 19: { /* Incomplete second order pyramid */
+      //nodes[0] = tmp_nodes[0];
+      nodes[1] = tmp_nodes[5];
+      nodes[2] = tmp_nodes[1];
+      nodes[3] = tmp_nodes[6];
+      nodes[4] = tmp_nodes[8];
+      nodes[5] = tmp_nodes[3];
+      nodes[6] = tmp_nodes[10];
+      nodes[7] = tmp_nodes[2];
+      nodes[8] = tmp_nodes[7];
+      //nodes[9] = tmp_nodes[9];
+      nodes[10] = tmp_nodes[12];
+      //nodes[11] = tmp_nodes[11];
+      nodes[12] = tmp_nodes[4];
+    } break;
+    case 26 : { /* Third order line */
+      //nodes[0] = tmp_nodes[0];
+      nodes[1] = tmp_nodes[2];
+      nodes[2] = tmp_nodes[3];
+      nodes[3] = tmp_nodes[1];
+    } break;
+    case 21 : { /* Third order triangle */
+      //nodes[0] = tmp_nodes[0];
+      nodes[1] = tmp_nodes[3];
+      nodes[2] = tmp_nodes[4];
+      nodes[3] = tmp_nodes[1];
+      nodes[4] = tmp_nodes[8];
+      nodes[5] = tmp_nodes[9];
+      nodes[6] = tmp_nodes[5];
+      //nodes[7] = tmp_nodes[7];
+      nodes[8] = tmp_nodes[6];
+      nodes[9] = tmp_nodes[2];
+    } break;
+    case 23: { /* Fourth order triangle */
+    //nodes[0]  = tmp_nodes[0];
+      nodes[1]  = tmp_nodes[3];
+      nodes[2]  = tmp_nodes[4];
+      nodes[3]  = tmp_nodes[5];
+      nodes[4]  = tmp_nodes[1];
+      nodes[5]  = tmp_nodes[11];
+      nodes[6]  = tmp_nodes[12];
+      nodes[7]  = tmp_nodes[13];
+      nodes[8]  = tmp_nodes[6];
+      nodes[9]  = tmp_nodes[10];
+      nodes[10] = tmp_nodes[14];
+      nodes[11] = tmp_nodes[7];
+      nodes[12] = tmp_nodes[9];
+      nodes[13] = tmp_nodes[8];
+      nodes[14] = tmp_nodes[2];
+    } break;
+    case 27: { /* Fourth order line */
+    //nodes[0]  = tmp_nodes[0];
+      nodes[1]  = tmp_nodes[2];
+      nodes[2]  = tmp_nodes[3];
+      nodes[3]  = tmp_nodes[4];
+      nodes[4]  = tmp_nodes[1];
+    } break;
+    }
+  }
+
+  /* MSH 4.1 binary format: a block of nb elements of the same type. The
+     records (element tag followed by the nbn node tags) are read in one
+     piece, then the node tags are replaced in place by the mesh points,
+     in the getfem order. This is done in parallel for large blocks, the
+     invalid tags being reported after the parallel section. */
+  struct gmsh4_element_block {
+    unsigned type, region, dim;
+    bgeot::pgeometric_trans pgt;
+    size_type nb, nbn;
+    std::vector<gmm::uint64_type> rec;
+
+    bool operator<(const gmsh4_element_block& other) const {
+      if (dim == other.dim) return region < other.region;
+      return dim > other.dim;
+    }
+  };
+
+  static void read_gmsh4_binary_element_block
+  (std::istream& f, const gmsh_node_numbering &numbering,
+   const gmsh_entity_physical_map &entity_phys, dal::bit_vector &reg,
+   gmsh4_element_block &b) {
+    int dimr = gmsh_read_binary<int>(f);
+    int entity = gmsh_read_binary<int>(f);
+    b.type = unsigned(gmsh_read_binary<int>(f));
+    b.nb = size_type(gmsh_read_binary<gmm::uint64_type>(f));
+    b.region = gmsh4_block_region(dimr, entity, entity_phys, reg);
+    gmsh_cv_info ci; ci.type = b.type; ci.set_nb_nodes();
+    if (b.type != 15) ci.set_pgt();
+    b.pgt = ci.pgt; b.nbn = ci.nodes.size();
+    b.dim = (b.type == 15) ? 0 : b.pgt->dim();
+    gmsh_read_binary(f, b.rec, b.nb * (b.nbn + 1));
+
+    size_type nb = b.nb, nbn = b.nbn, nbchunks = 1;
+    if (nb > 10000 && !me_is_multithreaded_now())
+      nbchunks = std::max(size_type(1), std::min(nb / 1000,
+                          global_thread_policy::num_threads()));
+    std::vector<size_type> invalid(nbchunks, size_type(-1));
+    std::vector<gmm::uint64_type> invalid_tag(nbchunks);
+    auto convert_chunk = [&](size_type c) {
+      if (c >= nbchunks) return;
+      std::vector<gmm::uint64_type> tmp_nodes;
+      for (size_type i = (nb*c)/nbchunks; i < (nb*(c+1))/nbchunks; ++i) {
+        auto nodes = b.rec.begin() + i*(nbn+1) + 1;
+        for (size_type k = 0; k < nbn; ++k) {
+          size_type ip = numbering(size_type(nodes[k]));
+          if (ip == size_type(-1) && invalid[c] == size_type(-1))
+            { invalid[c] = i; invalid_tag[c] = nodes[k]; }
+          nodes[k] = ip;
+        }
+        gmsh_reorder_nodes(b.type, nodes, nbn, tmp_nodes);
+      }
+    };
+    if (nbchunks > 1) {
+      GETFEM_OMP_PARALLEL(
+        convert_chunk(global_thread_policy::this_thread());
+      )
+    } else convert_chunk(0);
+
+    for (size_type c = 0; c < nbchunks; ++c)
+      GMM_ASSERT1(invalid[c] == size_type(-1), "Invalid node ID "
+                  << invalid_tag[c] << " in gmsh element "
+                  << b.rec[invalid[c]*(nbn+1)]);
+  }
+
+  /* Addition of a gmsh element to a mesh whose elements of highest
+     dimension have dimension N. The elements of lower dimension are
+     added to their region as faces of the elements of dimension N, or as
+     convexes if their region is in lower_dim_convex_rg. */
+  template <typename ITER>
+  static void add_gmsh_element
+  (mesh& m, unsigned N, unsigned type, bgeot::pgeometric_trans pgt,
+   unsigned region, size_type id, ITER nodes, size_type nbn,
+   std::set<size_type> *lower_dim_convex_rg, bool add_all_element_type,
+   std::map<size_type, std::set<size_type>> *nodal_map) {
+    bool cvok = false;
+    bool is_node = (type == 15);
+    unsigned ci_dim = (is_node) ? 0 : pgt->dim();
+    //  cout << "importing cv dim=" << ci_dim << " N=" << N
+    //       << " region: " << region << " type: " << type << "\n";
+
+    //main convex import
+    if (ci_dim == N) {
+      size_type ic = m.add_convex(pgt, nodes);
+      cvok = true;
+      m.region(region).add(ic);
+
+    //convexes with lower dimensions
+    }
+    else {
+      //convex that lies within the regions of lower_dim_convex_rg
+      //is imported explicitly as a convex.
+      if (lower_dim_convex_rg != NULL &&
+          lower_dim_convex_rg->find(region) != lower_dim_convex_rg->end()
+          && !is_node) {
+          size_type ic = m.add_convex(pgt, nodes);
+          cvok = true; m.region(region).add(ic);
+      }
+      //find if the convex is part of a face of higher dimension convex
+      else{
+        bgeot::mesh_structure::ind_cv_ct ct=m.convex_to_point(nodes[0]);
+        for (bgeot::mesh_structure::ind_cv_ct::const_iterator
+               it = ct.begin(); it != ct.end(); ++it) {
+          if (m.structure_of_convex(*it)->dim() == ci_dim + 1) {
+            for (short_type face=0;
+                 face < m.structure_of_convex(*it)->nb_faces(); ++face) {
+              if (m.is_convex_face_having_points(*it, face,
+                                                 short_type(nbn), nodes)) {
+                m.region(region).add(*it,face);
+                cvok = true;
+              }
+            }
+          }
+        }
+        if (is_node && (nodal_map != NULL)) {
+          for (size_type k = 0; k < nbn; ++k)
+            (*nodal_map)[region].insert(size_type(nodes[k]));
+        }
+        // if the convex is not part of the face of others
+        if (!cvok) {
+          if (is_node) {
+            if (nodal_map == NULL){
+              GMM_WARNING2("gmsh import ignored a node id: "
+                           << id << " region :" << region <<
+                           " point is not added explicitly as an element.");
+            }
+          }
+          else if (add_all_element_type) {
+            size_type ic = m.add_convex(pgt, nodes);
+            m.region(region).add(ic);
+            cvok = true;
+          } else {
+            GMM_WARNING2("gmsh import ignored an element of type "
+                         << bgeot::name_of_geometric_trans(pgt) <<
+                " as it does not belong to the face of another element");
+          }
+        }
+      }
+    }
+  }
+
   /*
      Format version 1 [for gmsh version < 2.0].
      structure: $NOD list_of_nodes $ENDNOD $ELT list_of_elt $ENDELT
@@ -233,6 +763,11 @@ namespace getfem {
      structure: $Nodes list_of_nodes $EndNodes $Elements list_of_elt
      $EndElements
 
+     Format version 4.1 may be ascii or binary. In both cases the region
+     of an element is the first physical tag of its entity, given by the
+     $Entities section, or the entity tag if the entity has none. In
+     binary, the nodes are identified by their tag and never merged.
+
      Lower dimensions elements in the regions of lower_dim_convex_rg will
      be imported as independant convexes.
 
@@ -279,20 +814,43 @@ namespace getfem {
     else
       GMM_ASSERT1(false, "can't read Gmsh format: " << header);
 
-    /* read the region names */
-    if (region_map != NULL) {
-      if (version >= 2.) {
-        *region_map = read_region_names_from_gmsh_mesh_file(f);
+    bool binary = false;
+    gmsh_entity_physical_map entity_phys;
+    if (version >= 4.05) { /* Format version 4.1 */
+      int file_type, data_size;
+      f >> file_type >> data_size;
+      binary = (file_type == 1);
+      if (binary) {
+        GMM_ASSERT1(data_size == int(sizeof(gmm::uint64_type)),
+                    "Unsupported data size in binary gmsh file");
+        f.get();
+        GMM_ASSERT1(gmsh_read_binary<int>(f) == 1,
+                    "Binary gmsh file written with a different byte order");
       }
+      read_gmsh4_header_sections(f, binary, region_map, entity_phys);
+    } else {
+      /* read the region names */
+      if (region_map != NULL) {
+        if (version >= 2.) {
+          *region_map = read_region_names_from_gmsh_mesh_file(f);
+        }
+      }
+      /* read the node list */
+      if (version >= 2.)
+        bgeot::read_until(f, "$Nodes"); /* Format versions 2 and 4 */
     }
-    /* read the node list */
-    if (version >= 2.)
-      bgeot::read_until(f, "$Nodes"); /* Format versions 2 and 4 */
 
     size_type nb_block, nb_node, dummy;
     std::string dummy2;
+    gmsh_node_numbering numbering; /* binary format */
     // cout << "version = " << version << endl;
-    if (version >= 4.05) {
+    if (binary) {
+      nb_block = size_type(gmsh_read_binary<gmm::uint64_type>(f));
+      nb_node = size_type(gmsh_read_binary<gmm::uint64_type>(f));
+      size_type min_tag = size_type(gmsh_read_binary<gmm::uint64_type>(f));
+      size_type max_tag = size_type(gmsh_read_binary<gmm::uint64_type>(f));
+      numbering.init(min_tag, max_tag, nb_node);
+    } else if (version >= 4.05) {
       f >> nb_block >> nb_node; bgeot::read_until(f, "\n");
     } else if (version >= 4.) {
       f >> nb_block >> nb_node;
@@ -305,6 +863,10 @@ namespace getfem {
     std::map<size_type, size_type> msh_node_2_getfem_node;
      std::vector<size_type> inds(nb_node);
     for (size_type block=0; block < nb_block; ++block) {
+      if (binary) {
+        read_gmsh4_binary_node_block(f, m, numbering);
+        continue;
+      }
       if (version >= 4.)
         f >> dummy >> dummy >> dummy >> nb_node;
       // cout << "nb_nodes = " << nb_node << endl;
@@ -338,7 +900,13 @@ namespace getfem {
       bgeot::read_until(f, "$ELM");
 
     size_type nb_cv;
-    if (version >= 4.05) {
+    if (binary) {
+      f.get(); // end of line
+      nb_block = size_type(gmsh_read_binary<gmm::uint64_type>(f));
+      nb_cv = size_type(gmsh_read_binary<gmm::uint64_type>(f));
+      gmsh_read_binary<gmm::uint64_type>(f); // minimum element tag
+      gmsh_read_binary<gmm::uint64_type>(f); // maximum element tag
+    } else if (version >= 4.05) {
       f >> nb_block >> nb_cv; bgeot::read_until(f, "\n");
     } else if (version >= 4.) { /* Format version 4 */
       f >> nb_block >> nb_cv;
@@ -348,18 +916,22 @@ namespace getfem {
     }
     // cout << "nb_bloc = " << nb_block << " nb_cv = " << nb_cv << endl;
 
-    std::vector<gmsh_cv_info> cvlst; cvlst.reserve(nb_cv);
+    std::vector<gmsh_cv_info> cvlst;
+    std::vector<gmsh4_element_block> blocks; /* binary format */
+    if (binary) blocks.resize(nb_block); else cvlst.reserve(nb_cv);
     dal::bit_vector reg;
+    std::vector<size_type> tmp_nodes;
     for (size_type block=0; block < nb_block; ++block) {
+      if (binary) {
+        read_gmsh4_binary_element_block(f, numbering, entity_phys, reg,
+                                        blocks[block]);
+        continue;
+      }
       unsigned dimr, type, region;
       if (version >= 4.) { /* Format version 4 */
-        f >> dimr >> region >> type >> nb_cv;
-        if (reg.is_in(region)) {
-          GMM_WARNING2("Two regions share the same number, "
-                       "the region numbering is modified");
-          while (reg.is_in(region)) region += 5;
-        }
-        reg.add(region);
+        int entity;
+        f >> dimr >> entity >> type >> nb_cv;
+        region = gmsh4_block_region(int(dimr), entity, entity_phys, reg);
       }
       for (size_type cv=0; cv < nb_cv; ++cv) {
 
@@ -402,321 +974,41 @@ namespace getfem {
         }
         if (ci.type != 15)
           ci.set_pgt();
-        // Reordering nodes for certain elements (should be completed ?)
-        // http://www.geuz.org/gmsh/doc/texinfo/gmsh.html#Node-ordering
-        std::vector<size_type> tmp_nodes(ci.nodes);
-        switch(ci.type) {
-        case 3 : {
-          ci.nodes[2] = tmp_nodes[3];
-          ci.nodes[3] = tmp_nodes[2];
-        } break;
-        case 5 : { /* First order hexaedron */
-          //ci.nodes[0] = tmp_nodes[0];
-          //ci.nodes[1] = tmp_nodes[1];
-          ci.nodes[2] = tmp_nodes[3];
-          ci.nodes[3] = tmp_nodes[2];
-          //ci.nodes[4] = tmp_nodes[4];
-          //ci.nodes[5] = tmp_nodes[5];
-          ci.nodes[6] = tmp_nodes[7];
-          ci.nodes[7] = tmp_nodes[6];
-        } break;
-        case 6 : { /* First order prism */
-          // no reordering
-        } break;
-        case 7 : { /* first order pyramid */
-          //ci.nodes[0] = tmp_nodes[0];
-          ci.nodes[1] = tmp_nodes[2];
-          ci.nodes[2] = tmp_nodes[1];
-          // ci.nodes[3] = tmp_nodes[3];
-          // ci.nodes[4] = tmp_nodes[4];
-        } break;
-        case 8 : { /* Second order line */
-          //ci.nodes[0] = tmp_nodes[0];
-          ci.nodes[1] = tmp_nodes[2];
-          ci.nodes[2] = tmp_nodes[1];
-        } break;
-        case 9 : { /* Second order triangle */
-          //ci.nodes[0] = tmp_nodes[0];
-          ci.nodes[1] = tmp_nodes[3];
-          ci.nodes[2] = tmp_nodes[1];
-          ci.nodes[3] = tmp_nodes[5];
-          //ci.nodes[4] = tmp_nodes[4];
-          ci.nodes[5] = tmp_nodes[2];
-        } break;
-        case 10 : { /* Second order quadrangle */
-          //ci.nodes[0] = tmp_nodes[0];
-          ci.nodes[1] = tmp_nodes[4];
-          ci.nodes[2] = tmp_nodes[1];
-          ci.nodes[3] = tmp_nodes[7];
-          ci.nodes[4] = tmp_nodes[8];
-          //ci.nodes[5] = tmp_nodes[5];
-          ci.nodes[6] = tmp_nodes[3];
-          ci.nodes[7] = tmp_nodes[6];
-          ci.nodes[8] = tmp_nodes[2];
-        } break;
-        case 11: { /* Second order tetrahedron */
-          //ci.nodes[0] = tmp_nodes[0];
-          ci.nodes[1] = tmp_nodes[4];
-          ci.nodes[2] = tmp_nodes[1];
-          ci.nodes[3] = tmp_nodes[6];
-          ci.nodes[4] = tmp_nodes[5];
-          ci.nodes[5] = tmp_nodes[2];
-          ci.nodes[6] = tmp_nodes[7];
-          ci.nodes[7] = tmp_nodes[9];
-          //ci.nodes[8] = tmp_nodes[8];
-          ci.nodes[9] = tmp_nodes[3];
-        } break;
-        case 12: { /* Second order hexahedron */
-          //ci.nodes[0] = tmp_nodes[0];
-          ci.nodes[1] = tmp_nodes[8];
-          ci.nodes[2] = tmp_nodes[1];
-          ci.nodes[3] = tmp_nodes[9];
-          ci.nodes[4] = tmp_nodes[20];
-          ci.nodes[5] = tmp_nodes[11];
-          ci.nodes[6] = tmp_nodes[3];
-          ci.nodes[7] = tmp_nodes[13];
-          ci.nodes[8] = tmp_nodes[2];
-          ci.nodes[9] = tmp_nodes[10];
-          ci.nodes[10] = tmp_nodes[21];
-          ci.nodes[11] = tmp_nodes[12];
-          ci.nodes[12] = tmp_nodes[22];
-          ci.nodes[13] = tmp_nodes[26];
-          ci.nodes[14] = tmp_nodes[23];
-          //ci.nodes[15] = tmp_nodes[15];
-          ci.nodes[16] = tmp_nodes[24];
-          ci.nodes[17] = tmp_nodes[14];
-          ci.nodes[18] = tmp_nodes[4];
-          ci.nodes[19] = tmp_nodes[16];
-          ci.nodes[20] = tmp_nodes[5];
-          ci.nodes[21] = tmp_nodes[17];
-          ci.nodes[22] = tmp_nodes[25];
-          ci.nodes[23] = tmp_nodes[18];
-          ci.nodes[24] = tmp_nodes[7];
-          ci.nodes[25] = tmp_nodes[19];
-          ci.nodes[26] = tmp_nodes[6];
-        } break;
-        case 13: { /* Second order prism (18-node) */
-          //ci.nodes[0] = tmp_nodes[0];
-          ci.nodes[1] = tmp_nodes[6];
-          ci.nodes[2] = tmp_nodes[1];
-          ci.nodes[3] = tmp_nodes[7];
-          ci.nodes[4] = tmp_nodes[9];
-          ci.nodes[5] = tmp_nodes[2];
-          ci.nodes[6] = tmp_nodes[8];
-          ci.nodes[7] = tmp_nodes[15];
-          ci.nodes[8] = tmp_nodes[10];
-          ci.nodes[9] = tmp_nodes[16];
-          ci.nodes[10] = tmp_nodes[17];
-          //ci.nodes[11] = tmp_nodes[11];
-          ci.nodes[12] = tmp_nodes[3];
-          ci.nodes[13] = tmp_nodes[12];
-          ci.nodes[14] = tmp_nodes[4];
-          ci.nodes[15] = tmp_nodes[13];
-          ci.nodes[16] = tmp_nodes[14];
-          ci.nodes[17] = tmp_nodes[5];
-        } break;
-        case 14: { /* Second order pyramid */
-          //ci.nodes[0] = tmp_nodes[0];
-          ci.nodes[1] = tmp_nodes[5];
-          ci.nodes[2] = tmp_nodes[1];
-          ci.nodes[3] = tmp_nodes[6];
-          ci.nodes[4] = tmp_nodes[13];
-          ci.nodes[5] = tmp_nodes[8];
-          ci.nodes[6] = tmp_nodes[3];
-          ci.nodes[7] = tmp_nodes[10];
-          ci.nodes[8] = tmp_nodes[2];
-          ci.nodes[9] = tmp_nodes[7];
-          ci.nodes[10] = tmp_nodes[9];
-          ci.nodes[11] = tmp_nodes[12];
-          ci.nodes[12] = tmp_nodes[11];
-          ci.nodes[13] = tmp_nodes[4];
-        } break;
-        case 16 : { /* Incomplete second order quadrangle */
-          //ci.nodes[0] = tmp_nodes[0];
-          ci.nodes[1] = tmp_nodes[4];
-          ci.nodes[2] = tmp_nodes[1];
-          ci.nodes[3] = tmp_nodes[7];
-          ci.nodes[4] = tmp_nodes[5];
-          ci.nodes[5] = tmp_nodes[3];
-          ci.nodes[6] = tmp_nodes[6];
-          ci.nodes[7] = tmp_nodes[2];
-        } break;
-        case 17: { /* Incomplete second order hexahedron */
-          //ci.nodes[0] = tmp_nodes[0];
-          ci.nodes[1] = tmp_nodes[8];
-          ci.nodes[2] = tmp_nodes[1];
-          ci.nodes[3] = tmp_nodes[9];
-          ci.nodes[4] = tmp_nodes[11];
-          ci.nodes[5] = tmp_nodes[3];
-          ci.nodes[6] = tmp_nodes[13];
-          ci.nodes[7] = tmp_nodes[2];
-          ci.nodes[8] = tmp_nodes[10];
-          ci.nodes[9] = tmp_nodes[12];
-          ci.nodes[10] = tmp_nodes[15];
-          ci.nodes[11] = tmp_nodes[14];
-          ci.nodes[12] = tmp_nodes[4];
-          ci.nodes[13] = tmp_nodes[16];
-          ci.nodes[14] = tmp_nodes[5];
-          ci.nodes[15] = tmp_nodes[17];
-          ci.nodes[16] = tmp_nodes[18];
-          ci.nodes[17] = tmp_nodes[7];
-          ci.nodes[18] = tmp_nodes[19];
-          ci.nodes[19] = tmp_nodes[6];
-        } break;
-        case 18: { /* Incomplete second order prism (15-node) */
-          //ci.nodes[0] = tmp_nodes[0];
-          ci.nodes[1] = tmp_nodes[6];
-          ci.nodes[2] = tmp_nodes[1];
-          ci.nodes[3] = tmp_nodes[7];
-          ci.nodes[4] = tmp_nodes[9];
-          ci.nodes[5] = tmp_nodes[2];
-          ci.nodes[6] = tmp_nodes[8];
-          ci.nodes[7] = tmp_nodes[10];
-          ci.nodes[8] = tmp_nodes[11];
-          ci.nodes[9] = tmp_nodes[3];
-          ci.nodes[10] = tmp_nodes[12];
-          ci.nodes[11] = tmp_nodes[4];
-          ci.nodes[12] = tmp_nodes[13];
-          ci.nodes[13] = tmp_nodes[14];
-          ci.nodes[14] = tmp_nodes[5];
-        } break;
-        case 19: { /* Incomplete second order pyramid */
-          //ci.nodes[0] = tmp_nodes[0];
-          ci.nodes[1] = tmp_nodes[5];
-          ci.nodes[2] = tmp_nodes[1];
-          ci.nodes[3] = tmp_nodes[6];
-          ci.nodes[4] = tmp_nodes[8];
-          ci.nodes[5] = tmp_nodes[3];
-          ci.nodes[6] = tmp_nodes[10];
-          ci.nodes[7] = tmp_nodes[2];
-          ci.nodes[8] = tmp_nodes[7];
-          //ci.nodes[9] = tmp_nodes[9];
-          ci.nodes[10] = tmp_nodes[12];
-          //ci.nodes[11] = tmp_nodes[11];
-          ci.nodes[12] = tmp_nodes[4];
-        } break;
-        case 26 : { /* Third order line */
-          //ci.nodes[0] = tmp_nodes[0];
-          ci.nodes[1] = tmp_nodes[2];
-          ci.nodes[2] = tmp_nodes[3];
-          ci.nodes[3] = tmp_nodes[1];
-        } break;
-        case 21 : { /* Third order triangle */
-          //ci.nodes[0] = tmp_nodes[0];
-          ci.nodes[1] = tmp_nodes[3];
-          ci.nodes[2] = tmp_nodes[4];
-          ci.nodes[3] = tmp_nodes[1];
-          ci.nodes[4] = tmp_nodes[8];
-          ci.nodes[5] = tmp_nodes[9];
-          ci.nodes[6] = tmp_nodes[5];
-          //ci.nodes[7] = tmp_nodes[7];
-          ci.nodes[8] = tmp_nodes[6];
-          ci.nodes[9] = tmp_nodes[2];
-        } break;
-        case 23: { /* Fourth order triangle */
-        //ci.nodes[0]  = tmp_nodes[0];
-          ci.nodes[1]  = tmp_nodes[3];
-          ci.nodes[2]  = tmp_nodes[4];
-          ci.nodes[3]  = tmp_nodes[5];
-          ci.nodes[4]  = tmp_nodes[1];
-          ci.nodes[5]  = tmp_nodes[11];
-          ci.nodes[6]  = tmp_nodes[12];
-          ci.nodes[7]  = tmp_nodes[13];
-          ci.nodes[8]  = tmp_nodes[6];
-          ci.nodes[9]  = tmp_nodes[10];
-          ci.nodes[10] = tmp_nodes[14];
-          ci.nodes[11] = tmp_nodes[7];
-          ci.nodes[12] = tmp_nodes[9];
-          ci.nodes[13] = tmp_nodes[8];
-          ci.nodes[14] = tmp_nodes[2];
-        } break;
-        case 27: { /* Fourth order line */
-        //ci.nodes[0]  = tmp_nodes[0];
-          ci.nodes[1]  = tmp_nodes[2];
-          ci.nodes[2]  = tmp_nodes[3];
-          ci.nodes[3]  = tmp_nodes[4];
-          ci.nodes[4]  = tmp_nodes[1];
-        } break;
-        }
+        gmsh_reorder_nodes(ci.type, ci.nodes.begin(), ci.nodes.size(),
+                           tmp_nodes);
+      }
+    }
+
+    if (binary) {
+      std::stable_sort(blocks.begin(), blocks.end());
+      if (blocks.size() && blocks.front().type == 15) {
+        GMM_WARNING2("Only nodes defined in the mesh! No elements are added.");
+        return;
       }
+      for (const gmsh4_element_block &b : blocks)
+        for (size_type i = 0; i < b.nb; ++i) {
+          auto rec = b.rec.begin() + i*(b.nbn+1);
+          add_gmsh_element(m, blocks.front().dim, b.type, b.pgt, b.region,
+                           size_type(rec[0]) - 1, rec + 1, b.nbn,
+                           lower_dim_convex_rg, add_all_element_type,
+                           nodal_map);
+        }
     }
 
     nb_cv = cvlst.size();
     if (cvlst.size()) {
-      std::sort(cvlst.begin(), cvlst.end());
+      std::stable_sort(cvlst.begin(), cvlst.end());
       if (cvlst.front().type == 15) {
         GMM_WARNING2("Only nodes defined in the mesh! No elements are added.");
         return;
       }
 
       unsigned N = cvlst.front().pgt->dim();
-      for (size_type cv=0; cv < nb_cv; ++cv) {
-        bool cvok = false;
-        gmsh_cv_info &ci = cvlst[cv];
-        bool is_node = (ci.type == 15);
-        unsigned ci_dim = (is_node) ? 0 : ci.pgt->dim();
-        //  cout << "importing cv dim=" << ci_dim << " N=" << N
-        //       << " region: " << ci.region << " type: " << ci.type << "\n";
-
-        //main convex import
-        if (ci_dim == N) {
-          size_type ic = m.add_convex(ci.pgt, ci.nodes.begin());
-          cvok = true;
-          m.region(ci.region).add(ic);
-
-        //convexes with lower dimensions
-        }
-        else {
-          //convex that lies within the regions of lower_dim_convex_rg
-          //is imported explicitly as a convex.
-          if (lower_dim_convex_rg != NULL &&
-              lower_dim_convex_rg->find(ci.region) != lower_dim_convex_rg->end()
-              && !is_node) {
-              size_type ic = m.add_convex(ci.pgt, ci.nodes.begin());
-              cvok = true; m.region(ci.region).add(ic);
-          }
-          //find if the convex is part of a face of higher dimension convex
-          else{
-            bgeot::mesh_structure::ind_cv_ct ct=m.convex_to_point(ci.nodes[0]);
-            for (bgeot::mesh_structure::ind_cv_ct::const_iterator
-                   it = ct.begin(); it != ct.end(); ++it) {
-              if (m.structure_of_convex(*it)->dim() == ci_dim + 1) {
-                for (short_type face=0;
-                     face < m.structure_of_convex(*it)->nb_faces(); ++face) {
-                  if (m.is_convex_face_having_points(*it, face,
-                                                    short_type(ci.nodes.size()),
-                                                    ci.nodes.begin())) {
-                    m.region(ci.region).add(*it,face);
-                    cvok = true;
-                  }
-                }
-              }
-            }
-            if (is_node && (nodal_map != NULL)) {
-              for (auto i : ci.nodes) (*nodal_map)[ci.region].insert(i);
-            }
-            // if the convex is not part of the face of others
-            if (!cvok) {
-              if (is_node) {
-                if (nodal_map == NULL){
-                  GMM_WARNING2("gmsh import ignored a node id: "
-                               << ci.id << " region :" << ci.region <<
-                               " point is not added explicitly as an element.");
-                }
-              }
-              else if (add_all_element_type) {
-                size_type ic = m.add_convex(ci.pgt, ci.nodes.begin());
-                m.region(ci.region).add(ic);
-                cvok = true;
-              } else {
-                GMM_WARNING2("gmsh import ignored an element of type "
-                             << bgeot::name_of_geometric_trans(ci.pgt) <<
-                    " as it does not belong to the face of another element");
-              }
-            }
-          }
-        }
-      }
+      for (const gmsh_cv_info &ci : cvlst)
+        add_gmsh_element(m, N, ci.type, ci.pgt, ci.region, ci.id,
+                         ci.nodes.begin(), ci.nodes.size(),
+                         lower_dim_convex_rg, add_all_element_type,
+                         nodal_map);
     }
     if (remove_last_dimension) maybe_remove_last_dimension(m);
   }
@@ -1545,7 +1837,11 @@ namespace getfem {
       else if (bgeot::casecmp(format,"structured_ball_shell")==0)
         { regular_ball_shell_mesh(m, filename); return; }
 
-      std::ifstream f(filename.c_str());
+      /* gmsh files may be binary (format 4.1) */
+      std::ios::openmode mode = std::ios::in;
+      if (bgeot::casecmp(format.substr(0, 4), "gmsh") == 0)
+        mode |= std::ios::binary;
+      std::ifstream f(filename.c_str(), mode);
       GMM_ASSERT1(f.good(), "can't open file " << filename);
       /* throw exceptions when an error occurs */
       f.exceptions(std::ifstream::badbit | std::ifstream::failbit);
@@ -1599,7 +1895,7 @@ namespace getfem {
   {
     m.clear();
     try {
-      std::ifstream f(filename.c_str());
+      std::ifstream f(filename.c_str(), std::ios::in | std::ios::binary);
       GMM_ASSERT1(f.good(), "can't open file " << filename);
       /* throw exceptions when an error occurs */
       f.exceptions(std::ifstream::badbit | std::ifstream::failbit);
@@ -20,6 +20,7 @@
 
 
 #include "getfem/getfem_interpolation.h"
+#include "getfem/bgeot_rtree.h"
 
 namespace getfem {
 
@@ -179,5 +180,201 @@ namespace getfem {
       mult *= scalar_type(2);
     } while (remaining_pts.card() > 0 && extrapolation == 2);
   }
+
+  interpolation_plan::interpolation_plan
+  (const mesh_fem &mf_source_, const mesh_fem &mf_target_,
+   int extrapolation_, double EPS_, mesh_region rg_source_,
+   mesh_region rg_target_)
+    : mf_source(mf_source_), mf_target(mf_target_),
+      extrapolation(extrapolation_), EPS(EPS_), rg_source(rg_source_),
+      rg_target(rg_target_), plan_built(false) {
+    GMM_ASSERT1(!dynamic_cast<const torus_mesh_fem *>(&mf_target),
+                "Interpolation plans are not available for torus mesh_fems");
+    add_dependency(mf_source);
+    add_dependency(mf_target);
+    add_dependency(mf_source.linked_mesh());
+    add_dependency(mf_target.linked_mesh());
+  }
+
+  void interpolation_plan::build() const {
+    if (plan_built) return;
+    const mesh &msh(mf_source.linked_mesh());
+    size_type qdim_s = mf_source.get_qdim(), qdim_t = mf_target.get_qdim();
+    GMM_ASSERT1(qdim_s == qdim_t || qdim_t == 1,
+                "Attempt to interpolate a field of dimension "
+                << qdim_s << " on a mesh_fem whose Qdim is " << qdim_t);
+    for (dal::bv_visitor cv(mf_target.convex_index()); !cv.finished();++cv) {
+      pfem pf_t = mf_target.fem_of_element(cv);
+      GMM_ASSERT1(pf_t->target_dim() == 1 && pf_t->is_lagrange(),
+                  "Target fem not convenient for interpolation");
+    }
+    mf_source.nb_dof(); // Dof enumerations, before the parallel section
+    mf_target.nb_dof();
+
+    // Target points
+    std::vector<base_node> pts;
+    pt_ids.resize(0);
+    if (rg_target.id() == mesh_region::all_convexes().id()) {
+      size_type nbpts = mf_target.nb_basic_dof() / qdim_t;
+      for (size_type i = 0; i < nbpts; ++i) {
+        pts.push_back(mf_target.point_of_basic_dof(i * qdim_t));
+        pt_ids.push_back(i);
+      }
+    } else {
+      for (dal::bv_visitor_c dof(mf_target.basic_dof_on_region(rg_target));
+           !dof.finished(); ++dof)
+        if (dof % qdim_t == 0) {
+          pts.push_back(mf_target.point_of_basic_dof(dof));
+          pt_ids.push_back(dof / qdim_t);
+        }
+    }
+    size_type nbpts = pts.size();
+    cv_of_pt.assign(nbpts, size_type(-1));
+    ref_coords.assign(nbpts, base_node());
+
+    // Candidate source convexes of each point: the ones whose bounding
+    // box, enlarged by EPS, contains the point.
+    mesh_region rg(rg_source);
+    rg.from_mesh(msh);
+    rg.error_if_not_convexes();
+    bgeot::rtree boxes;
+    for (dal::bv_visitor cv(rg.index()); !cv.finished(); ++cv)
+      if (mf_source.convex_index().is_in(cv)) {
+        base_node bmin, bmax;
+        bounding_box(bmin, bmax, msh.points_of_convex(cv),
+                     msh.trans_of_convex(cv));
+        for (size_type k = 0; k < bmin.size(); ++k)
+          { bmin[k] -= EPS; bmax[k] += EPS; }
+        boxes.add_box(bmin, bmax, cv);
+      }
+    boxes.build_tree();
+    std::vector<size_type> cvptr, cvind;
+    boxes.find_boxes_at_points(pts, cvptr, cvind, true);
+
+    // Location of the points, same selection as mesh_trans_inv::distribute
+    // on the candidate convexes taken in increasing order. Each partition
+    // works on a contiguous range of points and keeps the last inverted
+    // geometric transformation.
+    bool projection_into_element(extrapolation == 0);
+    size_type nbchunks = 1;
+    if (!me_is_multithreaded_now())
+      nbchunks = std::max(size_type(1), std::min(nbpts,
+                          global_thread_policy::num_threads()));
+    auto locate_points = [&](size_type c) {
+      if (c >= nbchunks) return;
+      bgeot::geotrans_inv_convex gic;
+      size_type last_cv = size_type(-1);
+      base_node pt_ref;
+      for (size_type i = (nbpts*c)/nbchunks; i < (nbpts*(c+1))/nbchunks;
+           ++i) {
+        scalar_type dist(0);
+        for (size_type l = cvptr[i]; l < cvptr[i+1]; ++l) {
+          if (cv_of_pt[i] != size_type(-1) && dist <= scalar_type(0)) break;
+          size_type cv = cvind[l];
+          bgeot::pgeometric_trans pgt = msh.trans_of_convex(cv);
+          if (cv != last_cv) {
+            gic.init(msh.points_of_convex(cv), pgt);
+            last_cv = cv;
+          }
+          bool converged;
+          bool gicisin = gic.invert(pts[i], pt_ref, converged, EPS,
+                                    projection_into_element);
+          scalar_type isin = pgt->convex_ref()->is_in(pt_ref);
+          if ((extrapolation || gicisin)
+              && (cv_of_pt[i] == size_type(-1) || isin < dist)) {
+            cv_of_pt[i] = cv; ref_coords[i] = pt_ref; dist = isin;
+          }
+        }
+      }
+    };
+    if (nbchunks > 1) {
+      GETFEM_OMP_PARALLEL(locate_points(global_thread_policy::this_thread());)
+    } else locate_points(0);
+
+    if (extrapolation == 2) { // points outside the source mesh
+      mesh_trans_inv mti(msh, EPS);
+      for (size_type i = 0; i < nbpts; ++i)
+        if (cv_of_pt[i] == size_type(-1)) mti.add_point_with_id(pts[i], i);
+      if (mti.nb_points()) {
+        mti.distribute(extrapolation, rg_source);
+        std::vector<size_type> itab;
+        for (dal::bv_visitor cv(mf_source.convex_index()); !cv.finished();
+             ++cv) {
+          mti.points_on_convex(cv, itab);
+          for (size_type ipt : itab) {
+            size_type i = mti.id_of_point(ipt);
+            if (cv_of_pt[i] == size_type(-1)) {
+              cv_of_pt[i] = cv;
+              ref_coords[i] = mti.reference_coords()[ipt];
+            }
+          }
+        }
+      }
+    }
+
+    missed_ids.clear();
+    for (size_type i = 0; i < nbpts; ++i)
+      if (cv_of_pt[i] == size_type(-1)) missed_ids.add(pt_ids[i]);
+    if (missed_ids.card())
+      GMM_WARNING2("in interpolation plan (different meshes), "
+                   << missed_ids.card() << " points of target mesh_fem "
+                   << "have been missed\nmissing points : " << missed_ids);
+
+    // Rows of the interpolation matrix, computed by the partitions on
+    // their ranges of points and concatenated in the order of the points.
+    std::vector<std::vector<size_type> > chunk_cols(nbchunks);
+    std::vector<std::vector<scalar_type> > chunk_values(nbchunks);
+    row_ptr.assign(nbpts*qdim_s+1, 0);
+    auto interpolation_rows = [&](size_type c) {
+      if (c >= nbchunks) return;
+      base_matrix G, Mloc;
+      size_type last_cv = size_type(-1);
+      std::unique_ptr<fem_interpolation_context> pctx;
+      for (size_type i = (nbpts*c)/nbchunks; i < (nbpts*(c+1))/nbchunks;
+           ++i) {
+        size_type cv = cv_of_pt[i];
+        if (cv == size_type(-1)) continue;
+        pfem pf_s = mf_source.fem_of_element(cv);
+        if (cv != last_cv) {
+          if (pf_s->need_G())
+            bgeot::vectors_to_base_matrix(G, msh.points_of_convex(cv));
+          pctx = std::make_unique<fem_interpolation_context>
+            (msh.trans_of_convex(cv), pf_s, base_node(), G, cv,
+             short_type(-1));
+          last_cv = cv;
+        }
+        pctx->set_xref(ref_coords[i]);
+        const mesh_fem::ind_dof_ct &idct
+          = mf_source.ind_basic_dof_of_element(cv);
+        gmm::resize(Mloc, qdim_s, idct.size());
+        pf_s->interpolation(*pctx, Mloc, dim_type(qdim_s));
+        for (size_type k = 0; k < qdim_s; ++k) {
+          for (size_type j = 0; j < idct.size(); ++j)
+            if (Mloc(k, j) != scalar_type(0)) {
+              chunk_cols[c].push_back(idct[j]);
+              chunk_values[c].push_back(Mloc(k, j));
+              ++(row_ptr[i*qdim_s+k+1]);
+            }
+        }
+      }
+    };
+    if (nbchunks > 1) {
+      GETFEM_OMP_PARALLEL
+        (interpolation_rows(global_thread_policy::this_thread());)
+    } else interpolation_rows(0);
+
+    for (size_type r = 0; r+1 < row_ptr.size(); ++r)
+      row_ptr[r+1] += row_ptr[r];
+    col_ind.resize(row_ptr.back());
+    values.resize(row_ptr.back());
+    auto itc = col_ind.begin();
+    auto itv = values.begin();
+    for (size_type c = 0; c < nbchunks; ++c) {
+      itc = std::copy(chunk_cols[c].begin(), chunk_cols[c].end(), itc);
+      itv = std::copy(chunk_values[c].begin(), chunk_values[c].end(), itv);
+    }
+    plan_built = true;
+  }
+
 }  /* end of namespace getfem.                                             */
 
@@ -67,6 +67,12 @@ namespace getfem {
 
       return true;
     }
+    size_t hash() const override {
+      size_t h = dal::hash_combine(std::hash<pmat_elem_type>()(pmt),
+                                   std::hash<pintegration_method>()(ppi));
+      h = dal::hash_combine(h, std::hash<bgeot::pgeometric_trans>()(pgt));
+      return dal::hash_combine(h, prefer_comp_on_real_element);
+    }
     emelem_comp_key_(pmat_elem_type pm, pintegration_method pi,
                        bgeot::pgeometric_trans pg, bool on_relt)
     { pmt = pm; ppi = pi; pgt = pg; prefer_comp_on_real_element = on_relt; }
@@ -66,6 +66,18 @@ namespace getfem {
       auto &o = dynamic_cast<const mat_elem_type_key &>(oo);
       return *o.pmet == *pmet;
     }
+    size_t hash() const override {
+      size_t h = pmet->size();
+      for (const constituant &c : *pmet) {
+        h = dal::hash_combine(h, size_t(c.t));
+        if (c.t == GETFEM_NONLINEAR_) {
+          h = dal::hash_combine(h, std::hash<const void *>()(c.nlt));
+          h = dal::hash_combine(h, c.nl_part);
+        }
+        h = dal::hash_combine(h, std::hash<pfem>()(c.pfi));
+      }
+      return h;
+    }
     mat_elem_type_key(const mat_elem_type *p) : pmet(p) {}
   };
 
@@ -23,6 +23,7 @@
 #include "gmm/gmm_condition_number.h"
 #include "getfem/getfem_mesh.h"
 #include "getfem/getfem_integration.h"
+#include "getfem/getfem_binary_io.h"
 
 #if defined(GETFEM_HAVE_METIS_OLD_API)
 extern "C" void METIS_PartGraphKway(int *, int *, int *, int *, int *, int *,
@@ -127,6 +128,7 @@ namespace getfem {
     modified = true;
 #endif
     cuthill_mckee_uptodate = false;
+    v_num = act_counter();
   }
 
   mesh::mesh(const std::string name) : name_(name)  { init(); }
@@ -248,6 +250,14 @@ namespace getfem {
     }
   }
 
+  const std::vector<size_type> &mesh::cuthill_mckee_ordering() const {
+    if (!cuthill_mckee_uptodate) {
+      bgeot::cuthill_mckee_on_convexes(*this, cmk_order);
+      cuthill_mckee_uptodate = true;
+    }
+    return cmk_order;
+  }
+
   void mesh::translation(const base_small_vector &V)
   { pts.translation(V); touch(); }
 
@@ -497,6 +507,7 @@ namespace getfem {
     gmm::uint64_type d = act_counter();
     for (dal::bv_visitor i(convex_index()); !i.finished(); ++i)
       cvs_v_num[i] = d;
+    v_num = d;
     Bank_info = std::unique_ptr<Bank_info_struct>();
     if (m.Bank_info.get())
       Bank_info = std::make_unique<Bank_info_struct>(*(m.Bank_info));
@@ -652,6 +663,7 @@ namespace getfem {
   }
 
   void mesh::read_from_file(const std::string &name) {
+    if (is_binary_file(name)) { read_from_binary_file(name); return; }
     std::ifstream o(name.c_str());
     GMM_ASSERT1(o, "Mesh file '" << name << "' does not exist");
     read_from_file(o);
@@ -714,6 +726,123 @@ namespace getfem {
     o.close();
   }
 
+  void mesh::write_binary_sections(binary_file_writer &w) const {
+    std::vector<gmm::uint64_type> ids;
+    std::vector<scalar_type> coords;
+    for (size_type i = 0; i < points_tab.size(); ++i)
+      if (is_point_valid(i)) {
+        ids.push_back(i);
+        coords.insert(coords.end(), pts[i].begin(), pts[i].end());
+      }
+    w.begin_section(BINARY_MESH_NODES);
+    w.write(dim()); w.write(ids.size());
+    w.write_array(ids); w.write_array(coords);
+    w.end_section();
+
+    std::map<bgeot::pgeometric_trans, gmm::uint64_type> gt_num;
+    std::vector<std::string> gt_names;
+    std::vector<gmm::uint64_type> types, ptr(1, 0), ipts;
+    ids.resize(0);
+    for (dal::bv_visitor cv(convex_index()); !cv.finished(); ++cv) {
+      auto it = gt_num.find(trans_of_convex(cv));
+      if (it == gt_num.end()) {
+        it = gt_num.emplace(trans_of_convex(cv), gt_names.size()).first;
+        gt_names.push_back
+          (bgeot::name_of_geometric_trans(trans_of_convex(cv)));
+      }
+      ids.push_back(cv); types.push_back(it->second);
+      ipts.insert(ipts.end(), ind_points_of_convex(cv).begin(),
+                  ind_points_of_convex(cv).end());
+      ptr.push_back(ipts.size());
+    }
+    w.begin_section(BINARY_MESH_GEOTRANS);
+    w.write_strings(gt_names);
+    w.end_section();
+    w.begin_section(BINARY_MESH_CONVEXES);
+    w.write(ids.size());
+    w.write_array(ids); w.write_array(types);
+    w.write_array(ptr); w.write_array(ipts);
+    w.end_section();
+
+    std::vector<gmm::uint16_type> faces;
+    for (dal::bv_visitor bnum(valid_cvf_sets); !bnum.finished(); ++bnum) {
+      ids.resize(0); faces.resize(0);
+      for (mr_visitor i(region(bnum)); !i.finished(); ++i)
+        { ids.push_back(i.cv()); faces.push_back(i.f()); }
+      w.begin_section(BINARY_MESH_REGION);
+      w.write(bnum); w.write(ids.size());
+      w.write_array(ids); w.write_array(faces);
+      w.end_section();
+    }
+  }
+
+  void mesh::write_to_binary_file(const std::string &name) const {
+    std::ofstream o(name.c_str(), std::ios::binary);
+    GMM_ASSERT1(o, "impossible to write to file '" << name << "'");
+    binary_file_writer w(o);
+    write_binary_sections(w);
+  }
+
+  void mesh::read_binary_sections(const binary_file_reader &r) {
+    clear();
+    auto s = r.get_section(BINARY_MESH_NODES);
+    dim_type d = dim_type(s.read());
+    size_type n = size_type(s.read());
+    const gmm::uint64_type *ids = s.read_array<gmm::uint64_type>(n);
+    const scalar_type *coords = s.read_array<scalar_type>(n*d);
+    base_node v(d);
+    for (size_type i = 0; i < n; ++i, coords += d) {
+      GMM_ASSERT1(i == 0 || ids[i] > ids[i-1], "Unsorted point indices");
+      std::copy(coords, coords + d, v.begin());
+      // No search for existing points: they are distinct in the file.
+      size_type ipl = add_point(v, scalar_type(-1));
+      if (ipl != ids[i]) swap_points(ipl, size_type(ids[i]));
+    }
+
+    std::vector<bgeot::pgeometric_trans> pgts;
+    for (const std::string &gtname
+           : r.get_section(BINARY_MESH_GEOTRANS).read_strings())
+      pgts.push_back(bgeot::geometric_trans_descriptor(gtname));
+    s = r.get_section(BINARY_MESH_CONVEXES);
+    n = size_type(s.read());
+    ids = s.read_array<gmm::uint64_type>(n);
+    const gmm::uint64_type *types = s.read_array<gmm::uint64_type>(n);
+    const gmm::uint64_type *ptr = s.read_array<gmm::uint64_type>(n+1);
+    const gmm::uint64_type *ipts = s.read_array<gmm::uint64_type>(ptr[n]);
+    gmm::uint64_type vnum = act_counter();
+    for (size_type i = 0; i < n; ++i) {
+      GMM_ASSERT1(i == 0 || ids[i] > ids[i-1], "Unsorted convex indices");
+      GMM_ASSERT1(types[i] < pgts.size(), "Wrong geometric transformation");
+      bgeot::pgeometric_trans pgt = pgts[types[i]];
+      GMM_ASSERT1(ptr[i+1] - ptr[i] == pgt->nb_points(),
+                  "Wrong number of points for convex " << ids[i]);
+      for (size_type k = ptr[i]; k < ptr[i+1]; ++k)
+        GMM_ASSERT1(pts.index().is_in(ipts[k]), "Convex " << ids[i]
+                    << " refers to the missing point " << ipts[k]);
+      // Convexes of a mesh file are distinct, no need to search them.
+      size_type ic = bgeot::mesh_structure::add_convex_noverif
+        (pgt->structure(), ipts + ptr[i], size_type(ids[i]));
+      gtab[ic] = pgt; trans_exists[ic] = true; cvs_v_num[ic] = vnum;
+    }
+    touch();
+
+    for (size_type k = 0; k < r.nb_sections(BINARY_MESH_REGION); ++k) {
+      s = r.get_section(BINARY_MESH_REGION, k);
+      size_type bnum = size_type(s.read());
+      n = size_type(s.read());
+      ids = s.read_array<gmm::uint64_type>(n);
+      const gmm::uint16_type *faces = s.read_array<gmm::uint16_type>(n);
+      mesh_region &rg = region(bnum);
+      for (size_type i = 0; i < n; ++i)
+        rg.add(size_type(ids[i]), short_type(faces[i]));
+    }
+  }
+
+  void mesh::read_from_binary_file(const std::string &name) {
+    binary_file_reader r(name);
+    read_binary_sections(r);
+  }
+
   size_type mesh::memsize(void) const {
     return bgeot::mesh_structure::memsize() - sizeof(bgeot::mesh_structure)
       + pts.memsize() + (pts.index().last_true()+1)*dim()*sizeof(scalar_type)
@@ -814,12 +943,21 @@ namespace getfem {
     return q * sqrt(scalar_type(N)) / scalar_type(2);
   }
 
+  /* The face adjacency table of the whole mesh is built only if a large
+     part of it is visited. Otherwise, the neighbors are searched locally
+     (or in the table if it is already built).
+  */
+  static void build_connectivity_if_worth(const mesh &m, size_type nbcv) {
+    if (2 * nbcv >= m.nb_convex()) m.connectivity();
+  }
+
   /* extract faces of convexes which are not shared
       + convexes whose dimension is smaller that m.dim()
   */
   void
   outer_faces_of_mesh(const getfem::mesh &m, const dal::bit_vector& cvlst,
                       convex_face_ct& flist) {
+    build_connectivity_if_worth(m, cvlst.card());
     for (dal::bv_visitor ic(cvlst); !ic.finished(); ++ic) {
       if (m.structure_of_convex(ic)->dim() == m.dim()) {
         for (short_type f = 0; f < m.structure_of_convex(ic)->nb_faces(); f++) {
@@ -837,6 +975,7 @@ namespace getfem {
                             const mesh_region &cvlst,
                             mesh_region &flist) {
     cvlst.error_if_not_convexes();
+    build_connectivity_if_worth(m, cvlst.size());
     for (mr_visitor i(cvlst); !i.finished(); ++i) {
       if (m.structure_of_convex(i.cv())->dim() == m.dim()) {
         for (short_type f = 0; f < m.structure_of_convex(i.cv())->nb_faces();
@@ -877,6 +1016,7 @@ namespace getfem {
     mesh_region mrr;
     mr.from_mesh(m);
     mr.error_if_not_convexes();
+    build_connectivity_if_worth(m, mr.size());
     dal::bit_vector visited;
     bgeot::mesh_structure::ind_set neighbors;
 
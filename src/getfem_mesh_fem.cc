@@ -20,9 +20,11 @@
 
 
 #include <queue>
+#include <cstdint>
 #include "getfem/dal_singleton.h"
 #include "getfem/getfem_mesh_fem.h"
 #include "getfem/getfem_torus.h"
+#include "getfem/getfem_binary_io.h"
 
 namespace getfem {
 
@@ -318,6 +320,259 @@ namespace getfem {
 
   /// Enumeration of dofs
   void mesh_fem::enumerate_dof() const {
+    if (!hash_dof_enumeration || !enumerate_dof_hash())
+      enumerate_dof_kdtree();
+  }
+
+  /* Description of the dofs of the elements sharing the same finite element
+     method and geometric transformation. */
+  struct dof_enum_elt_type_ {
+    pfem pf;
+    bgeot::pgeometric_trans pgt;
+    bgeot::pgeotrans_precomp pgp;
+    size_type nbd;
+    std::vector<unsigned char> kind; // 0: global, 1: not linkable, 2: linkable
+    // For linkable dofs, local indices of the points of the element common
+    // to the faces of the dof (all the points for an internal dof).
+    std::vector<size_type> sup_ptr;
+    std::vector<short_type> sup;
+  };
+
+  /* Hash based enumeration of dofs. Two linkable dofs of different elements
+     are identified if they have the same support (the mesh points common to
+     the faces of the element on which the dof lies), the same location, the
+     same type and the same partition, which is equivalent to the neighbour
+     search of the kd-tree based algorithm. The dof locations and supports
+     are computed in parallel over blocks of elements, then the dofs are
+     numbered in a sequential pass in the order of the elements with a flat
+     hash table. The characteristic sizes of the elements and the distance
+     tolerance are those of the original algorithm, so that the numbering is
+     the same as long as the dofs shared by two elements have the same
+     support in both of them, which is the case on conforming meshes of
+     elements of the same dimension and degree.
+     Returns false when the method cannot be applied (fems defined on the
+     real element, mixed dimensions or degrees of geometric
+     transformations). */
+  bool mesh_fem::enumerate_dof_hash() const {
+    GMM_ASSERT1(linked_mesh_ != 0, "Uninitialized mesh_fem");
+    context_check();
+    if (fe_convex.card() == 0)
+      { dof_enumeration_made = true; nb_total_dof = 0; return true; }
+    const mesh &m = linked_mesh();
+    size_type N = m.dim();
+
+    // Elements and their types
+    std::vector<size_type> elts;
+    elts.reserve(fe_convex.card());
+    for (dal::bv_visitor cv(m.convex_index()); !cv.finished(); ++cv)
+      if (fe_convex.is_in(cv)) elts.push_back(cv);
+    size_type nbelt = elts.size();
+
+    std::vector<dof_enum_elt_type_> types;
+    std::vector<size_type> elt_type(nbelt), slot_ptr(nbelt+1, 0);
+    std::vector<size_type> supid_ptr(nbelt+1, 0);
+    size_type last_type = size_type(-1);
+    for (size_type k = 0; k < nbelt; ++k) {
+      size_type cv = elts[k];
+      pfem pf = fem_of_element(cv);
+      bgeot::pgeometric_trans pgt = m.trans_of_convex(cv);
+      if (last_type == size_type(-1) || types[last_type].pf != pf
+          || types[last_type].pgt != pgt) {
+        last_type = size_type(-1);
+        for (size_type j = 0; j < types.size(); ++j)
+          if (types[j].pf == pf && types[j].pgt == pgt) last_type = j;
+      }
+      if (last_type == size_type(-1)) {
+        // The supports of a dof in two neighbour elements may differ on
+        // meshes mixing dimensions or degrees of geometric transformations.
+        if (pf->is_on_real_element() || (types.size() &&
+            (types[0].pgt->dim() != pgt->dim()
+             || types[0].pgt->complexity() != pgt->complexity())))
+          return false;
+        types.push_back(dof_enum_elt_type_());
+        dof_enum_elt_type_ &t = types.back();
+        t.pf = pf; t.pgt = pgt; t.nbd = pf->nb_dof(cv);
+        bgeot::pstored_point_tab pspt = pf->node_tab(cv);
+        t.pgp = bgeot::geotrans_precomp(pgt, pspt, pf);
+        bgeot::pconvex_structure cvs = m.structure_of_convex(cv);
+        pdof_description andof = global_dof(pf->dim());
+        t.kind.resize(t.nbd);
+        t.sup_ptr.assign(1, 0);
+        for (size_type i = 0; i < t.nbd; ++i) {
+          pdof_description pnd = pf->dof_types()[i];
+          t.kind[i] = (pnd == andof) ? 0 : (dof_linkable(pnd) ? 2 : 1);
+          if (t.kind[i] == 2) {
+            const std::vector<short_type> &ftab = pf->faces_of_dof(cv, i);
+            if (ftab.size() == 0) {
+              for (short_type j = 0; j < cvs->nb_points(); ++j)
+                t.sup.push_back(j);
+            } else if (ftab.size() == 1) {
+              for (short_type j : cvs->ind_points_of_face(ftab[0]))
+                t.sup.push_back(j);
+            } else {
+              const bgeot::convex_ind_ct &ind
+                = cvs->ind_common_points_of_faces(ftab);
+              if (ind.size() == 0) return false;
+              for (short_type j : ind) t.sup.push_back(j);
+            }
+          }
+          t.sup_ptr.push_back(t.sup.size());
+        }
+        // Initializes the precomputed values before the parallel loop
+        if (t.nbd) t.pgp->val(0);
+        last_type = types.size() - 1;
+      }
+      elt_type[k] = last_type;
+      slot_ptr[k+1] = slot_ptr[k] + types[last_type].nbd;
+      supid_ptr[k+1] = supid_ptr[k] + types[last_type].sup.size();
+    }
+    size_type nbslots = slot_ptr[nbelt];
+
+    // Local phase: characteristic sizes of the elements, location and
+    // support of the linkable dofs, on contiguous blocks of elements.
+    std::vector<scalar_type> car_sizes(nbelt), coords(nbslots*N);
+    std::vector<size_type> sup_ids(supid_ptr[nbelt]), hashes(nbslots, 0);
+    size_type nbchunks = 1;
+    if (!me_is_multithreaded_now())
+      nbchunks = std::max(size_type(1), std::min(nbelt,
+                          global_thread_policy::num_threads()));
+    auto local_phase = [&](size_type c) {
+      if (c >= nbchunks) return;
+      base_node bmin(N), bmax(N);
+      for (size_type k = (nbelt*c)/nbchunks; k < (nbelt*(c+1))/nbchunks;
+           ++k) {
+        size_type cv = elts[k];
+        const dof_enum_elt_type_ &t = types[elt_type[k]];
+        auto pts = m.points_of_convex(cv);
+        // Same characteristic size as enumerate_dof_kdtree (the bounding
+        // box ignores the first coordinate), for the same tolerance.
+        gmm::copy(pts[0], bmin); gmm::copy(bmin, bmax);
+        for (const base_node &pt : pts)
+          for (size_type d = 1; d < N; ++d) {
+            bmin[d] = std::min(bmin[d], pt[d]);
+            bmax[d] = std::max(bmax[d], pt[d]);
+          }
+        car_sizes[k] = gmm::vect_dist2_sqr(bmin, bmax);
+        const std::vector<size_type> &ipts = m.ind_points_of_convex(cv);
+        for (size_type i = 0; i < t.nbd; ++i) {
+          if (t.kind[i] != 2) continue;
+          size_type slot = slot_ptr[k] + i;
+          const base_vector &val = t.pgp->val(i);
+          auto itc = coords.begin() + slot*N;
+          for (size_type l = 0; l < val.size(); ++l)
+            for (size_type d = 0; d < N; ++d) itc[d] += val[l] * pts[l][d];
+          auto it0 = sup_ids.begin() + supid_ptr[k] + t.sup_ptr[i];
+          auto it1 = sup_ids.begin() + supid_ptr[k] + t.sup_ptr[i+1];
+          auto itl = t.sup.begin() + t.sup_ptr[i];
+          for (auto it = it0; it != it1; ++it, ++itl) *it = ipts[*itl];
+          std::sort(it0, it1);
+          std::uint64_t h = 0;
+          for (auto it = it0; it != it1; ++it) { // splitmix64 mixing
+            h += std::uint64_t(*it) + 0x9E3779B97F4A7C15ULL;
+            h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+            h ^= h >> 31;
+          }
+          hashes[slot] = size_type(h);
+        }
+      }
+    };
+    if (nbchunks > 1) {
+      GETFEM_OMP_PARALLEL(local_phase(global_thread_policy::this_thread());)
+    } else local_phase(0);
+
+    // Sequential numbering in the order of the elements.
+    std::vector<size_type> slot_elt(nbslots), dof_of_slot(nbslots);
+    size_type nblinkable = 0;
+    for (size_type k = 0; k < nbelt; ++k)
+      for (size_type slot = slot_ptr[k]; slot < slot_ptr[k+1]; ++slot) {
+        slot_elt[slot] = k;
+        if (types[elt_type[k]].kind[slot - slot_ptr[k]] == 2) ++nblinkable;
+      }
+    size_type table_size = 16;
+    while (table_size < 2*nblinkable) table_size *= 2;
+    std::vector<size_type> table(table_size, size_type(-1));
+
+    auto same_dof = [&](size_type s1, size_type s2) {
+      size_type k1 = slot_elt[s1], k2 = slot_elt[s2];
+      size_type i1 = s1 - slot_ptr[k1], i2 = s2 - slot_ptr[k2];
+      const dof_enum_elt_type_ &t1 = types[elt_type[k1]];
+      const dof_enum_elt_type_ &t2 = types[elt_type[k2]];
+      size_type n1 = t1.sup_ptr[i1+1] - t1.sup_ptr[i1];
+      if (n1 != t2.sup_ptr[i2+1] - t2.sup_ptr[i2]) return false;
+      if (!std::equal(sup_ids.begin() + supid_ptr[k1] + t1.sup_ptr[i1],
+                      sup_ids.begin() + supid_ptr[k1] + t1.sup_ptr[i1] + n1,
+                      sup_ids.begin() + supid_ptr[k2] + t2.sup_ptr[i2]))
+        return false;
+      if (get_dof_partition(elts[k1]) != get_dof_partition(elts[k2]))
+        return false;
+      pdof_description pnd1 = t1.pf->dof_types()[i1];
+      pdof_description pnd2 = t2.pf->dof_types()[i2];
+      if (pnd1 != pnd2 && dof_description_compare(pnd1, pnd2) != 0)
+        return false;
+      scalar_type dist2(0);
+      for (size_type d = 0; d < N; ++d)
+        dist2 += gmm::sqr(coords[s1*N+d] - coords[s2*N+d]);
+      // Tolerance of the current element, as in the kd-tree search.
+      return dist2 <= 1e-6*car_sizes[k2];
+    };
+
+    is_uniform_ = true;
+    is_uniformly_vectorized_ = (get_qdim() > 1);
+    pfem first_pf = types[elt_type[0]].pf;
+    if (first_pf->target_dim() > 1) is_uniformly_vectorized_ = false;
+    size_type nbdof = 0;
+    dal::bit_vector encountered_global_dof;
+    dal::dynamic_array<size_type> ind_global_dof;
+    std::vector<size_type> itab;
+    dof_structure.clear();
+    for (size_type k = 0; k < nbelt; ++k) {
+      size_type cv = elts[k];
+      const dof_enum_elt_type_ &t = types[elt_type[k]];
+      pfem pf = t.pf;
+      if (pf != first_pf) is_uniform_ = false;
+      if (pf->target_dim() > 1) is_uniformly_vectorized_ = false;
+      size_type nbq = Qdim / pf->target_dim();
+      itab.resize(t.nbd);
+      for (size_type i = 0; i < t.nbd; ++i) {
+        size_type slot = slot_ptr[k] + i;
+        if (t.kind[i] == 0) {              // global dof
+          size_type num = pf->index_of_global_dof(cv, i);
+          if (!(encountered_global_dof[num])) {
+            ind_global_dof[num] = nbdof;
+            nbdof += nbq;
+            encountered_global_dof[num] = true;
+          }
+          itab[i] = ind_global_dof[num];
+        } else if (t.kind[i] == 1) {       // not linkable dof
+          itab[i] = nbdof;
+          nbdof += nbq;
+        } else {                           // standard linkable dof
+          size_type h = hashes[slot], idof = size_type(-1);
+          size_type pos = h & (table_size - 1);
+          for (; table[pos] != size_type(-1); pos = (pos+1) & (table_size-1))
+            if (hashes[table[pos]] == h && same_dof(table[pos], slot))
+              { idof = dof_of_slot[table[pos]]; break; }
+          if (idof == size_type(-1)) {
+            table[pos] = slot;
+            idof = nbdof;
+            nbdof += nbq;
+          }
+          itab[i] = idof;
+        }
+        dof_of_slot[slot] = itab[i];
+      }
+      dof_structure.add_convex_noverif(pf->structure(cv), itab.begin(), cv);
+    }
+
+    dof_enumeration_made = true;
+    nb_total_dof = nbdof;
+    return true;
+  }
+
+  /* Original enumeration of dofs, with a kd-tree per element storing the
+     linkable dofs of its already processed neighbours. */
+  void mesh_fem::enumerate_dof_kdtree() const {
     bgeot::index_node_pair ipt;
     is_uniform_ = true;
     is_uniformly_vectorized_ = (get_qdim() > 1);
@@ -485,6 +740,7 @@ namespace getfem {
     mi.resize(1); mi[0] = Q;
     linked_mesh_ = &me;
     use_reduction = false;
+    hash_dof_enumeration = true;
     this->add_dependency(me);
     v_num = v_num_update = act_counter();
   }
@@ -512,6 +768,7 @@ namespace getfem {
     v_num_update = mf.v_num_update;
     v_num = mf.v_num;
     use_reduction = mf.use_reduction;
+    hash_dof_enumeration = mf.hash_dof_enumeration;
   }
 
   mesh_fem::mesh_fem(const mesh_fem &mf) : context_dependencies() {
@@ -700,6 +957,7 @@ namespace getfem {
   }
 
   void mesh_fem::read_from_file(const std::string &name) {
+    if (is_binary_file(name)) { read_from_binary_file(name); return; }
     std::ifstream o(name.c_str());
     GMM_ASSERT1(o, "Mesh_fem file '" << name << "' does not exist");
     read_from_file(o);
@@ -790,6 +1048,159 @@ namespace getfem {
     write_to_file(o);
   }
 
+  template <typename MAT> static void
+  write_compressed_matrix(binary_file_writer &w, const MAT &M) {
+    std::vector<gmm::uint64_type> ir(M.ir.begin(), M.ir.end());
+    std::vector<gmm::uint64_type> jc(M.jc.begin(), M.jc.end());
+    w.write(M.nr); w.write(M.nc); w.write(M.pr.size());
+    w.write_array(jc); w.write_array(ir); w.write_array(M.pr);
+  }
+
+  template <typename MAT> static void
+  read_compressed_matrix(binary_file_reader::section &s, bool by_columns,
+                         MAT &M) {
+    M.nr = size_type(s.read()); M.nc = size_type(s.read());
+    size_type nnz = size_type(s.read());
+    size_type nptr = by_columns ? M.nc : M.nr;
+    const gmm::uint64_type *jc = s.read_array<gmm::uint64_type>(nptr+1);
+    const gmm::uint64_type *ir = s.read_array<gmm::uint64_type>(nnz);
+    const scalar_type *pr = s.read_array<scalar_type>(nnz);
+    M.jc.assign(jc, jc + nptr + 1);
+    M.ir.assign(ir, ir + nnz);
+    M.pr.assign(pr, pr + nnz);
+  }
+
+  void mesh_fem::write_basic_binary_sections(binary_file_writer &w) const {
+    std::map<pfem, gmm::uint64_type> fem_num;
+    std::vector<std::string> fem_names;
+    std::vector<gmm::uint64_type> ids, fems, ptr(1, 0), dofs;
+    std::vector<gmm::uint32_type> partition;
+    for (dal::bv_visitor cv(convex_index()); !cv.finished(); ++cv) {
+      pfem pf = fem_of_element(cv);
+      auto it = fem_num.find(pf);
+      if (it == fem_num.end()) {
+        it = fem_num.emplace(pf, fem_names.size()).first;
+        fem_names.push_back(name_of_fem(pf));
+      }
+      ids.push_back(cv); fems.push_back(it->second);
+      partition.push_back(get_dof_partition(cv));
+      // skip repeated dofs for "pseudo" vector elements
+      size_type step = size_type(get_qdim()) / pf->target_dim();
+      const ind_dof_ct &ind = ind_basic_dof_of_element(cv);
+      for (size_type i = 0; i < ind.size(); i += step) dofs.push_back(ind[i]);
+      ptr.push_back(dofs.size());
+    }
+    w.begin_section(BINARY_MF_FEMS);
+    w.write_strings(fem_names);
+    w.end_section();
+    w.begin_section(BINARY_MF_CONVEXES);
+    w.write(get_qdim()); w.write(ids.size());
+    w.write_array(ids); w.write_array(fems);
+    w.end_section();
+    if (!dof_partition.empty()) {
+      w.begin_section(BINARY_MF_DOF_PARTITION);
+      w.write(partition.size()); w.write_array(partition);
+      w.end_section();
+    }
+    w.begin_section(BINARY_MF_DOF_ENUMERATION);
+    w.write(nb_basic_dof()); w.write(ids.size());
+    w.write_array(ptr); w.write_array(dofs);
+    w.end_section();
+  }
+
+  void mesh_fem::write_reduction_binary_section(binary_file_writer &w) const {
+    if (use_reduction) {
+      w.begin_section(BINARY_MF_REDUCTION);
+      write_compressed_matrix(w, R_);
+      write_compressed_matrix(w, E_);
+      w.end_section();
+    }
+  }
+
+  void mesh_fem::write_binary_sections(binary_file_writer &w) const {
+    context_check();
+    write_basic_binary_sections(w);
+    write_reduction_binary_section(w);
+  }
+
+  void mesh_fem::read_binary_sections(const binary_file_reader &r) {
+    GMM_ASSERT1(linked_mesh_ != 0, "Uninitialized mesh_fem");
+    clear();
+    std::vector<pfem> pfems;
+    for (const std::string &name
+           : r.get_section(BINARY_MF_FEMS).read_strings()) {
+      pfems.push_back(fem_descriptor(name));
+      GMM_ASSERT1(pfems.back(), "could not create the FEM '" << name << "'");
+    }
+    auto s = r.get_section(BINARY_MF_CONVEXES);
+    set_qdim(dim_type(s.read()));
+    size_type n = size_type(s.read());
+    const gmm::uint64_type *ids = s.read_array<gmm::uint64_type>(n);
+    const gmm::uint64_type *fems = s.read_array<gmm::uint64_type>(n);
+    for (size_type i = 0; i < n; ++i) {
+      GMM_ASSERT1(linked_mesh().convex_index().is_in(ids[i]), "Convex "
+                  << ids[i] << " does not exist, are you sure "
+                  "that the mesh attached to this object is right one ?");
+      GMM_ASSERT1(fems[i] < pfems.size(), "Wrong fem for convex " << ids[i]);
+      set_finite_element(size_type(ids[i]), pfems[fems[i]]);
+    }
+
+    if (r.nb_sections(BINARY_MF_DOF_PARTITION)) {
+      s = r.get_section(BINARY_MF_DOF_PARTITION);
+      GMM_ASSERT1(s.read() == n, "Wrong dof partition size");
+      const gmm::uint32_type *part = s.read_array<gmm::uint32_type>(n);
+      for (size_type i = 0; i < n; ++i)
+        set_dof_partition(size_type(ids[i]), unsigned(part[i]));
+    }
+
+    if (r.nb_sections(BINARY_MF_DOF_ENUMERATION)) {
+      s = r.get_section(BINARY_MF_DOF_ENUMERATION);
+      size_type nbdof = size_type(s.read());
+      GMM_ASSERT1(s.read() == n, "Wrong dof enumeration size");
+      const gmm::uint64_type *ptr = s.read_array<gmm::uint64_type>(n+1);
+      const gmm::uint64_type *dofs = s.read_array<gmm::uint64_type>(ptr[n]);
+      dof_structure.clear(); dof_enumeration_made = false;
+      is_uniform_ = true;
+      size_type nbdof_unif = size_type(-1);
+      for (size_type i = 0; i < n; ++i) {
+        size_type cv = size_type(ids[i]);
+        pfem pf = fem_of_element(cv);
+        GMM_ASSERT1(ptr[i+1] - ptr[i] == pf->nb_dof(cv),
+                    "Wrong number of dofs in dof enumeration of " << cv);
+        size_type nbd = nb_basic_dof_of_element(cv);
+        if (nbdof_unif == size_type(-1))
+          nbdof_unif = nbd;
+        else if (nbdof_unif != nbd)
+          is_uniform_ = false;
+        dof_structure.add_convex_noverif(pf->structure(cv), dofs + ptr[i], cv);
+      }
+      dof_enumeration_made = true;
+      touch(); v_num = act_counter();
+      nb_total_dof = nbdof;
+    }
+
+    if (r.nb_sections(BINARY_MF_REDUCTION)) {
+      s = r.get_section(BINARY_MF_REDUCTION);
+      read_compressed_matrix(s, true, R_);
+      read_compressed_matrix(s, false, E_);
+      use_reduction = true;
+    }
+  }
+
+  void mesh_fem::write_to_binary_file(const std::string &name,
+                                      bool with_mesh) const {
+    std::ofstream o(name.c_str(), std::ios::binary);
+    GMM_ASSERT1(o, "impossible to open file '" << name << "'");
+    binary_file_writer w(o);
+    if (with_mesh) linked_mesh().write_binary_sections(w);
+    write_binary_sections(w);
+  }
+
+  void mesh_fem::read_from_binary_file(const std::string &name) {
+    binary_file_reader r(name);
+    read_binary_sections(r);
+  }
+
   struct mf__key_ : public context_dependencies {
     const mesh *pmsh;
     dim_type order, qdim;
@@ -874,6 +1285,63 @@ namespace getfem {
   { return dal::singleton<dummy_mesh_fem_>::instance().mf; }
 
 
+  void color_convexes_by_dofs(const std::vector<const mesh_fem *> &mfs,
+                              const dal::bit_vector &cvs,
+                              std::vector<dal::bit_vector> &colors) {
+    colors.resize(0);
+    std::vector<std::vector<dal::bit_vector> > used_dofs; // [color][mf]
+    for (dal::bv_visitor cv(cvs); !cv.finished(); ++cv) {
+      size_type c = 0;
+      for (; c < colors.size(); ++c) {
+        bool conflict = false;
+        for (size_type i = 0; i < mfs.size() && !conflict; ++i)
+          if (mfs[i]->convex_index().is_in(cv))
+            for (const size_type &dof : mfs[i]->ind_basic_dof_of_element(cv))
+              if (used_dofs[c][i].is_in(dof)) { conflict = true; break; }
+        if (!conflict) break;
+      }
+      if (c == colors.size()) {
+        colors.push_back(dal::bit_vector());
+        used_dofs.push_back(std::vector<dal::bit_vector>(mfs.size()));
+      }
+      colors[c].add(cv);
+      for (size_type i = 0; i < mfs.size(); ++i)
+        if (mfs[i]->convex_index().is_in(cv))
+          for (const size_type &dof : mfs[i]->ind_basic_dof_of_element(cv))
+            used_dofs[c][i].add(dof);
+    }
+  }
+
+  void rigid_body_modes(const mesh_fem &mf, base_matrix &B) {
+    size_type nbd = mf.nb_basic_dof(), Q = mf.get_qdim();
+    size_type N = mf.linked_mesh().dim();
+    size_type nbm = (Q == N) ? (N * (N+1)) / 2 : Q;
+    base_matrix BB(nbd, nbm);
+    base_node c(N);
+    for (size_type i = 0; i < nbd; i += Q) c += mf.point_of_basic_dof(i);
+    if (nbd) c /= scalar_type(nbd / Q);
+    for (size_type i = 0; i < nbd; ++i) {
+      size_type k = i % Q;
+      BB(i, k) = scalar_type(1);
+      if (Q == N && N > 1) {
+        base_node x = mf.point_of_basic_dof(i) - c;
+        if (N == 2)
+          BB(i, 2) = (k == 0) ? -x[1] : x[0];
+        else if (N == 3) { // rotations around e_z, e_x and e_y
+          if (k == 0) { BB(i, 3) = -x[1]; BB(i, 5) = x[2]; }
+          if (k == 1) { BB(i, 3) = x[0]; BB(i, 4) = -x[2]; }
+          if (k == 2) { BB(i, 4) = x[1]; BB(i, 5) = -x[0]; }
+        } else
+          GMM_ASSERT1(false, "Rigid body modes only in dimension 2 and 3");
+      }
+    }
+    gmm::resize(B, mf.nb_dof(), nbm);
+    if (mf.is_reduced())
+      gmm::mult(mf.reduction_matrix(), BB, B);
+    else
+      gmm::copy(BB, B);
+  }
+
   void vectorize_base_tensor(const base_tensor &t, base_matrix &vt,
                              size_type ndof, size_type qdim, size_type N) {
     GMM_ASSERT1(qdim == N || qdim == 1, "mixed intrinsic vector and "
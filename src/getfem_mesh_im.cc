@@ -19,6 +19,7 @@
 ===========================================================================*/
 
 #include "getfem/getfem_mesh_im.h"
+#include "getfem/getfem_mesh_fem.h"
 
 
 namespace getfem {
@@ -225,6 +226,26 @@ namespace getfem {
     o.close();
   }
 
+  void balance_region_partitions(mesh_region &rg, const mesh_im &mim,
+                                 const mesh_fem *mf) {
+    const mesh &m = mim.linked_mesh();
+    rg.from_mesh(m);
+    const dal::bit_vector &cvs = mim.convex_index();
+    std::vector<scalar_type> costs(cvs.last_true()+1, scalar_type(0));
+    for (dal::bv_visitor cv(cvs); !cv.finished(); ++cv) {
+      pintegration_method pim = mim.int_method_of_element(cv);
+      scalar_type c(1);
+      if (pim->type() == IM_APPROX)
+        c = scalar_type(std::max(pim->approx_method()->nb_points_on_convex(),
+                                 size_type(1)));
+      if (mf && mf->convex_index().is_in(cv))
+        c *= scalar_type(std::max(mf->nb_basic_dof_of_element(cv),
+                                  size_type(1)));
+      costs[cv] = c;
+    }
+    rg.set_partition_costs(costs, m.cuthill_mckee_ordering());
+  }
+
   struct dummy_mesh_im_ {
     mesh_im mim;
     dummy_mesh_im_() : mim() {}
@@ -27,40 +27,53 @@ namespace getfem {
   using face_bitset = mesh_region::face_bitset;
 
   mesh_region::mesh_region(const mesh_region &other)
-    : p(std::make_shared<impl>()), id_(size_type(-2)), parent_mesh(0) {
+    : p(std::make_shared<impl>()), id_(size_type(-2)), parent_mesh(0),
+    part_owner(nullptr), part_stamp{0}, part_nb{0} {
     this->operator=(other);
   }
 
   mesh_region::mesh_region()
     : p(std::make_shared<impl>()), id_(size_type(-2)), type_(size_type(-1)),
-    partitioning_allowed{true}, parent_mesh(nullptr){
+    partitioning_allowed{true}, parent_mesh(nullptr),
+    part_owner(nullptr), part_stamp{0}, part_nb{0} {
     if (me_is_multithreaded_now()) prohibit_partitioning();
     mark_region_changed();
   }
 
   mesh_region::mesh_region(size_type id__) : id_(id__), type_(size_type(-1)),
-    partitioning_allowed{true}, parent_mesh(nullptr){
+    partitioning_allowed{true}, parent_mesh(nullptr),
+    part_owner(nullptr), part_stamp{0}, part_nb{0} {
     mark_region_changed();
   }
 
   mesh_region::mesh_region(mesh& m, size_type id__, size_type type) :
     p(std::make_shared<impl>()), id_(id__), type_(type),
-    partitioning_allowed{true}, parent_mesh(&m){
+    partitioning_allowed{true}, parent_mesh(&m),
+    part_owner(nullptr), part_stamp{0}, part_nb{0} {
     if (me_is_multithreaded_now()) prohibit_partitioning();
     mark_region_changed();
   }
 
   mesh_region::mesh_region(const dal::bit_vector &bv)
     : p(std::make_shared<impl>()), id_(size_type(-2)), type_(size_type(-1)),
-    partitioning_allowed{true}, parent_mesh(nullptr){
+    partitioning_allowed{true}, parent_mesh(nullptr),
+    part_owner(nullptr), part_stamp{0}, part_nb{0} {
     if (me_is_multithreaded_now()) prohibit_partitioning();
     add(bv);
     mark_region_changed();
   }
 
+  static std::atomic<size_type> region_stamp_counter{0};
+
   void mesh_region::mark_region_changed() const{
+    /* The stamp is stored in the shared data, so that the partitions of
+       all the mesh_region objects sharing it are invalidated. */
+    if (p) rp().stamp.store(++region_stamp_counter, std::memory_order_release);
+    invalidate_index();
+  }
+
+  void mesh_region::invalidate_index() const{
     index_updated.all_threads() = false;
-    partitions_updated.all_threads() = false;
     serial_index_updated = false;
   }
 
@@ -82,7 +95,7 @@ namespace getfem {
         *r = m.region(id_);
       }
     }
-    mark_region_changed();
+    invalidate_index();
     return *this;
   }
 
@@ -142,61 +155,109 @@ namespace getfem {
     else return {};
   }
 
-  void mesh_region::update_partition_iterators() const{
-    if ((partitions_updated.thrd_cast() == true)) return;
-    itbegin = partition_begin();
-    itend = partition_end  ();
-    partitions_updated = true;
+  bool mesh_region::partitions_valid(size_type nb_parts) const{
+    return part_owner.load(std::memory_order_acquire) == p.get()
+      && part_stamp.load(std::memory_order_relaxed)
+         == rp().stamp.load(std::memory_order_acquire)
+      && part_nb.load(std::memory_order_relaxed) == nb_parts;
   }
-  mesh_region::const_iterator
-    mesh_region::partition_begin( ) const{
-    auto region_size = rp().m.size();
-    if (region_size < partitions_updated.num_threads()){
-      //for small regions: put the whole region into zero thread
-      if (partitions_updated.this_thread() == 0) return rp().m.begin();
-      else return rp().m.end();
+
+  void mesh_region::update_partitions() const{
+    size_type nb_parts = global_thread_policy::num_threads();
+    if (partitions_valid(nb_parts)) return;
+
+    GLOBAL_OMP_GUARD
+
+    if (partitions_valid(nb_parts)) return;
+    part_owner.store(nullptr, std::memory_order_release);
+
+    const map_t &m = rp().m;
+    part_bounds.clear();
+    part_maps.clear();
+
+    if (rp().costs.empty()) {
+      // equal number of entries in each partition, found in a single pass.
+      size_type region_size = m.size();
+      part_bounds.resize(nb_parts + 1, m.end());
+      part_bounds[0] = m.begin();
+      if (region_size < nb_parts) {
+        //for small regions: put the whole region into zero thread
+        for (size_type i = 1; i <= nb_parts; ++i) part_bounds[i] = m.end();
+      } else {
+        auto partition_size = static_cast<size_type>
+          (std::ceil(static_cast<scalar_type>(region_size)/
+                     static_cast<scalar_type >(nb_parts)));
+        auto it = m.begin();
+        size_type i = 0, k = 1;
+        for (; it != m.end() && k < nb_parts; ++it, ++i)
+          if (i == partition_size * k) part_bounds[k++] = it;
+      }
+    } else {
+      // contiguous chunks of the traversal order with balanced costs.
+      const std::vector<scalar_type> &costs = rp().costs;
+      std::vector<const_iterator> seq;
+      seq.reserve(m.size());
+      dal::bit_vector done;
+      for (size_type cv : rp().cv_order) {
+        auto it = m.find(cv);
+        if (it != m.end() && !done.is_in(cv))
+          { seq.push_back(it); done.add(cv); }
+      }
+      for (auto it = m.begin(); it != m.end(); ++it)
+        if (!done.is_in(it->first)) seq.push_back(it);
+
+      std::vector<scalar_type> w(seq.size());
+      scalar_type total = scalar_type(0);
+      for (size_type i = 0; i < seq.size(); ++i) {
+        size_type cv = seq[i]->first;
+        w[i] = (cv < costs.size() ? costs[cv] : scalar_type(1))
+          * scalar_type(std::max(seq[i]->second.count(), size_t(1)));
+        total += w[i];
+      }
+
+      part_maps.resize(nb_parts);
+      scalar_type acc = scalar_type(0);
+      size_type k = 0;
+      for (size_type i = 0; i < seq.size(); ++i) {
+        while (k + 1 < nb_parts && total > scalar_type(0)
+               && acc >= total * scalar_type(k+1) / scalar_type(nb_parts))
+          ++k;
+        part_maps[k].insert(*(seq[i]));
+        acc += w[i];
+      }
     }
-    auto partition_size = static_cast<size_type>
-      (std::ceil(static_cast<scalar_type>(region_size)/
-       static_cast<scalar_type >(partitions_updated.num_threads())));
-    auto index_begin = partition_size * partitions_updated.this_thread();
-    if (index_begin >= region_size ) return rp().m.end();
 
-    auto it = rp().m.begin();
-    for (size_type i = 0; i != index_begin; ++i) ++it;
-    return it;
+    part_stamp.store(rp().stamp.load(), std::memory_order_relaxed);
+    part_nb.store(nb_parts, std::memory_order_relaxed);
+    part_owner.store(p.get(), std::memory_order_release);
   }
 
   mesh_region::const_iterator
-    mesh_region::partition_end( ) const{
-    auto region_size = rp().m.size();
-    if (region_size< partitions_updated.num_threads()) return rp().m.end();
-
-    auto partition_size = static_cast<size_type>
-      (std::ceil(static_cast<scalar_type>(region_size)/
-       static_cast<scalar_type >(partitions_updated.num_threads())));
-    auto index_end = partition_size * (partitions_updated.this_thread() + 1);
-    if (index_end >= region_size ) return  rp().m.end();
+    mesh_region::partition_begin( ) const{
+    update_partitions();
+    size_type t = global_thread_policy::this_thread();
+    if (!part_maps.empty()) return part_maps[t].begin();
+    return part_bounds[t];
+  }
 
-    auto it = rp().m.begin();
-    for (size_type i = 0; i < index_end && it != rp().m.end(); ++i) ++it;
-    return it;
+  mesh_region::const_iterator
+    mesh_region::partition_end( ) const{
+    update_partitions();
+    size_type t = global_thread_policy::this_thread();
+    if (!part_maps.empty()) return part_maps[t].end();
+    return part_bounds[t+1];
   }
 
   mesh_region::const_iterator mesh_region::begin() const{
     GMM_ASSERT1(p != 0, "Internal error");
-    if (me_is_multithreaded_now() && partitioning_allowed){
-      update_partition_iterators();
-      return itbegin;
-    }
+    if (me_is_multithreaded_now() && partitioning_allowed)
+      return partition_begin();
     else return rp().m.begin();
   }
 
   mesh_region::const_iterator mesh_region::end() const{
-    if (me_is_multithreaded_now() && partitioning_allowed){
-      update_partition_iterators();
-      return itend;
-    }
+    if (me_is_multithreaded_now() && partitioning_allowed)
+      return partition_end();
     else return rp().m.end();
   }
 
@@ -224,6 +285,16 @@ namespace getfem {
     return partitioning_allowed;
   }
 
+  void mesh_region::set_partition_costs(const std::vector<scalar_type> &costs,
+                                        const std::vector<size_type> &order){
+    GMM_ASSERT1(p, "Use from_mesh on that region before");
+    GMM_ASSERT1(!me_is_multithreaded_now(),
+                "Partition costs cannot be changed in a parallel section");
+    wp().costs = costs;
+    wp().cv_order = costs.empty() ? std::vector<size_type>() : order;
+    mark_region_changed();
+  }
+
   void mesh_region::update_index() const{
     auto& convex_index = me_is_multithreaded_now() ?
                            rp().index_.thrd_cast() : rp().serial_index_;
@@ -347,33 +347,32 @@ namespace getfem {
 
   void stored_mesh_slice::merge_nodes() const {
     size_type count = 0;
-    mesh mp;
+    bgeot::node_tab pts;
     clear_merged_nodes();
-    std::vector<size_type> iv;
     std::vector<const slice_node*> nv(nb_points());
     to_merged_index.resize(nb_points());
     for (cvlst_ct::const_iterator it = cvlst.begin(); it != cvlst.end(); ++it) {
       for (size_type i=0; i < it->nodes.size(); ++i) {
         nv[count] = &it->nodes[i];
-        to_merged_index[count++] = mp.add_point(it->nodes[i].pt);
+        to_merged_index[count++] = pts.add_node(it->nodes[i].pt, 0.);
         // cout << "orig[" << count-1 << "] = " << nv[count-1]->pt
         //      << ", idx=" << to_merged_index[count-1] << "\n";
       }
     }
-    gmm::sorted_indexes(to_merged_index,iv);
-    //cout << "to_merged_index = " << iv << "\n";
+    /* counting sort of the nodes by merged index, the nodes of a merged
+       node being kept in the order of the slice */
+    merged_nodes_idx.assign(pts.card()+1, 0);
+    for (size_type i=0; i < nb_points(); ++i)
+      merged_nodes_idx[to_merged_index[i]+1]++;
+    for (size_type i=0; i < pts.card(); ++i)
+      merged_nodes_idx[i+1] += merged_nodes_idx[i];
     merged_nodes.resize(nb_points());
-    merged_nodes_idx.reserve(nb_points()/8);
-    
-    merged_nodes_idx.push_back(0);
+    std::vector<size_type> pos(merged_nodes_idx.begin(),
+                               merged_nodes_idx.end()-1);
     for (size_type i=0; i < nb_points(); ++i) {
-      merged_nodes[i].P = nv[iv[i]];
-      merged_nodes[i].pos = unsigned(iv[i]);
-      // cout << "i=" << i << " -> {" << merged_nodes[i].P->pt
-      //      << "," << merged_nodes[i].pos << "}\n";
-      if (i == nb_points()-1 ||
-          to_merged_index[iv[i+1]] != to_merged_index[iv[i]]) 
-        merged_nodes_idx.push_back(i+1);
+      merged_node_t &mn = merged_nodes[pos[to_merged_index[i]]++];
+      mn.P = nv[i];
+      mn.pos = unsigned(i);
     }
     //cout << "merged_nodes_idx = " << merged_nodes_idx << "\n";
     merged_nodes_available = true;
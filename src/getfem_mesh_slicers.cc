@@ -114,13 +114,13 @@ namespace getfem {
     base_vector coeff;
     base_matrix G;
     bool ref_pts_changed = false;
-    if (ms.cvr != ms.prev_cvr
-        || defdata->pmf->fem_of_element(ms.cv) != pf) {
-      pf = defdata->pmf->fem_of_element(ms.cv);
-      if (pf->need_G()) 
-        bgeot::vectors_to_base_matrix
-          (G, defdata->pmf->linked_mesh().points_of_convex(ms.cv));
-    }
+    deformation_data &d = data;
+    pfem &pf = d.pf;
+    std::vector<base_node> &ref_pts = d.ref_pts;
+    pf = defdata->pmf->fem_of_element(ms.cv);
+    if (pf->need_G()) 
+      bgeot::vectors_to_base_matrix
+        (G, defdata->pmf->linked_mesh().points_of_convex(ms.cv));
     /* check that the points are still the same 
      * -- or recompute the fem_precomp */
     std::vector<base_node> ref_pts2; ref_pts2.reserve(ms.nodes_index.card());
@@ -133,10 +133,10 @@ namespace getfem {
     if (ref_pts2.size() != ref_pts.size()) ref_pts_changed = true;
     if (ref_pts_changed) {
       ref_pts.swap(ref_pts2);
-      fprecomp.clear();
+      d.fprecomp->clear();
     }
     bgeot::pstored_point_tab pspt = store_point_tab(ref_pts);
-    pfem_precomp pfp = fprecomp(pf, pspt);
+    pfem_precomp pfp = (*(d.fprecomp))(pf, pspt);
     defdata->copy(ms.cv, coeff);
     
     base_vector val(ms.m.dim());
@@ -197,7 +197,7 @@ namespace getfem {
                                     std::bitset<32> spin, std::bitset<32> spbin) {
     scalar_type alpha = 0; size_type iA=0, iB = 0;
     bool intersection = false;
-    static int level = 0;
+    THREAD_SAFE_STATIC int level = 0;
 
     level++;    
     /*
@@ -225,7 +225,7 @@ namespace getfem {
       n.faces = A.faces & B.faces;
       size_type nn = ms.nodes.size();
       ms.nodes.push_back(n); /* invalidate A and B.. */
-      pt_bin.add(nn); pt_in.add(nn);
+      pt_bin.thrd_cast().add(nn); pt_in.thrd_cast().add(nn);
       
       std::bitset<32> spin2(spin), spbin2(spbin); 
       std::swap(s.inodes[iA],nn);
@@ -276,6 +276,7 @@ namespace getfem {
     //cerr << "\n----\nslicer_volume::slice : entree, splx_in=" << splx_in << endl;
     if (ms.splx_in.card() == 0) return;
     prepare(ms.cv,ms.nodes,ms.nodes_index);
+    const dal::bit_vector &in = pt_in, &bin = pt_bin;
     for (dal::bv_visitor_c cnt(ms.splx_in); !cnt.finished(); ++cnt) {
       slice_simplex& s = ms.simplexes[cnt];
       /*cerr << "\n--------slicer_volume::slice : slicing convex " << cnt << endl;
@@ -286,8 +287,8 @@ namespace getfem {
       size_type in_cnt = 0, in_bcnt = 0;
       std::bitset<32> spin, spbin;
       for (size_type i=0; i < s.dim()+1; ++i) {
-        if (pt_in.is_in(s.inodes[i])) { ++in_cnt; spin.set(i); }
-        if (pt_bin.is_in(s.inodes[i])) { ++in_bcnt; spbin.set(i); }
+        if (in.is_in(s.inodes[i])) { ++in_cnt; spin.set(i); }
+        if (bin.is_in(s.inodes[i])) { ++in_bcnt; spbin.set(i); }
       }
 
       if (in_cnt == 0) {
@@ -299,11 +300,11 @@ namespace getfem {
     }
 
     /* signalement des points qui se trouvent pile-poil sur la bordure */
-    if (pt_bin.card()) {
+    if (bin.card()) {
       GMM_ASSERT1(ms.fcnt != dim_type(-1), 
                   "too much {faces}/{slices faces} in the convex " << ms.cv 
                   << " (nbfaces=" << ms.fcnt << ")");
-      for (dal::bv_visitor cnt(pt_bin); !cnt.finished(); ++cnt) {
+      for (dal::bv_visitor cnt(bin); !cnt.finished(); ++cnt) {
         ms.nodes[cnt].faces.set(ms.fcnt);
       }
       ms.fcnt++;
@@ -385,9 +386,11 @@ namespace getfem {
   void slicer_isovalues::prepare(size_type cv,
                                  const mesh_slicer::cs_nodes_ct& nodes, 
                                  const dal::bit_vector& nodes_index) {
-    pt_in.clear(); pt_bin.clear();
+    dal::bit_vector &in = pt_in, &bin = pt_bin;
+    std::vector<scalar_type> &U = Uval;
+    in.clear(); bin.clear();
     std::vector<base_node> refpts(nodes.size());
-    Uval.resize(nodes.size());
+    U.resize(nodes.size());
     base_vector coeff;
     base_matrix G;
     pfem pf = mfU->pmf->fem_of_element(cv);
@@ -407,11 +410,11 @@ namespace getfem {
       v[0] = 0;
       ctx.set_ii(i);
       pf->interpolation(ctx, coeff, v, mfU->pmf->get_qdim());
-      Uval[i] = v[0];
+      U[i] = v[0];
       // optimisable -- les bit_vectors sont lents..
-      pt_bin[i] = (gmm::abs(Uval[i] - val) < EPS * val_scaling);
-      pt_in[i] = (Uval[i] - val < 0); if (orient>0) pt_in[i] = !pt_in[i]; 
-      pt_in[i] = pt_in[i] || pt_bin[i];
+      bin[i] = (gmm::abs(U[i] - val) < EPS * val_scaling);
+      in[i] = (U[i] - val < 0); if (orient>0) in[i] = !in[i]; 
+      in[i] = in[i] || bin[i];
       // cerr << "cv=" << cv << ", node["<< i << "]=" << nodes[i].pt
       //      << ", Uval[i]=" << Uval[i] << ", pt_in[i]=" << pt_in[i]
       //      << ", pt_bin[i]=" << pt_bin[i] << endl;
@@ -421,10 +424,11 @@ namespace getfem {
   scalar_type
   slicer_isovalues::edge_intersect(size_type iA, size_type iB,
                                    const mesh_slicer::cs_nodes_ct&) const {
-    assert(iA < Uval.size() && iB < Uval.size());
-    if (((Uval[iA] < val) && (Uval[iB] > val)) ||
-        ((Uval[iA] > val) && (Uval[iB] < val)))
-      return (val-Uval[iA])/(Uval[iB]-Uval[iA]);
+    const std::vector<scalar_type> &U = Uval;
+    assert(iA < U.size() && iB < U.size());
+    if (((U[iA] < val) && (U[iB] > val)) ||
+        ((U[iA] > val) && (U[iB] < val)))
+      return (val-U[iA])/(U[iB]-U[iA]);
     else
       return 1./EPS;
   }
@@ -579,9 +583,11 @@ namespace getfem {
   /* -------------------- member functions of mesh_slicer -------------- */
 
   mesh_slicer::mesh_slicer(const mesh_level_set &mls_) :
-    m(mls_.linked_mesh()), mls(&mls_), pgt(0), cvr(0) {}
+    m(mls_.linked_mesh()), mls(&mls_), pgt(0), cvr(0), cvm(0), cvms(0),
+    pgp(0), prev_nrefine(0), prev_discont(true) {}
   mesh_slicer::mesh_slicer(const mesh& m_) : 
-    m(m_), mls(0), pgt(0), cvr(0) {}
+    m(m_), mls(0), pgt(0), cvr(0), cvm(0), cvms(0), pgp(0), prev_nrefine(0),
+    prev_discont(true) {}
 
   void mesh_slicer::using_mesh_level_set(const mesh_level_set &mls_) { 
     mls = &mls_;
@@ -646,17 +652,25 @@ namespace getfem {
     discont = (mls && mls->is_convex_cut(cv));
   }
 
-  void mesh_slicer::apply_slicers() {
+  void mesh_slicer::init_indexes() {
     simplex_index.clear(); simplex_index.add(0, simplexes.size());
     splx_in = simplex_index;
     nodes_index.clear(); nodes_index.add(0, nodes.size());      
-    for (size_type i=0; i < action.size(); ++i) {
+  }
+
+  void mesh_slicer::apply_actions(size_type i0, size_type i1) {
+    for (size_type i=i0; i < i1; ++i) {
       action[i]->exec(*this);
       //cout << "simplex_index=" << simplex_index << "\n   splx_in=" << splx_in << "\n";
       assert(simplex_index.contains(splx_in));
     }
   }
 
+  void mesh_slicer::apply_slicers() {
+    init_indexes();
+    apply_actions(0, action.size());
+  }
+
   void mesh_slicer::simplex_orientation(slice_simplex& s) {
     size_type N = m.dim();
     if (s.dim() == N) {
@@ -835,104 +849,160 @@ namespace getfem {
     return tmp_mesh_struct;
   }
 
-  void mesh_slicer::exec_(const short_type *pnrefine, 
-                          int nref_stride, 
-                          const mesh_region& cvlst) {
-    std::vector<base_node> cvm_pts;
-    const bgeot::basic_mesh *cvm = 0;
-    const bgeot::mesh_structure *cvms = 0;
-    bgeot::geotrans_precomp_pool gppool;
-    bgeot::pgeotrans_precomp pgp = 0;
-    std::vector<slice_node::faces_ct> points_on_faces;
-    bool prev_discont = true;
-
-    cvlst.from_mesh(m);
-    size_type prev_nrefine = 0;
-    // size_type prev_cv = size_type(-1);
-    for (mr_visitor it(cvlst); !it.finished(); ++it) {
-      size_type nrefine = pnrefine[it.cv()*nref_stride];
-      update_cv_data(it.cv(),it.f());
-      bool revert_orientation = check_orient(cv, pgt,m);
-
-      /* update structure-dependent data */
-      /* TODO : fix levelset handling when slicing faces .. */
-      if (prev_cvr != cvr || nrefine != prev_nrefine
-          || discont || prev_discont) {
-        if (discont) {
-          cvm = &refined_simplex_mesh_for_convex_cut_by_level_set
-            (mls->mesh_of_convex(cv), unsigned(nrefine));
-        } else {
-          cvm = bgeot::refined_simplex_mesh_for_convex(cvr,short_type(nrefine));
-        }
-        cvm_pts.resize(cvm->points().card());
-        std::copy(cvm->points().begin(), cvm->points().end(), cvm_pts.begin());
-        pgp = gppool(pgt, store_point_tab(cvm_pts));
-        flag_points_on_faces(cvr, cvm_pts, points_on_faces);
-        prev_nrefine = nrefine;
+  void mesh_slicer::init_convex(size_type cv_, short_type f_,
+                                short_type nrefine) {
+    update_cv_data(cv_, f_);
+    bool revert_orientation = check_orient(cv, pgt,m);
+
+    /* update structure-dependent data */
+    /* TODO : fix levelset handling when slicing faces .. */
+    if (prev_cvr != cvr || nrefine != prev_nrefine
+        || discont || prev_discont) {
+      if (discont) {
+        cvm = &refined_simplex_mesh_for_convex_cut_by_level_set
+          (mls->mesh_of_convex(cv), unsigned(nrefine));
+      } else {
+        cvm = bgeot::refined_simplex_mesh_for_convex(cvr, nrefine);
       }
-      if (face < dim_type(-1)) {
-        if (!discont) {
-          cvms = bgeot::refined_simplex_mesh_for_convex_faces
-            (cvr, short_type(nrefine))[face].get();
-        } else {
-          cvms = &refined_simplex_mesh_for_convex_faces_cut_by_level_set(face);
-        }
+      cvm_pts.resize(cvm->points().card());
+      std::copy(cvm->points().begin(), cvm->points().end(), cvm_pts.begin());
+      pgp = gppool(pgt, store_point_tab(cvm_pts));
+      flag_points_on_faces(cvr, cvm_pts, points_on_faces);
+      prev_nrefine = nrefine;
+    }
+    if (face < dim_type(-1)) {
+      if (!discont) {
+        cvms = bgeot::refined_simplex_mesh_for_convex_faces
+          (cvr, nrefine)[face].get();
       } else {
-        cvms = cvm; 
+        cvms = &refined_simplex_mesh_for_convex_faces_cut_by_level_set(face);
       }
+    } else {
+      cvms = cvm; 
+    }
 
-      /* apply the initial geometric transformation */
-      std::vector<size_type> ptsid(cvm_pts.size()); std::fill(ptsid.begin(), ptsid.end(), size_type(-1));
-      simplexes.resize(cvms->nb_convex());
-      nodes.resize(0);
-
-      base_node G;
-      for (size_type snum = 0; snum < cvms->nb_convex(); ++snum) { 
-        /* cvms should not contain holes in its convex index.. */
-        simplexes[snum].inodes.resize(cvms->nb_points_of_convex(snum));
-        std::copy(cvms->ind_points_of_convex(snum).begin(),
-                  cvms->ind_points_of_convex(snum).end(), simplexes[snum].inodes.begin());
-        if (revert_orientation) std::swap(simplexes[snum].inodes[0],simplexes[snum].inodes[1]);
-        /* store indices of points which are really used , and renumbers them */
-        if (discont) {
-          G.resize(m.dim()); G.fill(0.);
-          for (std::vector<size_type>::iterator itp = 
-                 simplexes[snum].inodes.begin();
-               itp != simplexes[snum].inodes.end(); ++itp) {
-            G += cvm_pts[*itp];
-          }
-          G /= scalar_type(simplexes[snum].inodes.size());
-        }
+    /* apply the initial geometric transformation */
+    std::vector<size_type> ptsid(cvm_pts.size()); std::fill(ptsid.begin(), ptsid.end(), size_type(-1));
+    simplexes.resize(cvms->nb_convex());
+    nodes.resize(0);
 
+    base_node G;
+    for (size_type snum = 0; snum < cvms->nb_convex(); ++snum) { 
+      /* cvms should not contain holes in its convex index.. */
+      simplexes[snum].inodes.resize(cvms->nb_points_of_convex(snum));
+      std::copy(cvms->ind_points_of_convex(snum).begin(),
+                cvms->ind_points_of_convex(snum).end(), simplexes[snum].inodes.begin());
+      if (revert_orientation) std::swap(simplexes[snum].inodes[0],simplexes[snum].inodes[1]);
+      /* store indices of points which are really used , and renumbers them */
+      if (discont) {
+        G.resize(m.dim()); G.fill(0.);
         for (std::vector<size_type>::iterator itp = 
                simplexes[snum].inodes.begin();
              itp != simplexes[snum].inodes.end(); ++itp) {
-          if (discont || ptsid[*itp] == size_type(-1)) {
-            ptsid[*itp] = nodes.size();
-            nodes.push_back(slice_node());
-            if (!discont) {
-              nodes.back().pt_ref = cvm_pts[*itp];
-            } else {
-              /* displace the ref point such that one will not interpolate
-                 on the discontinuity (yes this is quite ugly and not 
-                 robust) 
-              */
-              nodes.back().pt_ref = cvm_pts[*itp] + 0.01*(G - cvm_pts[*itp]);
-            }
-            nodes.back().faces = points_on_faces[*itp];
-            nodes.back().pt.resize(m.dim()); nodes.back().pt.fill(0.);
-            pgp->transform(m.points_of_convex(cv), *itp, nodes.back().pt);
-            //nodes.back().pt = pgt->transform(G, m.points_of_convex(cv));
-            //cerr << "G = " << G << " -> pt = " << nodes.back().pt << "\n";
+          G += cvm_pts[*itp];
+        }
+        G /= scalar_type(simplexes[snum].inodes.size());
+      }
+
+      for (std::vector<size_type>::iterator itp = 
+             simplexes[snum].inodes.begin();
+           itp != simplexes[snum].inodes.end(); ++itp) {
+        if (discont || ptsid[*itp] == size_type(-1)) {
+          ptsid[*itp] = nodes.size();
+          nodes.push_back(slice_node());
+          if (!discont) {
+            nodes.back().pt_ref = cvm_pts[*itp];
+          } else {
+            /* displace the ref point such that one will not interpolate
+               on the discontinuity (yes this is quite ugly and not 
+               robust) 
+            */
+            nodes.back().pt_ref = cvm_pts[*itp] + 0.01*(G - cvm_pts[*itp]);
           }
-          *itp = ptsid[*itp];
+          nodes.back().faces = points_on_faces[*itp];
+          nodes.back().pt.resize(m.dim()); nodes.back().pt.fill(0.);
+          pgp->transform(m.points_of_convex(cv), *itp, nodes.back().pt);
+          //nodes.back().pt = pgt->transform(G, m.points_of_convex(cv));
+          //cerr << "G = " << G << " -> pt = " << nodes.back().pt << "\n";
         }
+        *itp = ptsid[*itp];
       }
-      //cerr << "cv = " << cv << ", cvm.nb_points_ = "<< cvm->points().size() << ", nbnodes = " << nodes.size() << ", nb_simpl=" << simplexes.size() << "\n";
+    }
+    //cerr << "cv = " << cv << ", cvm.nb_points_ = "<< cvm->points().size() << ", nbnodes = " << nodes.size() << ", nb_simpl=" << simplexes.size() << "\n";
+    prev_discont = discont;
+  }
 
-      apply_slicers();
-      // prev_cv = it.cv();
-      prev_discont = discont;
+  /* state of a convex after the thread safe actions */
+  struct convex_slice_state {
+    size_type fcnt;
+    mesh_slicer::cs_nodes_ct nodes;
+    mesh_slicer::cs_simplexes_ct simplexes;
+    dal::bit_vector simplex_index, nodes_index, splx_in;
+  };
+
+  void mesh_slicer::exec_(const short_type *pnrefine, 
+                          int nref_stride, 
+                          const mesh_region& cvlst) {
+    cvlst.from_mesh(m);
+    prev_nrefine = 0; prev_discont = true;
+
+    size_type nbpar = 0, nbth = 1;
+    while (nbpar < action.size() && action[nbpar]->is_thread_safe()) ++nbpar;
+    if (nbpar && !me_is_multithreaded_now())
+      nbth = global_thread_policy::num_threads();
+
+    if (nbth < 2) {
+      for (mr_visitor it(cvlst); !it.finished(); ++it) {
+        init_convex(it.cv(), it.f(), pnrefine[it.cv()*nref_stride]);
+        apply_slicers();
+      }
+      return;
+    }
+
+    /* The leading thread safe actions are applied by one slicer per
+       thread on contiguous ranges of convexes, by blocks in order to
+       limit the memory used by the buffers. The other actions are then
+       applied in the order of the convexes. */
+    std::vector<std::pair<size_type, short_type> > cvf;
+    for (mr_visitor it(cvlst); !it.finished(); ++it)
+      cvf.push_back(std::make_pair(it.cv(), it.f()));
+    std::vector<std::unique_ptr<mesh_slicer> > workers(nbth);
+    for (size_type t = 0; t < nbth; ++t) {
+      workers[t] = std::make_unique<mesh_slicer>(m);
+      workers[t]->mls = mls;
+      for (size_type i = 0; i < nbpar; ++i)
+        workers[t]->push_back_action(*(action[i]));
+    }
+    const size_type block = 256 * nbth;
+    std::vector<convex_slice_state> states;
+    for (size_type c0 = 0; c0 < cvf.size(); c0 += block) {
+      size_type nc = std::min(block, cvf.size() - c0);
+      states.resize(nc);
+      auto slice_range = [&](size_type t) {
+        if (t >= nbth) return;
+        mesh_slicer &w = *(workers[t]);
+        for (size_type i = (nc*t)/nbth; i < (nc*(t+1))/nbth; ++i) {
+          size_type cv_ = cvf[c0+i].first;
+          w.init_convex(cv_, cvf[c0+i].second, pnrefine[cv_*nref_stride]);
+          w.apply_slicers();
+          convex_slice_state &st = states[i];
+          st.fcnt = w.fcnt;
+          st.nodes.swap(w.nodes); st.simplexes.swap(w.simplexes);
+          st.simplex_index.swap(w.simplex_index);
+          st.nodes_index.swap(w.nodes_index); st.splx_in.swap(w.splx_in);
+        }
+      };
+      GETFEM_OMP_PARALLEL(slice_range(global_thread_policy::this_thread());)
+
+      for (size_type i = 0; i < nc; ++i) {
+        convex_slice_state &st = states[i];
+        update_cv_data(cvf[c0+i].first, cvf[c0+i].second);
+        fcnt = st.fcnt;
+        nodes.swap(st.nodes); simplexes.swap(st.simplexes);
+        simplex_index.swap(st.simplex_index);
+        nodes_index.swap(st.nodes_index); splx_in.swap(st.splx_in);
+        apply_actions(nbpar, action.size());
+      }
     }
   }
 
@@ -1012,7 +1082,7 @@ namespace getfem {
     scalar_type a,b,c; // a*x^2 + b*x + c = 0
     a = gmm::vect_norm2_sqr(B-A);
     if (a < EPS)
-      return pt_bin.is_in(iA) ? 0. : 1./EPS;
+      return pt_bin.thrd_cast().is_in(iA) ? 0. : 1./EPS;
     b = 2*gmm::vect_sp(A-x0,B-A);
     c = gmm::vect_norm2_sqr(A-x0)-R*R;
     return slicer_volume::trinom(a,b,c);
@@ -1044,7 +1114,7 @@ namespace getfem {
     scalar_type Dd = gmm::vect_sp(D,d);
     scalar_type a = gmm::vect_norm2_sqr(D) - gmm::sqr(Dd);
     if (a < EPS)
-      return pt_bin.is_in(iA) ? 0. : 1./EPS;
+      return pt_bin.thrd_cast().is_in(iA) ? 0. : 1./EPS;
     assert(a> -EPS);
     scalar_type b = 2*(gmm::vect_sp(F,D) - Fd*Dd);
     scalar_type c = gmm::vect_norm2_sqr(F) - gmm::sqr(Fd) - gmm::sqr(R);
@@ -35,6 +35,7 @@ namespace getfem {
   public:
     typedef typename PLSOLVER::element_type::MATRIX MATRIX;
     typedef typename PLSOLVER::element_type::VECTOR VECTOR;
+    typedef typename PLSOLVER::element_type::CSC_MATRIX CSC_MATRIX;
     typedef typename gmm::linalg_traits<VECTOR>::value_type T;
     typedef typename gmm::number_traits<T>::magnitude_type R;
 
@@ -64,8 +65,13 @@ namespace getfem {
       else if (mult != R(0))  gmm::add(gmm::scaled(extra_rhs, mult), rhs);
     }
 
+    // Compressed copy of K, if any.
+    virtual const CSC_MATRIX *compressed_K() const { return nullptr; }
+
     virtual void linear_solve(VECTOR &dr, gmm::iteration &iter) {
-      (*linear_solver)(K, dr, rhs, iter);
+      const CSC_MATRIX *KC = compressed_K();
+      if (KC) (*linear_solver)(K, *KC, dr, rhs, iter);
+      else (*linear_solver)(K, dr, rhs, iter);
     }
 
     pb_base(PLSOLVER linsolv, const MATRIX &K_, VECTOR &rhs_)
@@ -73,6 +79,13 @@ namespace getfem {
     virtual ~pb_base() {}
   };
 
+  // Compressed copy of the tangent matrix kept by the model.
+  static const gmm::csc_matrix<scalar_type> *
+  compressed_tangent_matrix(const model &md, scalar_type)
+  { return md.real_tangent_matrix_csc(); }
+  static const gmm::csc_matrix<complex_type> *
+  compressed_tangent_matrix(const model &, complex_type) { return nullptr; }
+
   /* ***************************************************************** */
   /*     Linear model problem.                                         */
   /* ***************************************************************** */
@@ -84,6 +97,9 @@ namespace getfem {
     using typename pb_base<PLSOLVER>::R;
     using pb_base<PLSOLVER>::state_vector;
     using pb_base<PLSOLVER>::linear_solve;
+    using typename pb_base<PLSOLVER>::CSC_MATRIX;
+    const CSC_MATRIX *compressed_K() const
+    { return compressed_tangent_matrix(md, typename pb_base<PLSOLVER>::T()); }
     void compute_all() { md.assembly(model::BUILD_ALL); }
     lin_model_pb(model &, PLSOLVER) = delete;
   };
@@ -125,6 +141,9 @@ namespace getfem {
     using pb_base<PLSOLVER>::add_to_residual;
     using pb_base<PLSOLVER>::perturbation;
     using pb_base<PLSOLVER>::linear_solve;
+    using typename pb_base<PLSOLVER>::CSC_MATRIX;
+    const CSC_MATRIX *compressed_K() const
+    { return compressed_tangent_matrix(md, typename pb_base<PLSOLVER>::T()); }
 
     virtual R approx_external_load_norm() { return md.approx_external_load(); }
 
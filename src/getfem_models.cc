@@ -36,7 +36,10 @@ namespace getfem {
   model::model(bool comp_version) {
     init(); complex_version = comp_version;
     is_linear_ = is_symmetric_ = is_coercive_ = true;
-    leading_dim = 0;
+    leading_dim = 0; colored_assembly_ = false;
+    reuse_tangent_pattern_ = tangent_pattern_valid_ = false;
+    rTM_csc_valid_ = false;
+    generic_assembly_cache_ = false;
     time_integration = 0; init_step = false; time_step = scalar_type(1);
     add_interpolate_transformation
       ("neighbour_elt", interpolate_transformation_neighbor_instance());
@@ -328,6 +331,8 @@ namespace getfem {
         v.second.set_size();
       }
 
+    tangent_pattern_valid_ = rTM_csc_valid_ = false;
+    invalidate_generic_workspaces();
     if (complex_version) {
       gmm::resize(cTM, primary_size, primary_size);
       gmm::resize(crhs, primary_size);
@@ -950,10 +955,11 @@ namespace getfem {
   void model::add_macro(const std::string &name, const std::string &expr) {
     check_name_validity(name.substr(0, name.find("(")));
     macro_dict.add_macro(name, expr);
+    invalidate_generic_workspaces();
   }
 
   void model::del_macro(const std::string &name)
-  { macro_dict.del_macro(name); }
+  { macro_dict.del_macro(name); invalidate_generic_workspaces(); }
 
   void model::delete_brick(size_type ib) {
      GMM_ASSERT1(valid_bricks[ib], "Inexistent brick");
@@ -2051,6 +2057,29 @@ namespace getfem {
     as.varname = varname; as.expr = expr; as.region = rg; as.order = order;
     as.before = before;
     assignments.push_back(as);
+    invalidate_generic_workspaces();
+  }
+
+  void model::invalidate_generic_workspaces() const {
+    generic_workspaces.on_thread_update();
+    generic_workspaces.all_threads() = std::shared_ptr<ga_workspace>();
+    cached_generic_expressions.clear();
+  }
+
+  void model::update_generic_workspaces() const {
+    bool same = (generic_expressions.size()
+                 == cached_generic_expressions.size());
+    for (auto it1 = generic_expressions.begin(),
+           it2 = cached_generic_expressions.begin();
+         same && it1 != generic_expressions.end(); ++it1, ++it2)
+      same = (it1->expr == it2->expr && &(it1->mim) == &(it2->mim)
+              && it1->region == it2->region
+              && it1->secondary_domain == it2->secondary_domain);
+    if (!same) {
+      invalidate_generic_workspaces();
+      for (const auto &ge : generic_expressions)
+        cached_generic_expressions.push_back(ge);
+    }
   }
 
   void model::add_temporaries(const varnamelist &vl,
@@ -2327,6 +2356,134 @@ namespace getfem {
 
 
 
+  // Set to zero the stored entries of a col_matrix<rsvector>, keeping
+  // its sparsity pattern.
+  template <typename MAT> static void clear_stored_values(MAT &M) {
+    typedef typename gmm::linalg_traits<MAT>::value_type T;
+    for (size_type j = 0; j < gmm::mat_ncols(M); ++j)
+      for (auto &elt : M.col(j)) elt.e = T(0);
+  }
+
+  // Copy of the values of rTM into rTM_csc, whose structure is only built
+  // again when the pattern of rTM has changed.
+  void model::update_tangent_matrix_csc() const {
+    size_type nc = gmm::mat_ncols(rTM), nr = gmm::mat_nrows(rTM);
+    bool same_pattern = (rTM_csc.ncols() == nc && rTM_csc.nrows() == nr);
+    for (size_type j = 0; same_pattern && j < nc; ++j) {
+      const auto &col = rTM.col(j);
+      size_type k = rTM_csc.jc[j];
+      if (rTM_csc.jc[j+1] - k != col.size()) { same_pattern = false; break; }
+      for (const auto &elt : col) {
+        if (rTM_csc.ir[k] != elt.c) { same_pattern = false; break; }
+        rTM_csc.pr[k++] = elt.e;
+      }
+    }
+    if (!same_pattern) rTM_csc.init_with(rTM);
+    rTM_csc_valid_ = true;
+  }
+
+  bool model::coloring_cache_struct::is_up_to_date
+  (const std::list<gen_expr> &ges) const {
+    if (!valid || ges.size() != exprs.size()) return false;
+    size_type i = 0;
+    for (const auto &ge : ges) {
+      if (ge.expr != exprs[i] || &(ge.mim) != mims[i]
+          || ge.region != regions[i]) return false;
+      ++i;
+    }
+    for (const auto &mv : meshes)
+      if (mv.first->version_number() != mv.second) return false;
+    for (const auto &mfv : mfs)
+      if (mfv.first->version_number() != mfv.second) return false;
+    return true;
+  }
+
+  const std::vector<std::vector<mesh_region> > *
+  model::colored_expression_regions() const {
+    coloring_cache_struct &cc = coloring_cache;
+    if (cc.is_up_to_date(generic_expressions))
+      return cc.colorable ? &(cc.rgs) : nullptr;
+
+    cc.valid = true; cc.colorable = false;
+    cc.exprs.clear(); cc.mims.clear(); cc.regions.clear();
+    cc.meshes.clear(); cc.mfs.clear(); cc.rgs.clear();
+    for (const auto &ge : generic_expressions) {
+      cc.exprs.push_back(ge.expr);
+      cc.mims.push_back(&(ge.mim));
+      cc.regions.push_back(ge.region);
+    }
+
+    ga_workspace workspace(*this);
+    for (const auto &ge : generic_expressions) {
+      if (ge.secondary_domain.size()) return nullptr;
+      workspace.add_expression(ge.expr, ge.mim, ge.region, 2);
+    }
+
+    // mesh_fems of the test functions on each mesh
+    std::map<const mesh *, std::vector<const mesh_fem *> > mfs;
+    for (size_type i = 0; i < workspace.nb_trees(); ++i) {
+      const ga_workspace::tree_description &td = workspace.tree_info(i);
+      if (td.interpolate_name_test1.size() || td.interpolate_name_test2.size()
+          || td.secondary_domain.size()) return nullptr;
+      std::vector<const mesh_fem *> &mfl = mfs[td.m];
+      for (const std::string &name : {td.name_test1, td.name_test2}) {
+        if (name.size() == 0) continue;
+        const mesh_fem *mf = workspace.associated_mf(name);
+        if (!mf) {
+          if (!(workspace.associated_im_data(name))) return nullptr;
+        } else {
+          if (mf->is_reduced() || &(mf->linked_mesh()) != td.m)
+            return nullptr;
+          if (std::find(mfl.begin(), mfl.end(), mf) == mfl.end())
+            mfl.push_back(mf);
+        }
+      }
+    }
+
+    for (const auto &ge : generic_expressions) {
+      const mesh *m = &(ge.mim.linked_mesh());
+      if (std::find_if(cc.meshes.begin(), cc.meshes.end(),
+                       [m](const std::pair<const mesh *, gmm::uint64_type> &p)
+                       { return p.first == m; }) == cc.meshes.end())
+        cc.meshes.push_back(std::make_pair(m, m->version_number()));
+    }
+    for (const auto &mmf : mfs)
+      for (const mesh_fem *mf : mmf.second)
+        cc.mfs.push_back(std::make_pair(mf, mf->version_number()));
+
+    std::map<const mesh *, std::vector<dal::bit_vector> > colors;
+    size_type nb_colors = 0;
+    for (const auto &mmf : mfs) {
+      dal::bit_vector cvs;
+      for (const auto &ge : generic_expressions)
+        if (&(ge.mim.linked_mesh()) == mmf.first) {
+          mesh_region rg(ge.region);
+          rg.from_mesh(*(mmf.first));
+          cvs |= rg.index();
+        }
+      std::vector<dal::bit_vector> &cl = colors[mmf.first];
+      color_convexes_by_dofs(mmf.second, cvs, cl);
+      nb_colors = std::max(nb_colors, cl.size());
+    }
+    GMM_TRACE2("Colored assembly with " << nb_colors << " colors");
+
+    cc.rgs.assign(nb_colors, std::vector<mesh_region>());
+    for (size_type c = 0; c < nb_colors; ++c)
+      for (const auto &ge : generic_expressions) {
+        const mesh &m = ge.mim.linked_mesh();
+        auto it = colors.find(&m);
+        if (it != colors.end() && c < it->second.size()) {
+          mesh_region rg(ge.region);
+          rg.from_mesh(m);
+          cc.rgs[c].push_back(mesh_region::intersection
+                              (rg, mesh_region(it->second[c])));
+        } else
+          cc.rgs[c].push_back(mesh_region());
+      }
+    cc.colorable = true;
+    return &(cc.rgs);
+  }
+
   void model::assembly(build_version version) {
 
     GMM_ASSERT1(version != BUILD_ON_DATA_CHANGE,
@@ -2344,12 +2501,22 @@ namespace getfem {
 #endif
 
     context_check(); if (act_size_to_be_done) actualize_sizes();
+    bool keep_pattern = reuse_tangent_pattern_ && tangent_pattern_valid_;
+    if (version & BUILD_MATRIX) {
+      if (keep_pattern) tangent_slots_.recorded.on_thread_update();
+      else tangent_slots_.clear();
+      rTM_csc_valid_ = false;
+    }
     if (is_complex()) {
-      if (version & BUILD_MATRIX) gmm::clear(cTM);
+      if (version & BUILD_MATRIX) {
+        if (keep_pattern) clear_stored_values(cTM); else gmm::clear(cTM);
+      }
       if (version & BUILD_RHS) gmm::clear(crhs);
     }
     else {
-      if (version & BUILD_MATRIX) gmm::clear(rTM);
+      if (version & BUILD_MATRIX) {
+        if (keep_pattern) clear_stored_values(rTM); else gmm::clear(rTM);
+      }
       if (version & BUILD_RHS) gmm::clear(rrhs);
     }
     clear_dof_constraints();
@@ -2664,6 +2831,25 @@ namespace getfem {
                                    2, ge.secondary_domain);
       };
 
+      // Workspace of the current partition, either built for this assembly
+      // or kept from the previous one
+      if (generic_assembly_cache_) update_generic_workspaces();
+      auto partition_workspace = [&](std::unique_ptr<ga_workspace> &pws)
+        -> ga_workspace & {
+        if (!generic_assembly_cache_) {
+          pws.reset(new ga_workspace(*this));
+          add_assignments_and_expressions_to_workspace(*pws);
+          return *pws;
+        }
+        std::shared_ptr<ga_workspace> &sws = generic_workspaces.thrd_cast();
+        if (!sws) {
+          sws = std::make_shared<ga_workspace>(*this);
+          add_assignments_and_expressions_to_workspace(*sws);
+          sws->enable_compilation_cache();
+        }
+        return *sws;
+      };
+
       const bool with_internal = version & BUILD_WITH_INTERNAL
                                  && has_internal_variables();
       model_real_sparse_matrix intern_mat; // temp for extracting condensation info
@@ -2678,20 +2864,55 @@ namespace getfem {
       if (version & BUILD_MATRIX && with_internal)
         gmm::resize(res1, full_size);
 
-      if (version & BUILD_MATRIX) {
+      const std::vector<std::vector<mesh_region> > *color_regions
+        = (colored_assembly_ && !with_internal && assignments.empty())
+        ? colored_expression_regions() : nullptr;
+      if (color_regions) {
+        // The elements of a color share no dof: all the threads assemble
+        // directly into rTM and res0.
+        for (const auto &rgs : *color_regions) {
+          GETFEM_OMP_PARALLEL( // running the assembly in parallel
+            ga_workspace workspace(*this);
+            auto itrg = rgs.begin();
+            for (const auto &ge : generic_expressions) {
+              if (!(itrg->is_empty()))
+                workspace.add_expression(ge.expr, ge.mim, *itrg, 2);
+              ++itrg;
+            }
+            if (version & BUILD_RHS) {
+              workspace.set_assembled_vector(res0);
+              workspace.assembly(1);
+            }
+            if (version & BUILD_MATRIX) {
+              workspace.set_assembled_matrix(rTM);
+              workspace.set_assembled_matrix_slots
+                (keep_pattern ? &tangent_slots_ : nullptr);
+              workspace.assembly(2);
+            }
+          ) // end GETFEM_OMP_PARALLEL
+          if (keep_pattern && (version & BUILD_MATRIX))
+            tangent_slots_.merge();
+        }
+      }
+      else if (version & BUILD_MATRIX) {
         if (with_internal) {
           gmm::resize(intern_mat, full_size, primary_size);
           gmm::resize(res1, full_size);
         }
         accumulated_distro<decltype(rTM)> tangent_matrix_distro(rTM);
+        // The recorded positions are only valid in rTM itself
+        auto tangent_slots = [&]() -> ga_matrix_slots * {
+          return (keep_pattern && &(tangent_matrix_distro.get()) == &rTM)
+            ? &tangent_slots_ : nullptr;
+        };
         accumulated_distro<decltype(intern_mat)> intern_mat_distro(intern_mat);
         accumulated_distro<model_real_plain_vector> res1_distro(res1);
 
         if (version & BUILD_RHS) { // both BUILD_RHS & BUILD_MATRIX
           accumulated_distro<model_real_plain_vector> res0_distro(res0);
           GETFEM_OMP_PARALLEL( // running the assembly in parallel
-            ga_workspace workspace(*this);
-            add_assignments_and_expressions_to_workspace(workspace);
+            std::unique_ptr<ga_workspace> pws;
+            ga_workspace &workspace = partition_workspace(pws);
             workspace.set_assembled_vector(res0_distro);
             workspace.assembly(1, with_internal);
             if (with_internal) { // Condensation reads from/writes to rhs
@@ -2702,13 +2923,14 @@ namespace getfem {
               workspace.set_internal_coupling_matrix(intern_mat_distro);
             }
             workspace.set_assembled_matrix(tangent_matrix_distro);
+            workspace.set_assembled_matrix_slots(tangent_slots());
             workspace.assembly(2, with_internal);
           ) // end GETFEM_OMP_PARALLEL
         } // end of res0_distro scope
         else { // only BUILD_MATRIX
           GETFEM_OMP_PARALLEL( // running the assembly in parallel
-            ga_workspace workspace(*this);
-            add_assignments_and_expressions_to_workspace(workspace);
+            std::unique_ptr<ga_workspace> pws;
+            ga_workspace &workspace = partition_workspace(pws);
             if (with_internal) { // Condensation reads from/writes to rhs
               gmm::copy(gmm::scaled(full_rrhs, scalar_type(-1)),
                         res1_distro.get()); // initial value residual=-rhs (actually only the internal variables residual is needed)
@@ -2716,15 +2938,17 @@ namespace getfem {
               workspace.set_internal_coupling_matrix(intern_mat_distro);
             }
             workspace.set_assembled_matrix(tangent_matrix_distro);
+            workspace.set_assembled_matrix_slots(tangent_slots());
             workspace.assembly(2, with_internal);
           ) // end GETFEM_OMP_PARALLEL
         }
+        if (keep_pattern) tangent_slots_.merge();
       } // end of tangent_matrix_distro, intern_mat_distro, res1_distro scope
       else if (version & BUILD_RHS) {
         accumulated_distro<model_real_plain_vector> res0_distro(res0);
         GETFEM_OMP_PARALLEL( // running the assembly in parallel
-          ga_workspace workspace(*this);
-          add_assignments_and_expressions_to_workspace(workspace);
+          std::unique_ptr<ga_workspace> pws;
+          ga_workspace &workspace = partition_workspace(pws);
           workspace.set_assembled_vector(res0_distro);
           workspace.assembly(1, with_internal);
         ) // end GETFEM_OMP_PARALLEL
@@ -2871,6 +3095,12 @@ namespace getfem {
       }
     }
 
+    if (version & BUILD_MATRIX) {
+      tangent_pattern_valid_ = true;
+      if (reuse_tangent_pattern_ && !is_complex())
+        update_tangent_matrix_csc();
+    }
+
     if (version & BUILD_RHS) {
        // some contributions are added only in the master process
        // send the correct result to all other processes
@@ -21,6 +21,7 @@
 #include "getfem/dal_singleton.h"
 #include "getfem/getfem_locale.h"
 #include "getfem/getfem_omp.h"
+#include <chrono>
 
 #ifdef GETFEM_HAS_OPENMP
   #include <thread>
@@ -255,9 +256,39 @@ namespace getfem{
            nb_partitions : true_thread_policy::num_threads();
   }
 
+  void partition_master::set_scheduling(partition_scheduling s){
+    GMM_ASSERT1(!me_is_multithreaded_now(),
+                "Cannot change partition scheduling in parallel section.");
+    if (s == partition_scheduling::dynamic_partitions
+        && behaviour != thread_behaviour::partition_threads)
+      GMM_WARNING1("Dynamic scheduling has no effect with true threads "
+                   "behaviour.");
+    scheduling = s;
+  }
+
+  size_type partition_master::next_dynamic_partition(){
+    return dynamic_counter++;
+  }
+
+  void partition_master::set_thread_time(double t){
+    thread_times_[true_thread_policy::this_thread()] = t;
+  }
+
+  void partition_master::report_thread_times() const{
+    double tmax(0), tsum(0);
+    size_type nb(0);
+    for (double t : thread_times_)
+      if (t > 0.) { tmax = std::max(tmax, t); tsum += t; ++nb; }
+    if (nb > 1 && tsum > 0.)
+      GMM_TRACE4("Parallel execution on " << nb << " threads: max time "
+                 << tmax << " s, imbalance (max/mean) "
+                 << tmax * double(nb) / tsum);
+  }
+
   void partition_master::set_current_partition(size_type p){
     if (behaviour == thread_behaviour::partition_threads){
-      GMM_ASSERT2(partitions.thrd_cast().count(p) != 0, "Internal error: "
+      GMM_ASSERT2(scheduling == partition_scheduling::dynamic_partitions
+                  || partitions.thrd_cast().count(p) != 0, "Internal error: "
                   << p << " is not a valid partitions for thread "
                   << true_thread_policy::this_thread()
                   << ".");
@@ -342,6 +373,11 @@ namespace getfem{
     pexception->rethrow();
   }
 
+  static double wall_clock(){
+    return std::chrono::duration<double>
+      (std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
   void parallel_execution(std::function<void(void)> lambda,
                           bool iterate_over_partitions){
     if (me_is_multithreaded_now()) {
@@ -353,9 +389,23 @@ namespace getfem{
     if (pm.get_nb_partitions() < true_thread_policy::num_threads()){
       pm.set_nb_partitions(true_thread_policy::num_threads());
     }
+    bool dynamic = iterate_over_partitions
+      && pm.scheduling == partition_scheduling::dynamic_partitions
+      && pm.behaviour == thread_behaviour::partition_threads;
+    pm.dynamic_counter = 0;
+    pm.thread_times_.assign(true_thread_policy::num_threads(), 0.);
     #pragma omp parallel default(shared)
     {
-      if (iterate_over_partitions) {
+      double t0 = wall_clock();
+      if (dynamic) {
+        size_type nb_partitions = pm.get_nb_partitions();
+        for (size_type p = pm.next_dynamic_partition(); p < nb_partitions;
+             p = pm.next_dynamic_partition()) {
+          pm.set_current_partition(p);
+          boilerplate.run_lambda(lambda);
+        }
+      }
+      else if (iterate_over_partitions) {
         for (auto &&partitions : partition_master::get()) {
           (void)partitions;
           boilerplate.run_lambda(lambda);
@@ -364,8 +414,10 @@ namespace getfem{
       else {
         boilerplate.run_lambda(lambda);
       }
+      pm.set_thread_time(wall_clock() - t0);
     }
     if (iterate_over_partitions) partition_master::get().rewind_partitions();
+    pm.report_thread_times();
   }
 
 
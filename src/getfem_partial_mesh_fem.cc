@@ -112,6 +112,12 @@ namespace getfem {
     write_to_file(o);
   }
 
+  void partial_mesh_fem::write_binary_sections(binary_file_writer &w) const {
+    context_check(); mf.context_check();
+    mf.write_basic_binary_sections(w);
+    write_reduction_binary_section(w);
+  }
+
   dal::bit_vector select_dofs_from_im(const mesh_fem &mf, const mesh_im &mim,
                                       unsigned P) {
     const mesh &m = mf.linked_mesh();
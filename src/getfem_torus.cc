@@ -250,6 +250,7 @@ namespace getfem
       this->pts.add_node(node_tab_copy[pt]);
     }
 
+    invalidate_connectivity();
     for(size_type i = 0; i < this->convex_tab.size(); ++i){
       bgeot::pconvex_structure pstructure 
         = bgeot::torus_structure_descriptor(convex_tab[i].cstruct);
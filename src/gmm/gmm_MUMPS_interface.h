@@ -271,6 +271,7 @@ namespace gmm {
     std::vector<T> rhs_or_sol;
     int rank; // MPI rank
     int nrows_;
+    bool same_pattern_; // last set_matrix kept the previous sparsity pattern
 
   public:
 
@@ -279,7 +280,8 @@ namespace gmm {
       mumps_interf<T>::mumps_c(id);
     }
 
-    mumps_context(int sym=0) : id(), rank(0), nrows_(0) {
+    mumps_context(int sym=0)
+      : id(), rank(0), nrows_(0), same_pattern_(false) {
 #ifdef GMM_USES_MPI
       MPI_Comm_rank(MPI_COMM_WORLD, &rank);
 #endif
@@ -316,8 +318,12 @@ namespace gmm {
       nrows_ = int(gmm::mat_nrows(K));
       if (!distributed && rank != 0)
         return;
+      std::unique_ptr<ij_sparse_matrix<T> > pKnew
+        = std::make_unique< ij_sparse_matrix<T> >(K, id.sym > 0, rows, cols);
+      same_pattern_ = pK && id.n == nrows_ && pK->irn == pKnew->irn
+                      && pK->jcn == pKnew->jcn;
       id.n = nrows_;
-      pK = std::make_unique< ij_sparse_matrix<T> >(K, id.sym > 0, rows, cols);
+      pK = std::move(pKnew);
       if (distributed) {
         id.nz_loc = int(pK->irn.size());
         id.irn_loc = &(pK->irn[0]);
@@ -353,6 +359,11 @@ namespace gmm {
 
     const std::vector<T> &vector() const { return rhs_or_sol; }
 
+    /** True if the matrix given to the last call of set_matrix has the
+        same sparsity pattern as the one given to the previous call, in
+        which case a previous analysis is still valid. */
+    inline bool same_pattern() const { return same_pattern_; }
+
     inline void analyze() { run_job(1); }
     inline void factorize() { run_job(2); }
     inline void analyze_and_factorize() { run_job(4); }
@@ -405,6 +416,78 @@ namespace gmm {
   }
 
 
+  /** MUMPS factorization kept between successive solves.
+
+      The analysis phase (ordering and symbolic factorization) is done
+      only when the sparsity pattern of the matrix given to factorize()
+      differs from the one of the previously factorized matrix, otherwise
+      only the numerical factorization is recomputed. Once factorized,
+      any number of systems can be solved with the stored factors. The
+      object can also be used as a preconditioner of an iterative solver
+      with gmm::mult(P, v, w), which solves P w = v with the stored
+      factors.
+   */
+  template <typename T>
+  class mumps_factorization {
+    mutable std::unique_ptr<mumps_context<T> > ctx;
+    bool sym, factorized;
+    size_type nb_analyses_, nb_factorizations_;
+
+  public:
+
+    /** Analyse (if needed) and factorize A. Returns false if MUMPS
+        reports an error (singular matrix for instance). */
+    template <typename MAT> bool factorize(const MAT &A) {
+      if (!ctx) {
+        ctx = std::make_unique<mumps_context<T> >(sym ? 2 : 0);
+        ctx->ICNTL(1) = -1; ctx->ICNTL(2) = -1; ctx->ICNTL(3) = -1;
+        ctx->ICNTL(4) = 0;
+        ctx->ICNTL(14) += 80; // same workspace boost as MUMPS_solve
+      }
+      ctx->set_matrix(A, false);
+      if (factorized && ctx->same_pattern())
+        ctx->factorize();
+      else {
+        ctx->analyze_and_factorize();
+        ++nb_analyses_;
+      }
+      ++nb_factorizations_;
+      factorized = ctx->error_check();
+      return factorized;
+    }
+
+    /** Solve A X = B with the factors of the last factorized matrix. */
+    template <typename VECTX, typename VECTB>
+    bool solve(VECTX &X, const VECTB &B) const {
+      GMM_ASSERT1(factorized, "No valid factorization, call factorize first");
+      std::vector<T> b(vect_size(B));
+      gmm::copy(B, b);
+      ctx->set_vector(b);
+      ctx->solve();
+      bool ok = ctx->error_check();
+      ctx->mpi_broadcast();
+      gmm::copy(ctx->vector(), X);
+      return ok;
+    }
+
+    bool is_factorized() const { return factorized; }
+    size_type nrows() const { return ctx ? size_type(ctx->nrows()) : 0; }
+    /** Number of analysis phases performed since the construction. */
+    size_type nb_analyses() const { return nb_analyses_; }
+    /** Number of numerical factorizations performed. */
+    size_type nb_factorizations() const { return nb_factorizations_; }
+    /** Release the factors and the stored analysis. */
+    void clear() { ctx.reset(); factorized = false; }
+
+    explicit mumps_factorization(bool sym_ = false)
+      : sym(sym_), factorized(false), nb_analyses_(0), nb_factorizations_(0)
+    {}
+  };
+
+  template <typename T, typename V1, typename V2>
+  inline void mult(const mumps_factorization<T> &P, const V1 &v1, V2 &v2)
+  { P.solve(v2, v1); }
+
   /** MUMPS solve interface for distributed matrices
    *  Works only with sparse or skyline matrices
    */
@@ -403,11 +403,35 @@ namespace gmm {
     return res;
   }
 
+  template <typename IT1, typename IT2> inline
+  typename strongest_numeric_type<typename std::iterator_traits<IT1>::value_type,
+                                  typename std::iterator_traits<IT2>::value_type>::T
+  vect_sp_dense_par_(IT1 it, IT1 ite, IT2 it2, std::false_type)
+  { return vect_sp_dense_(it, ite, it2); }
+
+  template <typename IT1, typename IT2> inline
+  typename strongest_numeric_type<typename std::iterator_traits<IT1>::value_type,
+                                  typename std::iterator_traits<IT2>::value_type>::T
+  vect_sp_dense_par_(IT1 it, IT1 ite, IT2 it2, std::true_type) {
+    typedef typename strongest_numeric_type
+      <typename std::iterator_traits<IT1>::value_type,
+       typename std::iterator_traits<IT2>::value_type>::T T;
+    return parallel_blocks_sum<T>(size_type(ite - it),
+      [&](size_type i0, size_type i1)
+      { return vect_sp_dense_(it + i0, it + i1, it2 + i0); },
+      parallel_threshold());
+  }
+
   template <typename V1, typename V2> inline
   typename strongest_value_type<V1,V2>::value_type
     vect_sp(const V1 &v1, const V2 &v2, abstract_dense, abstract_dense) {
-    return vect_sp_dense_(vect_const_begin(v1), vect_const_end(v1),
-                          vect_const_begin(v2));
+    typedef typename linalg_traits<V1>::const_iterator IT1;
+    typedef typename linalg_traits<V2>::const_iterator IT2;
+    return vect_sp_dense_par_(vect_const_begin(v1), vect_const_end(v1),
+                              vect_const_begin(v2),
+                              std::integral_constant<bool,
+                              is_random_access_it_<IT1>::value
+                              && is_random_access_it_<IT2>::value>());
   }
 
   template <typename V1, typename V2> inline
@@ -536,19 +560,57 @@ namespace gmm {
   /*            Euclidean norm                                            */
   /* ******************************************************************** */
 
-  /** squared Euclidean norm of a vector. */
-  template <typename V>
-  typename number_traits<typename linalg_traits<V>::value_type>
+  template <typename IT> inline
+  typename number_traits<typename std::iterator_traits<IT>::value_type>
   ::magnitude_type
-  vect_norm2_sqr(const V &v) {
-    typedef typename linalg_traits<V>::value_type T;
+  vect_norm2_sqr_(IT it, IT ite) {
+    typedef typename std::iterator_traits<IT>::value_type T;
     typedef typename number_traits<T>::magnitude_type R;
-    auto it = vect_const_begin(v), ite = vect_const_end(v);
     R res(0);
     for (; it != ite; ++it) res += gmm::abs_sqr(*it);
     return res;
   }
 
+  template <typename IT> inline
+  typename number_traits<typename std::iterator_traits<IT>::value_type>
+  ::magnitude_type
+  vect_norm2_sqr_par_(IT it, IT ite, std::false_type)
+  { return vect_norm2_sqr_(it, ite); }
+
+  template <typename IT> inline
+  typename number_traits<typename std::iterator_traits<IT>::value_type>
+  ::magnitude_type
+  vect_norm2_sqr_par_(IT it, IT ite, std::true_type) {
+    typedef typename std::iterator_traits<IT>::value_type T;
+    typedef typename number_traits<T>::magnitude_type R;
+    return parallel_blocks_sum<R>(size_type(ite - it),
+      [&](size_type i0, size_type i1)
+      { return vect_norm2_sqr_(it + i0, it + i1); },
+      parallel_threshold());
+  }
+
+  template <typename V> inline
+  typename number_traits<typename linalg_traits<V>::value_type>
+  ::magnitude_type
+  vect_norm2_sqr_st_(const V &v, abstract_dense) {
+    typedef typename linalg_traits<V>::const_iterator IT;
+    return vect_norm2_sqr_par_(vect_const_begin(v), vect_const_end(v),
+                               is_random_access_it_<IT>());
+  }
+
+  template <typename V, typename ST> inline
+  typename number_traits<typename linalg_traits<V>::value_type>
+  ::magnitude_type
+  vect_norm2_sqr_st_(const V &v, ST)
+  { return vect_norm2_sqr_(vect_const_begin(v), vect_const_end(v)); }
+
+  /** squared Euclidean norm of a vector. */
+  template <typename V> inline
+  typename number_traits<typename linalg_traits<V>::value_type>
+  ::magnitude_type
+  vect_norm2_sqr(const V &v)
+  { return vect_norm2_sqr_st_(v, typename linalg_traits<V>::storage_type()); }
+
   /** Euclidean norm of a vector. */
   template <typename V> inline
    typename number_traits<typename linalg_traits<V>::value_type>
@@ -1463,6 +1525,17 @@ namespace gmm {
     for (; it3 != ite; ++it3, ++it2, ++it1) *it3 = *it1 + *it2;
   }
 
+  template <typename IT1, typename IT2, typename IT3> inline
+  void add_full_par_(IT1 it1, IT2 it2, IT3 it3, IT3 ite, std::false_type)
+  { add_full_(it1, it2, it3, ite); }
+
+  template <typename IT1, typename IT2, typename IT3> inline
+  void add_full_par_(IT1 it1, IT2 it2, IT3 it3, IT3 ite, std::true_type) {
+    parallel_blocks(size_type(ite - it3), [&](size_type i0, size_type i1)
+                    { add_full_(it1 + i0, it2 + i0, it3 + i0, it3 + i1); },
+                    parallel_threshold());
+  }
+
   template <typename IT1, typename IT2, typename IT3>
     void add_almost_full_(IT1 it1, IT1 ite1, IT2 it2, IT3 it3, IT3 ite3) {
     IT3 it = it3;
@@ -1484,8 +1557,15 @@ namespace gmm {
   template <typename L1, typename L2, typename L3> inline
   void add(const L1& l1, const L2& l2, L3& l3,
            abstract_dense, abstract_dense, abstract_dense) {
-    add_full_(vect_const_begin(l1), vect_const_begin(l2),
-              vect_begin(l3), vect_end(l3));
+    typedef typename linalg_traits<L1>::const_iterator IT1;
+    typedef typename linalg_traits<L2>::const_iterator IT2;
+    typedef typename linalg_traits<L3>::iterator IT3;
+    add_full_par_(vect_const_begin(l1), vect_const_begin(l2),
+                  vect_begin(l3), vect_end(l3),
+                  std::integral_constant<bool,
+                  is_random_access_it_<IT1>::value
+                  && is_random_access_it_<IT2>::value
+                  && is_random_access_it_<IT3>::value>());
   }
 
   // generic function for add(v1, v2, v3).
@@ -1547,13 +1627,81 @@ namespace gmm {
                          ::bool_type());
   }
 
+  template <typename IT1, typename IT2> inline
+  void add_dense_(IT1 it1, IT2 it2, IT2 ite, std::false_type)
+  { for (; it2 != ite; ++it2, ++it1) *it2 += *it1; }
+
+  template <typename IT1, typename IT2> inline
+  void add_dense_(IT1 it1, IT2 it2, IT2 ite, std::true_type) {
+    parallel_blocks(size_type(ite - it2), [&](size_type i0, size_type i1) {
+      IT1 itb1 = it1 + i0;
+      for (IT2 itb = it2 + i0, itbe = it2 + i1; itb != itbe; ++itb, ++itb1)
+        *itb += *itb1;
+    }, parallel_threshold());
+  }
+
   template <typename L1, typename L2>
   void add(const L1& l1, L2& l2, abstract_dense, abstract_dense) {
+    typedef typename linalg_traits<L1>::const_iterator IT1;
+    typedef typename linalg_traits<L2>::iterator IT2;
+    add_dense_(vect_const_begin(l1), vect_begin(l2), vect_end(l2),
+               std::integral_constant<bool, is_random_access_it_<IT1>::value
+               && is_random_access_it_<IT2>::value>());
+  }
+
+  template <typename L1, typename L2> inline
+  typename number_traits<typename linalg_traits<L2>::value_type>
+  ::magnitude_type
+  add_and_norm2_sqr_(const L1& l1, L2& l2, std::false_type)
+  { add(l1, l2); return vect_norm2_sqr(l2); }
+
+  template <typename L1, typename L2> inline
+  typename number_traits<typename linalg_traits<L2>::value_type>
+  ::magnitude_type
+  add_and_norm2_sqr_(const L1& l1, L2& l2, std::true_type) {
+    typedef typename linalg_traits<L2>::value_type T;
+    typedef typename number_traits<T>::magnitude_type R;
     auto it1 = vect_const_begin(l1);
-    auto it2 = vect_begin(l2), ite = vect_end(l2);
-    for (; it2 != ite; ++it2, ++it1) *it2 += *it1;
+    auto it2 = vect_begin(l2);
+    return parallel_blocks_sum<R>(vect_size(l2),
+      [&](size_type i0, size_type i1) {
+        R res(0);
+        auto itb1 = it1 + i0;
+        for (auto itb = it2 + i0, itbe = it2 + i1; itb != itbe;
+             ++itb, ++itb1)
+          { *itb += *itb1; res += gmm::abs_sqr(*itb); }
+        return res;
+      }, parallel_threshold());
   }
 
+  ///@endcond
+  /** Add l1 to l2 and return the squared Euclidean norm of the result,
+      computed in the same pass on dense vectors (fused kernel for the
+      update of the residual in the Krylov solvers). */
+  template <typename L1, typename L2> inline
+  typename number_traits<typename linalg_traits<L2>::value_type>
+  ::magnitude_type
+  add_and_norm2_sqr(const L1& l1, L2& l2) {
+    typedef typename linalg_traits<L1>::const_iterator IT1;
+    typedef typename linalg_traits<L2>::iterator IT2;
+    GMM_ASSERT2(vect_size(l1) == vect_size(l2), "dimensions mismatch, "
+                << vect_size(l1) << " !=" << vect_size(l2));
+    return add_and_norm2_sqr_(l1, l2, std::integral_constant<bool,
+      std::is_same<typename linalg_traits<L1>::storage_type,
+                   abstract_dense>::value
+      && std::is_same<typename linalg_traits<L2>::storage_type,
+                      abstract_dense>::value
+      && is_random_access_it_<IT1>::value
+      && is_random_access_it_<IT2>::value>());
+  }
+  ///@cond DOXY_SHOW_ALL_FUNCTIONS
+
+  template <typename L1, typename L2> inline
+  typename number_traits<typename linalg_traits<L2>::value_type>
+  ::magnitude_type
+  add_and_norm2_sqr(const L1& l1, const L2& l2)
+  { return add_and_norm2_sqr(l1, linalg_const_cast(l2)); }
+
   template <typename L1, typename L2>
   void add(const L1& l1, L2& l2, abstract_dense, abstract_skyline) {
     typedef typename linalg_traits<L1>::value_type T;
@@ -1708,19 +1856,109 @@ namespace gmm {
     }
   }
 
-  template <typename L1, typename L2, typename L3>
-  void mult_by_row(const L1& l1, const L2& l2, L3& l3, abstract_dense) {
+  template <typename L1, typename L2, typename L3, bool ADD>
+  void mult_by_row_dense_(const L1& l1, const L2& l2, L3& l3,
+                          std::integral_constant<bool, ADD>, std::false_type) {
     typename linalg_traits<L3>::iterator it=vect_begin(l3), ite=vect_end(l3);
     auto itr = mat_row_const_begin(l1);
     for (; it != ite; ++it, ++itr)
-      *it = vect_sp(linalg_traits<L1>::row(itr), l2,
-                    typename linalg_traits<L1>::storage_type(),
-                    typename linalg_traits<L2>::storage_type());
+      if (ADD)
+        *it += vect_sp(linalg_traits<L1>::row(itr), l2,
+                       typename linalg_traits<L1>::storage_type(),
+                       typename linalg_traits<L2>::storage_type());
+      else
+        *it = vect_sp(linalg_traits<L1>::row(itr), l2,
+                      typename linalg_traits<L1>::storage_type(),
+                      typename linalg_traits<L2>::storage_type());
+  }
+
+  // Row blocked version, each thread computes a contiguous range of l3.
+  template <typename L1, typename L2, typename L3, bool ADD>
+  void mult_by_row_dense_(const L1& l1, const L2& l2, L3& l3,
+                          std::integral_constant<bool, ADD>, std::true_type) {
+    auto it = vect_begin(l3);
+    auto itr0 = mat_row_const_begin(l1);
+    parallel_blocks(vect_size(l3), [&](size_type i0, size_type i1) {
+      auto itb = it + i0, itbe = it + i1;
+      auto itr = itr0 + i0;
+      for (; itb != itbe; ++itb, ++itr)
+        if (ADD)
+          *itb += vect_sp(linalg_traits<L1>::row(itr), l2,
+                          typename linalg_traits<L1>::storage_type(),
+                          typename linalg_traits<L2>::storage_type());
+        else
+          *itb = vect_sp(linalg_traits<L1>::row(itr), l2,
+                         typename linalg_traits<L1>::storage_type(),
+                         typename linalg_traits<L2>::storage_type());
+    }, parallel_threshold());
+  }
+
+  template <typename L1, typename L2, typename L3>
+  void mult_by_row(const L1& l1, const L2& l2, L3& l3, abstract_dense) {
+    typedef typename linalg_traits<L3>::iterator IT3;
+    mult_by_row_dense_(l1, l2, l3, std::false_type(),
+                       std::integral_constant<bool,
+                       omp_safe_matrix<L1>::value
+                       && is_random_access_it_<IT3>::value>());
+  }
+
+  // Column oriented product l3 += l1*l2 with dense l2 and l3: the columns
+  // are split between the threads, each one accumulating in a private
+  // vector, and the private vectors are then summed by blocks of rows.
+  template <typename L1, typename L2, typename L3>
+  bool mult_add_by_col_omp_(const L1& l1, const L2& l2, L3& l3,
+                            std::true_type) {
+#ifdef _OPENMP
+    typedef typename linalg_traits<L3>::value_type T;
+    size_type nr = mat_nrows(l1), nc = mat_ncols(l1);
+    if (nc < parallel_threshold() || omp_in_parallel()
+        || omp_get_max_threads() < 2)
+      return false;
+    std::vector<std::vector<T> > w(omp_get_max_threads());
+    auto it2 = vect_const_begin(l2);
+    auto it3 = vect_begin(l3);
+    #pragma omp parallel
+    {
+      size_type nt = size_type(omp_get_num_threads());
+      size_type t = size_type(omp_get_thread_num());
+      w[t].assign(nr, T(0));
+      for (size_type j = (nc*t)/nt; j < (nc*(t+1))/nt; ++j)
+        if (it2[j] != T(0))
+          add(scaled(mat_const_col(l1, j), T(it2[j])), w[t]);
+      #pragma omp barrier
+      for (size_type i = (nr*t)/nt; i < (nr*(t+1))/nt; ++i) {
+        T a(0);
+        for (size_type k = 0; k < nt; ++k) a += w[k][i];
+        it3[i] += a;
+      }
+    }
+    return true;
+#else
+    GMM_NOPERATION(l1); GMM_NOPERATION(l2); GMM_NOPERATION(l3);
+    return false;
+#endif
+  }
+
+  template <typename L1, typename L2, typename L3> inline
+  bool mult_add_by_col_omp_(const L1&, const L2&, L3&, std::false_type)
+  { return false; }
+
+  template <typename L1, typename L2, typename L3> inline
+  bool mult_add_by_col_omp_(const L1& l1, const L2& l2, L3& l3) {
+    typedef typename linalg_traits<L2>::const_iterator IT2;
+    typedef typename linalg_traits<L3>::iterator IT3;
+    return mult_add_by_col_omp_(l1, l2, l3, std::integral_constant<bool,
+      omp_safe_matrix<L1>::value
+      && std::is_same<typename linalg_traits<L3>::storage_type,
+                      abstract_dense>::value
+      && is_random_access_it_<IT2>::value
+      && is_random_access_it_<IT3>::value>());
   }
 
   template <typename L1, typename L2, typename L3>
   void mult_by_col(const L1& l1, const L2& l2, L3& l3, abstract_dense) {
     clear(l3);
+    if (mult_add_by_col_omp_(l1, l2, l3)) return;
     size_type nc = mat_ncols(l1);
     for (size_type i = 0; i < nc; ++i)
       add(scaled(mat_const_col(l1, i), l2[i]), l3);
@@ -1831,14 +2069,16 @@ namespace gmm {
 
   template <typename L1, typename L2, typename L3>
   void mult_add_by_row(const L1& l1, const L2& l2, L3& l3, abstract_dense) {
-    auto it=vect_begin(l3), ite=vect_end(l3);
-    auto itr = mat_row_const_begin(l1);
-    for (; it != ite; ++it, ++itr)
-      *it += vect_sp(linalg_traits<L1>::row(itr), l2);
+    typedef typename linalg_traits<L3>::iterator IT3;
+    mult_by_row_dense_(l1, l2, l3, std::true_type(),
+                       std::integral_constant<bool,
+                       omp_safe_matrix<L1>::value
+                       && is_random_access_it_<IT3>::value>());
   }
 
   template <typename L1, typename L2, typename L3>
   void mult_add_by_col(const L1& l1, const L2& l2, L3& l3, abstract_dense) {
+    if (mult_add_by_col_omp_(l1, l2, l3)) return;
     size_type nc = mat_ncols(l1);
     for (size_type i = 0; i < nc; ++i)
       add(scaled(mat_const_col(l1, i), l2[i]), l3);
@@ -191,16 +191,52 @@ typedef struct{double r,i;} FORTRAN_BLAS_Z;
   }
 
 
+  /* ********************************************************************* */
+  /* With OpenMP, the level 1 calls on vectors longer than                 */
+  /* parallel_threshold() are split in one chunk per thread.               */
+  /* ********************************************************************* */
+
+#ifdef _OPENMP
+  inline bool blas_split_(size_type n) {
+    return n >= parallel_threshold() && !omp_in_parallel()
+      && omp_get_max_threads() > 1;
+  }
+#else
+  inline bool blas_split_(size_type) { return false; }
+#endif
+
   /* ********************************************************************* */
   /* vect_norm2(x).                                                        */
   /* ********************************************************************* */
 
-# define nrm2_interface(blas_name, base_type)             \
-  inline number_traits<base_type>::magnitude_type         \
-  vect_norm2(const std::vector<base_type> &x) {           \
-    GMMLAPACK_TRACE("nrm2_interface");                    \
-    const BLAS_INT n=BLAS_INT(vect_size(x)), inc(1);      \
-    return blas_name(&n, &x[0], &inc);                    \
+  /* Euclidean norm scale*sqrt(ssq) of a union of blocks, combined from the */
+  /* norms of the blocks as in nrm2, so that no square of a norm overflows. */
+  template <typename R> struct scaled_norm2_ {
+    R scale, ssq;
+    scaled_norm2_(R nrm = R(0))
+      : scale(nrm), ssq(nrm == R(0) ? R(0) : R(1)) {}
+    scaled_norm2_ &operator +=(const scaled_norm2_ &b) {
+      if (b.scale > scale)
+        { ssq = b.ssq + ssq * gmm::sqr(scale / b.scale); scale = b.scale; }
+      else if (b.scale > R(0))
+        ssq += b.ssq * gmm::sqr(b.scale / scale);
+      return *this;
+    }
+    R norm() const { return scale * gmm::sqrt(ssq); }
+  };
+
+# define nrm2_interface(blas_name, base_type)                              \
+  inline number_traits<base_type>::magnitude_type                          \
+  vect_norm2(const std::vector<base_type> &x) {                            \
+    GMMLAPACK_TRACE("nrm2_interface");                                     \
+    typedef number_traits<base_type>::magnitude_type R;                    \
+    if (blas_split_(vect_size(x)))                                         \
+      return parallel_blocks_sum<scaled_norm2_<R> >(vect_size(x),          \
+        [&x](size_type i0, size_type i1) {                                 \
+          const BLAS_INT n=BLAS_INT(i1-i0), inc(1);                        \
+          return scaled_norm2_<R>(blas_name(&n, &x[i0], &inc)); }).norm(); \
+    const BLAS_INT n=BLAS_INT(vect_size(x)), inc(1);                       \
+    return blas_name(&n, &x[0], &inc);                                     \
   }
 
   nrm2_interface(snrm2_,  BLAS_S)
@@ -213,11 +249,20 @@ typedef struct{double r,i;} FORTRAN_BLAS_Z;
   /* ********************************************************************* */
 
 # define dot_interface(funcname, msg, blas_name, base_type)                \
+  inline base_type funcname##_blas_(const base_type *x,                    \
+                                    const base_type *y, size_type nn) {    \
+    if (blas_split_(nn))                                                   \
+      return parallel_blocks_sum<base_type>(nn,                            \
+        [x, y](size_type i0, size_type i1) {                               \
+          const BLAS_INT n=BLAS_INT(i1-i0), inc(1);                        \
+          return blas_name(&n, x+i0, &inc, y+i0, &inc); });                \
+    const BLAS_INT n=BLAS_INT(nn), inc(1);                                 \
+    return blas_name(&n, x, &inc, y, &inc);                                \
+  }                                                                        \
   inline base_type funcname(const std::vector<base_type> &x,               \
                             const std::vector<base_type> &y) {             \
     GMMLAPACK_TRACE(msg);                                                  \
-    const BLAS_INT n=BLAS_INT(vect_size(y)), inc(1);                       \
-    return blas_name(&n, &x[0], &inc, &y[0], &inc);                        \
+    return funcname##_blas_(&x[0], &y[0], vect_size(y));                   \
   }                                                                        \
   inline base_type funcname                                                \
    (const scaled_vector_const_ref<std::vector<base_type>,base_type> &x_,   \
@@ -225,8 +270,7 @@ typedef struct{double r,i;} FORTRAN_BLAS_Z;
     GMMLAPACK_TRACE(msg);                                                  \
     const std::vector<base_type> &x = *(linalg_origin(x_));                \
     base_type a(x_.r);                                                     \
-    const BLAS_INT n=BLAS_INT(vect_size(y)), inc(1);                       \
-    return a * blas_name(&n, &x[0], &inc, &y[0], &inc);                    \
+    return a * funcname##_blas_(&x[0], &y[0], vect_size(y));               \
   }                                                                        \
   inline base_type funcname                                                \
     (const std::vector<base_type> &x,                                      \
@@ -234,8 +278,7 @@ typedef struct{double r,i;} FORTRAN_BLAS_Z;
     GMMLAPACK_TRACE(msg);                                                  \
     const std::vector<base_type> &y = *(linalg_origin(y_));                \
     base_type b(y_.r);                                                     \
-    const BLAS_INT n=BLAS_INT(vect_size(y)), inc(1);                       \
-    return b * blas_name(&n, &x[0], &inc, &y[0], &inc);                    \
+    return b * funcname##_blas_(&x[0], &y[0], vect_size(y));               \
   }                                                                        \
   inline base_type funcname                                                \
     (const scaled_vector_const_ref<std::vector<base_type>,base_type> &x_,  \
@@ -244,8 +287,7 @@ typedef struct{double r,i;} FORTRAN_BLAS_Z;
     const std::vector<base_type> &x = *(linalg_origin(x_));                \
     const std::vector<base_type> &y = *(linalg_origin(y_));                \
     base_type a(x_.r), b(y_.r);                                            \
-    const BLAS_INT n=BLAS_INT(vect_size(y)), inc(1);                       \
-    return a*b * blas_name(&n, &x[0], &inc, &y[0], &inc);                  \
+    return a*b * funcname##_blas_(&x[0], &y[0], vect_size(y));             \
   }
 
   dot_interface(vect_sp, "dot_interface", sdot_,  BLAS_S)
@@ -397,14 +439,24 @@ typedef struct{double r,i;} FORTRAN_BLAS_Z;
 
 
 # define axpy_interface(blas_name, base_type)                              \
+  inline void axpy_blas_(const base_type &a, const base_type *x,           \
+                         base_type *y, size_type nn) {                     \
+    if (blas_split_(nn))                                                   \
+      parallel_blocks(nn, [&a, x, y](size_type i0, size_type i1) {         \
+        const BLAS_INT n=BLAS_INT(i1-i0), inc(1);                          \
+        blas_name(&n, &a, x+i0, &inc, y+i0, &inc); });                     \
+    else {                                                                 \
+      const BLAS_INT n=BLAS_INT(nn), inc(1);                               \
+      blas_name(&n, &a, x, &inc, y, &inc);                                 \
+    }                                                                      \
+  }                                                                        \
   inline void add(const std::vector<base_type> &x,                         \
                   std::vector<base_type> &y) {                             \
     GMMLAPACK_TRACE("axpy_interface");                                     \
     const size_type nn=vect_size(y);                                       \
     if (nn == 0) return;                                                   \
     else if (nn < 25) add_for_short_vectors(x, y, nn);                     \
-    else { const BLAS_INT n=BLAS_INT(nn), inc(1); const base_type a(1);    \
-           blas_name(&n, &a, &x[0], &inc, &y[0], &inc); }                  \
+    else axpy_blas_(base_type(1), &x[0], &y[0], nn);                       \
   }                                                                        \
   inline void add(const scaled_vector_const_ref<std::vector<base_type>,    \
                                                 base_type> &x_,            \
@@ -414,8 +466,7 @@ typedef struct{double r,i;} FORTRAN_BLAS_Z;
     const std::vector<base_type>& x = *(linalg_origin(x_));                \
     if (nn == 0) return;                                                   \
     else if (nn < 25) add_for_short_vectors(x, y, a, nn);                  \
-    else { const BLAS_INT n=BLAS_INT(nn), inc(1);                          \
-           blas_name(&n, &a, &x[0], &inc, &y[0], &inc); }                  \
+    else axpy_blas_(a, &x[0], &y[0], nn);                                  \
   }
 
   axpy_interface(saxpy_, BLAS_S)
@@ -38,6 +38,9 @@
 
 #include "gmm_ref.h"
 #include <complex>
+#ifdef _OPENMP
+# include <omp.h>
+#endif
 
 #ifndef M_PI
 # define        M_E             2.7182818284590452354       /* e          */
@@ -1040,6 +1043,77 @@ namespace gmm {
   }
 
 
+  /* ******************************************************************** */
+  /*             Thread parallelism                                       */
+  /* ******************************************************************** */
+
+  /** Minimal size of the vectors (or number of rows or columns of the
+      matrices) from which the BLAS-1 kernels and the sparse
+      matrix-vector products of gmm are multithreaded, when gmm is
+      compiled with OpenMP. Can be modified by
+      gmm::parallel_threshold() = n. */
+  inline size_type &parallel_threshold()
+  { static size_type threshold = 20000; return threshold; }
+
+  /** Call f(i0, i1) on a partition of [0, n) in contiguous blocks, one
+      block per OpenMP thread. Runs f(0, n) serially when gmm is not
+      compiled with OpenMP, when n < min_n or when already called from
+      inside a parallel region. */
+  template <typename F>
+  inline void parallel_blocks(size_type n, const F &f, size_type min_n = 0) {
+#ifdef _OPENMP
+    if (n >= min_n && n > 1 && !omp_in_parallel()
+        && omp_get_max_threads() > 1) {
+      #pragma omp parallel
+      {
+        size_type nt = size_type(omp_get_num_threads());
+        size_type t = size_type(omp_get_thread_num());
+        f((n*t)/nt, (n*(t+1))/nt);
+      }
+      return;
+    }
+#endif
+    (void)min_n;
+    f(size_type(0), n);
+  }
+
+  /** Same as parallel_blocks, f(i0, i1) returning a partial result of
+      type T. The partial results are summed in the order of the blocks,
+      so that the result is reproducible for a given number of threads.
+  */
+  template <typename T, typename F>
+  inline T parallel_blocks_sum(size_type n, const F &f, size_type min_n = 0) {
+#ifdef _OPENMP
+    if (n >= min_n && n > 1 && !omp_in_parallel()
+        && omp_get_max_threads() > 1) {
+      std::vector<T> partial(size_type(omp_get_max_threads()), T(0));
+      #pragma omp parallel
+      {
+        size_type nt = size_type(omp_get_num_threads());
+        size_type t = size_type(omp_get_thread_num());
+        partial[t] = f((n*t)/nt, (n*(t+1))/nt);
+      }
+      T res(0);
+      for (const T &p : partial) res += p;
+      return res;
+    }
+#endif
+    (void)min_n;
+    return f(size_type(0), n);
+  }
+
+  /* The dense kernels are split in blocks between the threads only for
+     random access iterators.                                             */
+  template <typename IT> struct is_random_access_it_
+    : std::is_same<typename std::iterator_traits<IT>::iterator_category,
+                   std::random_access_iterator_tag> {};
+
+  /** Matrix types whose rows or columns can be read concurrently by
+      several threads (the accessors do not modify any shared state, which
+      is not the case for instance for sub_index based sub matrices). The
+      sparse matrix-vector products are multithreaded only for them. */
+  template <typename M> struct omp_safe_matrix : std::false_type {};
+
   /* ******************************************************************** */
   /*             Write                                                    */
   /* ******************************************************************** */
@@ -646,6 +646,10 @@ namespace gmm {
       { return mat_col(*this, j)[i]; }
   };
 
+  template <typename PT1, typename PT2, typename PT3, int shift>
+  struct omp_safe_matrix<csc_matrix_ref<PT1, PT2, PT3, shift> >
+    : std::true_type {};
+
   template <typename PT1, typename PT2, typename PT3, int shift>
   struct linalg_traits<csc_matrix_ref<PT1, PT2, PT3, shift> > {
     typedef csc_matrix_ref<PT1, PT2, PT3, shift> this_type;
@@ -713,6 +717,10 @@ namespace gmm {
       { return mat_row(*this, i)[j]; }
   };
   
+  template <typename PT1, typename PT2, typename PT3, int shift>
+  struct omp_safe_matrix<csr_matrix_ref<PT1, PT2, PT3, shift> >
+    : std::true_type {};
+
   template <typename PT1, typename PT2, typename PT3, int shift>
   struct linalg_traits<csr_matrix_ref<PT1, PT2, PT3, shift> > {
     typedef csr_matrix_ref<PT1, PT2, PT3, shift> this_type;
@@ -186,6 +186,9 @@ namespace gmm
   void row_matrix<V>::clear_mat()
   { for (size_type i=0; i < nrows(); ++i) clear(li[i]); }
 
+  template <typename V>
+  struct omp_safe_matrix<row_matrix<V> > : std::true_type {};
+
   template <typename V>
   struct linalg_traits<row_matrix<V> > {
     typedef row_matrix<V> this_type;
@@ -293,6 +296,9 @@ namespace gmm
   template<typename V> void col_matrix<V>::clear_mat()
   { for (size_type i=0; i < ncols(); ++i)  clear(li[i]); }
 
+  template <typename V>
+  struct omp_safe_matrix<col_matrix<V> > : std::true_type {};
+
   template <typename V> struct linalg_traits<col_matrix<V> > {
     typedef col_matrix<V> this_type;
     typedef this_type origin_type;
@@ -423,6 +429,9 @@ namespace gmm
     if (a != b) for (size_type i = 0; i < n; ++i) (*this)(i,i) = a;
   }
 
+  template <typename T>
+  struct omp_safe_matrix<dense_matrix<T> > : std::true_type {};
+
   template <typename T>
   struct linalg_traits<dense_matrix<T> > {
     typedef dense_matrix<T> this_type;
@@ -589,6 +598,10 @@ namespace gmm
     for (size_type j = 0; j <= nc; ++j) jc[j] = shift;
   }
 
+  template <typename T, typename IND_TYPE, int shift>
+  struct omp_safe_matrix<csc_matrix<T, IND_TYPE, shift> >
+    : std::true_type {};
+
   template <typename T, typename IND_TYPE, int shift>
   struct linalg_traits<csc_matrix<T, IND_TYPE, shift> > {
     typedef csc_matrix<T, IND_TYPE, shift> this_type;
@@ -738,6 +751,10 @@ namespace gmm
   }
 
 
+  template <typename T, typename IND_TYPE, int shift>
+  struct omp_safe_matrix<csr_matrix<T, IND_TYPE, shift> >
+    : std::true_type {};
+
   template <typename T, typename IND_TYPE, int shift>
   struct linalg_traits<csr_matrix<T, IND_TYPE, shift> > {
     typedef csr_matrix<T, IND_TYPE, shift> this_type;
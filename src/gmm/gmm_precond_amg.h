@@ -0,0 +1,638 @@
+/* -*- c++ -*- (enables emacs c++ mode) */
+/*===========================================================================
+
+ Copyright (C) 2026 agent.
+
+ This file is a part of GetFEM
+
+ GetFEM  is  free software;  you  can  redistribute  it  and/or modify it
+ under  the  terms  of the  GNU  Lesser General Public License as published
+ by  the  Free Software Foundation;  either version 3 of the License,  or
+ (at your option) any later version along with the GCC Runtime Library
+ Exception either version 3.1 or (at your option) any later version.
+ This program  is  distributed  in  the  hope  that it will be useful,  but
+ WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ or  FITNESS  FOR  A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ License and GCC Runtime Library Exception for more details.
+ You  should  have received a copy of the GNU Lesser General Public License
+ along  with  this program. If not, see https://www.gnu.org/licenses/.
+
+ As a special exception, you  may use  this file  as it is a part of a free
+ software  library  without  restriction.  Specifically,  if   other  files
+ instantiate  templates  or  use macros or inline functions from this file,
+ or  you compile this  file  and  link  it  with other files  to produce an
+ executable, this file  does  not  by itself cause the resulting executable
+ to be covered  by the GNU Lesser General Public License.  This   exception
+ does not  however  invalidate  any  other  reasons why the executable file
+ might be covered by the GNU Lesser General Public License.
+
+===========================================================================*/
+
+/**@file gmm_precond_amg.h
+   @author  agent <agent@local>
+   @date October 17, 2026.
+   @brief Smoothed aggregation algebraic multigrid preconditioner.
+*/
+
+#ifndef GMM_PRECOND_AMG_H
+#define GMM_PRECOND_AMG_H
+
+#include "gmm_precond.h"
+#include "gmm_dense_lu.h"
+
+namespace gmm {
+
+  /** Smoothed aggregation algebraic multigrid preconditioner
+      (P. Vanek, J. Mandel, M. Brezina, Computing 56, 1996) for symmetric
+      positive definite matrices, to be used with gmm::cg.
+
+      The dofs are grouped in nodes of block_size consecutive dofs (the
+      components of a vector field) and the nodes are aggregated with
+      respect to the strength of their connections. The tentative
+      prolongation interpolates exactly the near null space B of the
+      operator (constant vectors by default, rigid body modes for
+      elasticity) on each aggregate, and is smoothed by a damped Jacobi
+      step. One application of the preconditioner is a V-cycle with
+      damped Jacobi smoothing and a dense direct solve on the coarsest
+      level. When the coarsening stops on a level larger than
+      max_coarse_lu (matrices without strong connections, max_levels
+      reached), the dense factorization is not computed and the coarsest
+      level is approximately solved by nb_coarse_sweeps symmetric
+      Gauss-Seidel sweeps, which keeps the preconditioner symmetric.
+      The setup, the smoothing and the residual computations are
+      parallelized with OpenMP when gmm is compiled with it.
+
+      The parameters theta (strength threshold), coarse_size,
+      max_levels, nb_smooth (number of pre and post smoothing steps),
+      max_coarse_lu and nb_coarse_sweeps have to be set before build_with
+      is called.
+  */
+  template <typename Matrix> class amg_precond {
+  public:
+    typedef typename linalg_traits<Matrix>::value_type value_type;
+    typedef typename number_traits<value_type>::magnitude_type magnitude_type;
+    typedef value_type T;
+    typedef magnitude_type R;
+
+    R theta;               // strength of connection threshold
+    size_type coarse_size; // size under which the level is solved directly
+    size_type max_levels;
+    size_type nb_smooth;   // number of Jacobi pre and post smoothing steps
+    size_type max_coarse_lu;    // maximal size of the dense coarse solve
+    size_type nb_coarse_sweeps; // Gauss-Seidel sweeps above this size
+
+  protected:
+
+    enum { PAR_MIN = 4096 }; // minimal size for a parallel loop
+
+    struct sp_mat { // compressed row storage
+      size_type nr = 0, nc = 0;
+      std::vector<size_type> ptr, ind;
+      std::vector<T> val;
+      size_type nnz() const { return ind.size(); }
+    };
+
+    struct level {
+      sp_mat A;
+      sp_mat P, Rt;              // prolongation from next level, P^H
+      std::vector<T> dinv;       // damped inverse of the diagonal of A
+      std::vector<size_type> node_ptr; // dofs of node I: [node_ptr[I], ..[I+1])
+    };
+
+    std::vector<level> levels;
+    dense_matrix<T> coarse_lu;
+    lapack_ipvt coarse_ipvt;
+    std::vector<T> coarse_dinv; // inverse of the diagonal, without LU
+
+    // y = A x
+    static void sp_mult(const sp_mat &A, const std::vector<T> &x,
+                        std::vector<T> &y) {
+      parallel_blocks(A.nr, [&](size_type i0, size_type i1) {
+        for (size_type i = i0; i < i1; ++i) {
+          T s(0);
+          for (size_type k = A.ptr[i]; k < A.ptr[i+1]; ++k)
+            s += A.val[k] * x[A.ind[k]];
+          y[i] = s;
+        }
+      }, PAR_MIN);
+    }
+
+    // C = A B, computed in two passes (pattern, then values)
+    static void sp_mult(const sp_mat &A, const sp_mat &B, sp_mat &C) {
+      C.nr = A.nr; C.nc = B.nc;
+      C.ptr.assign(A.nr+1, 0);
+      parallel_blocks(A.nr, [&](size_type i0, size_type i1) {
+        std::vector<size_type> mark(B.nc, size_type(-1));
+        for (size_type i = i0; i < i1; ++i) {
+          size_type cnt = 0;
+          for (size_type ka = A.ptr[i]; ka < A.ptr[i+1]; ++ka) {
+            size_type j = A.ind[ka];
+            for (size_type kb = B.ptr[j]; kb < B.ptr[j+1]; ++kb)
+              if (mark[B.ind[kb]] != i) { mark[B.ind[kb]] = i; ++cnt; }
+          }
+          C.ptr[i+1] = cnt;
+        }
+      }, PAR_MIN);
+      for (size_type i = 0; i < A.nr; ++i) C.ptr[i+1] += C.ptr[i];
+      C.ind.resize(C.ptr[A.nr]); C.val.resize(C.ptr[A.nr]);
+      parallel_blocks(A.nr, [&](size_type i0, size_type i1) {
+        std::vector<size_type> pos(B.nc, size_type(-1));
+        for (size_type i = i0; i < i1; ++i) {
+          size_type start = C.ptr[i], end = start;
+          for (size_type ka = A.ptr[i]; ka < A.ptr[i+1]; ++ka) {
+            size_type j = A.ind[ka];
+            for (size_type kb = B.ptr[j]; kb < B.ptr[j+1]; ++kb) {
+              size_type c = B.ind[kb];
+              if (pos[c] == size_type(-1) || pos[c] < start) {
+                pos[c] = end; C.ind[end] = c;
+                C.val[end++] = A.val[ka] * B.val[kb];
+              } else
+                C.val[pos[c]] += A.val[ka] * B.val[kb];
+            }
+          }
+        }
+      }, PAR_MIN);
+    }
+
+    // B = A^H
+    static void sp_transpose(const sp_mat &A, sp_mat &B) {
+      B.nr = A.nc; B.nc = A.nr;
+      B.ptr.assign(B.nr+1, 0);
+      for (size_type k = 0; k < A.nnz(); ++k) ++(B.ptr[A.ind[k]+1]);
+      for (size_type i = 0; i < B.nr; ++i) B.ptr[i+1] += B.ptr[i];
+      B.ind.resize(A.nnz()); B.val.resize(A.nnz());
+      std::vector<size_type> pos(B.ptr.begin(), B.ptr.end()-1);
+      for (size_type i = 0; i < A.nr; ++i)
+        for (size_type k = A.ptr[i]; k < A.ptr[i+1]; ++k) {
+          size_type p = pos[A.ind[k]]++;
+          B.ind[p] = i; B.val[p] = gmm::conj(A.val[k]);
+        }
+    }
+
+    // Estimation of the spectral radius of D^{-1}A by a few power
+    // iterations, bounded by the Gershgorin estimate.
+    static R spectral_radius(const sp_mat &A, const std::vector<T> &diag) {
+      size_type n = A.nr;
+      R gersh(0);
+      for (size_type i = 0; i < n; ++i)
+        if (diag[i] != T(0)) {
+          R s(0);
+          for (size_type k = A.ptr[i]; k < A.ptr[i+1]; ++k)
+            s += gmm::abs(A.val[k]);
+          gersh = std::max(gersh, s / gmm::abs(diag[i]));
+        }
+      std::vector<T> x(n), y(n);
+      for (size_type i = 0; i < n; ++i)
+        x[i] = T(R(1) + R((i * 7919) % 113) / R(113));
+      R rho(0);
+      for (size_type it = 0; it < 15; ++it) {
+        R nx = vect_norm2(x);
+        if (nx == R(0)) break;
+        scale(x, T(R(1) / nx));
+        sp_mult(A, x, y);
+        for (size_type i = 0; i < n; ++i)
+          y[i] = (diag[i] != T(0)) ? y[i] / diag[i] : T(0);
+        rho = vect_norm2(y);
+        std::swap(x, y);
+      }
+      rho *= R(11)/R(10);
+      return (gersh > R(0)) ? std::min(rho, gersh) : rho;
+    }
+
+    // Strongly connected neighbour nodes of each node (graph in CRS form)
+    void strength_graph(const level &L, std::vector<size_type> &gptr,
+                        std::vector<size_type> &gind) const {
+      const sp_mat &A = L.A;
+      size_type nn = L.node_ptr.size() - 1;
+      std::vector<size_type> node_of(A.nr);
+      for (size_type I = 0; I < nn; ++I)
+        for (size_type i = L.node_ptr[I]; i < L.node_ptr[I+1]; ++i)
+          node_of[i] = I;
+      std::vector<R> dnorm(nn, R(0));
+      parallel_blocks(nn, [&](size_type I0, size_type I1) {
+        for (size_type I = I0; I < I1; ++I)
+          for (size_type i = L.node_ptr[I]; i < L.node_ptr[I+1]; ++i)
+            for (size_type k = A.ptr[i]; k < A.ptr[i+1]; ++k)
+              if (node_of[A.ind[k]] == I)
+                dnorm[I] += gmm::abs_sqr(A.val[k]);
+      }, PAR_MIN);
+      R theta2 = theta * theta;
+      gptr.assign(nn+1, 0);
+      for (size_type pass = 0; pass < 2; ++pass) {
+        if (pass == 1) {
+          for (size_type I = 0; I < nn; ++I) gptr[I+1] += gptr[I];
+          gind.resize(gptr[nn]);
+        }
+        parallel_blocks(nn, [&](size_type I0, size_type I1) {
+          std::vector<R> s(nn, R(0));
+          std::vector<size_type> nbr;
+          for (size_type I = I0; I < I1; ++I) {
+            nbr.resize(0);
+            for (size_type i = L.node_ptr[I]; i < L.node_ptr[I+1]; ++i)
+              for (size_type k = A.ptr[i]; k < A.ptr[i+1]; ++k) {
+                size_type J = node_of[A.ind[k]];
+                if (J == I) continue;
+                if (s[J] == R(0)) nbr.push_back(J);
+                s[J] += gmm::abs_sqr(A.val[k]);
+              }
+            size_type cnt = 0;
+            for (size_type J : nbr) {
+              if (s[J] > R(0)
+                  && s[J] >= theta2 * gmm::sqrt(dnorm[I] * dnorm[J])) {
+                if (pass == 1) gind[gptr[I] + cnt] = J;
+                ++cnt;
+              }
+              s[J] = R(0);
+            }
+            if (pass == 0) gptr[I+1] = cnt;
+          }
+        }, PAR_MIN);
+      }
+    }
+
+    // Greedy aggregation of the nodes. Nodes without strong connections
+    // are left out (size_type(-1)). Returns the number of aggregates.
+    static size_type aggregate(const std::vector<size_type> &gptr,
+                               const std::vector<size_type> &gind,
+                               std::vector<size_type> &agg) {
+      const size_type none(-1);
+      size_type nn = gptr.size() - 1, na = 0;
+      agg.assign(nn, none);
+      for (size_type I = 0; I < nn; ++I) { // aggregates of whole neighbourhoods
+        if (agg[I] != none || gptr[I] == gptr[I+1]) continue;
+        bool free = true;
+        for (size_type k = gptr[I]; k < gptr[I+1] && free; ++k)
+          free = (agg[gind[k]] == none);
+        if (!free) continue;
+        agg[I] = na;
+        for (size_type k = gptr[I]; k < gptr[I+1]; ++k) agg[gind[k]] = na;
+        ++na;
+      }
+      std::vector<size_type> agg1(agg);
+      for (size_type I = 0; I < nn; ++I) // attach to a neighbour aggregate
+        if (agg[I] == none)
+          for (size_type k = gptr[I]; k < gptr[I+1]; ++k)
+            if (agg1[gind[k]] != none) { agg[I] = agg1[gind[k]]; break; }
+      for (size_type I = 0; I < nn; ++I) { // remaining nodes
+        if (agg[I] != none || gptr[I] == gptr[I+1]) continue;
+        agg[I] = na;
+        for (size_type k = gptr[I]; k < gptr[I+1]; ++k)
+          if (agg[gind[k]] == none) agg[gind[k]] = na;
+        ++na;
+      }
+      return na;
+    }
+
+    // Tentative prolongation: orthonormalization of the near null space
+    // B (column major, n x nb) on each aggregate. Bc receives the near
+    // null space of the coarse level and Lc.node_ptr its node structure.
+    static void tentative_prolongation(const level &L,
+                                       const std::vector<size_type> &agg,
+                                       size_type na,
+                                       const std::vector<T> &B, size_type nb,
+                                       sp_mat &Pt, std::vector<T> &Bc,
+                                       level &Lc) {
+      size_type n = L.A.nr, nn = L.node_ptr.size() - 1;
+      std::vector<size_type> aptr(na+1, 0), adofs(n);
+      for (size_type I = 0; I < nn; ++I)
+        if (agg[I] != size_type(-1))
+          aptr[agg[I]+1] += L.node_ptr[I+1] - L.node_ptr[I];
+      for (size_type a = 0; a < na; ++a) aptr[a+1] += aptr[a];
+      std::vector<size_type> pos(aptr.begin(), aptr.end()-1);
+      for (size_type I = 0; I < nn; ++I)
+        if (agg[I] != size_type(-1))
+          for (size_type i = L.node_ptr[I]; i < L.node_ptr[I+1]; ++i)
+            adofs[pos[agg[I]]++] = i;
+
+      // Modified Gram-Schmidt on each aggregate, Q stored by columns.
+      std::vector<T> Q(aptr[na] * nb), Rf(na * nb * nb, T(0));
+      std::vector<size_type> nkept(na, 0);
+      parallel_blocks(na, [&](size_type a0, size_type a1) {
+        for (size_type a = a0; a < a1; ++a) {
+          size_type m = aptr[a+1] - aptr[a], kept = 0;
+          T *q = &Q[0] + aptr[a] * nb, *r = &Rf[0] + a * nb * nb;
+          for (size_type c = 0; c < nb; ++c) {
+            T *v = q + kept * m;
+            for (size_type l = 0; l < m; ++l) v[l] = B[adofs[aptr[a]+l] + c*n];
+            R nrm0(0), nrm(0);
+            for (size_type l = 0; l < m; ++l) nrm0 += gmm::abs_sqr(v[l]);
+            for (size_type p = 0; p < kept; ++p) {
+              T s(0);
+              for (size_type l = 0; l < m; ++l) s += gmm::conj(q[p*m+l]) * v[l];
+              for (size_type l = 0; l < m; ++l) v[l] -= s * q[p*m+l];
+              r[p*nb+c] = s;
+            }
+            for (size_type l = 0; l < m; ++l) nrm += gmm::abs_sqr(v[l]);
+            nrm = gmm::sqrt(nrm);
+            if (kept < m && nrm > R(1E-10) * gmm::sqrt(nrm0)) {
+              for (size_type l = 0; l < m; ++l) v[l] /= nrm;
+              r[kept*nb+c] = T(nrm);
+              ++kept;
+            }
+          }
+          nkept[a] = kept;
+        }
+      }, PAR_MIN);
+
+      Lc.node_ptr.assign(na+1, 0);
+      for (size_type a = 0; a < na; ++a)
+        Lc.node_ptr[a+1] = Lc.node_ptr[a] + nkept[a];
+      size_type nc = Lc.node_ptr[na];
+
+      Pt.nr = n; Pt.nc = nc; Pt.ptr.assign(n+1, 0);
+      std::vector<size_type> agg_of(n, size_type(-1)), loc(n);
+      for (size_type a = 0; a < na; ++a)
+        for (size_type l = 0; l < aptr[a+1] - aptr[a]; ++l)
+          { agg_of[adofs[aptr[a]+l]] = a; loc[adofs[aptr[a]+l]] = l; }
+      for (size_type i = 0; i < n; ++i)
+        Pt.ptr[i+1] = Pt.ptr[i]
+          + ((agg_of[i] == size_type(-1)) ? 0 : nkept[agg_of[i]]);
+      Pt.ind.resize(Pt.ptr[n]); Pt.val.resize(Pt.ptr[n]);
+      for (size_type i = 0; i < n; ++i)
+        if (agg_of[i] != size_type(-1)) {
+          size_type a = agg_of[i], m = aptr[a+1] - aptr[a];
+          for (size_type p = 0; p < nkept[a]; ++p) {
+            Pt.ind[Pt.ptr[i]+p] = Lc.node_ptr[a] + p;
+            Pt.val[Pt.ptr[i]+p] = Q[aptr[a]*nb + p*m + loc[i]];
+          }
+        }
+
+      Bc.assign(nc * nb, T(0));
+      for (size_type a = 0; a < na; ++a)
+        for (size_type p = 0; p < nkept[a]; ++p)
+          for (size_type c = 0; c < nb; ++c)
+            Bc[Lc.node_ptr[a] + p + c*nc] = Rf[a*nb*nb + p*nb + c];
+    }
+
+    void set_smoother(level &L, std::vector<T> &diag) const {
+      size_type n = L.A.nr;
+      diag.assign(n, T(0));
+      for (size_type i = 0; i < n; ++i)
+        for (size_type k = L.A.ptr[i]; k < L.A.ptr[i+1]; ++k)
+          if (L.A.ind[k] == i) diag[i] += L.A.val[k];
+      R omega = R(4) / (R(3) * spectral_radius(L.A, diag));
+      L.dinv.resize(n);
+      for (size_type i = 0; i < n; ++i)
+        L.dinv[i] = (diag[i] != T(0)) ? T(omega) / diag[i] : T(0);
+    }
+
+    void setup(std::vector<T> B, size_type nb) {
+      std::vector<T> diag, Bc;
+      std::vector<size_type> gptr, gind, agg;
+      for (;;) {
+        level &L = levels.back();
+        size_type n = L.A.nr;
+        if (n <= coarse_size || levels.size() >= max_levels) break;
+        strength_graph(L, gptr, gind);
+        size_type na = aggregate(gptr, gind, agg);
+        if (na == 0) break;
+        level Lc;
+        sp_mat Pt, S, AP;
+        tentative_prolongation(L, agg, na, B, nb, Pt, Bc, Lc);
+        if (Lc.node_ptr[na] == 0 || Lc.node_ptr[na] >= n) break;
+
+        // Prolongation smoothing P = (I - omega D^{-1} A) Pt
+        set_smoother(L, diag);
+        S = L.A;
+        for (size_type i = 0; i < n; ++i) {
+          bool found_diag = false;
+          for (size_type k = S.ptr[i]; k < S.ptr[i+1]; ++k) {
+            S.val[k] *= -L.dinv[i];
+            if (S.ind[k] == i) { S.val[k] += T(1); found_diag = true; }
+          }
+          GMM_ASSERT1(found_diag || L.dinv[i] == T(0),
+                      "Internal error in amg setup");
+        }
+        for (size_type i = 0; i < n; ++i) // rows with a zero diagonal
+          if (L.dinv[i] == T(0)) {
+            for (size_type k = S.ptr[i]; k < S.ptr[i+1]; ++k)
+              S.val[k] = (S.ind[k] == i) ? T(1) : T(0);
+          }
+        sp_mult(S, Pt, L.P);
+        sp_transpose(L.P, L.Rt);
+
+        // Galerkin coarse operator
+        sp_mult(L.A, L.P, AP);
+        sp_mult(L.Rt, AP, Lc.A);
+        levels.push_back(std::move(Lc));
+        std::swap(B, Bc);
+      }
+
+      // Direct solver on the coarsest level
+      level &L = levels.back();
+      set_smoother(L, diag);
+      size_type n = L.A.nr;
+      coarse_dinv.clear();
+      if (n > max_coarse_lu) {
+        gmm::resize(coarse_lu, 0, 0);
+        coarse_ipvt.resize(0);
+        coarse_dinv.resize(n);
+        for (size_type i = 0; i < n; ++i)
+          coarse_dinv[i] = (diag[i] != T(0)) ? T(1) / diag[i] : T(0);
+        return;
+      }
+      gmm::resize(coarse_lu, n, n); gmm::clear(coarse_lu);
+      R maxd(0);
+      for (size_type i = 0; i < n; ++i) {
+        for (size_type k = L.A.ptr[i]; k < L.A.ptr[i+1]; ++k)
+          coarse_lu(i, L.A.ind[k]) += L.A.val[k];
+        maxd = std::max(maxd, gmm::abs(coarse_lu(i, i)));
+      }
+      coarse_ipvt.resize(n);
+      dense_matrix<T> Ac(coarse_lu);
+      if (n && lu_factor(coarse_lu, coarse_ipvt)) {
+        // singular coarse matrix (floating modes): small regularization
+        gmm::copy(Ac, coarse_lu);
+        for (size_type i = 0; i < n; ++i)
+          coarse_lu(i, i) += T(R(1E-10) * std::max(maxd, R(1)));
+        GMM_ASSERT1(!lu_factor(coarse_lu, coarse_ipvt),
+                    "Singular coarse matrix in amg preconditioner");
+      }
+    }
+
+    // Symmetric Gauss-Seidel sweeps on the coarsest level, from x = 0
+    void coarse_sweeps(const level &L, const std::vector<T> &b,
+                       std::vector<T> &x) const {
+      size_type n = L.A.nr;
+      auto relax = [&](size_type i) {
+        T s = b[i];
+        for (size_type k = L.A.ptr[i]; k < L.A.ptr[i+1]; ++k)
+          s -= L.A.val[k] * x[L.A.ind[k]];
+        x[i] += coarse_dinv[i] * s;
+      };
+      std::fill(x.begin(), x.end(), T(0));
+      for (size_type s = 0; s < nb_coarse_sweeps; ++s) {
+        for (size_type i = 0; i < n; ++i) relax(i);
+        for (size_type i = n; i > 0; --i) relax(i-1);
+      }
+    }
+
+    void vcycle(size_type l, const std::vector<T> &b,
+                std::vector<T> &x) const {
+      const level &L = levels[l];
+      size_type n = L.A.nr;
+      if (l+1 == levels.size()) {
+        if (!coarse_dinv.empty()) coarse_sweeps(L, b, x);
+        else if (n) lu_solve(coarse_lu, coarse_ipvt, x, b);
+        return;
+      }
+      std::vector<T> xn(n), r(n);
+      auto jacobi = [&]() {
+        parallel_blocks(n, [&](size_type i0, size_type i1) {
+          for (size_type i = i0; i < i1; ++i) {
+            T s = b[i];
+            for (size_type k = L.A.ptr[i]; k < L.A.ptr[i+1]; ++k)
+              s -= L.A.val[k] * x[L.A.ind[k]];
+            xn[i] = x[i] + L.dinv[i] * s;
+          }
+        }, PAR_MIN);
+        std::swap(x, xn);
+      };
+      for (size_type i = 0; i < n; ++i) x[i] = L.dinv[i] * b[i];
+      for (size_type s = 1; s < nb_smooth; ++s) jacobi();
+      sp_mult(L.A, x, r);
+      parallel_blocks(n, [&](size_type i0, size_type i1) {
+        for (size_type i = i0; i < i1; ++i) r[i] = b[i] - r[i];
+      }, PAR_MIN);
+      std::vector<T> bc(L.P.nc), xc(L.P.nc);
+      sp_mult(L.Rt, r, bc);
+      vcycle(l+1, bc, xc);
+      sp_mult(L.P, xc, r);
+      parallel_blocks(n, [&](size_type i0, size_type i1) {
+        for (size_type i = i0; i < i1; ++i) x[i] += r[i];
+      }, PAR_MIN);
+      for (size_type s = 0; s < nb_smooth; ++s) jacobi();
+    }
+
+  public:
+
+    /** Build the hierarchy for the matrix A with the constant vectors of
+        each of the block_size components as near null space. */
+    void build_with(const Matrix &A, size_type block_size = 1) {
+      size_type n = mat_nrows(A);
+      std::vector<T> B(n * block_size, T(0));
+      for (size_type i = 0; i < n; ++i) B[i + n * (i % block_size)] = T(1);
+      build_with_(A, B, block_size, block_size);
+    }
+
+    /** Build the hierarchy for the matrix A with the columns of the
+        dense matrix NS (of size mat_nrows(A) x k) as near null space.
+        block_size consecutive dofs are aggregated together. */
+    template <typename DMAT>
+    void build_with(const Matrix &A, const DMAT &NS, size_type block_size) {
+      size_type n = mat_nrows(A), nb = mat_ncols(NS);
+      GMM_ASSERT1(mat_nrows(NS) == n, "dimensions mismatch");
+      std::vector<T> B(n * nb);
+      for (size_type c = 0; c < nb; ++c)
+        for (size_type i = 0; i < n; ++i) B[i + n*c] = T(NS(i, c));
+      build_with_(A, B, nb, block_size);
+    }
+
+  protected:
+    void build_with_(const Matrix &A, std::vector<T> &B, size_type nb,
+                     size_type block_size) {
+      size_type n = mat_nrows(A);
+      GMM_ASSERT1(n == mat_ncols(A), "Non-square matrix");
+      GMM_ASSERT1(block_size > 0 && n % block_size == 0,
+                  "The block size should divide the matrix size");
+      levels.clear();
+      levels.push_back(level());
+      level &L = levels.back();
+      csr_matrix<T> M; M.init_with(A);
+      L.A.nr = L.A.nc = n;
+      L.A.ptr.assign(M.jc.begin(), M.jc.end());
+      L.A.ind.assign(M.ir.begin(), M.ir.end());
+      L.A.val.assign(M.pr.begin(), M.pr.end());
+      L.node_ptr.resize(n / block_size + 1);
+      for (size_type I = 0; I <= n / block_size; ++I)
+        L.node_ptr[I] = I * block_size;
+      setup(B, nb);
+    }
+
+  public:
+    /** Return true if the hierarchy has been built with a matrix equal to
+        A (same pattern and values), in which case it can be reused. */
+    bool is_built_with(const Matrix &A) const {
+      if (levels.empty() || mat_nrows(A) != levels[0].A.nr
+          || mat_ncols(A) != levels[0].A.nc) return false;
+      csr_matrix<T> M; M.init_with(A);
+      const sp_mat &A0 = levels[0].A;
+      return std::equal(A0.ptr.begin(), A0.ptr.end(), M.jc.begin())
+        && A0.nnz() == M.ir.size()
+        && std::equal(A0.ind.begin(), A0.ind.end(), M.ir.begin())
+        && std::equal(A0.val.begin(), A0.val.end(), M.pr.begin());
+    }
+    size_type nb_levels() const { return levels.size(); }
+    /** True if the coarsest level is solved by a dense factorization. */
+    bool is_coarse_level_factorized() const
+    { return levels.size() && coarse_dinv.empty(); }
+    size_type level_size(size_type l) const { return levels[l].A.nr; }
+    /** Total number of nonzeros of the hierarchy divided by the one of
+        the fine matrix. */
+    double operator_complexity() const {
+      double s = 0.;
+      for (const level &L : levels) s += double(L.A.nnz());
+      return levels.size() ? s / double(levels[0].A.nnz()) : 0.;
+    }
+    size_type memsize() const {
+      size_type s = sizeof(*this)
+        + (coarse_lu.size() + coarse_dinv.size()) * sizeof(T);
+      for (const level &L : levels)
+        s += (L.A.nnz() + L.P.nnz() + L.Rt.nnz())
+          * (sizeof(T) + sizeof(size_type)) + L.dinv.size() * sizeof(T);
+      return s;
+    }
+
+    template <typename V1, typename V2> void apply(const V1 &v1, V2 &v2) const {
+      GMM_ASSERT1(levels.size(), "Uninitialized amg preconditioner");
+      std::vector<T> b(vect_size(v1)), x(vect_size(v1));
+      gmm::copy(v1, b);
+      vcycle(0, b, x);
+      gmm::copy(x, v2);
+    }
+
+    amg_precond(const Matrix &A, size_type block_size = 1)
+      : theta(R(8)/R(100)), coarse_size(300), max_levels(25), nb_smooth(1),
+        max_coarse_lu(2000), nb_coarse_sweeps(3)
+    { build_with(A, block_size); }
+    template <typename DMAT>
+    amg_precond(const Matrix &A, const DMAT &NS, size_type block_size)
+      : theta(R(8)/R(100)), coarse_size(300), max_levels(25), nb_smooth(1),
+        max_coarse_lu(2000), nb_coarse_sweeps(3)
+    { build_with(A, NS, block_size); }
+    amg_precond()
+      : theta(R(8)/R(100)), coarse_size(300), max_levels(25), nb_smooth(1),
+        max_coarse_lu(2000), nb_coarse_sweeps(3)
+    {}
+  };
+
+  template <typename Matrix, typename V1, typename V2> inline
+  void mult(const amg_precond<Matrix>& P, const V1 &v1, V2 &v2)
+  { P.apply(v1, v2); }
+
+  template <typename Matrix, typename V1, typename V2> inline
+  void transposed_mult(const amg_precond<Matrix>& P, const V1 &v1, V2 &v2)
+  { P.apply(v1, v2); }
+
+  template <typename Matrix, typename V1, typename V2> inline
+  void left_mult(const amg_precond<Matrix>& P, const V1 &v1, V2 &v2)
+  { P.apply(v1, v2); }
+
+  template <typename Matrix, typename V1, typename V2> inline
+  void right_mult(const amg_precond<Matrix>&, const V1 &v1, V2 &v2)
+  { copy(v1, v2); }
+
+  template <typename Matrix, typename V1, typename V2> inline
+  void transposed_left_mult(const amg_precond<Matrix>& P,
+                            const V1 &v1, V2 &v2)
+  { P.apply(v1, v2); }
+
+  template <typename Matrix, typename V1, typename V2> inline
+  void transposed_right_mult(const amg_precond<Matrix>&,
+                             const V1 &v1, V2 &v2)
+  { copy(v1, v2); }
+
+}
+
+#endif
+
@@ -87,6 +87,7 @@ namespace gmm {
 
     typedef typename temporary_dense_vector<Vector1>::vector_type temp_vector;
     typedef typename linalg_traits<Vector1>::value_type T;
+    typedef typename number_traits<T>::magnitude_type R;
 
     T rho, rho_1(0), a;
     temp_vector p(vect_size(x)), q(vect_size(x)), r(vect_size(x)),
@@ -100,8 +101,9 @@ namespace gmm {
       mult(P, r, z);
       rho = vect_hp(PS, z, r);
       copy(z, p);
+      R rn = vect_norm2(r);
 
-      while (!iter.finished_vect(r)) {
+      while (!iter.finished(rn)) {
 
 	if (!iter.first()) { 
 	  mult(P, r, z);
@@ -112,7 +114,7 @@ namespace gmm {
 
 	a = rho / vect_hp(PS, q, p);	
 	add(scaled(p, a), x);
-	add(scaled(q, -a), r);
+	rn = gmm::sqrt(add_and_norm2_sqr(scaled(q, -a), r));
 	rho_1 = rho;
 
 	++iter;
@@ -127,6 +129,7 @@ namespace gmm {
 
     typedef typename temporary_dense_vector<Vector1>::vector_type temp_vector;
     typedef typename linalg_traits<Vector1>::value_type T;
+    typedef typename number_traits<T>::magnitude_type R;
 
     T rho, rho_1(0), a;
     temp_vector p(vect_size(x)), q(vect_size(x)), r(vect_size(x));
@@ -138,8 +141,9 @@ namespace gmm {
       mult(A, scaled(x, T(-1)), b, r);
       rho = vect_hp(PS, r, r);
       copy(r, p);
+      R rn = vect_norm2(r);
 
-      while (!iter.finished_vect(r)) {
+      while (!iter.finished(rn)) {
 
 	if (!iter.first()) { 
 	  rho = vect_hp(PS, r, r);
@@ -148,7 +152,7 @@ namespace gmm {
 	mult(A, p, q);
 	a = rho / vect_hp(PS, q, p);	
 	add(scaled(p, a), x);
-	add(scaled(q, -a), r);
+	rn = gmm::sqrt(add_and_norm2_sqr(scaled(q, -a), r));
 	rho_1 = rho;
 	++iter;
       }
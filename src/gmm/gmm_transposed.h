@@ -125,6 +125,10 @@ namespace gmm {
   (std::ostream &o, const transposed_row_ref<PT>& m)
   { gmm::write(o,m); return o; }
 
+  template <typename PT> struct omp_safe_matrix<transposed_row_ref<PT> >
+    : omp_safe_matrix<typename std::decay<
+        typename std::remove_pointer<PT>::type>::type> {};
+
   template <typename PT> struct  transposed_col_ref {
     
     typedef transposed_col_ref<PT> this_type;
@@ -208,6 +212,10 @@ namespace gmm {
   (std::ostream &o, const transposed_col_ref<PT>& m)
   { gmm::write(o,m); return o; }
 
+  template <typename PT> struct omp_safe_matrix<transposed_col_ref<PT> >
+    : omp_safe_matrix<typename std::decay<
+        typename std::remove_pointer<PT>::type>::type> {};
+
   template <typename TYPE, typename PT> struct transposed_return_ {
     typedef abstract_null_type return_type;
   };
@@ -0,0 +1,168 @@
+/*===========================================================================
+
+ Copyright (C) 2026 agent.
+
+ This file is a part of GetFEM
+
+ GetFEM  is  free software;  you  can  redistribute  it  and/or modify it
+ under  the  terms  of the  GNU  Lesser General Public License as published
+ by  the  Free Software Foundation;  either version 3 of the License,  or
+ (at your option) any later version along with the GCC Runtime Library
+ Exception either version 3.1 or (at your option) any later version.
+ This program  is  distributed  in  the  hope  that it will be useful,  but
+ WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ or  FITNESS  FOR  A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ License and GCC Runtime Library Exception for more details.
+ You  should  have received a copy of the GNU Lesser General Public License
+ along  with  this program. If not, see https://www.gnu.org/licenses/.
+
+===========================================================================*/
+/**
+   Test of the HHO reconstruction and stabilization operators on
+   polynomial data of the degree of the HHO method: the reconstructed
+   (symmetrized) gradients and values are exact and the stabilizations
+   vanish, on affine and non-affine elements.
+*/
+#include "getfem/getfem_regular_meshes.h"
+#include "getfem/getfem_HHO.h"
+
+using std::endl; using std::cout; using std::cerr;
+using bgeot::size_type;
+using bgeot::scalar_type;
+using bgeot::base_node;
+
+/* Regular mesh of the unit square or cube, sheared so that the elements
+   have no particular symmetry. The edges stay straight. */
+static void sheared_mesh(getfem::mesh &m, size_type N, size_type NX,
+                         bgeot::pgeometric_trans pgt) {
+  getfem::regular_unit_mesh(m, std::vector<size_type>(N, NX), pgt);
+  bgeot::base_matrix M(N, N);
+  for (size_type i = 0; i < N; ++i) {
+    M(i, i) = 1.;
+    if (i+1 < N) M(i, i+1) = 0.3;
+  }
+  M(N-1, 0) = -0.2;
+  m.transformation(M);
+}
+
+/* Exact polynomial field of degree 2 with value in R^Q. */
+static std::string polynomial(size_type N, size_type Q) {
+  const char *comp[3] = { "X(1)*X(1)-2*X(1)*X(2)+3*X(2)+1",
+                          "X(1)*X(2)+X(2)*X(2)-X(1)",
+                          "X(3)*X(1)-X(3)*X(3)+2*X(2)" };
+  std::stringstream s;
+  if (Q > 1) s << "[";
+  for (size_type k = 0; k < Q; ++k)
+    s << (k ? "," : "") << comp[k] << (N == 3 ? "+X(2)*X(3)" : "");
+  if (Q > 1) s << "]";
+  return s.str();
+}
+
+static scalar_type integral(const getfem::model &md,
+                            const getfem::mesh_im &mim,
+                            const std::string &expr,
+                            const getfem::mesh_region &rg
+                            = getfem::mesh_region::all_convexes()) {
+  getfem::ga_workspace workspace(md);
+  workspace.add_expression(expr, mim, rg);
+  workspace.assembly(0);
+  return workspace.assembled_potential();
+}
+
+static void check_zero(const getfem::model &md, const getfem::mesh_im &mim,
+                       const std::string &expr, const std::string &ref,
+                       const getfem::mesh_region &rg
+                       = getfem::mesh_region::all_convexes()) {
+  scalar_type e = gmm::sqrt(gmm::abs(integral(md, mim, expr, rg)));
+  scalar_type n = gmm::sqrt(gmm::abs(integral(md, mim, ref)));
+  cout << "  |" << expr << "| = " << e << endl;
+  GMM_ASSERT1(e < 1E-9 * n, "Operator not exact on polynomial data: "
+              << expr << " = " << e);
+}
+
+/* Scalar field (Q = 1) with the gradient reconstructions, or vector field
+   (Q = N) with the symmetrized ones. fem_u is the HHO method of degree 2,
+   fem_g and fem_r the fems of the reconstructed gradient and value. */
+static void test_HHO(size_type N, size_type Q, bgeot::pgeometric_trans pgt,
+                     const std::string &fem_u, const std::string &fem_g,
+                     const std::string &fem_r, size_type im_degree) {
+  cout << "Test of " << fem_u << " on " << bgeot::name_of_geometric_trans(pgt)
+       << (Q > 1 ? ", symmetrized operators" : "") << endl;
+  getfem::mesh m;
+  sheared_mesh(m, N, 3, pgt);
+  getfem::mesh_region all_faces = getfem::all_faces_of_mesh(m);
+
+  getfem::mesh_fem mfu(m, bgeot::dim_type(Q)), mfr(m, bgeot::dim_type(Q));
+  getfem::mesh_fem mfg(m, bgeot::dim_type(N));
+  if (Q > 1) mfg.set_qdim(bgeot::dim_type(Q), bgeot::dim_type(N));
+  mfu.set_finite_element(getfem::fem_descriptor(fem_u));
+  mfg.set_finite_element(getfem::fem_descriptor(fem_g));
+  mfr.set_finite_element(getfem::fem_descriptor(fem_r));
+  getfem::mesh_im mim(m);
+  mim.set_integration_method(bgeot::dim_type(im_degree));
+
+  getfem::model md;
+  md.add_fem_variable("u", mfu);
+  md.add_fem_data("Gu", mfg);
+  md.add_fem_data("ur", mfr);
+  md.add_fem_data("ue", mfr);
+  if (Q > 1) {
+    getfem::add_HHO_reconstructed_symmetrized_gradient(md, "HHO_Grad");
+    getfem::add_HHO_reconstructed_symmetrized_value(md, "HHO_Val");
+    getfem::add_HHO_symmetrized_stabilization(md, "HHO_Stab");
+  } else {
+    getfem::add_HHO_reconstructed_gradient(md, "HHO_Grad");
+    getfem::add_HHO_reconstructed_value(md, "HHO_Val");
+    getfem::add_HHO_stabilization(md, "HHO_Stab");
+  }
+  md.add_macro("HHO_Grad_u", "Elementary_transformation(u, HHO_Grad, Gu)");
+  md.add_macro("HHO_Val_u", "Elementary_transformation(u, HHO_Val, ur)");
+  md.add_macro("HHO_Stab_u", "Elementary_transformation(u, HHO_Stab)");
+
+  // The exact field is interpolated on the reconstruction fem of higher
+  // degree (ue) and on the HHO method (u).
+  std::string expr = polynomial(N, Q);
+  getfem::base_vector U(mfu.nb_dof()), Ue(mfr.nb_dof());
+  getfem::ga_interpolation_Lagrange_fem(md, expr, mfr, Ue);
+  gmm::copy(Ue, md.set_real_variable("ue"));
+  getfem::ga_interpolation_Lagrange_fem(md, expr, mfu, U);
+  gmm::copy(U, md.set_real_variable("u"));
+
+  std::string Grad_ue = (Q > 1) ? "Sym(Grad_ue)" : "Grad_ue";
+  check_zero(md, mim, "Norm_sqr(HHO_Grad_u-" + Grad_ue + ")",
+             "Norm_sqr(" + Grad_ue + ")");
+  check_zero(md, mim, "Norm_sqr(HHO_Val_u-ue)", "Norm_sqr(ue)");
+  check_zero(md, mim, "Norm_sqr(HHO_Stab_u)", "Norm_sqr(ue)", all_faces);
+
+  // A perturbation of a single interior value is seen by the stabilization
+  size_type cv = m.convex_index().first_true();
+  U[mfu.ind_basic_dof_of_element(cv)[0]] += 1.;
+  gmm::copy(U, md.set_real_variable("u"));
+  scalar_type s = integral(md, mim, "Norm_sqr(HHO_Stab_u)", all_faces);
+  cout << "  stabilization of a perturbed field: " << s << endl;
+  GMM_ASSERT1(s > 1E-6, "The stabilization vanishes on a perturbed field");
+}
+
+int main(void) {
+  GMM_SET_EXCEPTION_DEBUG;
+  for (size_type Q : {1, 2}) {
+    // Affine elements
+    test_HHO(2, Q, bgeot::simplex_geotrans(2, 1),
+             "FEM_HHO(FEM_SIMPLEX_IPK(2,2),FEM_SIMPLEX_CIPK(1,2))",
+             "FEM_PK(2,2)", "FEM_PK(2,3)", 6);
+    // Non-affine geometric transformations of straight elements
+    test_HHO(2, Q, bgeot::simplex_geotrans(2, 2),
+             "FEM_HHO(FEM_SIMPLEX_IPK(2,2),FEM_SIMPLEX_CIPK(1,2))",
+             "FEM_PK(2,2)", "FEM_PK(2,3)", 6);
+    test_HHO(2, Q, bgeot::parallelepiped_geotrans(2, 1),
+             "FEM_HHO(FEM_QUAD_IPK(2,2),FEM_SIMPLEX_CIPK(1,2))",
+             "FEM_QUAD_IPK(2,2)", "FEM_QUAD_IPK(2,3)", 8);
+  }
+  test_HHO(3, 1, bgeot::simplex_geotrans(3, 1),
+           "FEM_HHO(FEM_SIMPLEX_IPK(3,2),FEM_SIMPLEX_CIPK(2,2))",
+           "FEM_PK(3,2)", "FEM_PK(3,3)", 6);
+  test_HHO(3, 3, bgeot::simplex_geotrans(3, 1),
+           "FEM_HHO(FEM_SIMPLEX_IPK(3,2),FEM_SIMPLEX_CIPK(2,2))",
+           "FEM_PK(3,2)", "FEM_PK(3,3)", 6);
+  return 0;
+}
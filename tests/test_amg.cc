@@ -0,0 +1,194 @@
+/*===========================================================================
+
+ Copyright (C) 2026 agent.
+
+ This file is a part of GetFEM
+
+ GetFEM  is  free software;  you  can  redistribute  it  and/or modify it
+ under  the  terms  of the  GNU  Lesser General Public License as published
+ by  the  Free Software Foundation;  either version 3 of the License,  or
+ (at your option) any later version along with the GCC Runtime Library
+ Exception either version 3.1 or (at your option) any later version.
+ This program  is  distributed  in  the  hope  that it will be useful,  but
+ WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ or  FITNESS  FOR  A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ License and GCC Runtime Library Exception for more details.
+ You  should  have received a copy of the GNU Lesser General Public License
+ along  with  this program. If not, see https://www.gnu.org/licenses/.
+
+===========================================================================*/
+/**
+   Test of the smoothed aggregation algebraic multigrid preconditioner
+   (gmm::amg_precond) and of the "cg/amg" linear solver.
+*/
+#include "getfem/getfem_regular_meshes.h"
+#include "getfem/getfem_model_solvers.h"
+
+using std::endl; using std::cout; using std::cerr;
+using bgeot::size_type;
+using bgeot::scalar_type;
+
+typedef getfem::model_real_sparse_matrix MAT;
+typedef getfem::model_real_plain_vector VECT;
+typedef getfem::linear_solver_cg_preconditioned_amg<MAT, VECT> amg_solver;
+
+/* Matrix and right hand side of a Laplace (Q = 1) or linear elasticity
+   (Q = 2) problem on a regular NX x NX mesh of P1 triangles, with a
+   penalized Dirichlet condition on the bottom side. */
+static void build_problem(size_type NX, size_type Q, getfem::mesh &m,
+                          getfem::mesh_fem &mf, MAT &K, VECT &F) {
+  getfem::regular_unit_mesh(m, std::vector<size_type>(2, NX),
+                            bgeot::simplex_geotrans(2, 1));
+  getfem::mesh_region border;
+  getfem::outer_faces_of_mesh(m, border);
+  for (getfem::mr_visitor i(border); !i.finished(); ++i) {
+    bgeot::base_small_vector un = m.normal_of_face_of_convex(i.cv(), i.f());
+    if (un[1] < -0.5 * gmm::vect_norm2(un)) m.region(1).add(i.cv(), i.f());
+  }
+  mf.set_qdim(bgeot::dim_type(Q));
+  mf.set_classical_finite_element(1);
+  getfem::mesh_im mim(m);
+  mim.set_integration_method(2);
+
+  getfem::model md;
+  md.add_fem_variable("u", mf);
+  if (Q == 1) {
+    getfem::add_Laplacian_brick(md, mim, "u");
+    getfem::add_source_term_generic_assembly_brick(md, mim, "X(1)*Test_u");
+  } else {
+    md.add_initialized_scalar_data("lambda", 1.);
+    md.add_initialized_scalar_data("mu", 1.);
+    getfem::add_isotropic_linearized_elasticity_brick
+      (md, mim, "u", "lambda", "mu");
+    getfem::add_source_term_generic_assembly_brick
+      (md, mim, "[X(2), -X(1)].Test_u");
+  }
+  getfem::add_Dirichlet_condition_with_penalization(md, mim, "u", 1E4, 1);
+  md.assembly(getfem::model::BUILD_ALL);
+  gmm::resize(K, mf.nb_dof(), mf.nb_dof());
+  gmm::copy(md.real_tangent_matrix(), K);
+  gmm::resize(F, mf.nb_dof());
+  gmm::copy(md.real_rhs(), F);
+}
+
+static scalar_type relative_residual(const MAT &K, const VECT &x,
+                                     const VECT &F) {
+  VECT r(F.size());
+  gmm::mult(K, x, gmm::scaled(F, -1.), r);
+  return gmm::vect_norm2(r) / gmm::vect_norm2(F);
+}
+
+/* The number of cg iterations stays bounded when the mesh is refined. */
+static void test_scalability(size_type Q) {
+  size_type nbit[3];
+  for (size_type k = 0; k < 3; ++k) {
+    size_type NX = size_type(24) << k;
+    getfem::mesh m;
+    getfem::mesh_fem mf(m);
+    MAT K; VECT F;
+    build_problem(NX, Q, m, mf, K, F);
+    VECT x(mf.nb_dof());
+    amg_solver S(Q > 1 ? &mf : 0);
+    gmm::iteration iter(1E-10);
+    S(K, x, F, iter);
+    nbit[k] = iter.get_iteration();
+    cout << (Q == 1 ? "Laplacian" : "Elasticity") << ", " << mf.nb_dof()
+         << " dofs: " << S.P.nb_levels() << " levels, operator complexity "
+         << S.P.operator_complexity() << ", " << nbit[k]
+         << " cg iterations" << endl;
+    GMM_ASSERT1(iter.converged(), "cg/amg did not converge");
+    GMM_ASSERT1(relative_residual(K, x, F) < 1E-9, "Wrong solution");
+    GMM_ASSERT1(S.P.nb_levels() > 1, "No coarse level");
+  }
+  GMM_ASSERT1(nbit[2] <= nbit[0] + 10, "The number of iterations grows "
+              "with the size of the problem: " << nbit[0] << " -> "
+              << nbit[2]);
+}
+
+/* The hierarchy is built once and reused while the matrix is unchanged. */
+static void test_reuse() {
+  getfem::mesh m;
+  getfem::mesh_fem mf(m);
+  MAT K; VECT F;
+  build_problem(24, 2, m, mf, K, F);
+  amg_solver S(&mf);
+  GMM_ASSERT1(!S.P.is_built_with(K), "Hierarchy unexpectedly built");
+  VECT x(mf.nb_dof()), x2(mf.nb_dof());
+  gmm::iteration iter(1E-10);
+  S(K, x, F, iter);
+  GMM_ASSERT1(S.P.is_built_with(K), "The hierarchy is not kept");
+  size_type nb_levels = S.P.nb_levels(), n1 = S.P.level_size(1);
+
+  // Second solve with the same matrix: the kept hierarchy is used and
+  // gives the same iterates.
+  gmm::iteration iter2(1E-10);
+  S(K, x2, F, iter2);
+  GMM_ASSERT1(iter2.get_iteration() == iter.get_iteration()
+              && gmm::vect_dist2(x, x2) < 1E-12 * gmm::vect_norm2(x),
+              "Different result with the kept hierarchy");
+  GMM_ASSERT1(S.P.nb_levels() == nb_levels && S.P.level_size(1) == n1,
+              "Different hierarchy");
+
+  // A modified matrix gets a new hierarchy.
+  MAT K2(K);
+  for (size_type i = 0; i < gmm::mat_nrows(K2); ++i)
+    K2(i, i) = 2. * K2(i, i);
+  GMM_ASSERT1(!S.P.is_built_with(K2), "Matrix change not detected");
+  gmm::clear(x2);
+  gmm::iteration iter3(1E-10);
+  S(K2, x2, F, iter3);
+  GMM_ASSERT1(S.P.is_built_with(K2) && iter3.converged()
+              && relative_residual(K2, x2, F) < 1E-9,
+              "Wrong solution after a matrix change");
+}
+
+/* A coarsest level larger than max_coarse_lu is not factorized: a
+   diagonal matrix, which has no strong connection and is not coarsened,
+   and a Laplacian whose coarsening is stopped by max_levels. */
+static void test_large_coarse_level() {
+  size_type n = 5000;
+  MAT D(n, n);
+  VECT F(n), x(n);
+  for (size_type i = 0; i < n; ++i) {
+    D(i, i) = scalar_type(1 + i % 7);
+    F[i] = scalar_type(i % 3) - 1.;
+  }
+  amg_solver S;
+  gmm::iteration iter(1E-10);
+  S(D, x, F, iter);
+  cout << "Diagonal matrix: " << S.P.nb_levels() << " levels of size "
+       << S.P.level_size(S.P.nb_levels()-1) << ", " << iter.get_iteration()
+       << " cg iterations" << endl;
+  GMM_ASSERT1(!S.P.is_coarse_level_factorized(), "The coarse level of "
+              "size " << S.P.level_size(S.P.nb_levels()-1) << " is "
+              "factorized");
+  GMM_ASSERT1(iter.converged() && iter.get_iteration() <= 2
+              && relative_residual(D, x, F) < 1E-9, "Wrong solution");
+
+  getfem::mesh m;
+  getfem::mesh_fem mf(m);
+  MAT K;
+  build_problem(24, 1, m, mf, K, F);
+  amg_solver S2;
+  S2.P.max_levels = 2;
+  S2.P.max_coarse_lu = 50;
+  gmm::resize(x, mf.nb_dof()); gmm::clear(x);
+  gmm::iteration iter2(1E-10);
+  S2(K, x, F, iter2);
+  cout << "Laplacian, coarsest level of size " << S2.P.level_size(1)
+       << " without factorization: " << iter2.get_iteration()
+       << " cg iterations" << endl;
+  GMM_ASSERT1(S2.P.nb_levels() == 2 && S2.P.level_size(1) > 50
+              && !S2.P.is_coarse_level_factorized(), "Wrong hierarchy");
+  GMM_ASSERT1(iter2.converged() && relative_residual(K, x, F) < 1E-9,
+              "Wrong solution");
+}
+
+int main(void) {
+  GMM_SET_EXCEPTION_DEBUG;
+  test_scalability(1);
+  test_scalability(2);
+  test_reuse();
+  test_large_coarse_level();
+  return 0;
+}
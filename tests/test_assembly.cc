@@ -19,6 +19,7 @@
 ===========================================================================*/
 #include "getfem/getfem_assembling.h"
 #include "getfem/getfem_generic_assembly.h"
+#include "getfem/getfem_models.h"
 #include "getfem/getfem_export.h"
 #include "getfem/getfem_regular_meshes.h"
 #include "getfem/getfem_partial_mesh_fem.h"
@@ -886,6 +887,385 @@ static void test_new_assembly(int N, int NX, int pK) {
 
 
 
+static void test_colored_assembly(int N, int NX) {
+  getfem::mesh m;
+  std::vector<size_type> nsubdiv(N, NX);
+  getfem::regular_unit_mesh(m, nsubdiv, bgeot::simplex_geotrans(N, 1));
+  getfem::mesh_region border_faces = getfem::outer_faces_of_mesh(m);
+  m.region(1) = border_faces;
+
+  getfem::mesh_fem mf_u(m, dim_type(N)), mf_p(m);
+  mf_u.set_classical_finite_element(2);
+  mf_p.set_classical_finite_element(1);
+  getfem::mesh_im mim(m);
+  mim.set_integration_method(4);
+
+  getfem::model md;
+  md.add_fem_variable("u", mf_u);
+  md.add_fem_variable("p", mf_p);
+  base_vector U(mf_u.nb_dof()), P(mf_p.nb_dof());
+  gmm::fill_random(U); gmm::fill_random(P);
+  gmm::copy(U, md.set_real_variable("u"));
+  gmm::copy(P, md.set_real_variable("p"));
+  getfem::add_nonlinear_term
+    (md, mim, "(1+sqr(p))*Grad_u:Grad_Test_u + p*Div_Test_u"
+     "+ Div_u*Test_p + Norm_sqr(u)*Test_p");
+  getfem::add_nonlinear_term(md, mim, "(u.u)*(u.Test_u)", 1);
+
+  md.assembly(getfem::model::BUILD_ALL);
+  sparse_matrix_type K0(md.nb_dof(), md.nb_dof());
+  gmm::copy(md.real_tangent_matrix(), K0);
+  base_vector R0(md.real_rhs());
+
+  auto assembly_error = [&]() {
+    md.assembly(getfem::model::BUILD_ALL);
+    sparse_matrix_type K(md.nb_dof(), md.nb_dof());
+    gmm::copy(K0, K);
+    base_vector R(R0);
+    gmm::add(gmm::scaled(md.real_tangent_matrix(), scalar_type(-1)), K);
+    gmm::add(gmm::scaled(md.real_rhs(), scalar_type(-1)), R);
+    return std::max(gmm::mat_maxnorm(K), gmm::vect_norminf(R));
+  };
+
+  md.set_colored_assembly(true);
+  scalar_type err = assembly_error();
+  cout << "Colored assembly error : " << err << endl;
+  GMM_ASSERT1(err < 1E-10, "Error in colored assembly");
+
+  // The coloring is cached and has to follow the modifications of the mesh
+  dal::bit_vector refined;
+  for (dal::bv_visitor cv(m.convex_index()); !cv.finished(); ++cv)
+    if (cv % 2) refined.add(cv);
+  m.Bank_refine(refined);
+  gmm::resize(U, mf_u.nb_dof()); gmm::resize(P, mf_p.nb_dof());
+  gmm::fill_random(U); gmm::fill_random(P);
+  gmm::copy(U, md.set_real_variable("u"));
+  gmm::copy(P, md.set_real_variable("p"));
+  md.set_colored_assembly(false);
+  md.assembly(getfem::model::BUILD_ALL);
+  gmm::resize(K0, md.nb_dof(), md.nb_dof());
+  gmm::copy(md.real_tangent_matrix(), K0);
+  gmm::resize(R0, md.nb_dof());
+  gmm::copy(md.real_rhs(), R0);
+  md.set_colored_assembly(true);
+  err = assembly_error();
+  cout << "Colored assembly error after refinement : " << err << endl;
+  GMM_ASSERT1(err < 1E-10, "Error in colored assembly");
+}
+
+
+static void test_assembly_reuse(int N, int NX) {
+  getfem::mesh m;
+  std::vector<size_type> nsubdiv(N, NX);
+  getfem::regular_unit_mesh(m, nsubdiv, bgeot::simplex_geotrans(N, 1));
+  getfem::mesh_region border_faces = getfem::outer_faces_of_mesh(m);
+  m.region(1) = border_faces;
+
+  getfem::mesh_fem mf_u(m, dim_type(N)), mf_p(m);
+  mf_u.set_classical_finite_element(2);
+  mf_p.set_classical_finite_element(1);
+  getfem::mesh_im mim(m);
+  mim.set_integration_method(4);
+
+  getfem::model md;
+  md.add_fem_variable("u", mf_u);
+  md.add_fem_variable("p", mf_p);
+  base_vector U(mf_u.nb_dof()), P(mf_p.nb_dof());
+  gmm::fill_random(U); gmm::fill_random(P);
+  gmm::copy(U, md.set_real_variable("u"));
+  gmm::copy(P, md.set_real_variable("p"));
+  getfem::add_nonlinear_term
+    (md, mim, "(1+sqr(p))*Grad_u:Grad_Test_u + p*Div_Test_u"
+     "+ Div_u*Test_p + Norm_sqr(u)*Test_p");
+  getfem::add_nonlinear_term(md, mim, "(u.u)*(u.Test_u)", 1);
+
+  md.assembly(getfem::model::BUILD_ALL);
+  sparse_matrix_type K0(md.nb_dof(), md.nb_dof());
+  gmm::copy(md.real_tangent_matrix(), K0);
+  base_vector R0(md.real_rhs());
+
+  auto assembly_error = [&]() {
+    md.assembly(getfem::model::BUILD_ALL);
+    sparse_matrix_type K(md.nb_dof(), md.nb_dof());
+    gmm::copy(K0, K);
+    base_vector R(R0);
+    gmm::add(gmm::scaled(md.real_tangent_matrix(), scalar_type(-1)), K);
+    gmm::add(gmm::scaled(md.real_rhs(), scalar_type(-1)), R);
+    scalar_type e = std::max(gmm::mat_maxnorm(K), gmm::vect_norminf(R));
+    // The compressed copy of the tangent matrix given to the solvers
+    const gmm::csc_matrix<scalar_type> *KC = md.real_tangent_matrix_csc();
+    GMM_ASSERT1((KC != 0) == md.is_tangent_matrix_pattern_reused(),
+                "Wrong compressed tangent matrix");
+    if (KC) {
+      gmm::copy(*KC, K);
+      gmm::add(gmm::scaled(md.real_tangent_matrix(), scalar_type(-1)), K);
+      e = std::max(e, gmm::mat_maxnorm(K));
+    }
+    return e;
+  };
+
+  // The second assembly records the positions of the element matrices in
+  // the pattern, the following ones add the contributions through them.
+  md.set_reuse_tangent_matrix_pattern(true);
+  scalar_type err = std::max(assembly_error(), assembly_error());
+  err = std::max(err, assembly_error());
+  cout << "Assembly with pattern reuse error : " << err << endl;
+  GMM_ASSERT1(err < 1E-10, "Error in assembly with pattern reuse");
+
+  md.set_colored_assembly(true);
+  err = std::max(assembly_error(), assembly_error());
+  cout << "Colored assembly with pattern reuse error : " << err << endl;
+  GMM_ASSERT1(err < 1E-10, "Error in assembly with pattern reuse");
+
+  // A new brick adds entries at the top of the columns of p, which shifts
+  // the recorded positions of the other entries of these columns
+  sparse_matrix_type B(mf_u.nb_dof(), mf_p.nb_dof());
+  for (size_type j = 0; j < mf_p.nb_dof(); ++j) B(0, j) = scalar_type(1);
+  size_type ib = getfem::add_explicit_matrix(md, "u", "p", B);
+  md.set_reuse_tangent_matrix_pattern(false);
+  md.assembly(getfem::model::BUILD_ALL);
+  gmm::copy(md.real_tangent_matrix(), K0);
+  gmm::copy(md.real_rhs(), R0);
+  md.set_colored_assembly(false);
+  md.disable_brick(ib);
+  md.set_reuse_tangent_matrix_pattern(true);
+  md.assembly(getfem::model::BUILD_ALL);
+  md.assembly(getfem::model::BUILD_ALL);
+  md.enable_brick(ib);
+  err = std::max(assembly_error(), assembly_error());
+  cout << "Assembly with pattern reuse after pattern change error : "
+       << err << endl;
+  GMM_ASSERT1(err < 1E-10, "Error in assembly with pattern reuse");
+  md.set_reuse_tangent_matrix_pattern(false);
+
+  md.set_generic_assembly_cache(true);
+  err = std::max(assembly_error(), assembly_error());
+  cout << "Assembly with compilation cache error : " << err << endl;
+  GMM_ASSERT1(err < 1E-10, "Error in assembly with compilation cache");
+  md.set_reuse_tangent_matrix_pattern(true);
+  err = std::max(assembly_error(), assembly_error());
+  err = std::max(err, assembly_error());
+  cout << "Assembly with compilation cache and pattern reuse error : "
+       << err << endl;
+  GMM_ASSERT1(err < 1E-10, "Error in assembly with compilation cache");
+  md.set_reuse_tangent_matrix_pattern(false);
+
+  // The cached instructions have to follow the values of the variables
+  gmm::scale(md.set_real_variable("p"), scalar_type(2));
+  md.assembly(getfem::model::BUILD_ALL);
+  gmm::copy(md.real_tangent_matrix(), K0);
+  gmm::copy(md.real_rhs(), R0);
+  md.set_generic_assembly_cache(false);
+  err = assembly_error();
+  cout << "Compilation cache error after update : " << err << endl;
+  GMM_ASSERT1(err < 1E-10, "Error in assembly with compilation cache");
+}
+
+
+static void test_matrix_free_operator(int N, int NX) {
+  getfem::mesh m;
+  std::vector<size_type> nsubdiv(N, NX);
+  getfem::regular_unit_mesh(m, nsubdiv, bgeot::simplex_geotrans(N, 1));
+
+  getfem::mesh_fem mf_u(m, dim_type(N)), mf_p(m);
+  mf_u.set_classical_finite_element(2);
+  mf_p.set_classical_finite_element(1);
+  getfem::mesh_im mim(m);
+  mim.set_integration_method(4);
+
+  base_vector U(mf_u.nb_dof()), P(mf_p.nb_dof());
+  gmm::fill_random(U); gmm::fill_random(P);
+  getfem::ga_workspace workspace;
+  workspace.add_fem_variable("u", mf_u, gmm::sub_interval(0, U.size()), U);
+  workspace.add_fem_variable("p", mf_p, gmm::sub_interval(U.size(),
+                                                           P.size()), P);
+  workspace.add_expression("(1+sqr(p))*Grad_u:Grad_Test_u + p*Div_Test_u"
+                           "+ Div_u*Test_p + Norm_sqr(u)*Test_p", mim);
+  size_type nd = workspace.nb_primary_dof();
+
+  // Reference: assembled tangent matrix
+  getfem::model_real_sparse_matrix K(nd, nd);
+  workspace.set_assembled_matrix(K);
+  workspace.assembly(2);
+
+  getfem::ga_matrix_free_operator KK(workspace);
+  base_vector X(nd), Y(nd), Y0(nd), D, D0(nd);
+  gmm::fill_random(X);
+  gmm::mult(K, X, Y0);
+  getfem::mult(KK, X, Y);
+  scalar_type err = gmm::vect_dist2(Y, Y0) / gmm::vect_norm2(Y0);
+  KK.diagonal(D);
+  for (size_type i = 0; i < nd; ++i) D0[i] = K(i, i);
+  err = std::max(err, gmm::vect_dist2(D, D0) / gmm::vect_norm2(D0));
+  cout << "Matrix-free product error : " << err << endl;
+  GMM_ASSERT1(err < 1E-10, "Error in matrix-free product");
+
+  // Solve of a Laplace problem with cg and Jacobi preconditioner
+  getfem::ga_workspace workspace2;
+  base_vector V(mf_p.nb_dof());
+  workspace2.add_fem_variable("v", mf_p, gmm::sub_interval(0, V.size()), V);
+  workspace2.add_expression("Grad_v.Grad_Test_v + v*Test_v", mim);
+  getfem::model_real_sparse_matrix K2(V.size(), V.size());
+  workspace2.set_assembled_matrix(K2);
+  workspace2.assembly(2);
+  base_vector B(V.size()), V0(V.size());
+  gmm::fill_random(B);
+  gmm::diagonal_precond<getfem::model_real_sparse_matrix> P0(K2);
+  gmm::iteration iter(1E-10);
+  gmm::cg(K2, V0, B, P0, iter);
+  getfem::ga_matrix_free_operator KK2(workspace2);
+  gmm::diagonal_precond<getfem::model_real_sparse_matrix> PP;
+  KK2.jacobi_precond(PP);
+  iter.init();
+  gmm::cg(KK2, V, B, PP, iter);
+  err = gmm::vect_dist2(V, V0) / gmm::vect_norm2(V0);
+  cout << "Matrix-free cg error : " << err << " (" << iter.get_iteration()
+       << " iterations)" << endl;
+  GMM_ASSERT1(err < 1E-8, "Error in matrix-free cg");
+}
+
+static void test_sum_factorization(int N, int NX, int K) {
+  getfem::mesh m;
+  std::vector<size_type> nsubdiv(N, NX);
+  getfem::regular_unit_mesh(m, nsubdiv, bgeot::parallelepiped_geotrans(N, 1),
+                            true);
+  m.region(1) = getfem::outer_faces_of_mesh(m);
+
+  getfem::mesh_fem mf_u(m, dim_type(N)), mf_p(m);
+  mf_u.set_finite_element(getfem::QK_fem(N, short_type(K)));
+  mf_p.set_finite_element(getfem::QK_fem(N, short_type(K-1)));
+  GMM_ASSERT1(getfem::is_tensor_product_fem(getfem::QK_fem(N, short_type(K)))
+              && !getfem::is_tensor_product_fem(getfem::PK_fem(N, 2)),
+              "Wrong detection of tensor product elements");
+  getfem::mesh_im mim(m);
+  std::stringstream s;
+  s << "IM_GAUSS_PARALLELEPIPED(" << N << "," << 2*K << ")";
+  mim.set_integration_method(getfem::int_method_descriptor(s.str()));
+
+  // The residual of a linear problem computed with the sum factorized
+  // values, gradients and test functions has to be equal to the product
+  // with the tangent matrix, which does not use them.
+  base_vector U(mf_u.nb_dof()), P(mf_p.nb_dof());
+  gmm::fill_random(U); gmm::fill_random(P);
+  getfem::ga_workspace workspace;
+  workspace.add_fem_variable("u", mf_u, gmm::sub_interval(0, U.size()), U);
+  workspace.add_fem_variable("p", mf_p, gmm::sub_interval(U.size(),
+                                                           P.size()), P);
+  workspace.add_expression("Grad_u:Grad_Test_u + (Grad_p+u).Test_u"
+                           "+ Trace(Grad_u)*Test_p + p*Test_p", mim);
+  workspace.add_expression("(u+Grad_p).Test_u + p*Div_Test_u", mim, 1);
+  size_type nd = workspace.nb_primary_dof();
+  getfem::model_real_sparse_matrix KK(nd, nd);
+  workspace.set_assembled_matrix(KK);
+  workspace.assembly(2);
+  base_vector R(nd), R0(nd), X(nd);
+  workspace.set_assembled_vector(R);
+  workspace.assembly(1);
+  gmm::copy(U, gmm::sub_vector(X, gmm::sub_interval(0, U.size())));
+  gmm::copy(P, gmm::sub_vector(X, gmm::sub_interval(U.size(), P.size())));
+  gmm::mult(KK, X, R0);
+  scalar_type err = gmm::vect_dist2(R, R0) / gmm::vect_norm2(R0);
+  cout << "Sum factorization error : " << err << endl;
+  GMM_ASSERT1(err < 1E-10, "Error in sum factorized evaluation");
+
+  // The matrix-free product, sum factorized for the (u,u) and (p,p) terms,
+  // and its diagonal, computed with the complete base function tables.
+  base_vector C(mf_p.nb_dof());
+  gmm::fill_random(C);
+  getfem::ga_workspace workspace2;
+  workspace2.add_fem_variable("u", mf_u, gmm::sub_interval(0, U.size()), U);
+  workspace2.add_fem_variable("p", mf_p, gmm::sub_interval(U.size(),
+                                                            P.size()), P);
+  workspace2.add_fem_constant("c", mf_p, C);
+  workspace2.add_expression("(1+sqr(c))*Grad_u:Grad_Test_u + c*u.Test_u"
+                            "+ (c*Grad_p).Grad_Test_p - p*Test_p"
+                            "+ Grad_p.Test_u", mim);
+  gmm::clear(KK);
+  workspace2.set_assembled_matrix(KK);
+  workspace2.assembly(2);
+  getfem::ga_matrix_free_operator KM(workspace2);
+  base_vector Y(nd), Y0(nd), D, D0(nd);
+  gmm::fill_random(X);
+  gmm::mult(KK, X, Y0);
+  getfem::mult(KM, X, Y);
+  err = gmm::vect_dist2(Y, Y0) / gmm::vect_norm2(Y0);
+  KM.diagonal(D);
+  for (size_type i = 0; i < nd; ++i) D0[i] = KK(i, i);
+  err = std::max(err, gmm::vect_dist2(D, D0) / gmm::vect_norm2(D0));
+  cout << "Sum factorized matrix-free product error : " << err << endl;
+  GMM_ASSERT1(err < 1E-10, "Error in sum factorized matrix-free product");
+}
+
+
+static void test_interpolate_transformation_cache(int N, int NX) {
+  getfem::mesh m1, m2;
+  std::vector<size_type> nsubdiv(N, NX), nsubdiv2(N, NX/2+1);
+  getfem::regular_unit_mesh(m1, nsubdiv, bgeot::simplex_geotrans(N, 1));
+  // Quadratic target elements, for the non-linear inversions
+  getfem::regular_unit_mesh(m2, nsubdiv2, bgeot::simplex_geotrans(N, 2));
+
+  getfem::mesh_fem mf1(m1), mf2(m2);
+  mf1.set_classical_finite_element(1);
+  mf2.set_classical_finite_element(2);
+  getfem::mesh_im mim(m1);
+  mim.set_integration_method(4);
+
+  base_vector U(mf1.nb_dof()), W(mf2.nb_dof()), A(1);
+  gmm::fill_random(U); gmm::fill_random(W);
+  getfem::ga_workspace workspace;
+  workspace.add_fem_variable("u", mf1, gmm::sub_interval(0, U.size()), U);
+  workspace.add_fem_constant("w", mf2, W);
+  workspace.add_fixed_size_constant("a", A);
+  std::string expr = "X*(0.9-a)+0.05*Id(meshdim)(:,1)";
+  getfem::add_interpolate_transformation_from_expression
+    (workspace, "T0", m1, m2, size_type(-1), expr, false);
+  getfem::add_interpolate_transformation_from_expression
+    (workspace, "T1", m1, m2, size_type(-1), expr, true);
+  workspace.add_interpolate_transformation
+    ("N0", getfem::interpolate_transformation_neighbor_instance());
+  workspace.add_interpolate_transformation
+    ("N1", getfem::interpolate_transformation_neighbor_instance(m1));
+  getfem::mesh_region inner_faces = getfem::inner_faces_of_mesh(m1);
+
+  auto assembly = [&](const std::string &e, const getfem::mesh_region &rg) {
+    base_vector V(U.size());
+    getfem::ga_workspace ws(workspace, getfem::ga_workspace::inherit::ALL);
+    ws.add_expression(e, mim, rg);
+    ws.set_assembled_vector(V);
+    ws.assembly(1);
+    return V;
+  };
+
+  scalar_type err(0);
+  for (scalar_type a : {0., 0., 0.02, 0.02}) { // repeated: reuse of the cache
+    A[0] = a;
+    base_vector V0 = assembly("Interpolate(w,T0)*Test_u",
+                              getfem::mesh_region::all_convexes());
+    base_vector V1 = assembly("Interpolate(w,T1)*Test_u",
+                              getfem::mesh_region::all_convexes());
+    err = std::max(err, gmm::vect_dist2(V0, V1) / gmm::vect_norm2(V0));
+    V0 = assembly("(u-Interpolate(u,N0))*Test_u", inner_faces);
+    V1 = assembly("(u-Interpolate(u,N1))*Test_u", inner_faces);
+    err = std::max(err, gmm::vect_dist2(V0, V1) / gmm::vect_norm2(V0));
+  }
+  cout << "Cached interpolate transformations error : " << err << endl;
+  GMM_ASSERT1(err < 1E-10, "Error in cached interpolate transformations");
+
+  // The cache has to follow the modifications of the target mesh
+  base_matrix M(N, N);
+  gmm::copy(gmm::identity_matrix(), M);
+  M(0, 0) = 0.99;
+  m2.transformation(M);
+  gmm::fill_random(W);
+  base_vector V0 = assembly("Interpolate(w,T0)*Test_u",
+                            getfem::mesh_region::all_convexes());
+  base_vector V1 = assembly("Interpolate(w,T1)*Test_u",
+                            getfem::mesh_region::all_convexes());
+  err = gmm::vect_dist2(V0, V1) / gmm::vect_norm2(V0);
+  cout << "Cached transformation error after mesh update : " << err << endl;
+  GMM_ASSERT1(err < 1E-10, "Error in cached interpolate transformations");
+}
+
 int main(int argc, char *argv[]) {
   
   GETFEM_MPI_INIT(argc, argv);
@@ -894,6 +1274,16 @@ int main(int argc, char *argv[]) {
   
   test_new_assembly(2, 25, 2);
   test_new_assembly(3, 7, 2);
+  test_colored_assembly(2, 10);
+  test_colored_assembly(3, 4);
+  test_assembly_reuse(2, 10);
+  test_assembly_reuse(3, 4);
+  test_matrix_free_operator(2, 10);
+  test_matrix_free_operator(3, 4);
+  test_sum_factorization(2, 4, 3);
+  test_sum_factorization(3, 2, 3);
+  test_interpolate_transformation_cache(2, 8);
+  test_interpolate_transformation_cache(3, 3);
 
 
   // testbug();
@@ -0,0 +1,220 @@
+/*===========================================================================
+
+ Copyright (C) 2026 agent.
+
+ This file is a part of GetFEM
+
+ GetFEM  is  free software;  you  can  redistribute  it  and/or modify it
+ under  the  terms  of the  GNU  Lesser General Public License as published
+ by  the  Free Software Foundation;  either version 3 of the License,  or
+ (at your option) any later version along with the GCC Runtime Library
+ Exception either version 3.1 or (at your option) any later version.
+ This program  is  distributed  in  the  hope  that it will be useful,  but
+ WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ or  FITNESS  FOR  A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ License and GCC Runtime Library Exception for more details.
+ You  should  have received a copy of the GNU Lesser General Public License
+ along  with  this program. If not, see https://www.gnu.org/licenses/.
+
+===========================================================================*/
+/**
+   Test of the detection of the contact pairs of multi_contact_frame with
+   the influence boxes, by projection and by raytracing: exact pairs on a
+   flat master surface, geometrical properties of the pairs on a curved
+   one, and identical pairs whether the tree of the influence boxes is
+   refitted, rebuilt or computed by a new frame.
+*/
+#include "getfem/getfem_regular_meshes.h"
+#include "getfem/getfem_contact_and_friction_common.h"
+
+using std::endl; using std::cout; using std::cerr;
+using bgeot::size_type;
+using bgeot::scalar_type;
+using bgeot::base_node;
+using bgeot::base_small_vector;
+
+typedef getfem::model_real_plain_vector VECT;
+typedef getfem::multi_contact_frame::contact_pair contact_pair;
+
+static const scalar_type gap = 0.05, release_dist = 0.2;
+
+/* Unit body [0,1]^N translated by -e_N (master, top face in region 1) or
+   body [0.1,0.9]^(N-1) x [gap,1+gap] (slave, bottom face in region 1),
+   with non matching meshes. */
+static void body_mesh(getfem::mesh &m, size_type N, bool master) {
+  getfem::regular_unit_mesh(m, std::vector<size_type>(N, master ? 5 : 4),
+                            bgeot::simplex_geotrans(N, 1));
+  base_small_vector t(N);
+  if (master) t[N-1] = -1.;
+  else {
+    bgeot::base_matrix M(N, N);
+    for (size_type k = 0; k < N; ++k) M(k, k) = (k+1 < N) ? 0.8 : 1.;
+    m.transformation(M);
+    for (size_type k = 0; k+1 < N; ++k) t[k] = 0.1;
+    t[N-1] = gap;
+  }
+  m.translation(t);
+  getfem::mesh_region border;
+  getfem::outer_faces_of_mesh(m, border);
+  for (getfem::mr_visitor i(border); !i.finished(); ++i) {
+    base_small_vector un = m.normal_of_face_of_convex(i.cv(), i.f());
+    if (master ? (un[N-1] > 0.5 * gmm::vect_norm2(un))
+               : (un[N-1] < -0.5 * gmm::vect_norm2(un)))
+      m.region(1).add(i.cv(), i.f());
+  }
+}
+
+/* Vertical position of the deformed top face of the master body, for a
+   dip of depth amp and a shift s of the body along the first axis. */
+static scalar_type master_surface(const base_node &x, scalar_type amp,
+                                  scalar_type s) {
+  scalar_type f = -amp * sin(M_PI * (x[0] - s));
+  for (size_type k = 1; k+1 < x.size(); ++k) f *= sin(M_PI * x[k]);
+  return f;
+}
+
+/* Displacement of the master body, interpolated on the Lagrange fem. */
+static void master_displacement(const getfem::mesh_fem &mf, VECT &U,
+                                scalar_type amp, scalar_type s) {
+  size_type N = mf.linked_mesh().dim();
+  gmm::resize(U, mf.nb_dof());
+  for (size_type i = 0; i < mf.nb_dof(); i += N) {
+    base_node P = mf.point_of_basic_dof(i);
+    U[i] = s;
+    P[0] += s;
+    U[i+N-1] = master_surface(P, amp, s);
+  }
+}
+
+/* Each slave integration point on the face has a contact pair, whose
+   master point is on the master surface and whose distance is along the
+   master normal (projection) or the slave normal (raytrace). */
+static void check_pairs(getfem::multi_contact_frame &mcf, size_type nbpt,
+                        bool raytrace, scalar_type amp, scalar_type s,
+                        scalar_type d) {
+  GMM_ASSERT1(mcf.nb_contact_pairs() == nbpt, "Wrong number of contact "
+              "pairs: " << mcf.nb_contact_pairs() << " instead of " << nbpt);
+  size_type N = mcf.dim();
+  for (size_type i = 0; i < mcf.nb_contact_pairs(); ++i) {
+    const contact_pair &cp = mcf.get_contact_pair(i);
+    GMM_ASSERT1(gmm::abs(cp.slave_point[N-1] - gap + d) < 1E-10
+                && gmm::abs(cp.slave_n[N-1] + 1.) < 1E-10,
+                "Wrong slave point");
+    // The master normal is not necessarily of unit norm
+    base_small_vector nm = cp.master_n / gmm::vect_norm2(cp.master_n);
+    base_small_vector r = cp.slave_point - cp.master_point;
+    const base_small_vector &n = raytrace ? cp.slave_n : nm;
+    scalar_type rn = gmm::vect_sp(r, n);
+    GMM_ASSERT1(gmm::vect_dist2(r, rn * n) < 1E-8,
+                "The distance vector is not normal to the "
+                << (raytrace ? "slave" : "master") << " surface");
+    GMM_ASSERT1(gmm::abs(gmm::abs(cp.signed_dist) - gmm::vect_norm2(r))
+                < 1E-10 && cp.signed_dist > 0., "Wrong signed distance");
+    GMM_ASSERT1(nm[N-1] > 0.9, "Wrong master normal");
+    if (amp == 0.) {
+      // Flat master surface: exact pairs
+      GMM_ASSERT1(gmm::abs(cp.master_point[N-1]) < 1E-10
+                  && gmm::abs(cp.signed_dist - (gap - d)) < 1E-10
+                  && gmm::abs(nm[N-1] - 1.) < 1E-10,
+                  "Wrong contact pair on a flat surface");
+      for (size_type k = 0; k+1 < N; ++k)
+        GMM_ASSERT1(gmm::abs(cp.master_point[k] - cp.slave_point[k]) < 1E-8,
+                    "Wrong master point on a flat surface");
+    } else
+      GMM_ASSERT1(gmm::abs(cp.master_point[N-1]
+                           - master_surface(cp.master_point, amp, s)) < 1E-3,
+                  "The master point is not on the master surface");
+  }
+}
+
+/* The frame mcf gives the same pairs as a new frame on the same data. */
+static void compare_pairs(getfem::multi_contact_frame &mcf,
+                          getfem::multi_contact_frame &mcf2) {
+  GMM_ASSERT1(mcf.nb_contact_pairs() == mcf2.nb_contact_pairs(),
+              "Different numbers of contact pairs");
+  for (size_type i = 0; i < mcf.nb_contact_pairs(); ++i) {
+    const contact_pair &cp1 = mcf.get_contact_pair(i);
+    const contact_pair &cp2 = mcf2.get_contact_pair(i);
+    GMM_ASSERT1(cp1.slave_ind_element == cp2.slave_ind_element
+                && cp1.slave_ind_pt == cp2.slave_ind_pt
+                && gmm::vect_dist2(cp1.master_point, cp2.master_point) < 1E-9
+                && gmm::abs(cp1.signed_dist - cp2.signed_dist) < 1E-9,
+                "Different contact pairs");
+  }
+}
+
+static void test_contact_pairs(size_type N, bool raytrace) {
+  cout << "Contact pairs in dimension " << N << " by "
+       << (raytrace ? "raytrace" : "projection") << endl;
+  getfem::mesh m1, m2;
+  body_mesh(m1, N, true);
+  body_mesh(m2, N, false);
+  getfem::mesh_fem mf1(m1, bgeot::dim_type(N)), mf2(m2, bgeot::dim_type(N));
+  mf1.set_classical_finite_element(2);
+  mf2.set_classical_finite_element(1);
+  getfem::mesh_im mim1(m1), mim2(m2);
+  mim1.set_integration_method(4);
+  mim2.set_integration_method(4);
+  VECT U1, U2(mf2.nb_dof());
+  master_displacement(mf1, U1, 0., 0.);
+
+  size_type nbpt = 0;
+  for (getfem::mr_visitor i(m2.region(1)); !i.finished(); ++i)
+    nbpt += mim2.int_method_of_element(i.cv())->approx_method()
+      ->nb_points_on_face(i.f());
+
+  getfem::multi_contact_frame mcf(N, release_dist, false, false, 0.3,
+                                  raytrace);
+  mcf.add_master_boundary(mim1, &mf1, &U1, 1);
+  mcf.add_slave_boundary(mim2, &mf2, &U2, 1);
+  mcf.set_boxes_rebuild_distance(0.02);
+
+  // Flat master surface, slave body moved towards it.
+  scalar_type d = 0.02;
+  for (size_type i = N-1; i < mf2.nb_dof(); i += N) U2[i] = -d;
+  mcf.compute_contact_pairs();
+  check_pairs(mcf, nbpt, raytrace, 0., 0., d);
+  GMM_ASSERT1(mcf.nb_influence_boxes_rebuilds() == 1
+              && mcf.nb_influence_boxes_refits() == 0, "Wrong tree count");
+
+  // A small dip of the master surface: the tree is refitted.
+  master_displacement(mf1, U1, 0.01, 0.);
+  mcf.compute_contact_pairs();
+  check_pairs(mcf, nbpt, raytrace, 0.01, 0., d);
+  GMM_ASSERT1(mcf.nb_influence_boxes_rebuilds() == 1
+              && mcf.nb_influence_boxes_refits() == 1, "The influence boxes "
+              "are not refitted");
+  {
+    getfem::multi_contact_frame mcf2(N, release_dist, false, false, 0.3,
+                                     raytrace);
+    mcf2.add_master_boundary(mim1, &mf1, &U1, 1);
+    mcf2.add_slave_boundary(mim2, &mf2, &U2, 1);
+    mcf2.compute_contact_pairs();
+    compare_pairs(mcf, mcf2);
+  }
+
+  // A shift of the master body beyond the rebuild distance.
+  master_displacement(mf1, U1, 0.01, 0.05);
+  mcf.compute_contact_pairs();
+  check_pairs(mcf, nbpt, raytrace, 0.01, 0.05, d);
+  GMM_ASSERT1(mcf.nb_influence_boxes_rebuilds() == 2
+              && mcf.nb_influence_boxes_refits() == 1, "The influence boxes "
+              "are not rebuilt");
+  {
+    getfem::multi_contact_frame mcf2(N, release_dist, false, false, 0.3,
+                                     raytrace);
+    mcf2.add_master_boundary(mim1, &mf1, &U1, 1);
+    mcf2.add_slave_boundary(mim2, &mf2, &U2, 1);
+    mcf2.compute_contact_pairs();
+    compare_pairs(mcf, mcf2);
+  }
+  cout << "  " << mcf.nb_contact_pairs() << " contact pairs" << endl;
+}
+
+int main(void) {
+  GMM_SET_EXCEPTION_DEBUG;
+  for (size_type N : {2, 3})
+    for (bool raytrace : {false, true})
+      test_contact_pairs(N, raytrace);
+  return 0;
+}
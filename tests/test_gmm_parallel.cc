@@ -0,0 +1,185 @@
+/*===========================================================================
+
+ Copyright (C) 2026 agent.
+
+ This file is a part of GetFEM
+
+ GetFEM  is  free software;  you  can  redistribute  it  and/or modify it
+ under  the  terms  of the  GNU  Lesser General Public License as published
+ by  the  Free Software Foundation;  either version 3 of the License,  or
+ (at your option) any later version along with the GCC Runtime Library
+ Exception either version 3.1 or (at your option) any later version.
+ This program  is  distributed  in  the  hope  that it will be useful,  but
+ WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ or  FITNESS  FOR  A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ License and GCC Runtime Library Exception for more details.
+ You  should  have received a copy of the GNU Lesser General Public License
+ along  with  this program. If not, see https://www.gnu.org/licenses/.
+
+===========================================================================*/
+
+/* Multithreaded kernels of gmm (parallel_blocks, parallel_blocks_sum and
+   the BLAS-1 and sparse matrix-vector products using them) compared with
+   their serial versions, on sizes above parallel_threshold(). */
+
+#include "gmm/gmm.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using std::endl; using std::cout; using std::cerr;
+using gmm::size_type;
+
+static const size_type threshold = 1000, n = 5000;
+
+template <typename T>
+static void fill_random(std::vector<T> &v) {
+  for (T &x : v) x = gmm::random(T());
+}
+
+template <typename V1, typename V2>
+static bool same_vect(const V1 &v1, const V2 &v2) {
+  return gmm::vect_dist2(v1, v2) <= 1E-12 * (gmm::vect_norm2(v1) + 1.);
+}
+
+static void set_serial(bool serial)
+{ gmm::parallel_threshold() = serial ? size_type(-1) : threshold; }
+
+static void test_blocks() {
+  set_serial(false);
+  // each index is visited exactly once
+  std::vector<int> count(n, 0);
+  gmm::parallel_blocks(n, [&](size_type i0, size_type i1) {
+    GMM_ASSERT1(i0 <= i1 && i1 <= n, "Wrong block");
+    for (size_type i = i0; i < i1; ++i) ++count[i];
+  }, threshold);
+  for (size_type i = 0; i < n; ++i)
+    GMM_ASSERT1(count[i] == 1, "Index " << i << " visited " << count[i]
+                << " times");
+
+  // sums of integers are exact whatever the partition
+  double s = gmm::parallel_blocks_sum<double>(n,
+    [&](size_type i0, size_type i1) {
+      double r(0);
+      for (size_type i = i0; i < i1; ++i) r += double(i);
+      return r;
+    }, threshold);
+  GMM_ASSERT1(s == double(n*(n-1)/2), "Wrong parallel sum");
+
+  // empty and small ranges stay serial
+  size_type nb_calls = 0;
+  gmm::parallel_blocks(0, [&](size_type i0, size_type i1)
+                       { ++nb_calls; GMM_ASSERT1(i0 == i1, "Wrong block"); },
+                       threshold);
+  gmm::parallel_blocks(threshold-1, [&](size_type i0, size_type i1) {
+    ++nb_calls;
+    GMM_ASSERT1(i0 == 0 && i1 == threshold-1, "Wrong block");
+  }, threshold);
+  GMM_ASSERT1(nb_calls == 2, "Unexpected calls");
+}
+
+template <typename T> static void test_blas1() {
+  typedef typename gmm::number_traits<T>::magnitude_type R;
+  std::vector<T> x(n), y(n), z(n), y1(y), y2(y), z1(n), z2(n);
+  fill_random(x); fill_random(y);
+
+  set_serial(true);
+  T sp1 = gmm::vect_sp(x, y);
+  R nrm1 = gmm::vect_norm2(x);
+  gmm::copy(y, y1); gmm::add(x, y1);
+  gmm::add(x, gmm::scaled(y, T(2)), z1);
+  gmm::copy(y, y2);
+  R an1 = gmm::add_and_norm2_sqr(gmm::scaled(x, T(-1)), y2);
+
+  set_serial(false);
+  T sp2 = gmm::vect_sp(x, y);
+  R nrm2 = gmm::vect_norm2(x);
+  gmm::copy(y, z); gmm::add(x, z);
+  GMM_ASSERT1(same_vect(y1, z), "Wrong parallel add");
+  gmm::add(x, gmm::scaled(y, T(2)), z2);
+  GMM_ASSERT1(same_vect(z1, z2), "Wrong parallel add");
+  gmm::copy(y, z);
+  R an2 = gmm::add_and_norm2_sqr(gmm::scaled(x, T(-1)), z);
+  GMM_ASSERT1(same_vect(y2, z), "Wrong parallel add_and_norm2_sqr");
+
+  // the partial results are summed in another order
+  R tol = gmm::sqrt(gmm::default_tol(R()));
+  GMM_ASSERT1(gmm::abs(sp1 - sp2) <= tol * nrm1 * gmm::vect_norm2(y),
+              "Wrong vect_sp");
+  GMM_ASSERT1(gmm::abs(nrm1 - nrm2) <= tol * nrm1, "Wrong vect_norm2");
+  GMM_ASSERT1(gmm::abs(an1 - an2) <= tol * an1, "Wrong add_and_norm2_sqr");
+}
+
+/* The norms of the blocks are combined without overflow or underflow. */
+template <typename T> static void test_norm_scaling() {
+  typedef typename gmm::number_traits<T>::magnitude_type R;
+  R big = std::numeric_limits<R>::max() / R(100);
+  R tiny = std::numeric_limits<R>::min() * R(100);
+  for (R a : {big, tiny}) {
+    std::vector<T> x(n, T(a));
+    for (bool serial : {true, false}) {
+      set_serial(serial);
+      R nrm = gmm::vect_norm2(x);
+      GMM_ASSERT1(gmm::abs(nrm / (a * gmm::sqrt(R(n))) - R(1))
+                  < R(1E-3), "Overflow or underflow in vect_norm2: "
+                  << nrm << " instead of " << a * gmm::sqrt(R(n)));
+    }
+  }
+}
+
+template <typename MAT> static void test_mult(const MAT &M) {
+  std::vector<double> x(gmm::mat_ncols(M)), y(gmm::mat_nrows(M));
+  std::vector<double> z1(y.size()), z2(y.size()), w1(x.size()), w2(x.size());
+  fill_random(x); fill_random(y);
+
+  set_serial(true);
+  gmm::mult(M, x, z1);
+  gmm::mult(M, x, y, z2); gmm::add(gmm::scaled(y, -1.), z2);
+  GMM_ASSERT1(same_vect(z1, z2), "Wrong serial mult");
+  gmm::mult(gmm::transposed(M), y, w1);
+
+  set_serial(false);
+  gmm::mult(M, x, z2);
+  GMM_ASSERT1(same_vect(z1, z2), "Wrong parallel mult");
+  gmm::copy(y, z2);
+  gmm::mult_add(M, x, z2);
+  gmm::add(gmm::scaled(y, -1.), z2);
+  GMM_ASSERT1(same_vect(z1, z2), "Wrong parallel mult_add");
+  gmm::mult(gmm::transposed(M), y, w2);
+  GMM_ASSERT1(same_vect(w1, w2), "Wrong parallel transposed mult");
+}
+
+static void test_sparse_mult() {
+  gmm::row_matrix<gmm::wsvector<double> > W(n, n+7);
+  for (size_type i = 0; i < n; ++i)
+    for (size_type k = 0; k < 6; ++k)
+      W(i, (i * 37 + k * 101) % (n+7)) = gmm::random(double());
+  gmm::row_matrix<gmm::rsvector<double> > Mr(n, n+7);
+  gmm::col_matrix<gmm::rsvector<double> > Mc(n, n+7);
+  gmm::csr_matrix<double> Ar; gmm::csc_matrix<double> Ac;
+  gmm::copy(W, Mr); gmm::copy(W, Mc);
+  Ar.init_with(W); Ac.init_with(W);
+  test_mult(Mr);
+  test_mult(Mc);
+  test_mult(Ar);
+  test_mult(Ac);
+  test_mult(gmm::csr_matrix_ref<const double *, const unsigned int *,
+                                const unsigned int *>
+            (&(Ar.pr[0]), &(Ar.ir[0]), &(Ar.jc[0]), Ar.nr, Ar.nc));
+}
+
+int main(void) {
+  GMM_SET_EXCEPTION_DEBUG;
+  srand(1459);
+#ifdef _OPENMP
+  omp_set_num_threads(3);
+#endif
+  test_blocks();
+  test_blas1<double>();
+  test_blas1<float>();
+  test_blas1<std::complex<double> >();
+  test_norm_scaling<double>();
+  test_norm_scaling<std::complex<double> >();
+  test_sparse_mult();
+  return 0;
+}
@@ -176,6 +176,7 @@ scalar_type interpolate_check(const mesh_fem &mf1, const mesh_fem& mf2, int i, i
   static std::unique_ptr<rsr_matrix> rsr12, rsr21;
   static std::unique_ptr<wsr_matrix> wsr12, wsr21;
   static std::unique_ptr<wsc_matrix> wsc12, wsc21;
+  static std::unique_ptr<getfem::interpolation_plan> plan12, plan21;
 
   if (i == 0) {
     switch (mat_version) {
@@ -204,6 +205,10 @@ scalar_type interpolate_check(const mesh_fem &mf1, const mesh_fem& mf2, int i, i
       getfem::interpolation(mf1, mf2, *wsr12);
       getfem::interpolation(mf2, mf1, *wsr21);
       return 0.;
+    case 5:
+      plan12 = std::make_unique<getfem::interpolation_plan>(mf1, mf2);
+      plan21 = std::make_unique<getfem::interpolation_plan>(mf2, mf1);
+      break;
     default: assert(0);
     }
   }
@@ -223,6 +228,15 @@ scalar_type interpolate_check(const mesh_fem &mf1, const mesh_fem& mf2, int i, i
       gmm::mult(*(wsc21.get()), V, U2); break;
     case 4: gmm::mult(*(wsr12.get()), U, V);
       gmm::mult(*(wsr21.get()), V, U2); break;
+    case 5: {
+      plan12->apply(U, V);
+      std::vector<scalar_type> V2(mf2.nb_dof());
+      getfem::interpolation(mf1, mf2, U, V2);
+      gmm::add(gmm::scaled(V, -1.), V2);
+      GMM_ASSERT1(gmm::vect_norminf(V2) < 1e-10 * gmm::vect_norminf(V),
+                  "The interpolation plan differs from the interpolation");
+      plan21->apply(V, U2);
+    } break;
   }
   gmm::add(gmm::scaled(U,-1.),U2);
   return gmm::vect_norminf(U2)/gmm::vect_norminf(U);
@@ -408,12 +422,13 @@ int main(int argc, char *argv[]) {
   
   testDim_3D();
   test0();
-  for (int mat_version = 0; mat_version < 5; ++mat_version) {
+  for (int mat_version = 0; mat_version < 6; ++mat_version) {
     const char *msg[] = {"Testing interpolation", 
 			 "Testing stored interpolator in rsc matrix",
 			 "Testing stored interpolator in rsr matrix",
 			 "Testing stored interpolator in wsc matrix",
-			 "Testing stored interpolator in wsr matrix"};
+			 "Testing stored interpolator in wsr matrix",
+			 "Testing interpolation plan"};
     cout << msg[mat_version] << "..\n";
     test_same_mesh(mat_version, 2,quick ? 17 : 80,1);
     test_same_mesh(mat_version, 2,quick ? 8 : 20,4);
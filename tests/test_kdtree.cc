@@ -55,6 +55,15 @@ void verify_points_in_box(const std::vector<base_node>& v, bgeot::kdtree& tree,
     cout << "verify_points_in_box: error, brute force gave points\n " << bv1 << ",\nwhile points_in_box returned : " << bv2 << "\n";
   } else { cout << "."; cout.flush(); }
   assert(bv1 == bv2);
+
+  /* batched version, same points in the same order */
+  std::vector<size_type> idptr, idvec;
+  tree.points_in_boxes(std::vector<base_node>(2, bmin),
+                       std::vector<base_node>(2, bmax), idptr, idvec, true);
+  assert(idptr.size() == 3 && idptr[1] == ipts.size()
+         && idptr[2] == 2*ipts.size());
+  for (size_type i=0; i < ipts.size(); ++i)
+    assert(idvec[i] == ipts[i].i && idvec[ipts.size()+i] == ipts[i].i);
 }
 
 void check_tree() {
@@ -140,6 +149,13 @@ void speed_test(unsigned N, unsigned NPT, unsigned nrepeat) {
   }
   cout << "POINT QUERY: nb points in " << pt << ":" << pt << " is : " << npt << "\n";
   cout << "average query time is: " << (gmm::uclock_sec()-t)/(nrepeat*200.)*1e6 << " microseconds\n";
+
+  std::vector<base_node> qpts(nrepeat*200, pt);
+  std::vector<size_type> idptr, idvec;
+  t = gmm::uclock_sec();
+  tree.points_in_boxes(qpts, qpts, idptr, idvec, true);
+  assert(idptr.back() == npt*qpts.size());
+  cout << "average batched query time is: " << (gmm::uclock_sec()-t)/(nrepeat*200.)*1e6 << " microseconds\n";
 }
 
 int main(int argc, char **argv) {
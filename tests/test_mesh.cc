@@ -21,7 +21,11 @@
 #include "getfem/bgeot_poly_composite.h"
 #include "getfem/bgeot_comma_init.h"
 #include "getfem/getfem_export.h"
+#include "getfem/getfem_import.h"
 #include "getfem/bgeot_node_tab.h"
+#ifdef GETFEM_HAVE_ZLIB
+# include <zlib.h>
+#endif
 using std::endl; using std::cout; using std::cerr;
 using std::ends; using std::cin;
 using getfem::size_type;
@@ -304,6 +308,48 @@ void test_region() {
   cout << "a=" << a << "\nb=" << b << "a inter b=" << r << "\n";
 }
 
+/* The partitions of a region used in a parallel section have to cover the
+   region exactly once, also after a change of the number of threads. */
+static void check_region_partitions(const getfem::mesh_region &rg,
+                                    size_type nbcv) {
+  getfem::omp_distribute<std::vector<size_type>> cvs;
+  GETFEM_OMP_PARALLEL(
+    for (getfem::mr_visitor i(rg); !i.finished(); ++i)
+      cvs.thrd_cast().push_back(i.cv());
+  )
+  std::vector<size_type> all;
+  for (size_type t = 0; t < cvs.num_threads(); ++t)
+    all.insert(all.end(), cvs(t).begin(), cvs(t).end());
+  std::sort(all.begin(), all.end());
+  GMM_ASSERT1(all.size() == nbcv
+              && std::adjacent_find(all.begin(), all.end()) == all.end(),
+              "Wrong partitions of the region");
+}
+
+void test_region_partitions() {
+  getfem::mesh m;
+  std::vector<size_type> nsubdiv(2, 12);
+  getfem::regular_unit_mesh(m, nsubdiv, bgeot::simplex_geotrans(2, 1));
+  getfem::mesh_region &rg = m.region(3);
+  for (dal::bv_visitor cv(m.convex_index()); !cv.finished(); ++cv)
+    if (cv % 3) rg.add(cv);
+  size_type nbcv = rg.index().card();
+  std::vector<getfem::scalar_type> costs(m.nb_allocated_convex());
+  for (size_type i = 0; i < costs.size(); ++i)
+    costs[i] = getfem::scalar_type(1 + (i % 5));
+
+  size_type nbth = std::max(getfem::max_concurrency(), size_type(2));
+  for (size_type nth : {size_type(1), nbth, size_type(1), nbth + 1}) {
+    getfem::set_num_threads(int(nth));
+    check_region_partitions(m.region(3), nbcv);
+    m.region(3).set_partition_costs(costs, m.cuthill_mckee_ordering());
+    check_region_partitions(m.region(3), nbcv);
+    m.region(3).set_partition_costs(std::vector<getfem::scalar_type>());
+  }
+  getfem::set_num_threads(1);
+  check_region_partitions(m.region(3), nbcv);
+}
+
 void test_convex_ref() {
   for (bgeot::short_type k=1; k <= 2; ++k) {
     bgeot::pconvex_ref cvr  = bgeot::simplex_of_reference(1,k);
@@ -630,6 +676,385 @@ void test_incomplete_Q2(void) {
 
 
 
+/* read back the arrays of the appended section of a vtu file */
+static std::vector<std::string> read_appended_arrays(const std::string &f,
+                                                     bool compressed) {
+  std::vector<size_type> offsets;
+  for (size_type i = f.find("offset=\""); i != std::string::npos;
+       i = f.find("offset=\"", i+1))
+    offsets.push_back(size_type(std::stoul(f.substr(i+8))));
+  const std::string tag("<AppendedData encoding=\"raw\">\n_");
+  size_type start = f.find(tag);
+  GMM_ASSERT1(start != std::string::npos, "no appended data section");
+  start += tag.size();
+  size_type end = f.rfind("\n</AppendedData>");
+  std::vector<std::string> arrays;
+  for (size_type k = 0; k < offsets.size(); ++k) {
+    const char *p = f.data() + start + offsets[k];
+    std::uint64_t h[3];
+    memcpy(h, p, sizeof(h));
+    size_type nbytes = 0;
+    std::string a;
+    if (!compressed) {
+      nbytes = sizeof(std::uint64_t) + size_type(h[0]);
+      a = std::string(p + sizeof(std::uint64_t), size_type(h[0]));
+    } else {
+#ifdef GETFEM_HAVE_ZLIB
+      std::vector<std::uint64_t> csizes(h[0]);
+      memcpy(csizes.data(), p + sizeof(h), csizes.size()*sizeof(std::uint64_t));
+      nbytes = sizeof(h) + csizes.size()*sizeof(std::uint64_t);
+      for (size_type b = 0; b < csizes.size(); ++b) {
+        std::vector<Bytef> buf(h[1]);
+        uLongf len = uLongf(buf.size());
+        GMM_ASSERT1(uncompress(buf.data(), &len, (const Bytef *)(p + nbytes),
+                               uLong(csizes[b])) == Z_OK, "zlib error");
+        size_type expected = (b+1 == csizes.size() && h[2]) ? h[2] : h[1];
+        GMM_ASSERT1(len == expected, "wrong block size");
+        a.append((const char *)(buf.data()), len);
+        nbytes += size_type(csizes[b]);
+      }
+#endif
+    }
+    size_type next = (k+1 < offsets.size()) ? offsets[k+1] : end - start;
+    GMM_ASSERT1(offsets[k] + nbytes == next, "inconsistent appended data");
+    arrays.push_back(a);
+  }
+  return arrays;
+}
+
+void test_vtu_export() {
+  getfem::mesh m;
+  getfem::regular_unit_mesh(m, std::vector<size_type>(2, 10),
+                            bgeot::parallelepiped_geotrans(2, 1));
+  getfem::mesh_fem mf(m, 2);
+  mf.set_classical_finite_element(m.convex_index(), 1);
+  std::vector<double> U(mf.nb_dof()), C(m.convex_index().card());
+  for (size_type i = 0; i < mf.nb_dof(); ++i) U[i] = double(i);
+  for (size_type i = 0; i < C.size(); ++i) C[i] = double(i);
+
+  std::vector<std::string> ref;
+  for (int compress = 0; compress < 2; ++compress) {
+#ifndef GETFEM_HAVE_ZLIB
+    if (compress) break;
+#endif
+    std::stringstream ss;
+    {
+      getfem::vtu_export exp(ss);
+      exp.set_appended_data(compress != 0);
+      exp.exporting(mf);
+      exp.write_point_data(mf, U, "U");
+      exp.write_cell_data(C, "C");
+    }
+    std::vector<std::string> arrays
+      = read_appended_arrays(ss.str(), compress != 0);
+    // points, connectivity, offsets, types, U and C
+    GMM_ASSERT1(arrays.size() == 6, "wrong number of arrays");
+    GMM_ASSERT1(arrays[0].size() == 3*sizeof(float)*m.nb_points(),
+                "wrong size for the points");
+    GMM_ASSERT1(arrays[4].size() == 3*sizeof(float)*m.nb_points(),
+                "wrong size for the dataset");
+    float u[3];
+    memcpy(u, arrays[4].data() + 3*sizeof(float), sizeof(u));
+    GMM_ASSERT1(u[0] == 2.f && u[1] == 3.f && u[2] == 0.f,
+                "wrong values in the dataset");
+    if (compress)
+      GMM_ASSERT1(arrays == ref, "compressed and raw data differ");
+    ref = arrays;
+  }
+}
+
+/* compare the hash based dof enumeration with the kd-tree based one */
+static void check_dof_enumeration(getfem::mesh &m, const std::string &fem,
+                                  getfem::dim_type Q = 1) {
+  getfem::mesh_fem mf1(m, Q), mf2(m, Q);
+  if (fem.size()) {
+    mf1.set_finite_element(m.convex_index(), getfem::fem_descriptor(fem));
+    mf2.set_finite_element(m.convex_index(), getfem::fem_descriptor(fem));
+  } else {
+    mf1.set_classical_finite_element(2);
+    mf2.set_classical_finite_element(2);
+  }
+  for (dal::bv_visitor cv(m.convex_index()); !cv.finished(); ++cv)
+    if (cv % 7 == 3) { mf1.set_dof_partition(cv, 1); mf2.set_dof_partition(cv, 1); }
+  mf2.set_hash_dof_enumeration(false);
+  GMM_ASSERT1(mf1.nb_dof() == mf2.nb_dof(), "different number of dofs for "
+              << fem << " : " << mf1.nb_dof() << " != " << mf2.nb_dof());
+  for (dal::bv_visitor cv(m.convex_index()); !cv.finished(); ++cv)
+    for (size_type i = 0; i < mf1.nb_basic_dof_of_element(cv); ++i)
+      GMM_ASSERT1(mf1.ind_basic_dof_of_element(cv)[i]
+                  == mf2.ind_basic_dof_of_element(cv)[i],
+                  "different dof numbering for " << fem);
+}
+
+void test_dof_enumeration() {
+  getfem::mesh m1, m2, m3, mq, ma;
+  getfem::regular_unit_mesh(m1, std::vector<size_type>(1, 8),
+                            bgeot::simplex_geotrans(1, 1));
+  check_dof_enumeration(m1, "FEM_PK(1,3)", 2);
+  check_dof_enumeration(m1, "FEM_HERMITE(1)");
+  check_dof_enumeration(m1, "FEM_PK_DISCONTINUOUS(1,2)");
+
+  // anisotropic mesh: the characteristic sizes of the elements ignore the
+  // first coordinate in both algorithms
+  getfem::regular_unit_mesh(ma, std::vector<size_type>(2, 5),
+                            bgeot::simplex_geotrans(2, 1), true);
+  getfem::base_matrix A(2, 2); A(0, 0) = 1E3; A(1, 1) = 1E-3;
+  ma.transformation(A);
+  check_dof_enumeration(ma, "FEM_PK(2,2)");
+  check_dof_enumeration(ma, "FEM_HERMITE(2)");
+
+  getfem::regular_unit_mesh(m2, std::vector<size_type>(2, 6),
+                            bgeot::simplex_geotrans(2, 1), true);
+  getfem::regular_unit_mesh(m3, std::vector<size_type>(3, 3),
+                            bgeot::simplex_geotrans(3, 1));
+  getfem::regular_unit_mesh(mq, std::vector<size_type>(3, 3),
+                            bgeot::parallelepiped_geotrans(3, 1));
+  check_dof_enumeration(m2, "FEM_PK(2,1)", 2);
+  check_dof_enumeration(m2, "FEM_PK(2,3)");
+  check_dof_enumeration(m2, "FEM_PK_DISCONTINUOUS(2,2)");
+  check_dof_enumeration(m2, "FEM_HERMITE(2)");
+  check_dof_enumeration(m2, "FEM_ARGYRIS");
+  check_dof_enumeration(m2, "FEM_RT0(2)", 2);
+  check_dof_enumeration(m3, "FEM_PK(3,2)", 3);
+  check_dof_enumeration(m3, "FEM_NEDELEC(3)", 3);
+  check_dof_enumeration(mq, "FEM_QK(3,2)");
+
+  getfem::mesh mixed; // the mixed mesh of test_incomplete_Q2
+  mixed.read_from_file("Q2_incomplete.msh");
+  check_dof_enumeration(mixed, "");
+
+  getfem::mesh mtq; // triangles and quadrilaterals
+  getfem::regular_unit_mesh(mtq, std::vector<size_type>(2, 4),
+                            bgeot::parallelepiped_geotrans(2, 1));
+  size_type nbcv = mtq.convex_index().last_true() + 1;
+  for (size_type cv = 0; cv < nbcv; cv += 2) {
+    std::vector<base_node> pts;
+    for (const base_node &pt : mtq.points_of_convex(cv)) pts.push_back(pt);
+    mtq.sup_convex(cv);
+    mtq.add_triangle_by_points(pts[0], pts[1], pts[3]);
+    mtq.add_triangle_by_points(pts[0], pts[3], pts[2]);
+  }
+  check_dof_enumeration(mtq, "");
+}
+
+static void check_connectivity(const getfem::mesh &m,
+                               const std::vector<bgeot::convex_face> &ref) {
+  size_type k = 0;
+  for (dal::bv_visitor cv(m.convex_index()); !cv.finished(); ++cv)
+    for (bgeot::short_type f = 0; f < m.nb_faces_of_convex(cv); ++f, ++k) {
+      bgeot::convex_face cf = m.adjacent_face(cv, f);
+      GMM_ASSERT1(cf.cv == ref[k].cv && cf.f == ref[k].f,
+                  "Wrong neighbor of face " << f << " of convex " << cv);
+      GMM_ASSERT1(m.neighbor_of_convex(cv, f) == ref[k].cv,
+                  "Wrong neighbor of face " << f << " of convex " << cv);
+    }
+}
+
+static std::vector<bgeot::convex_face>
+adjacent_faces_of_mesh(const getfem::mesh &m) {
+  GMM_ASSERT1(!m.has_connectivity(), "Connectivity should be invalid");
+  std::vector<bgeot::convex_face> ref;
+  for (dal::bv_visitor cv(m.convex_index()); !cv.finished(); ++cv)
+    for (bgeot::short_type f = 0; f < m.nb_faces_of_convex(cv); ++f)
+      ref.push_back(m.adjacent_face(cv, f));
+  return ref;
+}
+
+void test_connectivity() {
+  getfem::mesh m;
+  getfem::regular_unit_mesh(m, std::vector<size_type>(3, 3),
+                            bgeot::simplex_geotrans(3, 1), true);
+  std::vector<bgeot::convex_face> ref = adjacent_faces_of_mesh(m);
+  // The faces of a small region are found without the table
+  getfem::mesh_region rg1, faces1;
+  rg1.add(m.convex_index().first_true());
+  getfem::outer_faces_of_mesh(m, rg1, faces1);
+  GMM_ASSERT1(!m.has_connectivity() && faces1.size()
+              == m.nb_faces_of_convex(m.convex_index().first_true()),
+              "Wrong outer faces of a single convex");
+  bgeot::pmesh_structure_connectivity c = m.connectivity();
+  GMM_ASSERT1(m.has_connectivity(), "Connectivity not built");
+  check_connectivity(m, ref);
+  for (dal::bv_visitor cv(m.convex_index()); !cv.finished(); ++cv)
+    GMM_ASSERT1(c->nb_faces_of_convex(cv) == m.nb_faces_of_convex(cv),
+                "Wrong number of faces of convex " << cv);
+
+  // The table is kept by its owner after a modification of the mesh
+  size_type cv0 = m.convex_index().first_true();
+  bgeot::convex_face cf0 = ref[0];
+  m.sup_convex(cv0);
+  GMM_ASSERT1(!m.has_connectivity() && c->neighbor_of_convex(cv0, 0)
+              == cf0.cv, "Outdated connectivity should be kept");
+  ref = adjacent_faces_of_mesh(m);
+  m.connectivity();
+  check_connectivity(m, ref);
+  m.optimize_structure();
+  ref = adjacent_faces_of_mesh(m);
+  m.connectivity();
+  check_connectivity(m, ref);
+}
+
+template <typename T> static std::string text_of(const T &t) {
+  std::stringstream ss; t.write_to_file(ss); return ss.str();
+}
+
+void test_binary_io() {
+  getfem::mesh m;
+  getfem::regular_unit_mesh(m, std::vector<size_type>(2, 5),
+                            bgeot::simplex_geotrans(2, 2), true);
+  m.sup_convex(3); m.sup_convex(7);
+  getfem::outer_faces_of_mesh(m, m.region(2));
+  m.region(5).add(m.convex_index());
+  m.region(5).sup(10);
+  m.region(8);
+
+  getfem::mesh_fem mf(m, 2);
+  mf.set_classical_finite_element(2);
+  mf.set_finite_element(12, getfem::fem_descriptor("FEM_PK(2,1)"));
+  mf.set_dof_partition(4, 1);
+  dal::bit_vector kept, border = mf.basic_dof_on_region(m.region(2));
+  for (size_type i = 0; i < mf.nb_basic_dof(); ++i)
+    if (!border.is_in(i)) kept.add(i);
+  mf.reduce_to_basic_dof(kept);
+
+  mf.write_to_binary_file("test_mesh_binary.gfb", true);
+  getfem::mesh m2;
+  m2.read_from_file("test_mesh_binary.gfb");
+  GMM_ASSERT1(text_of(m) == text_of(m2), "Binary mesh round trip failed");
+  getfem::mesh_fem mf2(m2);
+  mf2.read_from_file("test_mesh_binary.gfb");
+  GMM_ASSERT1(text_of(mf) == text_of(mf2), "Binary mesh_fem round trip "
+              "failed");
+  GMM_ASSERT1(mf2.nb_dof() == mf.nb_dof(), "Wrong number of dofs");
+
+  m2.write_to_binary_file("test_mesh_binary.gfb");
+  getfem::mesh m3;
+  m3.read_from_binary_file("test_mesh_binary.gfb");
+  GMM_ASSERT1(text_of(m) == text_of(m3), "Binary mesh round trip failed");
+
+  // A text file is rejected once mapped (and unmapped by the exception)
+  m.write_to_file("test_mesh_binary.gfb");
+  bool rejected = false;
+  try { m3.read_from_binary_file("test_mesh_binary.gfb"); }
+  catch (const gmm::gmm_error &e) {
+    rejected = (std::string(e.what()).find("is not a GetFEM binary file")
+                != std::string::npos);
+  }
+  GMM_ASSERT1(rejected, "Text file not rejected by the binary reader");
+  std::remove("test_mesh_binary.gfb");
+}
+
+
+/* Write a MSH 4.1 file of a N x N triangle mesh of the unit square, with
+   the bottom edge in the curve entity 3 (physical curve 9) and the domain
+   in the surface entity 1 (physical surface 7), either in ascii or in
+   binary format. The last node is a copy of the first one. With bad_node,
+   the last triangle refers to an undefined node. */
+static void write_msh41(std::ostream &f, bool binary, size_type N,
+                        bool bad_node = false) {
+  typedef gmm::uint64_type u64;
+  auto sz = [&](u64 v) {
+    if (binary) f.write(reinterpret_cast<const char *>(&v), sizeof(v));
+    else f << v << ' ';
+  };
+  auto in = [&](int v) {
+    if (binary) f.write(reinterpret_cast<const char *>(&v), sizeof(v));
+    else f << v << ' ';
+  };
+  auto db = [&](double v) {
+    if (binary) f.write(reinterpret_cast<const char *>(&v), sizeof(v));
+    else f << v << ' ';
+  };
+  auto nl = [&]() { if (!binary) f << '\n'; };
+  f.precision(17);
+  f << "$MeshFormat\n4.1 " << (binary ? 1 : 0) << " 8\n";
+  if (binary) { in(1); f << '\n'; }
+  f << "$EndMeshFormat\n$PhysicalNames\n2\n1 9 \"bottom\"\n"
+    << "2 7 \"domain\"\n$EndPhysicalNames\n$Entities\n";
+  sz(0); sz(1); sz(1); sz(0); nl();
+  in(3); for (double x : {0., 0., 0., 1., 0., 0.}) db(x);
+  sz(1); in(9); sz(0); nl();
+  in(1); for (double x : {0., 0., 0., 1., 1., 0.}) db(x);
+  sz(1); in(7); sz(0); nl();
+  if (binary) f << '\n';
+  f << "$EndEntities\n$Nodes\n";
+  size_type nbn = (N+1)*(N+1);
+  sz(1); sz(nbn+1); sz(1); sz(nbn+1); nl();
+  in(2); in(1); in(0); sz(nbn+1); nl();
+  for (size_type i = 0; i <= nbn; ++i) { sz(i+1); nl(); }
+  for (size_type j = 0; j <= N; ++j)
+    for (size_type i = 0; i <= N; ++i)
+      { db(double(i)/double(N)); db(double(j)/double(N)); db(0.); nl(); }
+  db(0.); db(0.); db(0.); nl();
+  if (binary) f << '\n';
+  f << "$EndNodes\n$Elements\n";
+  sz(2); sz(N + 2*N*N); sz(1); sz(N + 2*N*N); nl();
+  u64 tag = 1;
+  in(1); in(3); in(1); sz(N); nl();
+  for (size_type i = 0; i < N; ++i) { sz(tag++); sz(i+1); sz(i+2); nl(); }
+  in(2); in(1); in(2); sz(2*N*N); nl();
+  for (size_type j = 0; j < N; ++j)
+    for (size_type i = 0; i < N; ++i) {
+      u64 n0 = j*(N+1) + i + 1, n1 = n0 + 1, n2 = n0 + N + 1, n3 = n2 + 1;
+      sz(tag++); sz(n0); sz(n1); sz(n3); nl();
+      if (bad_node && i == N-1 && j == N-1) n0 = nbn + 5;
+      sz(tag++); sz(n0); sz(n3); sz(n2); nl();
+    }
+  if (binary) f << '\n';
+  f << "$EndElements\n";
+}
+
+void test_gmsh_binary_import() {
+  for (size_type N : {3, 80}) {
+    size_type nbn = (N+1)*(N+1);
+    for (bool merge : {true, false}) {
+      std::stringstream fa, fb;
+      write_msh41(fa, false, N);
+      write_msh41(fb, true, N);
+      getfem::mesh ma, mb;
+      std::map<std::string, size_type> ra, rb;
+      getfem::import_mesh_gmsh(fa, ma, ra, true, NULL, merge);
+      getfem::import_mesh_gmsh(fb, mb, rb, true, NULL, merge);
+      GMM_ASSERT1(ma.convex_index().card() == 2*N*N,
+                  "Wrong number of convexes");
+      GMM_ASSERT1(ma.dim() == 2, "Wrong dimension");
+      // binary nodes are inserted by tag, without merging
+      GMM_ASSERT1(ma.points().card() == (merge ? nbn : nbn+1)
+                  && mb.points().card() == nbn+1,
+                  "Duplicated nodes not handled as required");
+      GMM_ASSERT1(ra == rb && ra["bottom"] == 9 && ra["domain"] == 7,
+                  "Wrong region names");
+      // the regions are numbered by the physical tags of the entities
+      for (const getfem::mesh *pm : {&ma, &mb}) {
+        GMM_ASSERT1(pm->region(7).size() == 2*N*N
+                    && pm->region(9).size() == N
+                    && !pm->has_region(1) && !pm->has_region(3),
+                    "Regions not numbered by the physical tags");
+        for (getfem::mr_visitor i(pm->region(9)); !i.finished(); ++i)
+          for (const base_node &P : pm->points_of_face_of_convex(i.cv(),
+                                                                 i.f()))
+            GMM_ASSERT1(gmm::abs(P[1]) < 1E-12, "Wrong boundary region");
+      }
+      GMM_ASSERT1(merge || text_of(ma) == text_of(mb), "Binary gmsh import "
+                  "differs from the ascii one");
+    }
+
+    // An undefined node is reported in both formats, also when the
+    // elements are converted in parallel.
+    for (bool binary : {false, true}) {
+      std::stringstream fc;
+      write_msh41(fc, binary, N, true);
+      getfem::mesh mc;
+      bool reported = false;
+      try { getfem::import_mesh_gmsh(fc, mc); }
+      catch (const gmm::gmm_error &e) {
+        reported = (std::string(e.what()).find("Invalid node ID "
+                    + std::to_string(nbn+5)) != std::string::npos);
+      }
+      GMM_ASSERT1(reported, "Undefined node not reported");
+    }
+  }
+}
 
 int main(void) {
 
@@ -644,6 +1069,7 @@ int main(void) {
   test_convex_quality(-0.2,0);
   test_convex_quality(-0.01,-0.2);
   test_region();
+  test_region_partitions();
 
   test_search_point();
   
@@ -658,6 +1084,15 @@ int main(void) {
   test_refinable(3, 3);
 
   test_incomplete_Q2();
+
+  test_vtu_export();
+
+  test_dof_enumeration();
+
+  test_connectivity();
+
+  test_binary_io();
+  test_gmsh_binary_import();
   
   return 0;
 }
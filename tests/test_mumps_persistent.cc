@@ -0,0 +1,171 @@
+/*===========================================================================
+
+ Copyright (C) 2026 agent.
+
+ This file is a part of GetFEM
+
+ GetFEM  is  free software;  you  can  redistribute  it  and/or modify it
+ under  the  terms  of the  GNU  Lesser General Public License as published
+ by  the  Free Software Foundation;  either version 3 of the License,  or
+ (at your option) any later version along with the GCC Runtime Library
+ Exception either version 3.1 or (at your option) any later version.
+ This program  is  distributed  in  the  hope  that it will be useful,  but
+ WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ or  FITNESS  FOR  A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ License and GCC Runtime Library Exception for more details.
+ You  should  have received a copy of the GNU Lesser General Public License
+ along  with  this program. If not, see https://www.gnu.org/licenses/.
+
+===========================================================================*/
+/**
+   Test of the MUMPS solver keeping its analysis and factors between the
+   solves (linear_solver_mumps_persistent).
+*/
+#include "getfem/getfem_regular_meshes.h"
+#include "getfem/getfem_model_solvers.h"
+
+using std::endl; using std::cout; using std::cerr;
+using bgeot::size_type;
+using bgeot::scalar_type;
+
+#if defined(GMM_USES_MUMPS) && GETFEM_PARA_LEVEL <= 1
+
+typedef getfem::model_real_sparse_matrix MAT;
+typedef getfem::model_real_plain_vector VECT;
+typedef getfem::linear_solver_mumps_persistent<MAT, VECT> persistent_solver;
+
+/* Nonlinear diffusion problem solved in several loading steps with the
+   given solver. Returns the final solution. */
+static VECT solve_loading(const std::string &solver_name,
+                          getfem::rmodel_plsolver_type &lsolver) {
+  getfem::mesh m;
+  getfem::regular_unit_mesh(m, std::vector<size_type>(2, 6),
+                            bgeot::simplex_geotrans(2, 1));
+  getfem::mesh_region border;
+  getfem::outer_faces_of_mesh(m, border);
+  m.region(1) = border;
+  getfem::mesh_fem mf(m);
+  mf.set_classical_finite_element(2);
+  getfem::mesh_im mim(m);
+  mim.set_integration_method(4);
+
+  getfem::model md;
+  md.add_fem_variable("u", mf);
+  md.add_initialized_scalar_data("load", 0.);
+  getfem::add_nonlinear_term
+    (md, mim, "(1+u*u)*Grad_u.Grad_Test_u - load*X(1)*Test_u");
+  getfem::add_Dirichlet_condition_with_multipliers(md, mim, "u", mf, 1);
+
+  lsolver = getfem::rselect_linear_solver(md, solver_name);
+  for (size_type step = 1; step <= 4; ++step) {
+    md.set_real_variable("load")[0] = scalar_type(10 * step);
+    gmm::iteration iter(1E-10, 0, 40);
+    getfem::standard_solve(md, iter, lsolver);
+    GMM_ASSERT1(iter.converged(), "Newton did not converge with "
+                << solver_name << " at step " << step);
+  }
+  return md.real_variable("u");
+}
+
+static void test_model_solve() {
+  getfem::rmodel_plsolver_type ls_ref, ls_pers, ls_reuse;
+  VECT U_ref = solve_loading("mumps", ls_ref);
+  VECT U_pers = solve_loading("mumps_persistent", ls_pers);
+  VECT U_reuse = solve_loading("mumps_persistent/reuse", ls_reuse);
+  scalar_type nref = gmm::vect_norm2(U_ref);
+  GMM_ASSERT1(gmm::vect_dist2(U_ref, U_pers) < 1E-8 * nref,
+              "Persistent solver gives a different solution");
+  GMM_ASSERT1(gmm::vect_dist2(U_ref, U_reuse) < 1E-8 * nref,
+              "Persistent solver with reuse gives a different solution");
+
+  // The pattern of the tangent matrix does not change between the Newton
+  // iterations and the loading steps, except after the first iteration:
+  // the terms in u of the first tangent matrix vanish and the zero entries
+  // are not passed to MUMPS. Hence two analyses.
+  auto pers = std::dynamic_pointer_cast<persistent_solver>(ls_pers);
+  auto reuse = std::dynamic_pointer_cast<persistent_solver>(ls_reuse);
+  GMM_ASSERT1(pers && reuse, "Wrong type of linear solver");
+  cout << "persistent solver: " << pers->F.nb_analyses() << " analyses, "
+       << pers->F.nb_factorizations() << " factorizations" << endl;
+  cout << "persistent solver with reuse: " << reuse->F.nb_analyses()
+       << " analyses, " << reuse->F.nb_factorizations()
+       << " factorizations, " << reuse->nb_reused_solves
+       << " solves with previous factors" << endl;
+  GMM_ASSERT1(pers->F.nb_analyses() == 2, "Unexpected analyses");
+  GMM_ASSERT1(pers->F.nb_factorizations() > 4, "Missing factorizations");
+  GMM_ASSERT1(reuse->F.nb_analyses() == 2, "Unexpected analyses");
+  GMM_ASSERT1(reuse->nb_reused_solves > 0, "Factors never reused");
+  GMM_ASSERT1(reuse->F.nb_factorizations() < pers->F.nb_factorizations(),
+              "The reuse of the factors does not spare factorizations");
+}
+
+/* A pattern change triggers a new analysis, and the solve with the
+   previous factors starts from the given x. */
+static void test_pattern_and_initial_guess() {
+  size_type n = 30;
+  gmm::col_matrix<gmm::wsvector<scalar_type>> B(n, n);
+  for (size_type i = 0; i < n; ++i) {
+    B(i, i) = 4.;
+    if (i) B(i, i-1) = -1.;
+    if (i+1 < n) B(i, i+1) = -1.5;
+  }
+  MAT A1(n, n), A2(n, n);
+  gmm::copy(B, A1);
+  B(0, n-1) = 0.5;
+  for (size_type i = 0; i < n; ++i) B(i, i) = 3.;
+  gmm::copy(B, A2);
+  VECT x(n), b(n, 1.), r(n);
+
+  persistent_solver S(false, true, 1);
+  gmm::iteration iter(1E-12);
+  S(A1, x, b, iter);
+  gmm::mult(A1, x, gmm::scaled(b, -1.), r);
+  GMM_ASSERT1(iter.converged() && gmm::vect_norm2(r) < 1E-10,
+              "Wrong solution");
+
+  // New pattern and a matrix far from the factorized one: one gmres
+  // iteration from zero is not enough, the matrix is factorized again.
+  gmm::clear(x);
+  gmm::iteration iter2(1E-12);
+  S(A2, x, b, iter2);
+  gmm::mult(A2, x, gmm::scaled(b, -1.), r);
+  GMM_ASSERT1(iter2.converged() && gmm::vect_norm2(r) < 1E-10,
+              "Wrong solution");
+  GMM_ASSERT1(S.F.nb_analyses() == 2 && S.nb_reused_solves == 0,
+              "The pattern change is not detected");
+
+  // Same pattern, other values. The given solution is kept as initial
+  // guess of gmres with the previous factors, which then converges
+  // immediately (one iteration from zero would not be enough).
+  for (size_type i = 0; i < n; ++i) B(i, i) = 6.;
+  MAT A3(n, n);
+  gmm::copy(B, A3);
+  gmm::dense_matrix<scalar_type> D(n, n);
+  gmm::copy(A3, D);
+  VECT x_ref(n);
+  gmm::lu_solve(D, x_ref, b);
+  gmm::copy(x_ref, x);
+  gmm::iteration iter3(1E-12);
+  S(A3, x, b, iter3);
+  GMM_ASSERT1(iter3.converged() && S.nb_reused_solves == 1
+              && S.F.nb_factorizations() == 2,
+              "The initial guess is not used");
+  GMM_ASSERT1(gmm::vect_dist2(x, x_ref) < 1E-10, "Wrong solution");
+}
+
+int main(void) {
+  GMM_SET_EXCEPTION_DEBUG;
+  gmm::set_traces_level(1);
+  test_pattern_and_initial_guess();
+  test_model_solve();
+  return 0;
+}
+
+#else
+
+int main(void) {
+  cout << "MUMPS is not available, test skipped" << endl;
+  return 0;
+}
+
+#endif
@@ -0,0 +1,99 @@
+/*===========================================================================
+
+ Copyright (C) 2026 agent.
+
+ This file is a part of GetFEM
+
+ GetFEM  is  free software;  you  can  redistribute  it  and/or modify it
+ under  the  terms  of the  GNU  Lesser General Public License as published
+ by  the  Free Software Foundation;  either version 3 of the License,  or
+ (at your option) any later version along with the GCC Runtime Library
+ Exception either version 3.1 or (at your option) any later version.
+ This program  is  distributed  in  the  hope  that it will be useful,  but
+ WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ or  FITNESS  FOR  A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ License and GCC Runtime Library Exception for more details.
+ You  should  have received a copy of the GNU Lesser General Public License
+ along  with  this program. If not, see https://www.gnu.org/licenses/.
+
+===========================================================================*/
+#include "getfem/bgeot_kdtree.h"
+#include "getfem/getfem_generic_assembly.h"
+#include "getfem/getfem_regular_meshes.h"
+#include "getfem/getfem_omp.h"
+#include <thread>
+#include <chrono>
+using std::endl; using std::cout; using std::cerr;
+using bgeot::size_type;
+using bgeot::scalar_type;
+using bgeot::base_vector;
+
+/* Test of the static and dynamic scheduling of the partitions in the
+   parallel sections. */
+
+static getfem::partition_master &pm() { return getfem::partition_master::get(); }
+
+/* Each partition has to be processed exactly once. */
+static void check_partitions_processed(scalar_type sleep_time) {
+  getfem::omp_distribute<size_type> count(size_type(0));
+  GETFEM_OMP_PARALLEL(
+    ++(count.thrd_cast());
+    if (sleep_time > 0.)
+      std::this_thread::sleep_for(std::chrono::duration<double>(sleep_time));
+  )
+  for (size_type p = 0; p < count.num_threads(); ++p)
+    GMM_ASSERT1(count(p) == 1, "Partition " << p << " processed "
+                << count(p) << " times");
+
+  /* The times of the threads are wall clock times: sleeping partitions
+     have to be accounted for. */
+  const std::vector<double> &times = pm().thread_times();
+  if (sleep_time > 0. && !times.empty()) {
+    double tmax = *std::max_element(times.begin(), times.end());
+    cout << "max thread time: " << tmax << " s" << endl;
+    GMM_ASSERT1(tmax >= 0.9 * sleep_time, "Thread times are not wall "
+                "clock times");
+  }
+}
+
+static base_vector assembly(const getfem::mesh_im &mim,
+                            const getfem::mesh_fem &mf) {
+  base_vector V(mf.nb_dof());
+  getfem::ga_workspace workspace;
+  base_vector U(mf.nb_dof());
+  workspace.add_fem_variable("u", mf, gmm::sub_interval(0, U.size()), U);
+  workspace.add_expression("(1+X(1)*X(2))*Test_u", mim);
+  workspace.set_assembled_vector(V);
+  workspace.assembly(1);
+  return V;
+}
+
+int main(void) {
+  size_type nbth = std::max(getfem::max_concurrency(), size_type(2));
+  getfem::set_num_threads(int(nbth));
+  pm().set_nb_partitions(4*nbth);
+
+  getfem::mesh m;
+  std::vector<size_type> nsubdiv(2, 20);
+  getfem::regular_unit_mesh(m, nsubdiv, bgeot::simplex_geotrans(2, 1));
+  getfem::mesh_fem mf(m);
+  mf.set_classical_finite_element(2);
+  getfem::mesh_im mim(m);
+  mim.set_integration_method(4);
+
+  pm().set_scheduling(getfem::partition_scheduling::static_partitions);
+  check_partitions_processed(0.);
+  check_partitions_processed(0.01);
+  base_vector V0 = assembly(mim, mf);
+
+  pm().set_scheduling(getfem::partition_scheduling::dynamic_partitions);
+  check_partitions_processed(0.);
+  check_partitions_processed(0.01);
+  base_vector V1 = assembly(mim, mf);
+  pm().set_scheduling(getfem::partition_scheduling::static_partitions);
+
+  scalar_type err = gmm::vect_dist2(V0, V1) / gmm::vect_norm2(V0);
+  cout << "dynamic scheduling assembly error: " << err << endl;
+  GMM_ASSERT1(err < 1E-12, "Dynamic scheduling changes the assembly");
+  return 0;
+}
@@ -178,6 +178,69 @@ static void verify(const std::vector<base_node>& rmin, const std::vector<base_no
     assert(pbset.size() >= 1);
     assert(std::find(pbset.begin(), pbset.end(), i) != pbset.end());
   }
+
+  /* batched searches against the single ones */
+  std::vector<base_node> pts(rmin), qmax(rmin);
+  for (size_type i=0; i < rmin.size(); ++i)
+    for (size_type k=0; k < N; ++k) {
+      pts[i][k] = gmm::random(double())*1.3;
+      qmax[i][k] = pts[i][k] + gmm::random()*0.1;
+    }
+  pts.insert(pts.end(), rmax.begin(), rmax.end());
+  qmax.insert(qmax.end(), rmax.begin(), rmax.end());
+  std::vector<size_type> idptr, idvec;
+  for (int parallel = 0; parallel < 2; ++parallel) {
+    tree.find_boxes_at_points(pts, idptr, idvec, parallel != 0);
+    assert(idptr.size() == pts.size()+1);
+    for (size_type i=0; i < pts.size(); ++i) {
+      tree.find_boxes_at_point(pts[i], pbset);
+      assert(pbset.size() == idptr[i+1]-idptr[i]);
+      assert(std::equal(pbset.begin(), pbset.end(), idvec.begin()+idptr[i]));
+    }
+    tree.find_intersecting_boxes(pts, qmax, idptr, idvec, parallel != 0);
+    assert(idptr.size() == pts.size()+1);
+    for (size_type i=0; i < pts.size(); ++i) {
+      tree.find_intersecting_boxes(pts[i], qmax[i], pbset);
+      assert(pbset.size() == idptr[i+1]-idptr[i]);
+      assert(std::equal(pbset.begin(), pbset.end(), idvec.begin()+idptr[i]));
+    }
+  }
+
+  /* refit of a flat copy of the tree to moved boxes */
+  bgeot::flat_rtree ftree(tree);
+  assert(ftree.nb_boxes() == tree.nb_boxes());
+  std::vector<base_node> rmin2(rmin), rmax2(rmax);
+  for (size_type i=0; i < rmin.size(); ++i)
+    for (size_type k=0; k < N; ++k) {
+      double d = (gmm::random()-0.5)*extent[k];
+      rmin2[i][k] += d; rmax2[i][k] += d + gmm::random()*extent[k]*0.1;
+    }
+  ftree.refit(rmin2, rmax2);
+  for (int parallel = 0; parallel < 2; ++parallel) {
+    ftree.find_boxes_at_points(pts, idptr, idvec, parallel != 0);
+    for (size_type i=0; i < pts.size(); ++i) {
+      pbset.assign(idvec.begin()+idptr[i], idvec.begin()+idptr[i+1]);
+      brute_force_check(rmin2,rmax2,pbset,has_point_p(pts[i]));
+    }
+    ftree.find_intersecting_boxes(pts, qmax, idptr, idvec, parallel != 0);
+    for (size_type i=0; i < pts.size(); ++i) {
+      pbset.assign(idvec.begin()+idptr[i], idvec.begin()+idptr[i+1]);
+      brute_force_check(rmin2,rmax2,pbset,intersection_p(pts[i],qmax[i]));
+    }
+  }
+
+  /* the searches on the tree itself are not affected by the refit */
+  for (size_type i=0; i < pts.size(); ++i) {
+    tree.find_boxes_at_point(pts[i], pbset);
+    brute_force_check(rmin,rmax,pbset,has_point_p(pts[i]));
+    tree.find_intersecting_boxes(pts[i], qmax[i], pbset);
+    brute_force_check(rmin,rmax,pbset,intersection_p(pts[i],qmax[i]));
+  }
+  tree.find_boxes_at_points(pts, idptr, idvec);
+  for (size_type i=0; i < pts.size(); ++i) {
+    pbset.assign(idvec.begin()+idptr[i], idvec.begin()+idptr[i+1]);
+    brute_force_check(rmin,rmax,pbset,has_point_p(pts[i]));
+  }
 }
 
 static void check_tree() {
@@ -20,6 +20,7 @@
 #include "getfem/bgeot_comma_init.h"
 #include "getfem/bgeot_comma_init.h"
 #include "getfem/getfem_mesh_slice.h"
+#include "getfem/getfem_regular_meshes.h"
 using std::endl; using std::cout; using std::cerr;
 using std::ends; using std::cin;
 
@@ -63,6 +64,63 @@ namespace getfem {
 #endif
 }
 
+static std::string slice_text(const getfem::stored_mesh_slice &sl) {
+  std::stringstream s; s << sl; return s.str();
+}
+
+/* The slices built with several threads should be the same as the ones
+   built serially. */
+static void test_parallel_slice() {
+  getfem::mesh m;
+  getfem::regular_unit_mesh(m, std::vector<size_type>(3, 4),
+                            bgeot::parallelepiped_geotrans(3, 1));
+  getfem::mesh_fem mf(m), mfd(m, 3);
+  mf.set_classical_finite_element(1);
+  mfd.set_classical_finite_element(1);
+  std::vector<double> U(mf.nb_dof()), D(mfd.nb_dof());
+  for (size_type i = 0; i < mf.nb_dof(); ++i) {
+    getfem::base_node P = mf.point_of_basic_dof(i);
+    U[i] = P[0] + P[1] + P[2] + 0.3*P[0]*P[1];
+  }
+  for (size_type i = 0; i < mfd.nb_dof(); ++i)
+    D[i] = 0.05 * mfd.point_of_basic_dof(i)[(i+1) % 3];
+  getfem::mesh_slice_cv_dof_data<std::vector<double> > mfU(mf, U), mfD(mfd, D);
+
+  std::string ref_iso, ref_bound;
+  for (int nth : {1, 3}) {
+    getfem::set_num_threads(nth);
+    getfem::slicer_apply_deformation sdef(mfD);
+    getfem::slicer_isovalues siso(mfU, 1.2, 0);
+    getfem::stored_mesh_slice sl1, sl2;
+    sl1.build(m, sdef, siso, 3);
+    sl2.build(m, getfem::slicer_boundary(m), 2);
+    GMM_ASSERT1(sl1.nb_points() > 0, "Empty isosurface");
+    if (nth == 1) {
+      ref_iso = slice_text(sl1); ref_bound = slice_text(sl2);
+    } else {
+      GMM_ASSERT1(slice_text(sl1) == ref_iso,
+                  "The parallel isosurface differs from the serial one");
+      GMM_ASSERT1(slice_text(sl2) == ref_bound,
+                  "The parallel boundary slice differs from the serial one");
+    }
+
+    sl2.merge_nodes();
+    GMM_ASSERT1(sl2.nb_merged_nodes() == 9*9*9 - 7*7*7,
+                "Wrong number of merged nodes " << sl2.nb_merged_nodes());
+    size_type nb = 0;
+    for (size_type i = 0; i < sl2.nb_merged_nodes(); ++i) {
+      auto it = sl2.merged_point_nodes(i);
+      for (size_type j = 0; j < sl2.merged_point_cnt(i); ++j, ++nb) {
+        GMM_ASSERT1(gmm::vect_dist2(it[j].P->pt, sl2.merged_point(i)) < 1E-10,
+                    "Wrong merged node");
+        GMM_ASSERT1(j == 0 || it[j].pos > it[j-1].pos, "Wrong order");
+      }
+    }
+    GMM_ASSERT1(nb == sl2.nb_points(), "Some nodes are not merged");
+  }
+  getfem::set_num_threads(1);
+}
+
 int 
 main() {
 
@@ -112,5 +170,7 @@ main() {
   cout << sl << endl;
 
   cout << "memory 1: " << sl.memsize() << " bytes\n";
+
+  test_parallel_slice();
   return 0;
 }
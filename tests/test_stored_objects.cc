@@ -0,0 +1,178 @@
+/*===========================================================================
+
+ Copyright (C) 2026 agent.
+
+ This file is a part of GetFEM
+
+ GetFEM  is  free software;  you  can  redistribute  it  and/or modify it
+ under  the  terms  of the  GNU  Lesser General Public License as published
+ by  the  Free Software Foundation;  either version 3 of the License,  or
+ (at your option) any later version along with the GCC Runtime Library
+ Exception either version 3.1 or (at your option) any later version.
+ This program  is  distributed  in  the  hope  that it will be useful,  but
+ WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ or  FITNESS  FOR  A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ License and GCC Runtime Library Exception for more details.
+ You  should  have received a copy of the GNU Lesser General Public License
+ along  with  this program. If not, see https://www.gnu.org/licenses/.
+
+===========================================================================*/
+#include "getfem/bgeot_kdtree.h"
+#include "getfem/dal_static_stored_objects.h"
+#include "getfem/getfem_omp.h"
+#include "gmm/gmm_except.h"
+using std::endl; using std::cout; using std::cerr;
+using bgeot::size_type;
+
+/* Test of the semantics of the stored object tables, and timing of the
+   lookups, possibly concurrent. */
+
+bool quick = false;
+
+DAL_SIMPLE_KEY(test_int_key, size_type);
+DAL_DOUBLE_KEY(test_pair_key, size_type, std::string);
+
+struct test_object : virtual public dal::static_stored_object {
+  size_type i;
+  test_object(size_type ii) : i(ii) {}
+};
+
+/* A key without hash, to check the default linear lookup. */
+struct test_nohash_key : virtual public dal::static_stored_object_key {
+  size_type i;
+  bool compare(const static_stored_object_key &oo) const override
+  { return i < dynamic_cast<const test_nohash_key &>(oo).i; }
+  bool equal(const static_stored_object_key &oo) const override
+  { return i == dynamic_cast<const test_nohash_key &>(oo).i; }
+  test_nohash_key(size_type ii) : i(ii) {}
+};
+
+static size_type value_of(dal::pstatic_stored_object o) {
+  GMM_ASSERT1(o, "object not found");
+  return std::dynamic_pointer_cast<const test_object>(o)->i;
+}
+
+void check_semantics(size_type n) {
+  size_type nb0 = dal::nb_stored_objects();
+  std::vector<dal::pstatic_stored_object> objs(n);
+  for (size_type i = 0; i < n; ++i) {
+    objs[i] = std::make_shared<test_object>(i);
+    dal::add_stored_object(std::make_shared<test_int_key>(i), objs[i]);
+    dal::add_stored_object(std::make_shared<test_pair_key>
+                           (i, std::to_string(i)),
+                           std::make_shared<test_object>(i+n),
+                           objs[i], dal::AUTODELETE_STATIC_OBJECT);
+    dal::add_stored_object(std::make_shared<test_nohash_key>(i),
+                           std::make_shared<test_object>(i+2*n),
+                           objs[i], dal::AUTODELETE_STATIC_OBJECT);
+  }
+  GMM_ASSERT1(dal::nb_stored_objects() == nb0 + 3*n, "wrong size");
+
+  for (size_type i = 0; i < n; ++i) {
+    GMM_ASSERT1(value_of(dal::search_stored_object
+                         (std::make_shared<test_int_key>(i))) == i,
+                "wrong object");
+    GMM_ASSERT1(value_of(dal::search_stored_object
+                         (std::make_shared<test_pair_key>
+                          (i, std::to_string(i)))) == i+n, "wrong object");
+    GMM_ASSERT1(value_of(dal::search_stored_object
+                         (std::make_shared<test_nohash_key>(i))) == i+2*n,
+                "wrong object");
+  }
+  GMM_ASSERT1(!dal::search_stored_object(std::make_shared<test_int_key>(n)),
+              "unexpected object");
+  GMM_ASSERT1(!dal::search_stored_object
+              (std::make_shared<test_pair_key>(0, "1")), "unexpected object");
+
+  // Deleting an object deletes the objects depending on it.
+  for (size_type i = 0; i < n; i += 2) dal::del_stored_object(objs[i]);
+  GMM_ASSERT1(dal::nb_stored_objects() == nb0 + 3*(n/2), "wrong size");
+  for (size_type i = 0; i < n; ++i) {
+    bool kept = (i % 2) == 1;
+    GMM_ASSERT1(dal::exists_stored_object(objs[i]) == kept, "wrong deletion");
+    GMM_ASSERT1(bool(dal::search_stored_object
+                     (std::make_shared<test_int_key>(i))) == kept,
+                "wrong deletion");
+    GMM_ASSERT1(bool(dal::search_stored_object
+                     (std::make_shared<test_pair_key>
+                      (i, std::to_string(i)))) == kept, "wrong deletion");
+    GMM_ASSERT1(bool(dal::search_stored_object
+                     (std::make_shared<test_nohash_key>(i))) == kept,
+                "wrong deletion");
+  }
+
+  // The deleted keys can be stored again.
+  for (size_type i = 0; i < n; i += 2)
+    dal::add_stored_object(std::make_shared<test_int_key>(i),
+                           std::make_shared<test_object>(i+3*n));
+  for (size_type i = 0; i < n; ++i)
+    GMM_ASSERT1(value_of(dal::search_stored_object
+                         (std::make_shared<test_int_key>(i)))
+                == ((i % 2) ? i : i+3*n), "wrong object");
+
+  // Deleting the objects on which others depend removes everything.
+  for (size_type i = 0; i < n; ++i) {
+    auto o = dal::search_stored_object(std::make_shared<test_int_key>(i));
+    dal::del_stored_object(o);
+  }
+  GMM_ASSERT1(dal::nb_stored_objects() == nb0, "objects not deleted");
+  for (size_type i = 0; i < n; ++i)
+    GMM_ASSERT1(!dal::search_stored_object(std::make_shared<test_int_key>(i))
+                && !dal::search_stored_object
+                (std::make_shared<test_pair_key>(i, std::to_string(i))),
+                "deleted object found");
+}
+
+void lookup_speed(size_type n, size_type nrepeat) {
+  std::vector<dal::pstatic_stored_object> objs(n);
+  std::vector<dal::pstatic_stored_object_key> keys(n);
+  for (size_type i = 0; i < n; ++i) {
+    objs[i] = std::make_shared<test_object>(i);
+    keys[i] = std::make_shared<test_pair_key>(i, "key" + std::to_string(i));
+    dal::add_stored_object(keys[i], objs[i]);
+  }
+
+  double t = gmm::uclock_sec();
+  size_type nb_found = 0;
+  for (size_type k = 0; k < nrepeat; ++k)
+    for (size_type i = 0; i < n; ++i)
+      if (dal::search_stored_object(keys[(i*7919) % n]) == objs[(i*7919) % n])
+        ++nb_found;
+  GMM_ASSERT1(nb_found == n*nrepeat, "lookup failure");
+  cout << "average lookup time: " << (gmm::uclock_sec()-t)/double(n*nrepeat)*1e9
+       << " ns\n";
+
+  /* Concurrent lookups of the objects stored by the master thread. */
+  size_type nbth = getfem::max_concurrency();
+  getfem::set_num_threads(int(nbth));
+  getfem::omp_distribute<size_type> found(0);
+  t = gmm::uclock_sec();
+  GETFEM_OMP_PARALLEL(
+    size_type &nf = found.thrd_cast();
+    for (size_type k = 0; k < nrepeat; ++k)
+      for (size_type i = 0; i < n; ++i) {
+        size_type j = (i*7919 + k) % n;
+        if (dal::search_stored_object_on_all_threads(keys[j]) == objs[j])
+          ++nf;
+      }
+  )
+  double tt = gmm::uclock_sec() - t;
+  nb_found = 0;
+  for (size_type th = 0; th < found.num_threads(); ++th)
+    nb_found += found(th);
+  GMM_ASSERT1(nb_found == n*nrepeat*found.num_threads(), "lookup failure");
+  cout << "concurrent lookups on " << found.num_threads() << " threads: "
+       << tt/double(n*nrepeat)*1e9 << " ns per lookup and thread\n";
+  getfem::set_num_threads(1);
+
+  for (size_type i = 0; i < n; ++i) dal::del_stored_object(objs[i]);
+}
+
+int main(int argc, char **argv) {
+  if (argc == 2 && strcmp(argv[1],"-quick")==0) quick = true;
+  check_semantics(quick ? 100 : 1000);
+  if (!quick)
+    lookup_speed(10000, 100);
+  else lookup_speed(1000, 10);
+  return 0;
+}